@@ -0,0 +1,224 @@
+//
+//  bench_ssc.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+//  Benchmarks of the SPA, the sunrise/sunset search, and whole sunrise_sunset_calculate() calls, by latitude band.
+//
+//  Usage: bench_ssc [samples per band]
+//
+//  Writes CSV to stdout with one row per benchmark and band, with the latency distribution of single calls in
+//  nanoseconds and the number of evaluations of the SPA per call. The library is built into this file so that the
+//  internal search can be timed on its own.
+//
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 199309L
+#endif
+#include "ssc.c"
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#define DEFAULT_SAMPLES 200
+#define UNIX_2000 946684800
+#define SECONDS_PER_YEAR 31556952
+
+typedef struct {
+    const char *name;
+    double latitude_min; ///< Absolute latitude range [degrees]
+    double latitude_max;
+    bool both_hemispheres; ///< Otherwise northern hemisphere only
+    int first_day;         ///< Days since the start of the year to sample, -1 for any day
+    int days;
+} LatitudeBand;
+
+static const LatitudeBand bands[] = {
+    {"equatorial", 0.0, 15.0, true, -1, 0},
+    {"mid", 30.0, 55.0, true, -1, 0},
+    {"60-64", 60.0, 64.0, true, -1, 0},
+    {"above_64", 64.0, 72.0, true, -1, 0},
+    // December to mid January in the arctic
+    {"polar_night", 70.0, 85.0, false, 334, 45},
+};
+
+typedef struct {
+    unix_t time;
+    double latitude;
+    double longitude;
+} Sample;
+
+typedef struct {
+    uint64_t *nanoseconds;
+    uint64_t *evaluations;
+    size_t count;
+} Measurements;
+
+static uint64_t now_ns(void) {
+#ifdef _WIN32
+    LARGE_INTEGER counter, frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (uint64_t) ((double) counter.QuadPart * 1e9 / (double) frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+#endif
+}
+
+/// Deterministic xorshift generator, so that every run uses the same samples
+static double random_uniform(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return (double) (*state >> 11) / 9007199254740992.0;
+}
+
+static void generate_samples(const LatitudeBand *band, Sample *samples, size_t count) {
+    uint64_t state = 0x9E3779B97F4A7C15u;
+    size_t i;
+    for (i = 0; i < count; i++) {
+        double latitude = band->latitude_min + (band->latitude_max - band->latitude_min) * random_uniform(&state);
+        unix_t year = UNIX_2000 + (unix_t) (random_uniform(&state) * 40.0) * SECONDS_PER_YEAR;
+        double day = band->first_day < 0 ? random_uniform(&state) * 365.0
+                                         : band->first_day + random_uniform(&state) * band->days;
+        samples[i].latitude = band->both_hemispheres && random_uniform(&state) < 0.5 ? -latitude : latitude;
+        samples[i].longitude = random_uniform(&state) * 360.0 - 180.0;
+        samples[i].time = year + (unix_t) (day * 86400.0);
+    }
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+    return x < y ? -1 : x > y;
+}
+
+static void report(const char *benchmark, const LatitudeBand *band, Measurements *m) {
+    double mean_ns = 0, mean_evaluations = 0;
+    uint64_t max_evaluations = 0;
+    size_t i;
+    for (i = 0; i < m->count; i++) {
+        mean_ns += (double) m->nanoseconds[i];
+        mean_evaluations += (double) m->evaluations[i];
+        max_evaluations = m->evaluations[i] > max_evaluations ? m->evaluations[i] : max_evaluations;
+    }
+    mean_ns /= (double) m->count;
+    mean_evaluations /= (double) m->count;
+    qsort(m->nanoseconds, m->count, sizeof(uint64_t), compare_u64);
+    printf("%s,%s,%zu,%.0f,%llu,%llu,%llu,%llu,%.1f,%llu\n",
+           benchmark,
+           band->name,
+           m->count,
+           mean_ns,
+           (unsigned long long) m->nanoseconds[m->count / 2],
+           (unsigned long long) m->nanoseconds[m->count * 9 / 10],
+           (unsigned long long) m->nanoseconds[m->count * 99 / 100],
+           (unsigned long long) m->nanoseconds[m->count - 1],
+           mean_evaluations,
+           (unsigned long long) max_evaluations);
+    fflush(stdout);
+}
+
+static void bench_spa_calculate(const LatitudeBand *band, const Sample *samples, Measurements *m) {
+    spa_data spa;
+    size_t i;
+    for (i = 0; i < m->count; i++) {
+        uint64_t start;
+        spa.jd = jd_from_unix(samples[i].time);
+        spa.delta_t = 0;
+        spa.longitude = samples[i].longitude;
+        spa.latitude = samples[i].latitude;
+        spa.elevation = SSC_DEFAULT_ELEVATION;
+        spa.pressure = SSC_DEFAULT_PRESSURE;
+        spa.temperature = SSC_DEFAULT_TEMPERATURE;
+        spa.atmos_refract = SSC_DEFAULT_ATMOSPHERIC_REFRACTION;
+        start = now_ns();
+        spa_calculate(&spa);
+        m->nanoseconds[i] = now_ns() - start;
+        m->evaluations[i] = 1;
+    }
+    report("spa_calculate", band, m);
+}
+
+static void bench_search(const LatitudeBand *band, const Sample *samples, Measurements *m) {
+    SunriseSunsetParameters params;
+    SunriseSunsetContext context;
+    SunriseSunsetSearchStats stats;
+    bool visible = false;
+    unix_t result;
+    size_t i;
+    for (i = 0; i < m->count; i++) {
+        uint64_t start;
+        SunriseSunsetParameters_init(&params, samples[i].time, samples[i].latitude, samples[i].longitude);
+        solar_context_init(&context, &params);
+        solar_visible_at(&context, params.time, &visible);
+        search_stats_init(&stats);
+        context.stats = &stats;
+        start = now_ns();
+        search_for_change_in_visibility(&context, params.time, params.step_size, visible, &result);
+        m->nanoseconds[i] = now_ns() - start;
+        m->evaluations[i] = stats.evaluations;
+    }
+    report("search_for_change_in_visibility", band, m);
+}
+
+static void bench_calculate(const LatitudeBand *band,
+                            const Sample *samples,
+                            Measurements *m,
+                            SunriseSunsetSearch search,
+                            const char *benchmark) {
+    SunriseSunsetParameters params;
+    SunriseSunsetResult result;
+    SunriseSunsetStats stats;
+    size_t i;
+    for (i = 0; i < m->count; i++) {
+        uint64_t start;
+        SunriseSunsetParameters_init(&params, samples[i].time, samples[i].latitude, samples[i].longitude);
+        params.search = search;
+        start = now_ns();
+        sunrise_sunset_calculate_stats(&params, &result, &stats);
+        m->nanoseconds[i] = now_ns() - start;
+        m->evaluations[i] = stats.evaluations;
+    }
+    report(benchmark, band, m);
+}
+
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? (size_t) strtoul(argv[1], NULL, 10) : DEFAULT_SAMPLES;
+    Sample *samples;
+    Measurements m;
+    size_t i;
+
+    if (count == 0) {
+        fprintf(stderr, "Usage: %s [samples per band]\n", argv[0]);
+        return 1;
+    }
+    samples = (Sample *) malloc(count * sizeof(Sample));
+    m.nanoseconds = (uint64_t *) malloc(count * sizeof(uint64_t));
+    m.evaluations = (uint64_t *) malloc(count * sizeof(uint64_t));
+    m.count = count;
+    if (samples == NULL || m.nanoseconds == NULL || m.evaluations == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    printf("benchmark,band,samples,mean_ns,p50_ns,p90_ns,p99_ns,max_ns,mean_evaluations,max_evaluations\n");
+    for (i = 0; i < sizeof(bands) / sizeof(bands[0]); i++) {
+        generate_samples(&bands[i], samples, count);
+        bench_spa_calculate(&bands[i], samples, &m);
+        bench_search(&bands[i], samples, &m);
+        bench_calculate(&bands[i], samples, &m, SunriseSunsetSearch_Step, "sunrise_sunset_calculate_step");
+        bench_calculate(&bands[i], samples, &m, SunriseSunsetSearch_Predictor, "sunrise_sunset_calculate_predictor");
+    }
+
+    free(samples);
+    free(m.nanoseconds);
+    free(m.evaluations);
+    return 0;
+}
@@ -49,4 +49,22 @@ int main() {
 
         start += 1800;
     }
+
+    // Alternatively list every event in a window, which only searches once per event
+    SunriseSunsetEvent events[16];
+    size_t count = 0;
+    start = time_t_for_time(2021, 7, 28, 22, 0);
+    SunriseSunsetParameters_init(&input, start, STLOUIS_LAT, STLOUIS_LON);
+    input.search = SunriseSunsetSearch_Predictor;
+    SpaError error = sunrise_sunset_events(&input, start, start + 7 * 86400, events, 16, &count);
+    if (error != SpaError_Success) {
+        printf("Failed to list the events: %d\n", error);
+        return 1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        char strEvent[100];
+        struct tm *local = localtime(&events[i].time);
+        strftime(strEvent, sizeof(strEvent), "%d/%m/%y %H:%M", local);
+        printf("%s: %s\n", events[i].rise ? "Rise" : "Set ", strEvent);
+    }
 }
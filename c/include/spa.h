@@ -37,6 +37,7 @@ typedef enum {
     SpaError_InvalidLatitude = 10,
     SpaError_InvalidAtmosRefract = 16,
     SpaError_InvalidElevation = 11,
+    SpaError_InvalidThreshold = 17,
 } SpaError;
 
 typedef struct
@@ -121,4 +122,181 @@ typedef struct
 
 SpaError spa_calculate(spa_data *spa);
 
+//-------------------------------------------------------------------------
+// Split evaluation
+//
+// The geocentric part of the algorithm (earth periodic terms, nutation,
+// sidereal time, right ascension and declination) depends only on the
+// time, so it can be computed once into a spa_ephemeris and then reused
+// for any number of observers. Treat both structs as opaque, their
+// fields are an implementation detail and may change.
+//-------------------------------------------------------------------------
+
+typedef struct
+{
+    double jd;          // Julian day
+    double delta_t;     // Difference between earth rotation time and terrestrial time
+
+    double nu;          // Greenwich sidereal time [degrees]
+    double alpha;       // geocentric sun right ascension [degrees]
+    double delta;       // geocentric sun declination [degrees]
+    double xi;          // sun equatorial horizontal parallax [degrees]
+
+    double sin_delta;   // sin of geocentric declination
+    double cos_delta;   // cos of geocentric declination
+    double sin_xi;      // sin of equatorial horizontal parallax
+
+} spa_ephemeris;
+
+typedef struct
+{
+    double longitude;      // Observer longitude (negative west of Greenwich)
+    double latitude;       // Observer latitude (negative south of equator)
+    double elevation;      // Observer elevation [meters]
+    double pressure;       // Annual average local pressure [millibars]
+    double temperature;    // Annual average local temperature [degrees Celsius]
+    double atmos_refract;  // Atmospheric refraction at sunrise and sunset
+
+    double sin_lat;        // sin of observer latitude
+    double cos_lat;        // cos of observer latitude
+    double x;              // parallax term x (cos u + elevation term)
+    double y;              // parallax term y (0.99664719 sin u + elevation term)
+    double refract_scale;  // pressure and temperature factor of the refraction correction
+    double refract_limit;  // lowest uncorrected elevation that refraction is applied to [degrees]
+
+} spa_observer;
+
+// Compute the observer independent part of the algorithm
+// Validates jd and delta_t, using the same ranges and error codes as spa_calculate
+SpaError spa_calculate_ephemeris(spa_ephemeris *ephemeris, double jd, double delta_t);
+
+//-------------------------------------------------------------------------
+// Nutation
+//
+// Nutation in longitude and obliquity (63 periodic terms) is one of the
+// largest costs of an evaluation, but it changes slowly. A spa_nutation
+// selects a cheaper series and/or caches the nutation at the edges of
+// fixed width time buckets and interpolates linearly inside them, which
+// suits a search that evaluates many nearby times.
+//-------------------------------------------------------------------------
+
+typedef enum {
+    SpaNutation_Full = 0,      // All 63 periodic terms, as spa_calculate
+    SpaNutation_Truncated = 1, // The 13 largest terms. Over -2000 to 6000 the omitted terms are bounded by
+                               // 0.085 arc seconds in del_psi and 0.027 arc seconds in del_epsilon,
+                               // which moves a sunrise/sunset by well under a second.
+} SpaNutationSeries;
+
+typedef struct
+{
+    SpaNutationSeries series; // Which periodic series to evaluate
+    double interval;          // Width of the interpolation buckets [days], 0 evaluates at every time.
+                              // The fastest significant term has a period of 13.66 days, so the
+                              // interpolation error is below 0.01 * interval^2 arc seconds.
+
+    //---------------------Cache (private)------------------------
+    int valid;                // If the bucket below has been evaluated
+    double jde_lo;            // Julian ephemeris day at the start of the cached bucket
+    double del_psi[2];        // nutation longitude at both edges of the bucket [degrees]
+    double del_epsilon[2];    // nutation obliquity at both edges of the bucket [degrees]
+
+} spa_nutation;
+
+// Initialise a nutation configuration with an empty cache
+void spa_nutation_init(spa_nutation *nutation, SpaNutationSeries series, double interval);
+
+// As spa_calculate_ephemeris, evaluating nutation as configured (NULL is the full series every time)
+// The cache is updated, so a spa_nutation must not be shared between threads
+SpaError spa_calculate_ephemeris_nutation(spa_ephemeris *ephemeris, double jd, double delta_t,
+                                          spa_nutation *nutation);
+
+// Complete an ephemeris from its geocentric values, e.g. when they come from an interpolated table
+// The equation of the equinoxes is the Greenwich sidereal time minus the Greenwich mean sidereal
+// time (del_psi * cos(epsilon)) [degrees]. No validation is done.
+void spa_ephemeris_from_geocentric(spa_ephemeris *ephemeris, double jd, double delta_t, double alpha,
+                                   double delta, double r, double equation_of_equinoxes);
+
+// Validate observer inputs and precompute the per-observer constants
+// Uses the same ranges and error codes as spa_calculate
+SpaError spa_observer_init(spa_observer *observer, double latitude, double longitude, double elevation,
+                           double pressure, double temperature, double atmos_refract);
+
+// Topocentric elevation angle (corrected) [degrees], equal to spa_data.e from spa_calculate
+// Both inputs must have been successfully initialised, no further validation is done
+double spa_calculate_elevation(const spa_ephemeris *ephemeris, const spa_observer *observer);
+
+// Topocentric elevation angle (uncorrected) [degrees], equal to spa_data.e0 from spa_calculate
+// Unlike the corrected angle this is continuous in time, the refraction correction starts abruptly
+double spa_calculate_elevation_uncorrected(const spa_ephemeris *ephemeris, const spa_observer *observer);
+
+// Apply the atmospheric refraction correction of an observer to an uncorrected elevation angle [degrees]
+// spa_observer_refraction_corrected(o, spa_calculate_elevation_uncorrected(e, o)) == spa_calculate_elevation(e, o)
+double spa_observer_refraction_corrected(const spa_observer *observer, double e0);
+
+// Evaluate spa_calculate_elevation for count (ephemeris, observer) pairs
+// With a SIMD level selected (see spa_simd.h) the pairs are transposed into blocks and evaluated across
+// items with vector trig, agreeing with spa_calculate_elevation to within 1e-11 degrees
+void spa_calculate_elevations(int count, const spa_ephemeris *ephemerides, const spa_observer *observers,
+                              double *elevations);
+
+//-------------------------------------------------------------------------
+// Lean evaluation
+//
+// spa_calculate stores all of spa_data, and the split evaluation stores
+// a spa_ephemeris, when a search only reads the elevation. The lean
+// evaluation keeps the intermediate values in a small working struct and
+// locals, and stores only the groups of them selected in an output mask.
+// It does no validation: the observer is validated once by
+// spa_observer_init, and the time once per query by spa_validate_time.
+//-------------------------------------------------------------------------
+
+typedef enum {
+    SpaOutput_Elevation   = 0,      // Only the corrected elevation angle
+    SpaOutput_Geocentric  = 1 << 0, // nu, alpha, delta and xi
+    SpaOutput_Nutation    = 1 << 1, // del_psi, del_epsilon and epsilon
+    SpaOutput_Topocentric = 1 << 2, // h, del_alpha, delta_prime, h_prime and e0
+} SpaOutput;
+
+typedef struct
+{
+    double e;           // topocentric elevation angle (corrected) [degrees], always set
+
+    //---------------------SpaOutput_Geocentric------------------------
+    double nu;          // Greenwich sidereal time [degrees]
+    double alpha;       // geocentric sun right ascension [degrees]
+    double delta;       // geocentric sun declination [degrees]
+    double xi;          // sun equatorial horizontal parallax [degrees]
+
+    //---------------------SpaOutput_Nutation--------------------------
+    double del_psi;     // nutation longitude [degrees]
+    double del_epsilon; // nutation obliquity [degrees]
+    double epsilon;     // ecliptic true obliquity  [degrees]
+
+    //---------------------SpaOutput_Topocentric-----------------------
+    double h;           // observer hour angle [degrees]
+    double del_alpha;   // sun right ascension parallax [degrees]
+    double delta_prime; // topocentric sun declination [degrees]
+    double h_prime;     // topocentric local hour angle [degrees]
+    double e0;          // topocentric elevation angle (uncorrected) [degrees]
+
+} spa_lean_outputs;
+
+// Range of jd accepted by spa_calculate, -2000-01-01 00:00 to 6000-12-31 23:59:59
+#define SPA_MIN_JD 990575.50000
+#define SPA_MAX_JD 3912880.49999
+// Largest magnitude of delta_t accepted by spa_calculate [seconds]
+#define SPA_MAX_DELTA_T 8000
+// Semidiameter of the sun used for the refraction limit [degrees]
+#define SPA_SUN_RADIUS 0.26667
+
+// Validate jd and delta_t, using the same ranges and error codes as spa_calculate
+SpaError spa_validate_time(double jd, double delta_t);
+
+// Topocentric elevation angle (corrected) [degrees], equal to spa_calculate_elevation of the
+// ephemeris from spa_calculate_ephemeris_nutation with the same nutation (NULL is the full series)
+// The observer must have been successfully initialised, and jd and delta_t validated
+// outputs is a mask of SpaOutput selecting the intermediates to store, intermediates can be NULL
+double spa_calculate_elevation_lean(const spa_observer *observer, double jd, double delta_t,
+                                    spa_nutation *nutation, unsigned outputs, spa_lean_outputs *intermediates);
+
 #endif
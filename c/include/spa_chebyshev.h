@@ -0,0 +1,140 @@
+//
+//  spa_chebyshev.h
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+//  Precomputed Chebyshev tables of the geocentric SPA outputs.
+//
+//  A table covers a range of Julian ephemeris days with fixed length segments. In each segment the right ascension,
+//  declination, earth radius vector, equation of the equinoxes and true obliquity are Chebyshev series fitted to
+//  spa_calculate(). An ephemeris lookup then costs about 60 multiply-adds instead of the full periodic series.
+//
+//  With the default 8 day segments and 12 coefficients the fit error is around 1e-6 arc seconds, below the numerical
+//  noise of the SPA itself. A table for 1900 to 2100 is about 4.4 MB.
+//
+//  The table file is the header below followed directly by the coefficients as native doubles, laid out as
+//  [segment][quantity][coefficient]. Files are written and read in the byte order of the machine, a file from a
+//  machine of the other byte order is rejected. The file can be memory mapped read-only and shared between
+//  processes, see spa_chebyshev_map_file().
+//
+#ifndef SUNRISE_SUNSET_CALCULATOR_SPA_CHEBYSHEV_H
+#define SUNRISE_SUNSET_CALCULATOR_SPA_CHEBYSHEV_H
+
+#include "spa.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define SPA_CHEBYSHEV_MAGIC "SSCCHEB"
+#define SPA_CHEBYSHEV_VERSION 1
+#define SPA_CHEBYSHEV_DEFAULT_SEGMENT_DAYS 8.0
+#define SPA_CHEBYSHEV_DEFAULT_COEFFICIENTS 12
+#define SPA_CHEBYSHEV_MAX_COEFFICIENTS 64
+
+/// The quantities stored for each segment, in file order
+typedef enum {
+    SpaChebyshev_Alpha = 0,               ///< Geocentric sun right ascension, continuous within a segment [degrees]
+    SpaChebyshev_Delta = 1,               ///< Geocentric sun declination [degrees]
+    SpaChebyshev_R = 2,                   ///< Earth radius vector [AU]
+    SpaChebyshev_EquationOfEquinoxes = 3, ///< Greenwich sidereal time minus mean sidereal time [degrees]
+    SpaChebyshev_Epsilon = 4,             ///< Ecliptic true obliquity [degrees]
+    SpaChebyshev_QuantityCount = 5,
+} SpaChebyshevQuantity;
+
+typedef enum {
+    SpaChebyshevError_Success = 0,
+    SpaChebyshevError_Io = 1,            ///< The file could not be read, written or mapped
+    SpaChebyshevError_InvalidFormat = 2, ///< Not a table, an unsupported version or byte order, or truncated
+    SpaChebyshevError_InvalidRange = 3,  ///< Invalid parameters to generate a table with
+} SpaChebyshevError;
+
+/// File header, the coefficients start header_size bytes from the start of the file
+typedef struct {
+    char magic[8];              ///< SPA_CHEBYSHEV_MAGIC, NUL terminated
+    uint32_t version;           ///< SPA_CHEBYSHEV_VERSION
+    uint32_t header_size;       ///< Offset of the coefficients [bytes]
+    uint32_t quantity_count;    ///< SpaChebyshev_QuantityCount
+    uint32_t coefficient_count; ///< Coefficients per quantity per segment, the first is stored halved
+    uint64_t segment_count;     ///< Number of segments
+    double jde_start;           ///< Julian ephemeris day at the start of the first segment
+    double segment_days;        ///< Length of each segment [days]
+    double byte_order;          ///< 1.0 in the byte order of the writer
+    uint64_t reserved;          ///< Zero
+} spa_chebyshev_header;
+
+/// A validated view of a table held in memory, which is not copied
+typedef struct {
+    const spa_chebyshev_header *header; ///< Table header
+    const double *coefficients;         ///< First coefficient of the first segment
+    double jde_end;                     ///< Julian ephemeris day at the end of the last segment
+} spa_chebyshev;
+
+/// Size of the table needed to cover a range
+/// @param jde_start Julian ephemeris day to start from
+/// @param jde_end Julian ephemeris day to cover up to
+/// @param segment_days Length of each segment [days]
+/// @param coefficient_count Coefficients per quantity per segment
+/// @return Size in bytes, 0 if the parameters are invalid
+size_t spa_chebyshev_size(double jde_start, double jde_end, double segment_days, int coefficient_count);
+
+/// Fit a table to spa_calculate() over a range
+/// @param[out] buffer Buffer of at least spa_chebyshev_size() bytes, aligned for double
+/// @param size Size of the buffer [bytes]
+/// @param jde_start Julian ephemeris day to start from
+/// @param jde_end Julian ephemeris day to cover up to
+/// @param segment_days Length of each segment [days]
+/// @param coefficient_count Coefficients per quantity per segment
+/// @return SpaChebyshevError code
+SpaChebyshevError spa_chebyshev_generate(
+    void *buffer, size_t size, double jde_start, double jde_end, double segment_days, int coefficient_count);
+
+/// Validate a table in memory and set up a view of it
+/// @param[out] table View to initialise
+/// @param[in] data Table data, aligned for double, which must outlive the view
+/// @param size Size of the data [bytes]
+/// @return SpaChebyshevError code
+SpaChebyshevError spa_chebyshev_init(spa_chebyshev *table, const void *data, size_t size);
+
+/// Evaluate an ephemeris from a table, usable with spa_calculate_elevation()
+/// @param[in] table Table to evaluate
+/// @param[out] ephemeris Ephemeris to fill
+/// @param jd Julian day
+/// @param delta_t Difference between earth rotation time and terrestrial time
+/// @return SpaError_UnsupportedDate if the time is outside of the table, otherwise as spa_calculate_ephemeris()
+SpaError spa_chebyshev_calculate_ephemeris(const spa_chebyshev *table,
+                                           spa_ephemeris *ephemeris,
+                                           double jd,
+                                           double delta_t);
+
+//-------------------------------------------------------------------------
+// Table files, these need an operating system so are not available in the nostdlib build
+//-------------------------------------------------------------------------
+
+/// A memory mapped table file
+typedef struct {
+    spa_chebyshev table; ///< View of the mapped table
+    void *mapping;       ///< Start of the mapping
+    size_t size;         ///< Size of the mapping [bytes]
+    void *handle;        ///< Platform file mapping handle (Windows only)
+} spa_chebyshev_file;
+
+/// Generate a table and write it to a file
+/// @param path File to write
+/// @param jde_start Julian ephemeris day to start from
+/// @param jde_end Julian ephemeris day to cover up to
+/// @param segment_days Length of each segment [days]
+/// @param coefficient_count Coefficients per quantity per segment
+/// @return SpaChebyshevError code
+SpaChebyshevError spa_chebyshev_write_file(
+    const char *path, double jde_start, double jde_end, double segment_days, int coefficient_count);
+
+/// Map a table file read-only, the pages are shared with other processes mapping the same file
+/// @param[out] file Mapped file to initialise
+/// @param path File to map
+/// @return SpaChebyshevError code
+SpaChebyshevError spa_chebyshev_map_file(spa_chebyshev_file *file, const char *path);
+
+/// Unmap a table file previously mapped by spa_chebyshev_map_file()
+/// @param[in, out] file Mapped file
+void spa_chebyshev_unmap_file(spa_chebyshev_file *file);
+
+#endif //SUNRISE_SUNSET_CALCULATOR_SPA_CHEBYSHEV_H
@@ -0,0 +1,84 @@
+//
+//  spa_float.h
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+//  Single precision Solar Position Algorithm, for processors with a single precision FPU (e.g. Cortex-M4F) and for
+//  wide SIMD batches where float doubles the number of lanes.
+//
+//  The same periodic terms as spa.c are evaluated in float, from float term tables of about 3.6 KB instead of 17.5 KB.
+//  Only the time arguments that grow without bound are reduced in double precision, once per ephemeris: the mean
+//  motion of the earth and the Greenwich mean sidereal time. The observer stage (parallax and refraction) has a float
+//  version too, so a batch of elevations can be evaluated entirely in float.
+//
+//  Error budget against spa.c, see test_spa_float for the measured errors:
+//  - Right ascension, sidereal time and declination within 0.0003 degrees (1 arc second) between 1900 and 2100. The
+//    arguments of the periodic terms grow with the distance from J2000, so over the whole -2000 to 6000 range the
+//    right ascension is within 0.008 degrees and the declination within 0.003 degrees.
+//  - The float observer stage adds under 0.0001 degrees to the elevation.
+//  - Sunrise and sunset within 2 seconds up to the polar circles between 1900 and 2100, and within 5 seconds over the
+//    whole date range.
+//
+#ifndef SUNRISE_SUNSET_CALCULATOR_SPA_FLOAT_H
+#define SUNRISE_SUNSET_CALCULATOR_SPA_FLOAT_H
+
+#include "spa.h"
+
+/// Observer independent part of the algorithm in single precision, see spa_ephemeris
+typedef struct {
+    float nu;        ///< Greenwich sidereal time [degrees]
+    float alpha;     ///< Geocentric sun right ascension [degrees]
+    float delta;     ///< Geocentric sun declination [degrees]
+    float xi;        ///< Sun equatorial horizontal parallax [degrees]
+    float sin_delta; ///< sin of geocentric declination
+    float cos_delta; ///< cos of geocentric declination
+    float sin_xi;    ///< sin of equatorial horizontal parallax
+} spa_float_ephemeris;
+
+/// Precomputed observer constants in single precision, see spa_observer
+typedef struct {
+    float longitude;     ///< Observer longitude (negative west of Greenwich)
+    float sin_lat;       ///< sin of observer latitude
+    float cos_lat;       ///< cos of observer latitude
+    float x;             ///< Parallax term x
+    float y;             ///< Parallax term y
+    float refract_scale; ///< Pressure and temperature factor of the refraction correction
+    float refract_limit; ///< Lowest uncorrected elevation that refraction is applied to [degrees]
+} spa_float_observer;
+
+/// Evaluate an ephemeris with the single precision algorithm
+/// @param[out] ephemeris Ephemeris to fill
+/// @param jd Julian day
+/// @param delta_t Difference between earth rotation time and terrestrial time
+/// @return SpaError code, using the same date range as spa_calculate()
+SpaError spa_float_calculate_ephemeris(spa_float_ephemeris *ephemeris, double jd, double delta_t);
+
+/// Widen a single precision ephemeris, so that it can be used with spa_calculate_elevation()
+/// @param[out] ephemeris Ephemeris to fill
+/// @param[in] source Ephemeris from spa_float_calculate_ephemeris()
+/// @param jd Julian day of the source
+/// @param delta_t Difference between earth rotation time and terrestrial time of the source
+void spa_float_ephemeris_widen(spa_ephemeris *ephemeris, const spa_float_ephemeris *source, double jd, double delta_t);
+
+/// Narrow the constants of an observer to single precision
+/// @param[out] observer Observer to fill
+/// @param[in] source Observer that has been successfully initialised with spa_observer_init()
+void spa_float_observer_init(spa_float_observer *observer, const spa_observer *source);
+
+/// Topocentric elevation angle (corrected) [degrees], see spa_calculate_elevation()
+float spa_float_calculate_elevation(const spa_float_ephemeris *ephemeris, const spa_float_observer *observer);
+
+/// Topocentric elevation angle (uncorrected) [degrees], see spa_calculate_elevation_uncorrected()
+float spa_float_calculate_elevation_uncorrected(const spa_float_ephemeris *ephemeris,
+                                                const spa_float_observer *observer);
+
+/// Apply the atmospheric refraction correction of an observer to an uncorrected elevation angle [degrees]
+float spa_float_observer_refraction_corrected(const spa_float_observer *observer, float e0);
+
+/// Evaluate spa_float_calculate_elevation() for count (ephemeris, observer) pairs
+void spa_float_calculate_elevations(int count,
+                                    const spa_float_ephemeris *ephemerides,
+                                    const spa_float_observer *observers,
+                                    float *elevations);
+
+#endif //SUNRISE_SUNSET_CALCULATOR_SPA_FLOAT_H
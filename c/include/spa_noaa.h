@@ -0,0 +1,29 @@
+//
+//  spa_noaa.h
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+//  Low precision solar ephemeris, as used by the NOAA solar calculator (Meeus, Astronomical Algorithms, chapter 25).
+//
+//  The sun's position is evaluated from a handful of polynomial and periodic terms instead of the full SPA periodic
+//  series, and nutation is reduced to its main term. The observer stage (parallax and refraction) is shared with the
+//  SPA through spa_ephemeris, so only the geocentric position differs.
+//
+//  Against spa_calculate() the right ascension is within 0.01 degrees and the declination within 0.004 degrees
+//  between -1000 and 5000, rising to 0.025 and 0.01 degrees at the ends of the -2000 to 6000 range. Sunrise and
+//  sunset are within 10 seconds up to 60 degrees latitude and within a minute up to the polar circles, see
+//  test_ssc_noaa for the measured errors.
+//
+#ifndef SUNRISE_SUNSET_CALCULATOR_SPA_NOAA_H
+#define SUNRISE_SUNSET_CALCULATOR_SPA_NOAA_H
+
+#include "spa.h"
+
+/// Evaluate an ephemeris with the low precision algorithm, usable with spa_calculate_elevation()
+/// @param[out] ephemeris Ephemeris to fill
+/// @param jd Julian day
+/// @param delta_t Difference between earth rotation time and terrestrial time
+/// @return SpaError code, using the same date range as spa_calculate()
+SpaError spa_noaa_calculate_ephemeris(spa_ephemeris *ephemeris, double jd, double delta_t);
+
+#endif //SUNRISE_SUNSET_CALCULATOR_SPA_NOAA_H
@@ -8,7 +8,11 @@
 #define SUNRISE_SUNSET_CALCULATOR_SSC_H
 
 #include "spa.h"
+#include "spa_chebyshev.h"
+#include "spa_float.h"
+#include "spa_noaa.h"
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 typedef int64_t unix_t;
@@ -17,6 +21,60 @@ typedef int64_t unix_t;
 #define SSC_DEFAULT_TEMPERATURE 16
 #define SSC_DEFAULT_PRESSURE 1013.25
 #define SSC_DEFAULT_ELEVATION 0.0
+#define SSC_DEFAULT_NUTATION_INTERVAL 0.0
+/// Refraction corrected elevation of the centre of the sun at sunrise and sunset [degrees]
+#define SSC_SUNRISE_ELEVATION (-0.8333)
+/// Elevation at the start of morning and the end of evening civil twilight [degrees]
+#define SSC_CIVIL_TWILIGHT_ELEVATION (-6.0)
+/// Elevation at the start of morning and the end of evening nautical twilight [degrees]
+#define SSC_NAUTICAL_TWILIGHT_ELEVATION (-12.0)
+/// Elevation at the start of morning and the end of evening astronomical twilight [degrees]
+#define SSC_ASTRONOMICAL_TWILIGHT_ELEVATION (-18.0)
+/// Elevation at the end of the morning and the start of the evening golden hour [degrees]
+#define SSC_GOLDEN_HOUR_ELEVATION 6.0
+/// A nutation interval that makes nutation almost free in a search, with an error below 0.001 arc seconds
+#define SSC_FAST_NUTATION_INTERVAL 0.25
+
+/// Step size of sunrise_sunset_default_step_size() below SSC_HIGH_LATITUDE [seconds]
+#define SSC_DEFAULT_STEP_SIZE 14400
+/// Absolute latitude from which the default step size is SSC_HIGH_LATITUDE_STEP_SIZE [degrees]
+#define SSC_HIGH_LATITUDE 60.0
+#define SSC_HIGH_LATITUDE_STEP_SIZE 3600
+/// Absolute latitude from which the default step size is SSC_EXTREME_LATITUDE_STEP_SIZE [degrees]
+#define SSC_EXTREME_LATITUDE 64.0
+#define SSC_EXTREME_LATITUDE_STEP_SIZE 600
+
+/// Upper bound on the rate of change of the solar declination, which peaks at about 0.4 [degrees per day]
+#define SSC_MAX_DECLINATION_RATE 0.5
+/// Allowance for the difference between the geocentric and topocentric elevation in the polar skip [degrees]
+#define SSC_PARALLAX_MARGIN 0.01
+/// Polar day and night need at least a day of margin, which is impossible below this latitude even with the strongest
+/// refraction the parameters allow, so the searches only try to skip them above it [degrees]
+#define SSC_POLAR_LATITUDE 60.0
+
+/// How sunrise_sunset_calculate() searches for the change in visibility
+typedef enum {
+    /// Step through time by the step size until the visibility changes, then bisect down to one second.
+    /// Typically 20 to 35 evaluations of the SPA in each direction.
+    SunriseSunsetSearch_Step = 0,
+    /// Predict the event from the sunrise equation, refine it with Newton and secant steps on the SPA elevation, and
+    /// check the change in visibility at whole seconds. Typically 4 or 5 evaluations in each direction.
+    /// Falls back to SunriseSunsetSearch_Step when the sun does not rise or set within a day, or when the refined
+    /// time cannot be verified.
+    SunriseSunsetSearch_Predictor = 1,
+    /// Find the transits and nadirs around the time, between which the elevation only rises or only falls, and refine
+    /// the change in visibility between the pair that brackets it. Typically 6 to 12 evaluations in each direction,
+    /// and bounded whatever the day length, so unlike SunriseSunsetSearch_Step very short days are not skipped and the
+    /// step size is not used.
+    SunriseSunsetSearch_Transit = 2,
+} SunriseSunsetSearch;
+
+/// Which algorithm evaluates the position of the sun
+typedef enum {
+    SunriseSunsetEngine_Spa = 0,      ///< NREL Solar Position Algorithm
+    SunriseSunsetEngine_Noaa = 1,     ///< Low precision NOAA algorithm, see spa_noaa.h for its error bounds
+    SunriseSunsetEngine_SpaFloat = 2, ///< SPA in single precision, see spa_float.h for its error budget
+} SunriseSunsetEngine;
 
 typedef struct {
     unix_t time;          ///< Unix timestamp to calculate sunrise and sunset times around
@@ -32,15 +90,51 @@ typedef struct {
                           ///< possible that a sunrise/sunset may be skipped.
                           ///< It should not be too small or otherwise or the search will take an unreasonable
                           ///< amount of time.
+    SpaNutationSeries nutation; ///< Which nutation series to evaluate, see SpaNutationSeries for error bounds
+    double nutation_interval;   ///< Interpolate nutation linearly between evaluations this many days apart,
+                                ///< instead of evaluating it at every step of the search. 0 disables.
+                                ///< e.g. SSC_FAST_NUTATION_INTERVAL
+    const spa_chebyshev *ephemeris_table; ///< Optional precomputed ephemeris to use instead of the full SPA,
+                                          ///< times outside of the table fall back to the full SPA. NULL disables.
+    SunriseSunsetSearch search;           ///< Search strategy, see SunriseSunsetSearch
+    SunriseSunsetEngine engine;           ///< Algorithm for times not covered by ephemeris_table
 } SunriseSunsetParameters;
 
+/// Statistics of the search in one direction of a sunrise_sunset_calculate_stats() call
+typedef struct {
+    uint32_t evaluations; ///< Evaluations of the SPA
+    uint32_t steps;       ///< Coarse steps of the step search before the change in visibility was found
+    uint32_t bisections;  ///< Bisection depth of the step search, the number of times the step was halved
+    int64_t skipped;      ///< Time jumped over without stepping during polar day or night [seconds]
+    int64_t span;         ///< Time scanned from the input time to the event [seconds]
+} SunriseSunsetSearchStats;
+
+/// Statistics of a sunrise_sunset_calculate_stats() call
+typedef struct {
+    uint32_t evaluations;             ///< Total evaluations of the SPA, including the one at the input time
+    SunriseSunsetSearchStats backward; ///< Search backwards from the input time
+    SunriseSunsetSearchStats forward;  ///< Search forwards from the input time
+} SunriseSunsetStats;
+
+/// Statistics summed over many calls, see sunrise_sunset_stats_add()
+typedef struct {
+    uint64_t calls;           ///< Number of successful calls
+    uint64_t evaluations;     ///< Total evaluations of the SPA
+    uint64_t steps;           ///< Total coarse steps in both directions
+    uint64_t bisections;      ///< Total bisection steps in both directions
+    int64_t skipped;          ///< Total time jumped over during polar day or night [seconds]
+    uint32_t max_evaluations; ///< Most evaluations of the SPA in one call
+    int64_t max_span;         ///< Longest time scanned in one direction of one call [seconds]
+} SunriseSunsetAggregateStats;
+
 /// Provides a sensible default step size for a given latitude
 /// <ul>
 ///   <li> Absolute latitude less than 60 = 4 hour step
 ///   <li> Absolute latitude less than 64 = 1 hour step
 ///   <li> Absolute latitude greater than 64 = 10 minute step
 /// </ul>
-/// Note that at extreme latitudes it is possible that very short days/nights may be skipped.
+/// Note that at extreme latitudes it is possible that very short days/nights may be skipped, which
+/// SunriseSunsetSearch_Transit avoids.
 /// @see <a href="http://time.unitarium.com/events/shortest-day.html">Shortest Day of The Year</a>
 /// @param latitude The latitude of the location to calculate sunrise and sunset times
 /// @return Step size in seconds
@@ -65,4 +159,233 @@ typedef struct {
 /// @return Result of the calculation
 SpaError sunrise_sunset_calculate(const SunriseSunsetParameters *params, SunriseSunsetResult *result);
 
+/// A sunrise or sunset found by sunrise_sunset_events()
+typedef struct {
+    unix_t time; ///< Unix timestamp of the event, the first second with the new visibility
+    bool rise;   ///< True for a sunrise, false for a sunset
+} SunriseSunsetEvent;
+
+/// Find every sunrise and sunset within a time window, in order.
+/// Each search starts from the previous event, so the cost is about one search per event. Whole days where the sun
+/// cannot rise or set (polar day or night) are skipped using the declination, without searching through them.
+/// The search strategy and step size of the parameters are used, their time is ignored.
+/// @param[in] params Input parameters
+/// @param start Unix timestamp to start the window from, events must be after this time
+/// @param end Unix timestamp to end the window at, events may be at this time
+/// @param[out] events Buffer to write the events to
+/// @param capacity Number of events the buffer can hold. If it fills up the search stops early, and can be
+///                 continued with a window starting at the time of the last event.
+/// @param[out] count Number of events written
+/// @return Result of the calculation
+SpaError sunrise_sunset_events(const SunriseSunsetParameters *params,
+                               unix_t start,
+                               unix_t end,
+                               SunriseSunsetEvent *events,
+                               size_t capacity,
+                               size_t *count);
+
+/// Calculate only the sunrise or only the sunset around a time, with the visibility.
+/// Only the direction the event is in is searched (before the time for the sunrise and after it for the sunset while
+/// the sun is visible, the other way round while it is not), about half the cost of sunrise_sunset_calculate(). Polar
+/// day and night are skipped as in sunrise_sunset_events().
+/// @param[in] params Input parameters
+/// @param rise True for the sunrise, false for the sunset
+/// @param[out] result Struct to write results to, the event is the first second of the visibility after it (as in
+///                    sunrise_sunset_calculator_query()) and the other event is 0
+/// @return Result of the calculation
+SpaError sunrise_sunset_calculate_event(const SunriseSunsetParameters *params, bool rise, SunriseSunsetResult *result);
+
+/// A crossing of an elevation threshold found by sunrise_sunset_crossings()
+typedef struct {
+    unix_t time;      ///< Unix timestamp of the crossing, the first second on the new side of the threshold
+    size_t threshold; ///< Index of the threshold that was crossed
+    bool rising;      ///< True if the sun rises to the threshold, false if it sets below it
+} SunriseSunsetCrossing;
+
+/// Find every crossing of a list of elevation thresholds (e.g. sunrise and the three twilights) during the local mean
+/// solar day around the time of the parameters, in time order.
+/// The thresholds are all bracketed from one shared sequence of evaluations, at two hour steps through the day and at
+/// its highest and lowest elevations, and each crossing is then refined with a few more evaluations. So five
+/// thresholds cost little more than a single sunrise search. The thresholds are compared with the refraction corrected
+/// elevation, so SSC_SUNRISE_ELEVATION gives the same events as sunrise_sunset_events().
+/// The search strategy and step size of the parameters are not used.
+/// @param[in] params Input parameters, the day starts at the local mean midnight (from the longitude) before the time,
+///                   crossings must be after this and may be at the end of the day
+/// @param[in] thresholds Refraction corrected elevations [degrees], e.g. SSC_CIVIL_TWILIGHT_ELEVATION. Thresholds
+///                       outside of [-90, 90], or not finite, fail with SpaError_InvalidThreshold.
+/// @param threshold_count Number of thresholds
+/// @param[out] crossings Buffer to write the crossings to
+/// @param capacity Number of crossings the buffer can hold, if there are more only the earliest are written
+/// @param[out] count Number of crossings written
+/// @return Result of the calculation
+SpaError sunrise_sunset_crossings(const SunriseSunsetParameters *params,
+                                  const double *thresholds,
+                                  size_t threshold_count,
+                                  SunriseSunsetCrossing *crossings,
+                                  size_t capacity,
+                                  size_t *count);
+
+/// Solar noon and midnight found by sunrise_sunset_transit()
+typedef struct {
+    unix_t transit;       ///< Solar noon, when the sun crosses the meridian at its highest
+    unix_t nadir;         ///< Solar midnight at the start of the day, when the sun crosses the meridian at its lowest
+    double max_elevation; ///< Refraction corrected elevation at the transit, the highest of the day [degrees]
+    double min_elevation; ///< Refraction corrected elevation at the nadir, the lowest of the day [degrees]
+                          ///< (the declination moves the extremes off the meridian by under a minute, changing
+                          ///< them by well under 0.001°)
+} SunriseSunsetTransit;
+
+/// Find solar noon and the solar midnight before it, for the local mean solar day around the time of the parameters.
+/// Each is found to the nearest second where the local hour angle crosses zero (or 180°), by Newton steps from the
+/// local mean noon (or midnight), usually 2 or 3 evaluations each.
+/// The search strategy and step size of the parameters are not used.
+/// @param[in] params Input parameters
+/// @param[out] transit Struct to write the results to
+/// @return Result of the calculation
+SpaError sunrise_sunset_transit(const SunriseSunsetParameters *params, SunriseSunsetTransit *transit);
+
+/// One day of sunrise_sunset_table()
+typedef struct {
+    unix_t rise;   ///< First sunrise of the day, the first second the sun is visible, if has_rise
+    unix_t set;    ///< First sunset of the day, the first second the sun is not visible, if has_set
+    bool has_rise; ///< If the sun rises during the day
+    bool has_set;  ///< If the sun sets during the day
+    bool visible;  ///< If the sun is visible at the start of the day, so polar day when it neither rises nor sets
+} SunriseSunsetDay;
+
+/// Statistics of a sunrise_sunset_table() call
+typedef struct {
+    uint64_t evaluations; ///< Evaluations of the SPA
+    uint64_t events;      ///< Sunrises and sunsets found
+    uint64_t seeded;      ///< Events found from the same event of the day before
+    uint64_t searched;    ///< Days searched without the events of the day before
+} SunriseSunsetTableStats;
+
+/// Find the sunrise and sunset of each of a run of consecutive local mean solar days, e.g. a year for a site.
+/// Events move by minutes at most from one day to the next, so each is predicted from the same event on the days
+/// before, and refined by Newton steps on the elevation to the pair of whole seconds either side of it, typically 2 or
+/// 3 evaluations per event. A day is searched as sunrise_sunset_events() does with SunriseSunsetSearch_Transit instead
+/// when there are no events on the day before to start from, or where the prediction cannot be trusted: when the sun
+/// meets the horizon at a shallow angle near the polar circles, as events appear or vanish, or near the ends of the
+/// day. The events are the same as those sunrise_sunset_events() finds with SunriseSunsetSearch_Transit.
+/// The search strategy and step size of the parameters are not used.
+/// @param[in] params Input parameters, the first day starts at the local mean midnight (from the longitude) before the
+///                   time
+/// @param day_count Number of days
+/// @param[out] days A day for each of day_count days
+/// @param[out] stats Optional statistics, NULL disables
+/// @return Result of the calculation
+SpaError sunrise_sunset_table(const SunriseSunsetParameters *params,
+                              size_t day_count,
+                              SunriseSunsetDay *days,
+                              SunriseSunsetTableStats *stats);
+
+/// Calculate sunrise and sunset times, and statistics of the calculation.
+/// Gives the same result as sunrise_sunset_calculate(), for working out why some calls are slower than others and for
+/// tuning the step size.
+/// @param[in] params Input parameters
+/// @param[out] result Struct to write results to
+/// @param[out] stats Struct to write statistics to, can be NULL
+/// @return Result of the calculation, the statistics are only complete for SpaError_Success
+SpaError sunrise_sunset_calculate_stats(const SunriseSunsetParameters *params,
+                                        SunriseSunsetResult *result,
+                                        SunriseSunsetStats *stats);
+
+/// Initialise SunriseSunsetAggregateStats with zeros
+/// @param[out] aggregate SunriseSunsetAggregateStats struct to initialise
+void SunriseSunsetAggregateStats_init(SunriseSunsetAggregateStats *aggregate);
+
+/// Add the statistics of a call to an aggregate
+/// @param[in, out] aggregate Aggregate statistics
+/// @param[in] stats Statistics of one call
+void sunrise_sunset_stats_add(SunriseSunsetAggregateStats *aggregate, const SunriseSunsetStats *stats);
+
+/// Add one aggregate to another, e.g. to combine the statistics of separate threads
+/// @param[in, out] aggregate Aggregate statistics
+/// @param[in] other Aggregate statistics to add
+void sunrise_sunset_stats_merge(SunriseSunsetAggregateStats *aggregate, const SunriseSunsetAggregateStats *other);
+
+/// A calculator for one location that caches the interval between the previous and next events, so that queries
+/// within it are answered without evaluating the SPA. Once the time moves past the next event only the event after
+/// it is searched for, other queries outside of the interval recalculate it.
+/// The fields are internal, initialise with SunriseSunsetCalculator_init().
+typedef struct {
+    SunriseSunsetParameters params; ///< Validated parameters
+    bool cached;                    ///< If the interval is valid
+    bool visible;                   ///< If the sun is visible within the interval
+    unix_t interval_start;          ///< Previous event, the first second of the interval
+    unix_t interval_end;            ///< Next event, the first second after the interval
+} SunriseSunsetCalculator;
+
+/// Validate parameters and initialise a SunriseSunsetCalculator with them.
+/// @param[out] calculator SunriseSunsetCalculator struct to initialise
+/// @param[in] params Input parameters, the time is not used
+/// @return SpaError code
+SpaError SunriseSunsetCalculator_init(SunriseSunsetCalculator *calculator, const SunriseSunsetParameters *params);
+
+/// Calculate sunrise and sunset times around a time with a SunriseSunsetCalculator.
+/// Gives the same result as sunrise_sunset_calculate(), except that events are always the first second of the new
+/// visibility, where sunrise_sunset_calculate() may be a second either side.
+/// @param[in, out] calculator Calculator for the location
+/// @param time Unix timestamp to calculate sunrise and sunset times around
+/// @param[out] result Struct to write results to
+/// @return Result of the calculation
+SpaError sunrise_sunset_calculator_query(SunriseSunsetCalculator *calculator, unix_t time, SunriseSunsetResult *result);
+
+/// Structure-of-arrays input for sunrise_sunset_calculate_batch().
+/// The optional per-item columns may be NULL, in which case the shared value is used for every item.
+typedef struct {
+    size_t count;               ///< Number of items in each column
+    const unix_t *time;         ///< Unix timestamps to calculate sunrise and sunset times around
+    const double *latitude;     ///< Latitudes (N) of the locations to calculate for
+    const double *longitude;    ///< Longitudes (E) of the locations to calculate for
+    const double *elevation;    ///< Optional per-item observer elevation [meters]
+    const double *pressure;     ///< Optional per-item annual average local pressure [millibars]
+    const double *temperature;  ///< Optional per-item annual average local temperature [degrees Celsius]
+    const uint32_t *step_size;  ///< Optional per-item step size in seconds.
+                                ///< When NULL sunrise_sunset_default_step_size() of each latitude is used.
+    double delta_t;             ///< Shared difference between earth rotation time and terrestrial time
+    double shared_elevation;    ///< Shared observer elevation [meters]
+    double shared_pressure;     ///< Shared annual average local pressure [millibars]
+    double shared_temperature;  ///< Shared annual average local temperature [degrees Celsius]
+    double atmos_refract;       ///< Shared atmospheric refraction at sunrise and sunset
+    SpaNutationSeries nutation; ///< Which nutation series to evaluate
+    double nutation_interval;   ///< Nutation interpolation interval [days], 0 disables
+    const spa_chebyshev *ephemeris_table; ///< Optional precomputed ephemeris, NULL disables
+    SunriseSunsetEngine engine;           ///< Algorithm for times not covered by ephemeris_table
+} SunriseSunsetBatchInput;
+
+/// Initialise SunriseSunsetBatchInput with required columns and default shared values.
+/// @param[out] input SunriseSunsetBatchInput struct to initialise
+/// @param count Number of items
+/// @param time Unix timestamps to calculate sunrise and sunset times around
+/// @param latitude The latitudes (N) of the locations to calculate for
+/// @param longitude The longitudes (E) of the locations to calculate for
+void SunriseSunsetBatchInput_init(SunriseSunsetBatchInput *input,
+                                  size_t count,
+                                  const unix_t *time,
+                                  const double *latitude,
+                                  const double *longitude);
+
+/// Structure-of-arrays output for sunrise_sunset_calculate_batch(), each column must hold count items.
+/// The result columns of an item are left unspecified if its status is not SpaError_Success.
+typedef struct {
+    unix_t *set;                        ///< Unix timestamps of the closest sunsets
+    unix_t *rise;                       ///< Unix timestamps of the closest sunrises
+    bool *visible;                      ///< If the sun is currently visible
+    SpaError *status;                   ///< Result of the calculation for each item
+    SunriseSunsetAggregateStats *stats; ///< Optional statistics that successful items are added to, NULL disables
+} SunriseSunsetBatchOutput;
+
+/// Calculate sunrise and sunset times for many items.
+/// Each item gives the same result as sunrise_sunset_calculate() would with SunriseSunsetSearch_Step, but the
+/// searches of a block of items are run in lockstep so that the observer dependent stage can be evaluated across
+/// items at once with vector trig (see spa_calculate_elevations()), and the ephemeris is shared between neighbouring
+/// items that are evaluated at the same time. The vector elevations differ from the scalar ones by under 1e-11
+/// degrees, a billionth of a second of solar motion, so a search could only differ at an exact knife edge.
+/// @param[in] input Input columns
+/// @param[out] output Output columns
+/// @return SpaError_Success if every item succeeded, otherwise the status of the first failed item
+SpaError sunrise_sunset_calculate_batch(const SunriseSunsetBatchInput *input, const SunriseSunsetBatchOutput *output);
+
 #endif //SUNRISE_SUNSET_CALCULATOR_SSC_H
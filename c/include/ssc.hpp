@@ -0,0 +1,662 @@
+//
+//  ssc.hpp
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+//  Header only C++17 interface to the library, with the configuration of a calculator chosen at compile time:
+//  - Engine: ssc::Spa or ssc::Noaa, see SunriseSunsetEngine
+//  - Precision: double, or float for the single precision SPA (spa_float.h)
+//  - Search: ssc::StepSearch or ssc::PredictorSearch, see SunriseSunsetSearch
+//  - Outputs: which of ssc::Visible, ssc::Rise and ssc::Set are needed
+//  - Atmosphere: ssc::StandardAtmosphere fixes the pressure, temperature and refraction at their defaults.
+//    ssc::CustomAtmosphere takes them at runtime.
+//
+//  calculate() runs the C library with the engine, precision and search. The visibility alone is a single evaluation
+//  of the engine, only the sunrise or only the sunset is searched for in the one direction it is in with
+//  sunrise_sunset_calculate_event(), and both run sunrise_sunset_calculate(). With the standard atmosphere the
+//  pressure, temperature and refraction are constants rather than members, and the visibility compares the elevation
+//  before refraction with a horizon worked out at compile time.
+//
+//  evaluate() and table() are constexpr, so that small tables can be baked in at compile time (e.g. a year of
+//  sunrises for a fixed site). They run a port of the NOAA engine and of the observer stage, on the same
+//  approximations of the math functions as spa_math.c, and the step search with its polar skip whatever the Search,
+//  and give the same events as the C library with SunriseSunsetEngine_Noaa to within a second. Only a single event is
+//  searched for in one direction, and the standard atmosphere has its horizon worked out once at compile time. They
+//  need the Noaa engine, the periodic terms of the SPA are far past the constant evaluation limits of compilers. A
+//  year of daily events needs a larger -fconstexpr-ops-limit in GCC and -fconstexpr-steps in Clang.
+//
+//  The constants shared with the C library come from spa.h and ssc.h.
+//
+//  Errors are thrown as ssc::Error, and are compile errors in constant evaluation.
+//
+#ifndef SUNRISE_SUNSET_CALCULATOR_SSC_HPP
+#define SUNRISE_SUNSET_CALCULATOR_SSC_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+extern "C" {
+#include "ssc.h"
+}
+
+namespace ssc {
+
+/// NREL Solar Position Algorithm
+struct Spa {};
+/// Low precision NOAA algorithm, see spa_noaa.h for its error bounds
+struct Noaa {};
+
+/// See SunriseSunsetSearch_Step
+struct StepSearch {};
+/// See SunriseSunsetSearch_Predictor
+struct PredictorSearch {};
+
+/// Default pressure, temperature and atmospheric refraction, fixed at compile time
+struct StandardAtmosphere {};
+/// Pressure, temperature and atmospheric refraction set at runtime
+struct CustomAtmosphere {};
+
+/// Outputs of a calculation, combined as a bit mask
+enum Output : unsigned {
+    Visible = 1u, ///< If the sun is currently visible
+    Rise = 2u,    ///< The closest sunrise
+    Set = 4u,     ///< The closest sunset
+    All = Visible | Rise | Set,
+};
+
+/// Result of a calculation, the events that were not asked for are 0
+struct Result {
+    unix_t set;   ///< Unix timestamp of the closest sunset
+    unix_t rise;  ///< Unix timestamp of the closest sunrise
+    bool visible; ///< If the sun is currently visible
+};
+
+/// A failed calculation
+class Error : public std::runtime_error {
+  public:
+    explicit Error(SpaError code) : std::runtime_error("sunrise sunset calculation failed"), code_(code) {}
+
+    SpaError code() const noexcept {
+        return code_;
+    }
+
+  private:
+    SpaError code_;
+};
+
+namespace detail {
+
+//-------------------------------------------------------------------------
+// Math functions usable in constant evaluation, see spa_math.c
+//-------------------------------------------------------------------------
+
+constexpr double pi = 3.14159265358979323846;
+constexpr double deg_to_rad = pi / 180.0;
+constexpr double rad_to_deg = 180.0 / pi;
+
+template <class T> constexpr T floor(T x) {
+    // Values at least this large are whole numbers
+    constexpr T limit = std::is_same<T, float>::value ? T(8388608.0) : T(4503599627370496.0);
+    if (!(x > -limit && x < limit)) {
+        return x;
+    }
+    T truncated = static_cast<T>(static_cast<std::int64_t>(x));
+    return truncated > x ? truncated - T(1) : truncated;
+}
+
+template <class T> constexpr T fabs(T x) {
+    return x < T(0) ? -x : x;
+}
+
+constexpr double limit_degrees(double degrees) {
+    double limited = degrees - 360.0 * floor(degrees / 360.0);
+    return limited < 0.0 ? limited + 360.0 : limited;
+}
+
+/// Reduce x to [-pi/4, pi/4] with pi/2 split in two, so that the multiple of it is exact
+template <class T> constexpr T reduce(T x, int &quadrant) {
+    if constexpr (std::is_same<T, float>::value) {
+        float k = floor(x * 0.63661977236758134308f + 0.5f);
+        quadrant = static_cast<int>(static_cast<std::int32_t>(k) & 3);
+        return (x - k * 1.5703125f) - k * 4.83826794897e-4f;
+    } else {
+        double k = floor(x * 0.63661977236758134308 + 0.5);
+        quadrant = static_cast<int>(static_cast<std::int64_t>(k) & 3);
+        return (x - k * 1.57079632673412561417e+00) - k * 6.07710050650619224932e-11;
+    }
+}
+
+/// Taylor series of sin for |r| <= pi/4, to r^11 in double and r^9 in float
+template <class T> constexpr T sin_kernel(T r) {
+    T r2 = r * r;
+    T sum = std::is_same<T, float>::value ? T(0) : r2 * T(-1.0 / 39916800.0);
+    return r +
+           r * r2 * (T(-1.0 / 6.0) + r2 * (T(1.0 / 120.0) + r2 * (T(-1.0 / 5040.0) + r2 * (T(1.0 / 362880.0) + sum))));
+}
+
+/// Taylor series of cos for |r| <= pi/4, to r^12 in double and r^10 in float
+template <class T> constexpr T cos_kernel(T r) {
+    T r2 = r * r;
+    T sum = std::is_same<T, float>::value ? T(0) : r2 * T(1.0 / 479001600.0);
+    return T(1) +
+           r2 * (T(-1.0 / 2.0) +
+                 r2 * (T(1.0 / 24.0) +
+                       r2 * (T(-1.0 / 720.0) + r2 * (T(1.0 / 40320.0) + r2 * (T(-1.0 / 3628800.0) + sum)))));
+}
+
+template <class T> constexpr T sin(T x) {
+    int quadrant = 0;
+    T r = reduce(x, quadrant);
+    switch (quadrant) {
+    case 0:
+        return sin_kernel(r);
+    case 1:
+        return cos_kernel(r);
+    case 2:
+        return -sin_kernel(r);
+    default:
+        return -cos_kernel(r);
+    }
+}
+
+template <class T> constexpr T cos(T x) {
+    int quadrant = 0;
+    T r = reduce(x, quadrant);
+    switch (quadrant) {
+    case 0:
+        return cos_kernel(r);
+    case 1:
+        return -sin_kernel(r);
+    case 2:
+        return -cos_kernel(r);
+    default:
+        return sin_kernel(r);
+    }
+}
+
+template <class T> constexpr T tan(T x) {
+    int quadrant = 0;
+    T r = reduce(x, quadrant);
+    return (quadrant & 1) ? -cos_kernel(r) / sin_kernel(r) : sin_kernel(r) / cos_kernel(r);
+}
+
+/// atan, reduced below tan(pi/12) and then the series to r^17 in double and r^13 in float
+template <class T> constexpr T atan(T x) {
+    bool negative = x < T(0);
+    T offset = T(0);
+    x = negative ? -x : x;
+    bool inverted = x > T(1);
+    x = inverted ? T(1) / x : x;
+    if (x > T(0.26794919243112270647)) {
+        x = (x * T(1.73205080756887729353) - T(1)) / (T(1.73205080756887729353) + x);
+        offset = T(pi / 6.0);
+    }
+    T r2 = x * x, sum = T(0);
+    for (int n = std::is_same<T, float>::value ? 6 : 8; n >= 1; n--) {
+        sum = r2 * ((n & 1 ? T(-1) : T(1)) / T(2 * n + 1) + sum);
+    }
+    T result = offset + x + x * sum;
+    result = inverted ? T(pi / 2.0) - result : result;
+    return negative ? -result : result;
+}
+
+template <class T> constexpr T atan2(T y, T x) {
+    if (x > T(0)) {
+        return atan(y / x);
+    }
+    if (x < T(0)) {
+        return atan(y / x) + (y < T(0) ? T(-pi) : T(pi));
+    }
+    return y > T(0) ? T(pi / 2.0) : (y < T(0) ? T(-pi / 2.0) : T(0));
+}
+
+/// Square root by Newton's method, after scaling by powers of 4 into [0.25, 1]
+template <class T> constexpr T sqrt(T x) {
+    if (!(x > T(0))) {
+        return T(0);
+    }
+    T scale = T(1);
+    while (x > T(1)) {
+        x /= T(4);
+        scale *= T(2);
+    }
+    while (x < T(0.25)) {
+        x *= T(4);
+        scale /= T(2);
+    }
+    T r = T(1);
+    for (int i = 0; i < 6; i++) {
+        r = T(0.5) * (r + x / r);
+    }
+    return r * scale;
+}
+
+template <class T> constexpr T asin(T x) {
+    return atan2(x, sqrt((T(1) - x) * (T(1) + x)));
+}
+
+template <class T> constexpr T acos(T x) {
+    return atan2(sqrt((T(1) - x) * (T(1) + x)), x);
+}
+
+//-------------------------------------------------------------------------
+// NOAA engine and observer stage, see spa_noaa.c and spa.c
+//-------------------------------------------------------------------------
+
+/// See spa_ephemeris
+template <class T> struct Ephemeris {
+    T nu;        ///< Greenwich sidereal time [degrees]
+    T alpha;     ///< Geocentric sun right ascension [degrees]
+    T delta;     ///< Geocentric sun declination [degrees]
+    T sin_delta; ///< sin of geocentric declination
+    T cos_delta; ///< cos of geocentric declination
+    T sin_xi;    ///< sin of equatorial horizontal parallax
+};
+
+/// See spa_observer
+template <class T> struct Observer {
+    double latitude;  ///< Observer latitude [degrees]
+    T longitude;      ///< Observer longitude (negative west of Greenwich)
+    T sin_lat;        ///< sin of observer latitude
+    T cos_lat;        ///< cos of observer latitude
+    T x;              ///< Parallax term x
+    T y;              ///< Parallax term y
+    T refract_scale;  ///< Pressure and temperature factor of the refraction correction
+    T refract_limit;  ///< Lowest uncorrected elevation that refraction is applied to [degrees]
+};
+
+constexpr void ensure(SpaError code) {
+    if (code != SpaError_Success) {
+        throw Error(code);
+    }
+}
+
+constexpr double jd_from_unix(double t) {
+    return (t / 86400.0) + 2440587.5;
+}
+
+/// The NOAA ephemeris, with the time arguments that grow without bound reduced in double precision, see spa_float.h
+template <class T> constexpr Ephemeris<T> noaa_ephemeris(double jd, double delta_t) {
+    if (jd < SPA_MIN_JD || jd > SPA_MAX_JD) {
+        throw Error(SpaError_UnsupportedDate);
+    }
+    double t = (jd + delta_t / 86400.0 - 2451545.0) / 36525.0;
+    double jc = (jd - 2451545.0) / 36525.0;
+    T l0 = T(limit_degrees(280.46646 + t * (36000.76983 + t * 0.0003032)));
+    T m = T(limit_degrees(357.52911 + t * (35999.05029 - t * 0.0001537)));
+    T omega = T(limit_degrees(125.04 - 1934.136 * t));
+    T nu0 = T(limit_degrees(280.46061837 + 360.98564736629 * (jd - 2451545.0) +
+                            jc * jc * (0.000387933 - jc / 38710000.0)));
+    T tt = T(t), rad = T(deg_to_rad), deg = T(rad_to_deg);
+
+    T e = T(0.016708634) - tt * (T(0.000042037) + tt * T(0.0000001267));
+    T c = sin(m * rad) * (T(1.914602) - tt * (T(0.004817) + tt * T(0.000014))) +
+          sin(T(2) * m * rad) * (T(0.019993) - tt * T(0.000101)) + sin(T(3) * m * rad) * T(0.000289);
+    T r = T(1.000001018) * (T(1) - e * e) / (T(1) + e * cos((m + c) * rad));
+    T sin_omega = sin(omega * rad);
+    T lambda = l0 + c - T(0.00569) - T(0.00478) * sin_omega;
+    T epsilon0 =
+        T(23) + (T(26) + (T(21.448) - tt * (T(46.815) + tt * (T(0.00059) - tt * T(0.001813)))) / T(60)) / T(60);
+    T epsilon = epsilon0 + T(0.00256) * cos(omega * rad);
+    T sin_lambda = sin(lambda * rad);
+
+    Ephemeris<T> ephemeris{};
+    ephemeris.alpha = atan2(cos(epsilon * rad) * sin_lambda, cos(lambda * rad)) * deg;
+    ephemeris.alpha = ephemeris.alpha < T(0) ? ephemeris.alpha + T(360) : ephemeris.alpha;
+    ephemeris.delta = asin(sin(epsilon * rad) * sin_lambda) * deg;
+    ephemeris.nu = nu0 - T(0.00478) * sin_omega * cos(epsilon * rad);
+    ephemeris.sin_delta = sin(ephemeris.delta * rad);
+    ephemeris.cos_delta = cos(ephemeris.delta * rad);
+    ephemeris.sin_xi = sin(T(8.794) / (T(3600) * r) * rad);
+    return ephemeris;
+}
+
+template <class T>
+constexpr Observer<T> make_observer(double latitude,
+                                    double longitude,
+                                    double elevation,
+                                    double pressure,
+                                    double temperature,
+                                    double atmos_refract) {
+    // Same checks as spa_observer_init()
+    ensure(pressure < 0 || pressure > 5000 ? SpaError_InvalidPressure : SpaError_Success);
+    ensure(temperature <= -273 || temperature > 6000 ? SpaError_InvalidTemperature : SpaError_Success);
+    ensure(fabs(longitude) > 180 ? SpaError_InvalidLongitude : SpaError_Success);
+    ensure(fabs(latitude) > 90 ? SpaError_InvalidLatitude : SpaError_Success);
+    ensure(fabs(atmos_refract) > 5 ? SpaError_InvalidAtmosRefract : SpaError_Success);
+    ensure(elevation < -6500000 ? SpaError_InvalidElevation : SpaError_Success);
+
+    double lat_rad = latitude * deg_to_rad;
+    double u = atan(0.99664719 * tan(lat_rad));
+    Observer<T> observer{};
+    observer.latitude = latitude;
+    observer.longitude = T(longitude);
+    observer.sin_lat = T(sin(lat_rad));
+    observer.cos_lat = T(cos(lat_rad));
+    observer.y = T(0.99664719 * sin(u) + elevation * sin(lat_rad) / 6378140.0);
+    observer.x = T(cos(u) + elevation * cos(lat_rad) / 6378140.0);
+    observer.refract_scale = T((pressure / 1010.0) * (283.0 / (273.0 + temperature)) * 1.02);
+    observer.refract_limit = T(-(SPA_SUN_RADIUS + atmos_refract));
+    return observer;
+}
+
+/// See spa_calculate_elevation_uncorrected()
+template <class T> constexpr T elevation_uncorrected(const Ephemeris<T> &ephemeris, const Observer<T> &observer) {
+    T rad = T(deg_to_rad);
+    T h = (ephemeris.nu + observer.longitude - ephemeris.alpha) * rad;
+    T sin_h = sin(h), cos_h = cos(h);
+    T denominator = ephemeris.cos_delta - observer.x * ephemeris.sin_xi * cos_h;
+    T delta_alpha = atan2(-observer.x * ephemeris.sin_xi * sin_h, denominator);
+    T delta_prime = atan2((ephemeris.sin_delta - observer.y * ephemeris.sin_xi) * cos(delta_alpha), denominator);
+    return asin(observer.sin_lat * sin(delta_prime) + observer.cos_lat * cos(delta_prime) * cos(h - delta_alpha)) *
+           T(rad_to_deg);
+}
+
+/// See spa_observer_refraction_corrected()
+template <class T> constexpr T refraction_corrected(const Observer<T> &observer, T e0) {
+    if (!(e0 >= observer.refract_limit)) {
+        return e0;
+    }
+    return e0 + observer.refract_scale / (T(60) * tan((e0 + T(10.3) / (e0 + T(5.11))) * T(deg_to_rad)));
+}
+
+/// See visible_elevation_threshold() in ssc.c
+template <class T> constexpr T visible_threshold(const Observer<T> &observer) {
+    T low = T(-10), high = T(10);
+    for (int i = 0; i < 50; i++) {
+        T mid = (low + high) / T(2);
+        if (refraction_corrected(observer, mid) >= T(SSC_SUNRISE_ELEVATION)) {
+            high = mid;
+        } else {
+            low = mid;
+        }
+    }
+    return high;
+}
+
+/// Pressure, temperature and atmospheric refraction of a calculator, the defaults as constants with
+/// ssc::StandardAtmosphere
+template <class Atmosphere> struct AtmosphereValues {
+    static constexpr double pressure = SSC_DEFAULT_PRESSURE;
+    static constexpr double temperature = SSC_DEFAULT_TEMPERATURE;
+    static constexpr double atmos_refract = SSC_DEFAULT_ATMOSPHERIC_REFRACTION;
+};
+
+/// Stored at runtime with ssc::CustomAtmosphere
+template <> struct AtmosphereValues<CustomAtmosphere> {
+    double pressure = SSC_DEFAULT_PRESSURE;
+    double temperature = SSC_DEFAULT_TEMPERATURE;
+    double atmos_refract = SSC_DEFAULT_ATMOSPHERIC_REFRACTION;
+};
+
+/// See sunrise_sunset_default_step_size()
+constexpr std::uint32_t default_step_size(double latitude) {
+    double latitude_abs = fabs(latitude);
+    return latitude_abs < SSC_HIGH_LATITUDE
+               ? SSC_DEFAULT_STEP_SIZE
+               : (latitude_abs < SSC_EXTREME_LATITUDE ? SSC_HIGH_LATITUDE_STEP_SIZE : SSC_EXTREME_LATITUDE_STEP_SIZE);
+}
+
+//-------------------------------------------------------------------------
+// Step search, see ssc.c
+//-------------------------------------------------------------------------
+
+/// Location and configuration of a constant evaluated search
+template <class T> struct Search {
+    Observer<T> observer;
+    double delta_t;
+    T horizon; ///< Uncorrected elevation at which the sun becomes visible [degrees]
+
+    constexpr Ephemeris<T> ephemeris(double time) const {
+        return noaa_ephemeris<T>(jd_from_unix(time), delta_t);
+    }
+
+    /// Visibility from an ephemeris, comparing the uncorrected elevation with the horizon so that the refraction
+    /// correction is not evaluated
+    constexpr bool visible(const Ephemeris<T> &ephemeris) const {
+        return elevation_uncorrected(ephemeris, observer) >= horizon;
+    }
+
+    /// See polar_skip()
+    constexpr std::int64_t polar_skip(const Ephemeris<T> &ephemeris, bool is_visible) const {
+        double delta = double(ephemeris.delta);
+        double margin = is_visible ? (fabs(observer.latitude + delta) - 90.0) - double(horizon)
+                                   : double(horizon) - (90.0 - fabs(observer.latitude - delta));
+        double seconds = floor((margin - SSC_PARALLAX_MARGIN) / SSC_MAX_DECLINATION_RATE * 86400.0);
+        return seconds > 0.0 ? static_cast<std::int64_t>(seconds) : 0;
+    }
+
+    /// See search_for_change_in_visibility()
+    constexpr unix_t step(unix_t start, std::int64_t step_size, bool currently_visible) const {
+        std::int64_t step_abs = step_size > 0 ? step_size : -step_size;
+        bool polar = fabs(observer.latitude) >= SSC_POLAR_LATITUDE, bracketed = false;
+        while (step_size != 0) {
+            Ephemeris<T> current = ephemeris(static_cast<double>(start));
+            if (visible(current) != currently_visible) {
+                step_size = -(step_size / 2);
+                currently_visible = !currently_visible;
+                bracketed = true;
+            } else {
+                std::int64_t steps = 1;
+                if (polar && !bracketed) {
+                    std::int64_t skip_steps = polar_skip(current, currently_visible) / step_abs;
+                    steps = skip_steps > 1 ? skip_steps : 1;
+                }
+                start += steps * step_size;
+            }
+        }
+        return start;
+    }
+};
+
+} // namespace detail
+
+/// Sunrise and sunset calculator for one location, configured at compile time, see the top of this file.
+template <class Engine = Spa,
+          class Precision = double,
+          class SearchStrategy = PredictorSearch,
+          unsigned Outputs = All,
+          class Atmosphere = StandardAtmosphere>
+class Calculator {
+    static_assert(std::is_same<Engine, Spa>::value || std::is_same<Engine, Noaa>::value,
+                  "Engine must be ssc::Spa or ssc::Noaa");
+    static_assert(std::is_same<Precision, double>::value || std::is_same<Precision, float>::value,
+                  "Precision must be double or float");
+    static_assert(std::is_same<SearchStrategy, StepSearch>::value ||
+                      std::is_same<SearchStrategy, PredictorSearch>::value,
+                  "Search must be ssc::StepSearch or ssc::PredictorSearch");
+    static_assert(Outputs != 0 && (Outputs & ~unsigned(All)) == 0, "Outputs must be a mask of ssc::Output");
+    static_assert(std::is_same<Atmosphere, StandardAtmosphere>::value ||
+                      std::is_same<Atmosphere, CustomAtmosphere>::value,
+                  "Atmosphere must be ssc::StandardAtmosphere or ssc::CustomAtmosphere");
+
+    static constexpr bool custom_atmosphere = std::is_same<Atmosphere, CustomAtmosphere>::value;
+
+  public:
+    using engine_type = Engine;
+    using precision_type = Precision;
+
+    /// The engine that calculate() runs. The NOAA engine of the C library is double precision only, so float only
+    /// applies to evaluate() there.
+    static constexpr SunriseSunsetEngine engine =
+        std::is_same<Engine, Noaa>::value
+            ? SunriseSunsetEngine_Noaa
+            : (std::is_same<Precision, float>::value ? SunriseSunsetEngine_SpaFloat : SunriseSunsetEngine_Spa);
+    static constexpr SunriseSunsetSearch search =
+        std::is_same<SearchStrategy, StepSearch>::value ? SunriseSunsetSearch_Step : SunriseSunsetSearch_Predictor;
+
+    /// @param latitude The latitude (N) of the location to calculate for
+    /// @param longitude The longitude (E) of the location to calculate for
+    /// @param elevation Observer elevation [meters]
+    constexpr Calculator(double latitude, double longitude, double elevation = SSC_DEFAULT_ELEVATION)
+        : latitude_(latitude), longitude_(longitude), elevation_(elevation), atmosphere_(), delta_t_(0.0),
+          step_size_(detail::default_step_size(latitude)) {}
+
+    /// Only with ssc::CustomAtmosphere
+    /// @param pressure Annual average local pressure [millibars]
+    /// @param temperature Annual average local temperature [degrees Celsius]
+    /// @param atmos_refract Atmospheric refraction at sunrise and sunset
+    constexpr Calculator(double latitude,
+                         double longitude,
+                         double elevation,
+                         double pressure,
+                         double temperature,
+                         double atmos_refract)
+        : latitude_(latitude), longitude_(longitude), elevation_(elevation), atmosphere_(), delta_t_(0.0),
+          step_size_(detail::default_step_size(latitude)) {
+        static_assert(custom_atmosphere, "The atmosphere can only be set with ssc::CustomAtmosphere");
+        if constexpr (custom_atmosphere) {
+            atmosphere_.pressure = pressure;
+            atmosphere_.temperature = temperature;
+            atmosphere_.atmos_refract = atmos_refract;
+        }
+    }
+
+    /// Copy with a difference between earth rotation time and terrestrial time
+    constexpr Calculator with_delta_t(double delta_t) const {
+        Calculator copy = *this;
+        copy.delta_t_ = delta_t;
+        return copy;
+    }
+
+    /// Copy with a step size for the step search [seconds], see SunriseSunsetParameters
+    constexpr Calculator with_step_size(std::uint32_t step_size) const {
+        Calculator copy = *this;
+        copy.step_size_ = step_size;
+        return copy;
+    }
+
+    /// Parameters for the C library
+    /// @param time Unix timestamp to calculate sunrise and sunset times around
+    SunriseSunsetParameters parameters(unix_t time) const {
+        SunriseSunsetParameters params;
+        SunriseSunsetParameters_init(&params, time, latitude_, longitude_);
+        params.delta_t = delta_t_;
+        params.elevation = elevation_;
+        params.pressure = atmosphere_.pressure;
+        params.temperature = atmosphere_.temperature;
+        params.atmos_refract = atmosphere_.atmos_refract;
+        params.step_size = step_size_;
+        params.search = search;
+        params.engine = engine;
+        return params;
+    }
+
+    /// Calculate with the C library, see the top of this file for what the configuration changes
+    /// @param time Unix timestamp to calculate sunrise and sunset times around
+    Result calculate(unix_t time) const {
+        SunriseSunsetParameters params = parameters(time);
+        Result result{0, 0, false};
+        if constexpr ((Outputs & (Rise | Set)) == 0) {
+            result.visible = visible_now(params);
+        } else {
+            SunriseSunsetResult c_result;
+            if constexpr ((Outputs & (Rise | Set)) == (Rise | Set)) {
+                detail::ensure(sunrise_sunset_calculate(&params, &c_result));
+            } else {
+                detail::ensure(sunrise_sunset_calculate_event(&params, (Outputs & Rise) != 0, &c_result));
+            }
+            result.set = c_result.set;
+            result.rise = c_result.rise;
+            result.visible = c_result.visible;
+        }
+        return result;
+    }
+
+    /// Calculate in constant evaluation, with the NOAA engine
+    /// @param time Unix timestamp to calculate sunrise and sunset times around
+    constexpr Result evaluate(unix_t time) const {
+        static_assert(std::is_same<Engine, Noaa>::value, "Constant evaluation needs the ssc::Noaa engine");
+        using T = Precision;
+        detail::ensure(detail::fabs(delta_t_) > SPA_MAX_DELTA_T ? SpaError_InvalidDeltaT : SpaError_Success);
+        detail::Search<T> context{detail::make_observer<T>(latitude_,
+                                                           longitude_,
+                                                           elevation_,
+                                                           atmosphere_.pressure,
+                                                           atmosphere_.temperature,
+                                                           atmosphere_.atmos_refract),
+                                  delta_t_,
+                                  T(0)};
+        if constexpr (custom_atmosphere) {
+            context.horizon = detail::visible_threshold(context.observer);
+        } else {
+            context.horizon = standard_horizon<T>;
+        }
+
+        detail::Ephemeris<T> ephemeris = context.ephemeris(static_cast<double>(time));
+        Result result{0, 0, context.visible(ephemeris)};
+        if constexpr ((Outputs & (Rise | Set)) != 0) {
+            // The sun rose before the time if it is visible, and sets after it
+            if (Outputs & (result.visible ? Rise : Set)) {
+                (result.visible ? result.rise : result.set) = context.step(time, -step_size(), result.visible);
+            }
+            if (Outputs & (result.visible ? Set : Rise)) {
+                (result.visible ? result.set : result.rise) = context.step(time, step_size(), result.visible);
+            }
+        }
+        return result;
+    }
+
+    /// Calculate a table in constant evaluation, see evaluate()
+    /// @param start Unix timestamp of the first entry
+    /// @param interval Time between entries [seconds]
+    template <std::size_t N> constexpr std::array<Result, N> table(unix_t start, std::int64_t interval) const {
+        std::array<Result, N> results{};
+        for (std::size_t i = 0; i < N; i++) {
+            results[i] = evaluate(start + static_cast<std::int64_t>(i) * interval);
+        }
+        return results;
+    }
+
+  private:
+    /// Uncorrected elevation at which the sun becomes visible with the standard atmosphere [degrees]
+    template <class T>
+    static constexpr T standard_horizon = detail::visible_threshold(detail::make_observer<T>(
+        0.0, 0.0, 0.0, SSC_DEFAULT_PRESSURE, SSC_DEFAULT_TEMPERATURE, SSC_DEFAULT_ATMOSPHERIC_REFRACTION));
+
+    constexpr std::int64_t step_size() const {
+        return static_cast<std::int64_t>(step_size_);
+    }
+
+    /// The visibility alone, a single evaluation of the engine
+    static bool visible_now(const SunriseSunsetParameters &params) {
+        spa_observer observer;
+        spa_ephemeris ephemeris;
+        double jd = static_cast<double>(params.time) / 86400.0 + 2440587.5;
+        detail::ensure(spa_observer_init(&observer,
+                                         params.latitude,
+                                         params.longitude,
+                                         params.elevation,
+                                         params.pressure,
+                                         params.temperature,
+                                         params.atmos_refract));
+        if constexpr (engine == SunriseSunsetEngine_SpaFloat) {
+            spa_float_ephemeris narrow;
+            detail::ensure(spa_float_calculate_ephemeris(&narrow, jd, params.delta_t));
+            spa_float_ephemeris_widen(&ephemeris, &narrow, jd, params.delta_t);
+        } else if constexpr (engine == SunriseSunsetEngine_Noaa) {
+            detail::ensure(spa_noaa_calculate_ephemeris(&ephemeris, jd, params.delta_t));
+        } else {
+            detail::ensure(spa_calculate_ephemeris(&ephemeris, jd, params.delta_t));
+        }
+        if constexpr (custom_atmosphere) {
+            return spa_calculate_elevation(&ephemeris, &observer) >= SSC_SUNRISE_ELEVATION;
+        } else {
+            return spa_calculate_elevation_uncorrected(&ephemeris, &observer) >= standard_horizon<double>;
+        }
+    }
+
+    double latitude_;
+    double longitude_;
+    double elevation_;
+    detail::AtmosphereValues<Atmosphere> atmosphere_;
+    double delta_t_;
+    std::uint32_t step_size_;
+};
+
+} // namespace ssc
+
+#endif //SUNRISE_SUNSET_CALCULATOR_SSC_HPP
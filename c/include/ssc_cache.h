@@ -0,0 +1,87 @@
+//
+//  ssc_cache.h
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+//  An opt-in cache of results shared by every thread of a process, for request streams where most queries are at a
+//  few thousand locations but at times scattered across the day.
+//
+//  Each entry is the interval between the events found by one sunrise_sunset_calculate() call, keyed by the location
+//  rounded to the resolution of the cache and a hash of the other parameters (everything but the time). A query hits
+//  when an entry with its key has an interval containing its time, and is answered with the events of that interval.
+//  The events of a hit can differ by a second from those a new search would find, as the search may land either side
+//  of the first second of the new visibility.
+//
+//  Entries are kept in a fixed number of buckets of SSC_CACHE_WAYS, so the memory used does not grow after creation.
+//  A full bucket replaces its least recently used entry. The buckets are split between shards that each have their
+//  own lock and counters, so threads querying different locations rarely wait for each other. The search itself runs
+//  without holding a lock.
+//
+//  Uses POSIX threads, or Windows threads on Windows.
+//
+#ifndef SUNRISE_SUNSET_CALCULATOR_SSC_CACHE_H
+#define SUNRISE_SUNSET_CALCULATOR_SSC_CACHE_H
+
+#include "ssc.h"
+
+#define SSC_CACHE_DEFAULT_ENTRIES (1 << 16)
+/// About 110 m, which usually moves the events by well under a second from those of the exact location
+#define SSC_CACHE_DEFAULT_RESOLUTION 0.001
+#define SSC_CACHE_DEFAULT_SHARDS 64
+/// Entries in each bucket, any of which can hold the intervals of a location
+#define SSC_CACHE_WAYS 8
+
+/// Configuration of a SunriseSunsetCache
+typedef struct {
+    size_t entries;    ///< Most intervals kept, rounded up to a power of two number of buckets
+    double resolution; ///< Latitudes and longitudes are rounded to a multiple of this and the events are those of the
+                       ///< rounded location, so nearby queries share entries [degrees]. 0 keys on the exact location,
+                       ///< otherwise between 1e-9 and 1.
+    size_t shards;     ///< Number of independently locked groups of buckets, rounded up to a power of two
+} SunriseSunsetCacheConfig;
+
+/// Counters since the cache was created, summed over every shard
+typedef struct {
+    uint64_t hits;      ///< Queries answered from an entry
+    uint64_t misses;    ///< Queries that were calculated
+    uint64_t stores;    ///< Intervals added
+    uint64_t evictions; ///< Intervals replaced by a newer one to make space
+    uint64_t entries;   ///< Intervals held now
+    uint64_t capacity;  ///< Most intervals that can be held
+} SunriseSunsetCacheStats;
+
+/// A cache shared between threads, the fields are internal
+typedef struct SunriseSunsetCache SunriseSunsetCache;
+
+/// Initialise SunriseSunsetCacheConfig with the default values
+/// @param[out] config SunriseSunsetCacheConfig struct to initialise
+void SunriseSunsetCacheConfig_init(SunriseSunsetCacheConfig *config);
+
+/// Allocate an empty cache
+/// @param[in] config Configuration
+/// @return The cache, or NULL if the configuration is not valid or there is not enough memory
+SunriseSunsetCache *sunrise_sunset_cache_create(const SunriseSunsetCacheConfig *config);
+
+/// Free a cache, which must not be in use by any other thread
+/// @param[in] cache Cache to free, can be NULL
+void sunrise_sunset_cache_destroy(SunriseSunsetCache *cache);
+
+/// Calculate sunrise and sunset times, from the cache if an entry contains the time and otherwise with
+/// sunrise_sunset_calculate() at the rounded location, adding the result to the cache. Can be called from any number
+/// of threads at once.
+/// @param[in] cache Cache to use
+/// @param[in] params Input parameters
+/// @param[out] result Struct to write results to
+/// @param[out] hit Optional, set to whether the result came from the cache
+/// @return Result of the calculation, failed calculations are not cached
+SpaError sunrise_sunset_cache_calculate(SunriseSunsetCache *cache,
+                                        const SunriseSunsetParameters *params,
+                                        SunriseSunsetResult *result,
+                                        bool *hit);
+
+/// Read the counters of a cache, which can be called while other threads use it
+/// @param[in] cache Cache to read
+/// @param[out] stats Counters
+void sunrise_sunset_cache_stats(SunriseSunsetCache *cache, SunriseSunsetCacheStats *stats);
+
+#endif //SUNRISE_SUNSET_CALCULATOR_SSC_CACHE_H
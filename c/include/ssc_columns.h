@@ -0,0 +1,164 @@
+//
+//  ssc_columns.h
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+//  A fixed width columnar binary format for batches of sunrise and sunset calculations.
+//
+//  A columns file is the header below followed by one column per field that is present, each holding row_count
+//  values of a fixed width and starting on a multiple of SSC_COLUMNS_ALIGNMENT bytes. The columns have the types
+//  of sunrise_sunset_calculate_batch(), so a view of a mapped file can be passed to it directly and the results
+//  are written straight into the mapped output columns (see ssc_columns_batch_init()).
+//
+//  Like the Chebyshev table files, columns files are written and read in the byte order of the machine, and a file
+//  from a machine of the other byte order is rejected.
+//
+#ifndef SUNRISE_SUNSET_CALCULATOR_SSC_COLUMNS_H
+#define SUNRISE_SUNSET_CALCULATOR_SSC_COLUMNS_H
+
+#include "ssc.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define SSC_COLUMNS_MAGIC "SSCCOLS"
+#define SSC_COLUMNS_VERSION 1
+/// Columns start on a multiple of this many bytes, a cache line, so that they suit any vector width
+#define SSC_COLUMNS_ALIGNMENT 64
+
+/// The columns a file can hold, in file order
+typedef enum {
+    SscColumn_Time = 0,        ///< unix_t, Unix timestamps to calculate sunrise and sunset times around
+    SscColumn_Latitude = 1,    ///< double, latitudes (N) [degrees]
+    SscColumn_Longitude = 2,   ///< double, longitudes (E) [degrees]
+    SscColumn_Elevation = 3,   ///< double, observer elevations [meters]
+    SscColumn_Pressure = 4,    ///< double, annual average local pressures [millibars]
+    SscColumn_Temperature = 5, ///< double, annual average local temperatures [degrees Celsius]
+    SscColumn_Rise = 6,        ///< unix_t, closest sunrises
+    SscColumn_Set = 7,         ///< unix_t, closest sunsets
+    SscColumn_Visible = 8,     ///< bool (one byte), if the sun is visible
+    SscColumn_Status = 9,      ///< SpaError (four bytes), result of the calculation
+    SscColumn_Count = 10,
+} SscColumn;
+
+/// Column mask bit of a column
+#define SSC_COLUMN(column) (1u << (column))
+/// The columns sunrise_sunset_calculate_batch() needs as input
+#define SSC_COLUMNS_INPUT                                                                                              \
+    (SSC_COLUMN(SscColumn_Time) | SSC_COLUMN(SscColumn_Latitude) | SSC_COLUMN(SscColumn_Longitude))
+/// The optional per-row atmosphere columns, all or none of which must be present
+#define SSC_COLUMNS_ATMOSPHERE                                                                                         \
+    (SSC_COLUMN(SscColumn_Elevation) | SSC_COLUMN(SscColumn_Pressure) | SSC_COLUMN(SscColumn_Temperature))
+/// The columns sunrise_sunset_calculate_batch() writes
+#define SSC_COLUMNS_RESULT                                                                                             \
+    (SSC_COLUMN(SscColumn_Rise) | SSC_COLUMN(SscColumn_Set) | SSC_COLUMN(SscColumn_Visible) |                        \
+     SSC_COLUMN(SscColumn_Status))
+
+typedef enum {
+    SscColumnsError_Success = 0,
+    SscColumnsError_Io = 1,             ///< The file could not be read, written or mapped
+    SscColumnsError_InvalidFormat = 2,  ///< Not a columns file, an unsupported version or byte order, or truncated
+    SscColumnsError_InvalidColumns = 3, ///< The buffer is too small, or the columns needed are missing
+} SscColumnsError;
+
+/// File header, each present column starts offsets[column] bytes from the start of the file
+typedef struct {
+    char magic[8];                     ///< SSC_COLUMNS_MAGIC, NUL terminated
+    uint32_t version;                  ///< SSC_COLUMNS_VERSION
+    uint32_t header_size;              ///< Size of this header [bytes]
+    uint64_t row_count;                ///< Number of values in each column
+    uint32_t column_mask;              ///< SSC_COLUMN() of each column present
+    uint32_t alignment;                ///< SSC_COLUMNS_ALIGNMENT
+    double byte_order;                 ///< 1.0 in the byte order of the writer
+    uint64_t offsets[SscColumn_Count]; ///< Offset of each column, 0 if it is not present [bytes]
+    uint32_t widths[SscColumn_Count];  ///< Size of each value of each column [bytes]
+} ssc_columns_header;
+
+/// A validated view of columns held in memory, which are not copied. Columns that are not present are NULL.
+typedef struct {
+    ssc_columns_header *header; ///< Header
+    size_t row_count;           ///< Number of values in each column
+    unix_t *time;
+    double *latitude;
+    double *longitude;
+    double *elevation;
+    double *pressure;
+    double *temperature;
+    unix_t *rise;
+    unix_t *set;
+    bool *visible;
+    SpaError *status;
+} ssc_columns;
+
+/// Size of a buffer or file holding columns
+/// @param row_count Number of rows
+/// @param column_mask SSC_COLUMN() of each column
+/// @return Size in bytes, 0 if the columns or the size are too large
+size_t ssc_columns_size(size_t row_count, uint32_t column_mask);
+
+/// Write a header into a buffer and set up a view of its columns, the values of the columns are left as they are
+/// @param[out] columns View to initialise
+/// @param[out] buffer Buffer of at least ssc_columns_size() bytes, aligned for double (and to SSC_COLUMNS_ALIGNMENT
+///             for the columns to be aligned, as mappings are)
+/// @param size Size of the buffer [bytes]
+/// @param row_count Number of rows
+/// @param column_mask SSC_COLUMN() of each column
+/// @return SscColumnsError code
+SscColumnsError
+ssc_columns_create(ssc_columns *columns, void *buffer, size_t size, size_t row_count, uint32_t column_mask);
+
+/// Validate columns in memory and set up a view of them
+/// @param[out] columns View to initialise
+/// @param[in] data Columns data, aligned as for ssc_columns_create(), which must outlive the view. The view is
+///             writable, but must not be written through if the data is not.
+/// @param size Size of the data [bytes]
+/// @return SscColumnsError code
+SscColumnsError ssc_columns_init(ssc_columns *columns, void *data, size_t size);
+
+/// Set up batch input and output over a range of rows of a view, so that sunrise_sunset_calculate_batch() reads the
+/// input columns and writes the result columns in place. The input is initialised with SunriseSunsetBatchInput_init(),
+/// and its shared values can be changed afterwards.
+/// @param[in] columns View with the input columns, and the result columns if output is not NULL
+/// @param first First row of the range
+/// @param count Number of rows in the range
+/// @param[out] input Batch input to initialise
+/// @param[out] output Optional batch output to initialise, NULL disables
+/// @return SscColumnsError_InvalidColumns if the range or any of the columns needed are missing
+SscColumnsError ssc_columns_batch_init(const ssc_columns *columns,
+                                       size_t first,
+                                       size_t count,
+                                       SunriseSunsetBatchInput *input,
+                                       SunriseSunsetBatchOutput *output);
+
+//-------------------------------------------------------------------------
+// Columns files, these need an operating system so are not available in the nostdlib build
+//-------------------------------------------------------------------------
+
+/// A memory mapped columns file
+typedef struct {
+    ssc_columns columns; ///< View of the mapped columns
+    void *mapping;       ///< Start of the mapping
+    size_t size;         ///< Size of the mapping [bytes]
+    void *handle;        ///< Platform file mapping handle (Windows only)
+} ssc_columns_file;
+
+/// Create (or replace) a columns file and map it writable, values written to the columns are written to the file
+/// @param[out] file Mapped file to initialise
+/// @param path File to create
+/// @param row_count Number of rows
+/// @param column_mask SSC_COLUMN() of each column, the values start zeroed
+/// @return SscColumnsError code
+SscColumnsError
+ssc_columns_create_file(ssc_columns_file *file, const char *path, size_t row_count, uint32_t column_mask);
+
+/// Map a columns file, the pages are shared with other processes mapping the same file
+/// @param[out] file Mapped file to initialise
+/// @param path File to map
+/// @param writable If values written to the columns are written to the file, otherwise they must not be written
+/// @return SscColumnsError code
+SscColumnsError ssc_columns_map_file(ssc_columns_file *file, const char *path, bool writable);
+
+/// Unmap a columns file previously mapped by ssc_columns_create_file() or ssc_columns_map_file()
+/// @param[in, out] file Mapped file
+void ssc_columns_unmap_file(ssc_columns_file *file);
+
+#endif //SUNRISE_SUNSET_CALCULATOR_SSC_COLUMNS_H
@@ -0,0 +1,149 @@
+//
+//  ssc_daemon.h
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+//  The protocol of the sscd query daemon, and a client for it.
+//
+//  sscd listens on a Unix domain socket, so it is only reachable from the same machine. Every message in either
+//  direction is a header followed by count fixed size records, all in the native byte order of the machine.
+//  A client can send any number of requests before reading the responses (pipelining), though the daemon stops reading
+//  after SSC_DAEMON_MAX_IN_FLIGHT until the client reads responses. Each request is answered by one response with the
+//  same id, but calculations are run on a pool of threads so responses to different requests can arrive in a
+//  different order to the requests.
+//
+//  Results are cached by the daemon in a SunriseSunsetCache (see ssc_cache.h) shared between all of its clients. A
+//  query hits the cache when an earlier query at the same location with the same search and engine found an interval
+//  between events that contains its time. A hit returns the events of that interval, which can differ by a second from
+//  those a new search would find.
+//
+#ifndef SUNRISE_SUNSET_CALCULATOR_SSC_DAEMON_H
+#define SUNRISE_SUNSET_CALCULATOR_SSC_DAEMON_H
+
+#include "ssc.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define SSC_DAEMON_MAGIC 0x44435353u // "SSCD"
+/// Most queries in a single request
+#define SSC_DAEMON_MAX_QUERIES 65536
+/// Most requests of a connection that the daemon reads ahead of writing their responses, after which it stops reading
+/// the connection until the client reads a response
+#define SSC_DAEMON_MAX_IN_FLIGHT 32
+/// Seconds the daemon waits to write a response to a client that is not reading them, before dropping the client
+#define SSC_DAEMON_SEND_TIMEOUT 10
+/// Buckets of the latency histogram, bucket i counts requests that took less than 2^i microseconds (and at least
+/// 2^(i-1)), and the last bucket counts everything slower
+#define SSC_DAEMON_LATENCY_BUCKETS 24
+
+/// Types of message, a response has the type of its request
+typedef enum {
+    SscDaemonMessage_Calculate = 1, ///< Records are ssc_daemon_query, answered with one ssc_daemon_result per query
+    SscDaemonMessage_Stats = 2,     ///< No records, answered with one ssc_daemon_stats
+    SscDaemonMessage_Shutdown = 3,  ///< No records, answered with no records. The daemon stops accepting connections
+                                    ///< and exits once the calculations already queued are answered.
+} SscDaemonMessage;
+
+/// Header of every message
+typedef struct {
+    uint32_t magic;  ///< SSC_DAEMON_MAGIC
+    uint16_t type;   ///< SscDaemonMessage
+    uint8_t search;  ///< SunriseSunsetSearch of a calculation
+    uint8_t engine;  ///< SunriseSunsetEngine of a calculation
+    uint32_t id;     ///< Chosen by the client, and copied to the response
+    uint32_t count;  ///< Number of records that follow
+} ssc_daemon_header;
+
+/// A query of a calculation, the other parameters are the defaults of SunriseSunsetParameters_init()
+typedef struct {
+    unix_t time;      ///< Unix timestamp to calculate sunrise and sunset times around
+    double latitude;  ///< The latitude (N) of the location to calculate for
+    double longitude; ///< The longitude (E) of the location to calculate for
+} ssc_daemon_query;
+
+/// The result of a query, in the order of the queries
+typedef struct {
+    unix_t rise;     ///< Unix timestamp of the closest sunrise
+    unix_t set;      ///< Unix timestamp of the closest sunset
+    int32_t status;  ///< SpaError of the calculation, the events are unspecified unless it is SpaError_Success
+    uint8_t visible; ///< If the sun is currently visible
+    uint8_t cached;  ///< If the result came from the cache
+    uint16_t reserved;
+} ssc_daemon_result;
+
+/// Counters since the daemon started
+typedef struct {
+    uint64_t connections;     ///< Connections accepted
+    uint64_t requests;        ///< Requests answered, of every type
+    uint64_t queries;         ///< Queries calculated or found in the cache
+    uint64_t cache_hits;      ///< Queries found in the cache
+    uint64_t cache_misses;    ///< Queries calculated
+    uint64_t queue_depth;     ///< Calculations waiting for a worker now
+    uint64_t max_queue_depth; ///< Most calculations that have waited for a worker at once
+    uint64_t workers;         ///< Threads calculating
+    uint64_t latency[SSC_DAEMON_LATENCY_BUCKETS]; ///< Calculations by time from receipt to response, see
+                                                  ///< SSC_DAEMON_LATENCY_BUCKETS
+} ssc_daemon_stats;
+
+//-------------------------------------------------------------------------
+// Client, which needs Unix domain sockets so is not available on Windows
+//-------------------------------------------------------------------------
+
+typedef enum {
+    SscDaemonError_Success = 0,
+    SscDaemonError_Io = 1,       ///< Could not connect, or the connection failed or was closed
+    SscDaemonError_Protocol = 2, ///< An unexpected response, or one larger than the buffer for it
+} SscDaemonError;
+
+/// A connection to the daemon
+typedef struct {
+    int socket; ///< Connected socket, -1 when disconnected
+} ssc_daemon_client;
+
+/// Connect to the daemon
+/// @param[out] client Client to initialise
+/// @param path Path of the daemon's socket
+/// @return SscDaemonError code
+SscDaemonError ssc_daemon_connect(ssc_daemon_client *client, const char *path);
+
+/// Close a connection, responses that have not been read are discarded
+/// @param[in, out] client Client to disconnect
+void ssc_daemon_disconnect(ssc_daemon_client *client);
+
+/// Send a request without waiting for the response, see ssc_daemon_receive()
+/// @param[in] client Connected client
+/// @param[in] header Header of the request, the magic is filled in
+/// @param[in] records header->count records of the type of the request
+/// @return SscDaemonError code
+SscDaemonError ssc_daemon_send(ssc_daemon_client *client, const ssc_daemon_header *header, const void *records);
+
+/// Receive the next response
+/// @param[in] client Connected client
+/// @param[out] header Header of the response
+/// @param[out] records Buffer for the records of the response
+/// @param capacity Size of the buffer [bytes]
+/// @return SscDaemonError code
+SscDaemonError ssc_daemon_receive(ssc_daemon_client *client, ssc_daemon_header *header, void *records, size_t capacity);
+
+/// Calculate queries and wait for the results, there must not be any other responses still to be read
+/// @param[in] client Connected client
+/// @param search Search strategy
+/// @param engine Algorithm
+/// @param[in] queries Queries to calculate
+/// @param count Number of queries, at most SSC_DAEMON_MAX_QUERIES
+/// @param[out] results A result for each query
+/// @return SscDaemonError code
+SscDaemonError ssc_daemon_calculate(ssc_daemon_client *client,
+                                    SunriseSunsetSearch search,
+                                    SunriseSunsetEngine engine,
+                                    const ssc_daemon_query *queries,
+                                    uint32_t count,
+                                    ssc_daemon_result *results);
+
+/// Read the daemon's counters, there must not be any other responses still to be read
+/// @param[in] client Connected client
+/// @param[out] stats Counters
+/// @return SscDaemonError code
+SscDaemonError ssc_daemon_stats_query(ssc_daemon_client *client, ssc_daemon_stats *stats);
+
+#endif //SUNRISE_SUNSET_CALCULATOR_SSC_DAEMON_H
@@ -0,0 +1,75 @@
+//
+//  ssc_grid.h
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+//  Sunrise and sunset for every cell of a latitude/longitude grid.
+//
+//  Each cell is calculated around its local mean solar noon, so that the offsets of its sunrise and sunset from noon
+//  change smoothly across the grid. Those offsets are calculated exactly with sunrise_sunset_calculate() on a coarse
+//  lattice and interpolated bilinearly in between. Before a block of the lattice is interpolated its edge midpoints and
+//  centre are also calculated exactly, and if any of them differs from the interpolation by more than the tolerance, or
+//  the sun is visible at some of them and not at others, the block is split in four and each quarter is checked again.
+//  This refines down to single cells around the polar circles, where sunrise and sunset disappear, and interpolates
+//  everywhere else.
+//
+#ifndef SUNRISE_SUNSET_CALCULATOR_SSC_GRID_H
+#define SUNRISE_SUNSET_CALCULATOR_SSC_GRID_H
+
+#include "ssc.h"
+
+#define SSC_GRID_DEFAULT_BLOCK_SIZE 16
+#define SSC_GRID_DEFAULT_TOLERANCE 30.0
+
+/// A regular latitude/longitude grid, cells are stored row by row with rows * columns in total
+typedef struct {
+    SunriseSunsetParameters params; ///< Parameters shared by every cell.
+                                    ///< The time, latitude, longitude and step size are set for each cell.
+    double latitude;                ///< Latitude (N) of the first row
+    double longitude;               ///< Longitude (E) of the first column
+    double latitude_step;           ///< Latitude difference between rows, can be negative
+    double longitude_step;          ///< Longitude difference between columns, can be negative
+    size_t rows;                    ///< Number of rows
+    size_t columns;                 ///< Number of columns
+    size_t block_size;              ///< Spacing of the coarse lattice in cells, a power of two
+    double tolerance;               ///< Largest accepted interpolation error [seconds]
+} SunriseSunsetGrid;
+
+/// Initialise SunriseSunsetGrid with required and default values.
+/// @param[out] grid SunriseSunsetGrid struct to initialise
+/// @param latitude Latitude (N) of the first row
+/// @param longitude Longitude (E) of the first column
+/// @param latitude_step Latitude difference between rows
+/// @param longitude_step Longitude difference between columns
+/// @param rows Number of rows
+/// @param columns Number of columns
+void SunriseSunsetGrid_init(SunriseSunsetGrid *grid,
+                            double latitude,
+                            double longitude,
+                            double latitude_step,
+                            double longitude_step,
+                            size_t rows,
+                            size_t columns);
+
+/// Raster output for sunrise_sunset_grid_calculate(), each column must hold rows * columns items
+typedef struct {
+    unix_t *set;   ///< Unix timestamps of the closest sunsets to local noon
+    unix_t *rise;  ///< Unix timestamps of the closest sunrises to local noon
+    bool *visible; ///< If the sun is visible at local noon
+    bool *exact;   ///< If the cell was calculated exactly rather than interpolated
+} SunriseSunsetGridOutput;
+
+/// Calculate sunrise and sunset times for every cell of a grid on one day.
+/// Each cell is calculated around its local mean solar noon, so it gives the sunrise and sunset of that day when the
+/// sun rises and sets, the surrounding events during polar night, and the previous sunrise and next sunset during
+/// polar day. Exact cells are the same as sunrise_sunset_calculate(), interpolated cells are within the tolerance of
+/// it wherever the estimate from the surrounding exact cells holds.
+/// @param[in] grid Grid to calculate
+/// @param day Unix timestamp of 00:00 UTC on the day
+/// @param[out] output Output raster
+/// @return SpaError code, the output is incomplete unless SpaError_Success
+SpaError sunrise_sunset_grid_calculate(const SunriseSunsetGrid *grid,
+                                      unix_t day,
+                                      const SunriseSunsetGridOutput *output);
+
+#endif //SUNRISE_SUNSET_CALCULATOR_SSC_GRID_H
@@ -0,0 +1,67 @@
+//
+//  ssc_parallel.h
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+//  Multithreaded sunrise and sunset for every day of a range at many locations.
+//
+//  The locations x days items are split into chunks of consecutive items, and each worker thread starts with an equal
+//  share of the chunks. A worker that runs out steals the later half of the remaining chunks of another worker, so
+//  expensive items (e.g. polar locations, with a 10 minute search step) do not leave the other threads idle. Every item
+//  is written to its own position in the output, so the output does not depend on the number of threads or on how the
+//  chunks were scheduled.
+//
+//  Uses POSIX threads, or Windows threads on Windows.
+//
+#ifndef SUNRISE_SUNSET_CALCULATOR_SSC_PARALLEL_H
+#define SUNRISE_SUNSET_CALCULATOR_SSC_PARALLEL_H
+
+#include "ssc.h"
+
+#define SSC_PARALLEL_DEFAULT_CHUNK_SIZE 64
+
+/// A job of every day of a range at many locations
+typedef struct {
+    SunriseSunsetParameters params; ///< Parameters shared by every item.
+                                    ///< The time, latitude, longitude and step size are set for each item.
+    size_t location_count;          ///< Number of locations
+    const double *latitude;         ///< The latitudes (N) of the locations
+    const double *longitude;        ///< The longitudes (E) of the locations
+    const uint32_t *step_size;      ///< Optional per-location step size in seconds.
+                                    ///< When NULL sunrise_sunset_default_step_size() of each latitude is used.
+    size_t day_count;               ///< Number of days
+    unix_t start;                   ///< Unix timestamp to calculate around on the first day
+    unix_t interval;                ///< Seconds between days
+    size_t threads;                 ///< Number of threads, including the calling thread
+    size_t chunk_size;              ///< Number of consecutive items a thread takes at once
+} SunriseSunsetParallelJob;
+
+/// Number of processors available to run threads on
+/// @return Number of online processors, at least 1
+size_t sunrise_sunset_parallel_processors(void);
+
+/// Initialise SunriseSunsetParallelJob with required and default values, one thread per processor and daily intervals.
+/// @param[out] job SunriseSunsetParallelJob struct to initialise
+/// @param location_count Number of locations
+/// @param latitude The latitudes (N) of the locations
+/// @param longitude The longitudes (E) of the locations
+/// @param start Unix timestamp to calculate around on the first day
+/// @param day_count Number of days
+void SunriseSunsetParallelJob_init(SunriseSunsetParallelJob *job,
+                                   size_t location_count,
+                                   const double *latitude,
+                                   const double *longitude,
+                                   unix_t start,
+                                   size_t day_count);
+
+/// Calculate sunrise and sunset times for every location and day of a job with multiple threads.
+/// Item (location, day) is written at location * day_count + day of each output column, with the same result as
+/// sunrise_sunset_calculate() at start + day * interval. If a thread cannot be started the remaining threads do its
+/// share of the work.
+/// @param[in] job Job to run
+/// @param[out] output Output columns, each must hold location_count * day_count items. Statistics of every successful
+/// item are added to the optional stats, with the same totals whatever the number of threads.
+/// @return SpaError_Success if every item succeeded, otherwise the status of the first failed item
+SpaError sunrise_sunset_parallel_run(const SunriseSunsetParallelJob *job, const SunriseSunsetBatchOutput *output);
+
+#endif //SUNRISE_SUNSET_CALCULATOR_SSC_PARALLEL_H
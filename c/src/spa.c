@@ -68,16 +68,19 @@
 //
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
-#include <math.h>
+#include "spa_math.h"
+#include <stddef.h>
 #include "spa.h"
+#include "spa_simd.h"
 
 #define PI         3.1415926535897932384626433832795028841971
-#define SUN_RADIUS 0.26667
+#define SUN_RADIUS SPA_SUN_RADIUS
 
 #define L_COUNT 6
 #define B_COUNT 2
 #define R_COUNT 5
 #define Y_COUNT 63
+#define Y_TRUNCATED_COUNT 13    // leading rows of PE_TERMS with an amplitude of at least 0.01 arc seconds
 
 #define L_MAX_SUBCOUNT 64
 #define B_MAX_SUBCOUNT 5
@@ -495,22 +498,40 @@ static double third_order_polynomial(double a, double b, double c, double d, dou
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
-static int validate_inputs(spa_data *spa)
+static SpaError validate_time_inputs(double jd, double delta_t)
 {
     // Less than -2000-01-01 00:00 or Greater than 6000-12-31 23:59:59
-    if ((spa->jd < 990575.50000) || (spa->jd > 3912880.49999)) return SpaError_UnsupportedDate;
+    if ((jd < SPA_MIN_JD) || (jd > SPA_MAX_JD)) return SpaError_UnsupportedDate;
 
-    if ((spa->pressure < 0) || (spa->pressure > 5000)) return SpaError_InvalidPressure;
-    if ((spa->temperature <= -273) || (spa->temperature > 6000)) return SpaError_InvalidTemperature;
+    if (fabs(delta_t) > SPA_MAX_DELTA_T) return SpaError_InvalidDeltaT;
 
-    if (fabs(spa->delta_t) > 8000) return SpaError_InvalidDeltaT;
-    if (fabs(spa->longitude) > 180) return SpaError_InvalidLongitude;
-    if (fabs(spa->latitude) > 90) return SpaError_InvalidLatitude;
-    if (fabs(spa->atmos_refract) > 5) return SpaError_InvalidAtmosRefract;
-    if (spa->elevation < -6500000) return SpaError_InvalidElevation;
+    return SpaError_Success;
+}
+
+static SpaError validate_observer_inputs(double latitude, double longitude, double elevation,
+                                         double pressure, double temperature, double atmos_refract)
+{
+    if ((pressure < 0) || (pressure > 5000)) return SpaError_InvalidPressure;
+    if ((temperature <= -273) || (temperature > 6000)) return SpaError_InvalidTemperature;
+
+    if (fabs(longitude) > 180) return SpaError_InvalidLongitude;
+    if (fabs(latitude) > 90) return SpaError_InvalidLatitude;
+    if (fabs(atmos_refract) > 5) return SpaError_InvalidAtmosRefract;
+    if (elevation < -6500000) return SpaError_InvalidElevation;
 
     return SpaError_Success;
 }
+
+static SpaError validate_inputs(spa_data *spa)
+{
+    SpaError result = validate_time_inputs(spa->jd, spa->delta_t);
+
+    if (result == SpaError_Success)
+        result = validate_observer_inputs(spa->latitude, spa->longitude, spa->elevation,
+                                          spa->pressure, spa->temperature, spa->atmos_refract);
+
+    return result;
+}
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
 static double julian_century(double jd)
@@ -537,6 +558,9 @@ static double earth_periodic_term_summation(const double terms[][TERM_COUNT], in
 {
     int i;
     double sum=0;
+    spa_term_summation kernel = spa_simd_kernel();
+
+    if (kernel) return kernel(terms, count, jme);
 
     for (i = 0; i < count; i++)
         sum += terms[i][TERM_A]*cos(terms[i][TERM_B]+terms[i][TERM_C]*jme);
@@ -643,13 +667,13 @@ static double xy_term_summation(int i, double x[TERM_X_COUNT])
     return sum;
 }
 
-static void nutation_longitude_and_obliquity(double jce, double x[TERM_X_COUNT], double *del_psi,
+static void nutation_longitude_and_obliquity(double jce, double x[TERM_X_COUNT], int count, double *del_psi,
                                                                           double *del_epsilon)
 {
     int i;
     double xy_term_sum, sum_psi=0, sum_epsilon=0;
 
-    for (i = 0; i < Y_COUNT; i++) {
+    for (i = 0; i < count; i++) {
         xy_term_sum  = deg2rad(xy_term_summation(i, x));
         sum_psi     += (PE_TERMS[i][TERM_PSI_A] + jce*PE_TERMS[i][TERM_PSI_B])*sin(xy_term_sum);
         sum_epsilon += (PE_TERMS[i][TERM_EPS_C] + jce*PE_TERMS[i][TERM_EPS_D])*cos(xy_term_sum);
@@ -721,66 +745,100 @@ static double sun_equatorial_horizontal_parallax(double r)
     return 8.794 / (3600.0 * r);
 }
 
-static void right_ascension_parallax_and_topocentric_dec(double latitude, double elevation,
-	       double xi, double h, double delta, double *delta_alpha, double *delta_prime)
+static void observer_parallax_terms(double latitude, double elevation, double *x, double *y)
 {
-    double delta_alpha_rad;
     double lat_rad   = deg2rad(latitude);
-    double xi_rad    = deg2rad(xi);
-    double h_rad     = deg2rad(h);
-    double delta_rad = deg2rad(delta);
     double u = atan(0.99664719 * tan(lat_rad));
-    double y = 0.99664719 * sin(u) + elevation*sin(lat_rad)/6378140.0;
-    double x =              cos(u) + elevation*cos(lat_rad)/6378140.0;
 
-    delta_alpha_rad =      atan2(                - x*sin(xi_rad) *sin(h_rad),
-                                  cos(delta_rad) - x*sin(xi_rad) *cos(h_rad));
+    *y = 0.99664719 * sin(u) + elevation*sin(lat_rad)/6378140.0;
+    *x =              cos(u) + elevation*cos(lat_rad)/6378140.0;
+}
+
+static void topocentric_parallax(double x, double y, double sin_xi, double h, double sin_delta,
+	                         double cos_delta, double *delta_alpha, double *delta_prime)
+{
+    double delta_alpha_rad;
+    double h_rad     = deg2rad(h);
+
+    delta_alpha_rad =      atan2(                - x*sin_xi *sin(h_rad),
+                                  cos_delta      - x*sin_xi *cos(h_rad));
 
-    *delta_prime = rad2deg(atan2((sin(delta_rad) - y*sin(xi_rad))*cos(delta_alpha_rad),
-                                  cos(delta_rad) - x*sin(xi_rad) *cos(h_rad)));
+    *delta_prime = rad2deg(atan2((sin_delta      - y*sin_xi)*cos(delta_alpha_rad),
+                                  cos_delta      - x*sin_xi *cos(h_rad)));
 
     *delta_alpha = rad2deg(delta_alpha_rad);
 }
 
+static void right_ascension_parallax_and_topocentric_dec(double latitude, double elevation,
+	       double xi, double h, double delta, double *delta_alpha, double *delta_prime)
+{
+    double x, y;
+    double xi_rad    = deg2rad(xi);
+    double delta_rad = deg2rad(delta);
+
+    observer_parallax_terms(latitude, elevation, &x, &y);
+    topocentric_parallax(x, y, sin(xi_rad), h, sin(delta_rad), cos(delta_rad), delta_alpha, delta_prime);
+}
+
 static double topocentric_local_hour_angle(double h, double delta_alpha)
 {
     return h - delta_alpha;
 }
 
+static double topocentric_elevation_angle_sincos(double sin_lat, double cos_lat, double delta_prime,
+	                                         double h_prime)
+{
+    double delta_prime_rad = deg2rad(delta_prime);
+
+    return rad2deg(asin(sin_lat*sin(delta_prime_rad) +
+                        cos_lat*cos(delta_prime_rad) * cos(deg2rad(h_prime))));
+}
+
 static double topocentric_elevation_angle(double latitude, double delta_prime, double h_prime)
 {
     double lat_rad         = deg2rad(latitude);
-    double delta_prime_rad = deg2rad(delta_prime);
 
-    return rad2deg(asin(sin(lat_rad)*sin(delta_prime_rad) +
-                        cos(lat_rad)*cos(delta_prime_rad) * cos(deg2rad(h_prime))));
+    return topocentric_elevation_angle_sincos(sin(lat_rad), cos(lat_rad), delta_prime, h_prime);
 }
 
-static double atmospheric_refraction_correction(double pressure, double temperature,
-	                                     double atmos_refract, double e0)
+static double atmospheric_refraction_scale(double pressure, double temperature)
+{
+    return (pressure / 1010.0) * (283.0 / (273.0 + temperature)) * 1.02;
+}
+
+static double atmospheric_refraction_limit(double atmos_refract)
+{
+    return -1*(SUN_RADIUS + atmos_refract);
+}
+
+static double atmospheric_refraction_correction_scaled(double refract_scale, double refract_limit, double e0)
 {
     double del_e = 0;
 
-    if (e0 >= -1*(SUN_RADIUS + atmos_refract))
-        del_e = (pressure / 1010.0) * (283.0 / (273.0 + temperature)) *
-                 1.02 / (60.0 * tan(deg2rad(e0 + 10.3/(e0 + 5.11))));
+    if (e0 >= refract_limit)
+        del_e = refract_scale / (60.0 * tan(deg2rad(e0 + 10.3/(e0 + 5.11))));
 
     return del_e;
 }
 
+static double atmospheric_refraction_correction(double pressure, double temperature,
+	                                     double atmos_refract, double e0)
+{
+    return atmospheric_refraction_correction_scaled(atmospheric_refraction_scale(pressure, temperature),
+                                                    atmospheric_refraction_limit(atmos_refract), e0);
+}
+
 static double topocentric_elevation_angle_corrected(double e0, double delta_e)
 {
     return e0 + delta_e;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////
-// Calculate required SPA parameters to get the right ascension (alpha) and declination (delta)
+// Calculate the time and earth heliocentric SPA parameters
 // Note: JD must be already calculated and in structure
 ////////////////////////////////////////////////////////////////////////////////////////////////
-static void calculate_geocentric_sun_right_ascension_and_declination(spa_data *spa)
+static void calculate_earth_heliocentric_position(spa_data *spa)
 {
-    double x[TERM_X_COUNT];
-
     spa->jc = julian_century(spa->jd);
 
     spa->jde = julian_ephemeris_day(spa->jd, spa->delta_t);
@@ -793,6 +851,15 @@ static void calculate_geocentric_sun_right_ascension_and_declination(spa_data *s
 
     spa->theta = geocentric_longitude(spa->l);
     spa->beta  = geocentric_latitude(spa->b);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// Calculate the nutation SPA parameters using the first count periodic terms
+// Note: JCE must be already calculated and in structure
+////////////////////////////////////////////////////////////////////////////////////////////////
+static void calculate_nutation(spa_data *spa, int count)
+{
+    double x[TERM_X_COUNT];
 
     x[TERM_X0] = spa->x0 = mean_elongation_moon_sun(spa->jce);
     x[TERM_X1] = spa->x1 = mean_anomaly_sun(spa->jce);
@@ -800,8 +867,15 @@ static void calculate_geocentric_sun_right_ascension_and_declination(spa_data *s
     x[TERM_X3] = spa->x3 = argument_latitude_moon(spa->jce);
     x[TERM_X4] = spa->x4 = ascending_longitude_moon(spa->jce);
 
-    nutation_longitude_and_obliquity(spa->jce, x, &(spa->del_psi), &(spa->del_epsilon));
+    nutation_longitude_and_obliquity(spa->jce, x, count, &(spa->del_psi), &(spa->del_epsilon));
+}
 
+////////////////////////////////////////////////////////////////////////////////////////////////
+// Calculate the right ascension (alpha) and declination (delta) from the earth position and nutation
+// Note: Earth position and nutation must be already calculated and in structure
+////////////////////////////////////////////////////////////////////////////////////////////////
+static void calculate_apparent_sun_position(spa_data *spa)
+{
     spa->epsilon0 = ecliptic_mean_obliquity(spa->jme);
     spa->epsilon  = ecliptic_true_obliquity(spa->del_epsilon, spa->epsilon0);
 
@@ -814,6 +888,123 @@ static void calculate_geocentric_sun_right_ascension_and_declination(spa_data *s
     spa->delta = geocentric_declination(spa->beta, spa->epsilon, spa->lamda);
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////
+// Calculate required SPA parameters to get the right ascension (alpha) and declination (delta)
+// Note: JD must be already calculated and in structure
+////////////////////////////////////////////////////////////////////////////////////////////////
+static void calculate_geocentric_sun_right_ascension_and_declination(spa_data *spa)
+{
+    calculate_earth_heliocentric_position(spa);
+    calculate_nutation(spa, Y_COUNT);
+    calculate_apparent_sun_position(spa);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// Nutation for the time already in the structure, using the series and interpolation cache
+// Note: JCE must be already calculated and in structure
+////////////////////////////////////////////////////////////////////////////////////////////////
+static int nutation_series_count(SpaNutationSeries series)
+{
+    return (series == SpaNutation_Truncated) ? Y_TRUNCATED_COUNT : Y_COUNT;
+}
+
+static void nutation_at_jce(double jce, int count, double *del_psi, double *del_epsilon)
+{
+    double x[TERM_X_COUNT];
+
+    x[TERM_X0] = mean_elongation_moon_sun(jce);
+    x[TERM_X1] = mean_anomaly_sun(jce);
+    x[TERM_X2] = mean_anomaly_moon(jce);
+    x[TERM_X3] = argument_latitude_moon(jce);
+    x[TERM_X4] = ascending_longitude_moon(jce);
+
+    nutation_longitude_and_obliquity(jce, x, count, del_psi, del_epsilon);
+}
+
+static void nutation_at_jde(double jde, SpaNutationSeries series, double *del_psi, double *del_epsilon)
+{
+    nutation_at_jce(julian_ephemeris_century(jde), nutation_series_count(series), del_psi, del_epsilon);
+}
+
+static void nutation_cached(double jde, spa_nutation *nutation, double *del_psi, double *del_epsilon)
+{
+    double jde_lo, fraction;
+
+    if (nutation->interval <= 0) {
+        nutation_at_jde(jde, nutation->series, del_psi, del_epsilon);
+        return;
+    }
+
+    jde_lo = nutation->interval*floor(jde / nutation->interval);
+
+    if (!nutation->valid || jde_lo != nutation->jde_lo) {
+        if (nutation->valid && jde_lo == nutation->jde_lo + nutation->interval) {
+            // Moved forwards into the next bucket, reuse the shared bracket
+            nutation->del_psi[0]     = nutation->del_psi[1];
+            nutation->del_epsilon[0] = nutation->del_epsilon[1];
+            nutation_at_jde(jde_lo + nutation->interval, nutation->series,
+                            &(nutation->del_psi[1]), &(nutation->del_epsilon[1]));
+        } else if (nutation->valid && jde_lo == nutation->jde_lo - nutation->interval) {
+            // Moved backwards into the previous bucket, reuse the shared bracket
+            nutation->del_psi[1]     = nutation->del_psi[0];
+            nutation->del_epsilon[1] = nutation->del_epsilon[0];
+            nutation_at_jde(jde_lo, nutation->series, &(nutation->del_psi[0]), &(nutation->del_epsilon[0]));
+        } else {
+            nutation_at_jde(jde_lo, nutation->series, &(nutation->del_psi[0]), &(nutation->del_epsilon[0]));
+            nutation_at_jde(jde_lo + nutation->interval, nutation->series,
+                            &(nutation->del_psi[1]), &(nutation->del_epsilon[1]));
+        }
+        nutation->jde_lo = jde_lo;
+        nutation->valid  = 1;
+    }
+
+    fraction = (jde - jde_lo) / nutation->interval;
+    *del_psi     = nutation->del_psi[0]     + fraction*(nutation->del_psi[1]     - nutation->del_psi[0]);
+    *del_epsilon = nutation->del_epsilon[0] + fraction*(nutation->del_epsilon[1] - nutation->del_epsilon[0]);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// Geocentric position of the sun without the spa_data intermediates
+// Only the values that the ephemeris, the elevation and the lean outputs need are kept, the
+// rest stay in locals so that nothing else is stored
+////////////////////////////////////////////////////////////////////////////////////////////////
+typedef struct
+{
+    double r;           // earth radius vector [Astronomical Units, AU]
+    double del_psi;     // nutation longitude [degrees]
+    double del_epsilon; // nutation obliquity [degrees]
+    double epsilon;     // ecliptic true obliquity  [degrees]
+    double nu;          // Greenwich sidereal time [degrees]
+    double alpha;       // geocentric sun right ascension [degrees]
+    double delta;       // geocentric sun declination [degrees]
+} spa_geocentric;
+
+static void calculate_geocentric(spa_geocentric *sun, double jd, double delta_t, spa_nutation *nutation)
+{
+    double jc, jde, jce, jme, theta, beta, lamda;
+
+    jc  = julian_century(jd);
+    jde = julian_ephemeris_day(jd, delta_t);
+    jce = julian_ephemeris_century(jde);
+    jme = julian_ephemeris_millennium(jce);
+
+    sun->r = earth_radius_vector(jme);
+    theta  = geocentric_longitude(earth_heliocentric_longitude(jme));
+    beta   = geocentric_latitude(earth_heliocentric_latitude(jme));
+
+    if (nutation)
+        nutation_cached(jde, nutation, &(sun->del_psi), &(sun->del_epsilon));
+    else
+        nutation_at_jce(jce, Y_COUNT, &(sun->del_psi), &(sun->del_epsilon));
+
+    sun->epsilon = ecliptic_true_obliquity(sun->del_epsilon, ecliptic_mean_obliquity(jme));
+    lamda        = apparent_sun_longitude(theta, sun->del_psi, aberration_correction(sun->r));
+    sun->nu      = greenwich_sidereal_time(greenwich_mean_sidereal_time(jd, jc), sun->del_psi, sun->epsilon);
+
+    sun->alpha = geocentric_right_ascension(lamda, sun->epsilon, beta);
+    sun->delta = geocentric_declination(beta, sun->epsilon, lamda);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////
 // Calculate all SPA parameters and put into structure
 // Note: All inputs values (listed in header file) must already be in structure
@@ -845,3 +1036,222 @@ SpaError spa_calculate(spa_data *spa)
     return result;
 }
 ///////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// Calculate the observer independent SPA parameters for a single point in time
+///////////////////////////////////////////////////////////////////////////////////////////
+SpaError spa_calculate_ephemeris(spa_ephemeris *ephemeris, double jd, double delta_t)
+{
+    return spa_calculate_ephemeris_nutation(ephemeris, jd, delta_t, NULL);
+}
+
+SpaError spa_calculate_ephemeris_nutation(spa_ephemeris *ephemeris, double jd, double delta_t,
+                                          spa_nutation *nutation)
+{
+    SpaError result;
+    spa_geocentric sun;
+
+    result = validate_time_inputs(jd, delta_t);
+
+    if (result == SpaError_Success)
+    {
+        calculate_geocentric(&sun, jd, delta_t, nutation);
+
+        ephemeris->jd      = jd;
+        ephemeris->delta_t = delta_t;
+        ephemeris->nu      = sun.nu;
+        ephemeris->alpha   = sun.alpha;
+        ephemeris->delta   = sun.delta;
+        ephemeris->xi      = sun_equatorial_horizontal_parallax(sun.r);
+
+        ephemeris->sin_delta = sin(deg2rad(ephemeris->delta));
+        ephemeris->cos_delta = cos(deg2rad(ephemeris->delta));
+        ephemeris->sin_xi    = sin(deg2rad(ephemeris->xi));
+    }
+
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// Calculate the topocentric elevation angle, storing only the selected intermediate values
+///////////////////////////////////////////////////////////////////////////////////////////
+SpaError spa_validate_time(double jd, double delta_t)
+{
+    return validate_time_inputs(jd, delta_t);
+}
+
+double spa_calculate_elevation_lean(const spa_observer *observer, double jd, double delta_t,
+                                    spa_nutation *nutation, unsigned outputs, spa_lean_outputs *intermediates)
+{
+    spa_geocentric sun;
+    double h, xi, delta_rad, del_alpha, delta_prime, h_prime, e0, e;
+
+    calculate_geocentric(&sun, jd, delta_t, nutation);
+
+    h         = observer_hour_angle(sun.nu, observer->longitude, sun.alpha);
+    xi        = sun_equatorial_horizontal_parallax(sun.r);
+    delta_rad = deg2rad(sun.delta);
+
+    topocentric_parallax(observer->x, observer->y, sin(deg2rad(xi)), h, sin(delta_rad), cos(delta_rad),
+                         &del_alpha, &delta_prime);
+
+    h_prime = topocentric_local_hour_angle(h, del_alpha);
+    e0      = topocentric_elevation_angle_sincos(observer->sin_lat, observer->cos_lat, delta_prime, h_prime);
+    e       = spa_observer_refraction_corrected(observer, e0);
+
+    if (intermediates)
+    {
+        intermediates->e = e;
+        if (outputs & SpaOutput_Geocentric) {
+            intermediates->nu    = sun.nu;
+            intermediates->alpha = sun.alpha;
+            intermediates->delta = sun.delta;
+            intermediates->xi    = xi;
+        }
+        if (outputs & SpaOutput_Nutation) {
+            intermediates->del_psi     = sun.del_psi;
+            intermediates->del_epsilon = sun.del_epsilon;
+            intermediates->epsilon     = sun.epsilon;
+        }
+        if (outputs & SpaOutput_Topocentric) {
+            intermediates->h           = h;
+            intermediates->del_alpha   = del_alpha;
+            intermediates->delta_prime = delta_prime;
+            intermediates->h_prime     = h_prime;
+            intermediates->e0          = e0;
+        }
+    }
+
+    return e;
+}
+///////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// Fill the observer independent SPA parameters from precomputed geocentric values
+///////////////////////////////////////////////////////////////////////////////////////////
+void spa_ephemeris_from_geocentric(spa_ephemeris *ephemeris, double jd, double delta_t, double alpha,
+                                   double delta, double r, double equation_of_equinoxes)
+{
+    ephemeris->jd      = jd;
+    ephemeris->delta_t = delta_t;
+    ephemeris->nu      = greenwich_mean_sidereal_time(jd, julian_century(jd)) + equation_of_equinoxes;
+    ephemeris->alpha   = limit_degrees(alpha);
+    ephemeris->delta   = delta;
+    ephemeris->xi      = sun_equatorial_horizontal_parallax(r);
+
+    ephemeris->sin_delta = sin(deg2rad(ephemeris->delta));
+    ephemeris->cos_delta = cos(deg2rad(ephemeris->delta));
+    ephemeris->sin_xi    = sin(deg2rad(ephemeris->xi));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// Configure how nutation is evaluated by spa_calculate_ephemeris_nutation
+///////////////////////////////////////////////////////////////////////////////////////////
+void spa_nutation_init(spa_nutation *nutation, SpaNutationSeries series, double interval)
+{
+    nutation->series   = series;
+    nutation->interval = interval;
+    nutation->valid    = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// Validate and precompute the time independent SPA parameters for an observer
+///////////////////////////////////////////////////////////////////////////////////////////
+SpaError spa_observer_init(spa_observer *observer, double latitude, double longitude, double elevation,
+                           double pressure, double temperature, double atmos_refract)
+{
+    SpaError result;
+
+    result = validate_observer_inputs(latitude, longitude, elevation, pressure, temperature, atmos_refract);
+
+    if (result == SpaError_Success)
+    {
+        observer->latitude      = latitude;
+        observer->longitude     = longitude;
+        observer->elevation     = elevation;
+        observer->pressure      = pressure;
+        observer->temperature   = temperature;
+        observer->atmos_refract = atmos_refract;
+
+        observer->sin_lat = sin(deg2rad(latitude));
+        observer->cos_lat = cos(deg2rad(latitude));
+        observer_parallax_terms(latitude, elevation, &(observer->x), &(observer->y));
+        observer->refract_scale = atmospheric_refraction_scale(pressure, temperature);
+        observer->refract_limit = atmospheric_refraction_limit(atmos_refract);
+    }
+
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// Calculate the topocentric elevation angle of the sun for an observer
+///////////////////////////////////////////////////////////////////////////////////////////
+double spa_calculate_elevation(const spa_ephemeris *ephemeris, const spa_observer *observer)
+{
+    return spa_observer_refraction_corrected(observer, spa_calculate_elevation_uncorrected(ephemeris, observer));
+}
+///////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// Calculate the topocentric elevation angle of the sun before the refraction correction
+///////////////////////////////////////////////////////////////////////////////////////////
+double spa_calculate_elevation_uncorrected(const spa_ephemeris *ephemeris, const spa_observer *observer)
+{
+    double h, del_alpha, delta_prime, h_prime;
+
+    h = observer_hour_angle(ephemeris->nu, observer->longitude, ephemeris->alpha);
+
+    topocentric_parallax(observer->x, observer->y, ephemeris->sin_xi, h, ephemeris->sin_delta,
+                         ephemeris->cos_delta, &del_alpha, &delta_prime);
+
+    h_prime = topocentric_local_hour_angle(h, del_alpha);
+
+    return topocentric_elevation_angle_sincos(observer->sin_lat, observer->cos_lat, delta_prime, h_prime);
+}
+
+double spa_observer_refraction_corrected(const spa_observer *observer, double e0)
+{
+    return topocentric_elevation_angle_corrected(e0,
+               atmospheric_refraction_correction_scaled(observer->refract_scale, observer->refract_limit, e0));
+}
+///////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// Calculate the topocentric elevation angle of the sun for many (ephemeris, observer) pairs
+///////////////////////////////////////////////////////////////////////////////////////////
+void spa_calculate_elevations(int count, const spa_ephemeris *ephemerides, const spa_observer *observers,
+                              double *elevations)
+{
+    spa_elevation_kernel kernel = spa_simd_elevation_kernel();
+    spa_observer_block block;
+    int start, size, i;
+
+    if (kernel == NULL) {
+        for (i = 0; i < count; i++)
+            elevations[i] = spa_calculate_elevation(&ephemerides[i], &observers[i]);
+        return;
+    }
+
+    for (start = 0; start < count; start += size) {
+        size = count - start < SPA_SIMD_BLOCK ? count - start : SPA_SIMD_BLOCK;
+
+        // Transpose into the block, repeating the last item to fill it
+        for (i = 0; i < SPA_SIMD_BLOCK; i++) {
+            const spa_ephemeris *ephemeris = &ephemerides[start + (i < size ? i : size - 1)];
+            const spa_observer  *observer  = &observers[start + (i < size ? i : size - 1)];
+
+            block.hour_angle[i]    = ephemeris->nu + observer->longitude - ephemeris->alpha;
+            block.sin_delta[i]     = ephemeris->sin_delta;
+            block.cos_delta[i]     = ephemeris->cos_delta;
+            block.sin_xi[i]        = ephemeris->sin_xi;
+            block.x[i]             = observer->x;
+            block.y[i]             = observer->y;
+            block.sin_lat[i]       = observer->sin_lat;
+            block.cos_lat[i]       = observer->cos_lat;
+            block.refract_scale[i] = observer->refract_scale;
+            block.refract_limit[i] = observer->refract_limit;
+        }
+        kernel(&block, size, &elevations[start]);
+    }
+}
+///////////////////////////////////////////////////////////////////////////////////////////
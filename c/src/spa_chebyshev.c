@@ -0,0 +1,204 @@
+//
+//  spa_chebyshev.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+#include "spa_chebyshev.h"
+#define _USE_MATH_DEFINES
+#include "spa_math.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define HEADER_SIZE ((uint32_t) sizeof(spa_chebyshev_header))
+
+/// Number of segments needed to cover a range, 0 if the parameters are invalid
+static uint64_t segment_count(double jde_start, double jde_end, double segment_days, int coefficient_count) {
+    if (!(jde_end > jde_start) || !(segment_days > 0) || coefficient_count < 1 ||
+        coefficient_count > SPA_CHEBYSHEV_MAX_COEFFICIENTS) {
+        return 0;
+    }
+    return (uint64_t) ceil((jde_end - jde_start) / segment_days);
+}
+
+size_t spa_chebyshev_size(double jde_start, double jde_end, double segment_days, int coefficient_count) {
+    uint64_t segments = segment_count(jde_start, jde_end, segment_days, coefficient_count);
+    if (segments == 0) {
+        return 0;
+    }
+    return HEADER_SIZE + (size_t) segments * SpaChebyshev_QuantityCount * (size_t) coefficient_count * sizeof(double);
+}
+
+/// Evaluate the geocentric quantities at a Julian ephemeris day
+static SpaError geocentric_quantities(double jde, double quantities[SpaChebyshev_QuantityCount]) {
+    spa_data spa;
+    SpaError result;
+
+    // delta_t = 0 makes jd equal to jde, the observer only needs to be valid
+    spa.jd = jde;
+    spa.delta_t = 0;
+    spa.longitude = 0;
+    spa.latitude = 0;
+    spa.elevation = 0;
+    spa.pressure = 1013.25;
+    spa.temperature = 16;
+    spa.atmos_refract = 0.5667;
+    result = spa_calculate(&spa);
+
+    quantities[SpaChebyshev_Alpha] = spa.alpha;
+    quantities[SpaChebyshev_Delta] = spa.delta;
+    quantities[SpaChebyshev_R] = spa.r;
+    quantities[SpaChebyshev_EquationOfEquinoxes] = spa.nu - spa.nu0;
+    quantities[SpaChebyshev_Epsilon] = spa.epsilon;
+    return result;
+}
+
+/// Fit one segment by sampling at the Chebyshev nodes
+static SpaError fit_segment(double jde_start, double segment_days, int count, double *coefficients) {
+    double samples[SPA_CHEBYSHEV_MAX_COEFFICIENTS][SpaChebyshev_QuantityCount];
+    SpaError result;
+    int i, j, k;
+
+    for (k = 0; k < count; k++) {
+        double x = cos(M_PI * (k + 0.5) / count);
+        result = geocentric_quantities(jde_start + segment_days * (x + 1.0) / 2.0, samples[k]);
+        if (result != SpaError_Success) {
+            return result;
+        }
+        // Right ascension wraps at 360 degrees, keep it continuous within the segment
+        if (k > 0) {
+            samples[k][SpaChebyshev_Alpha] += 360.0 * floor((samples[0][SpaChebyshev_Alpha] -
+                                                             samples[k][SpaChebyshev_Alpha] + 180.0) /
+                                                            360.0);
+        }
+    }
+
+    for (i = 0; i < SpaChebyshev_QuantityCount; i++) {
+        for (j = 0; j < count; j++) {
+            double sum = 0;
+            for (k = 0; k < count; k++) {
+                sum += samples[k][i] * cos(M_PI * j * (k + 0.5) / count);
+            }
+            coefficients[i * count + j] = (j == 0 ? 1.0 : 2.0) * sum / count;
+        }
+    }
+    return SpaError_Success;
+}
+
+SpaChebyshevError spa_chebyshev_generate(
+    void *buffer, size_t size, double jde_start, double jde_end, double segment_days, int coefficient_count) {
+    spa_chebyshev_header *header = (spa_chebyshev_header *) buffer;
+    double *coefficients = (double *) ((char *) buffer + HEADER_SIZE);
+    uint64_t segments = segment_count(jde_start, jde_end, segment_days, coefficient_count);
+    uint64_t s;
+    int i;
+
+    if (segments == 0) {
+        return SpaChebyshevError_InvalidRange;
+    }
+    if (size < spa_chebyshev_size(jde_start, jde_end, segment_days, coefficient_count)) {
+        return SpaChebyshevError_InvalidRange;
+    }
+
+    for (i = 0; i < (int) sizeof(header->magic); i++) {
+        header->magic[i] = i < (int) sizeof(SPA_CHEBYSHEV_MAGIC) ? SPA_CHEBYSHEV_MAGIC[i] : '\0';
+    }
+    header->version = SPA_CHEBYSHEV_VERSION;
+    header->header_size = HEADER_SIZE;
+    header->quantity_count = SpaChebyshev_QuantityCount;
+    header->coefficient_count = (uint32_t) coefficient_count;
+    header->segment_count = segments;
+    header->jde_start = jde_start;
+    header->segment_days = segment_days;
+    header->byte_order = 1.0;
+    header->reserved = 0;
+
+    for (s = 0; s < segments; s++) {
+        double *segment = coefficients + s * SpaChebyshev_QuantityCount * (uint64_t) coefficient_count;
+        if (fit_segment(jde_start + (double) s * segment_days, segment_days, coefficient_count, segment) !=
+            SpaError_Success) {
+            return SpaChebyshevError_InvalidRange;
+        }
+    }
+    return SpaChebyshevError_Success;
+}
+
+SpaChebyshevError spa_chebyshev_init(spa_chebyshev *table, const void *data, size_t size) {
+    const spa_chebyshev_header *header = (const spa_chebyshev_header *) data;
+    size_t expected;
+    int i;
+
+    if (size < HEADER_SIZE) {
+        return SpaChebyshevError_InvalidFormat;
+    }
+    for (i = 0; i < (int) sizeof(SPA_CHEBYSHEV_MAGIC); i++) {
+        if (header->magic[i] != SPA_CHEBYSHEV_MAGIC[i]) {
+            return SpaChebyshevError_InvalidFormat;
+        }
+    }
+    if (header->version != SPA_CHEBYSHEV_VERSION || header->byte_order != 1.0 || header->header_size < HEADER_SIZE ||
+        header->header_size % sizeof(double) != 0 || header->quantity_count != SpaChebyshev_QuantityCount ||
+        header->coefficient_count < 1 || header->coefficient_count > SPA_CHEBYSHEV_MAX_COEFFICIENTS ||
+        header->segment_count == 0 || !(header->segment_days > 0)) {
+        return SpaChebyshevError_InvalidFormat;
+    }
+    expected = header->header_size + (size_t) header->segment_count * header->quantity_count *
+                                         header->coefficient_count * sizeof(double);
+    if (size < expected) {
+        return SpaChebyshevError_InvalidFormat;
+    }
+
+    table->header = header;
+    table->coefficients = (const double *) ((const char *) data + header->header_size);
+    table->jde_end = header->jde_start + (double) header->segment_count * header->segment_days;
+    return SpaChebyshevError_Success;
+}
+
+/// Evaluate a Chebyshev series at x in [-1, 1] using Clenshaw's recurrence, the first coefficient is halved
+static double clenshaw(const double *coefficients, int count, double x) {
+    double b1 = 0, b2 = 0, t;
+    int j;
+    for (j = count - 1; j >= 1; j--) {
+        t = 2.0 * x * b1 - b2 + coefficients[j];
+        b2 = b1;
+        b1 = t;
+    }
+    return x * b1 - b2 + coefficients[0];
+}
+
+SpaError spa_chebyshev_calculate_ephemeris(const spa_chebyshev *table,
+                                           spa_ephemeris *ephemeris,
+                                           double jd,
+                                           double delta_t) {
+    const spa_chebyshev_header *header = table->header;
+    int count = (int) header->coefficient_count;
+    double jde, offset, x;
+    const double *segment;
+    uint64_t index;
+
+    if (fabs(delta_t) > SPA_MAX_DELTA_T) {
+        return SpaError_InvalidDeltaT;
+    }
+    jde = jd + delta_t / 86400.0;
+    if (!(jde >= header->jde_start && jde <= table->jde_end)) {
+        return SpaError_UnsupportedDate;
+    }
+
+    offset = (jde - header->jde_start) / header->segment_days;
+    index = (uint64_t) offset;
+    if (index >= header->segment_count) {
+        index = header->segment_count - 1;
+    }
+    x = 2.0 * (offset - (double) index) - 1.0;
+    segment = table->coefficients + index * SpaChebyshev_QuantityCount * (uint64_t) count;
+
+    spa_ephemeris_from_geocentric(ephemeris,
+                                  jd,
+                                  delta_t,
+                                  clenshaw(segment + SpaChebyshev_Alpha * count, count, x),
+                                  clenshaw(segment + SpaChebyshev_Delta * count, count, x),
+                                  clenshaw(segment + SpaChebyshev_R * count, count, x),
+                                  clenshaw(segment + SpaChebyshev_EquationOfEquinoxes * count, count, x));
+    return SpaError_Success;
+}
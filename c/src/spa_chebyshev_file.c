@@ -0,0 +1,146 @@
+//
+//  spa_chebyshev_file.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+#include "spa_chebyshev.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SpaChebyshevError spa_chebyshev_write_file(
+    const char *path, double jde_start, double jde_end, double segment_days, int coefficient_count) {
+    size_t size = spa_chebyshev_size(jde_start, jde_end, segment_days, coefficient_count);
+    SpaChebyshevError result;
+    double *buffer;
+    FILE *file;
+
+    if (size == 0) {
+        return SpaChebyshevError_InvalidRange;
+    }
+    buffer = (double *) malloc(size);
+    if (buffer == NULL) {
+        return SpaChebyshevError_Io;
+    }
+    result = spa_chebyshev_generate(buffer, size, jde_start, jde_end, segment_days, coefficient_count);
+    if (result == SpaChebyshevError_Success) {
+        file = fopen(path, "wb");
+        if (file == NULL) {
+            result = SpaChebyshevError_Io;
+        } else {
+            if (fwrite(buffer, 1, size, file) != size) {
+                result = SpaChebyshevError_Io;
+            }
+            if (fclose(file) != 0) {
+                result = SpaChebyshevError_Io;
+            }
+        }
+    }
+    free(buffer);
+    return result;
+}
+
+#ifdef _WIN32
+
+SpaChebyshevError spa_chebyshev_map_file(spa_chebyshev_file *file, const char *path) {
+    LARGE_INTEGER size;
+    HANDLE handle, mapping;
+    void *view;
+    SpaChebyshevError result;
+
+    handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return SpaChebyshevError_Io;
+    }
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0) {
+        CloseHandle(handle);
+        return SpaChebyshevError_InvalidFormat;
+    }
+    mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(handle);
+    if (mapping == NULL) {
+        return SpaChebyshevError_Io;
+    }
+    view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == NULL) {
+        CloseHandle(mapping);
+        return SpaChebyshevError_Io;
+    }
+    result = spa_chebyshev_init(&file->table, view, (size_t) size.QuadPart);
+    if (result != SpaChebyshevError_Success) {
+        UnmapViewOfFile(view);
+        CloseHandle(mapping);
+        return result;
+    }
+    file->mapping = view;
+    file->size = (size_t) size.QuadPart;
+    file->handle = mapping;
+    return SpaChebyshevError_Success;
+}
+
+void spa_chebyshev_unmap_file(spa_chebyshev_file *file) {
+    if (file->mapping != NULL) {
+        UnmapViewOfFile(file->mapping);
+        CloseHandle((HANDLE) file->handle);
+    }
+    file->mapping = NULL;
+    file->handle = NULL;
+    file->size = 0;
+}
+
+#else
+
+SpaChebyshevError spa_chebyshev_map_file(spa_chebyshev_file *file, const char *path) {
+    struct stat status;
+    SpaChebyshevError result;
+    void *mapping;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return SpaChebyshevError_Io;
+    }
+    if (fstat(fd, &status) != 0) {
+        close(fd);
+        return SpaChebyshevError_Io;
+    }
+    if (status.st_size <= 0) {
+        close(fd);
+        return SpaChebyshevError_InvalidFormat;
+    }
+    mapping = mmap(NULL, (size_t) status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping keeps its own reference to the file
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return SpaChebyshevError_Io;
+    }
+    result = spa_chebyshev_init(&file->table, mapping, (size_t) status.st_size);
+    if (result != SpaChebyshevError_Success) {
+        munmap(mapping, (size_t) status.st_size);
+        return result;
+    }
+    file->mapping = mapping;
+    file->size = (size_t) status.st_size;
+    file->handle = NULL;
+    return SpaChebyshevError_Success;
+}
+
+void spa_chebyshev_unmap_file(spa_chebyshev_file *file) {
+    if (file->mapping != NULL) {
+        munmap(file->mapping, file->size);
+    }
+    file->mapping = NULL;
+    file->handle = NULL;
+    file->size = 0;
+}
+
+#endif
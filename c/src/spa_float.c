@@ -0,0 +1,556 @@
+//
+//  spa_float.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+//  Single precision version of the geocentric and observer stages of spa.c, with the periodic terms of the SPA
+//  technical report (Reda & Andreas, NREL/TP-560-34302) stored as float.
+//
+#include "spa_float.h"
+#include "spa_math.h"
+#include <stddef.h>
+
+#define PI_F 3.14159265f
+#define DEG_TO_RAD_F (PI_F / 180.0f)
+#define RAD_TO_DEG_F (180.0f / PI_F)
+#define TWO_PI 6.283185307179586476925286766559
+
+#define L_COUNT 6
+#define B_COUNT 2
+#define R_COUNT 5
+#define Y_COUNT 63
+
+#define L_ROWS 128
+#define B_ROWS 7
+#define R_ROWS 59
+
+/// The first L1 term, which has no periodic argument. It is the mean motion of the earth, and is reduced to a
+/// single revolution in double precision rather than multiplied by the time in float [radians per millennium]
+#define EARTH_MEAN_MOTION 6283.31966747491
+
+enum { TERM_A, TERM_B, TERM_C, TERM_COUNT };
+enum { TERM_X0, TERM_X1, TERM_X2, TERM_X3, TERM_X4, TERM_X_COUNT };
+enum { TERM_PSI_A, TERM_PSI_B, TERM_EPS_C, TERM_EPS_D, TERM_PE_COUNT };
+
+#define TERM_Y_COUNT TERM_X_COUNT
+
+/// Rows of each series, the series are stored one after another in the tables below
+static const int l_subcount[L_COUNT] = {64, 33, 20, 7, 3, 1};
+static const int b_subcount[B_COUNT] = {5, 2};
+static const int r_subcount[R_COUNT] = {40, 10, 6, 2, 1};
+
+static const float L_TERMS[L_ROWS][TERM_COUNT] = {
+    // L0
+    {175347046.0f, 0.0f, 0.0f},
+    {3341656.0f, 4.6692568f, 6283.07585f},
+    {34894.0f, 4.6261f, 12566.1517f},
+    {3497.0f, 2.7441f, 5753.3849f},
+    {3418.0f, 2.8289f, 3.5231f},
+    {3136.0f, 3.6277f, 77713.7715f},
+    {2676.0f, 4.4181f, 7860.4194f},
+    {2343.0f, 6.1352f, 3930.2097f},
+    {1324.0f, 0.7425f, 11506.7698f},
+    {1273.0f, 2.0371f, 529.691f},
+    {1199.0f, 1.1096f, 1577.3435f},
+    {990.0f, 5.233f, 5884.927f},
+    {902.0f, 2.045f, 26.298f},
+    {857.0f, 3.508f, 398.149f},
+    {780.0f, 1.179f, 5223.694f},
+    {753.0f, 2.533f, 5507.553f},
+    {505.0f, 4.583f, 18849.228f},
+    {492.0f, 4.205f, 775.523f},
+    {357.0f, 2.92f, 0.067f},
+    {317.0f, 5.849f, 11790.629f},
+    {284.0f, 1.899f, 796.298f},
+    {271.0f, 0.315f, 10977.079f},
+    {243.0f, 0.345f, 5486.778f},
+    {206.0f, 4.806f, 2544.314f},
+    {205.0f, 1.869f, 5573.143f},
+    {202.0f, 2.458f, 6069.777f},
+    {156.0f, 0.833f, 213.299f},
+    {132.0f, 3.411f, 2942.463f},
+    {126.0f, 1.083f, 20.775f},
+    {115.0f, 0.645f, 0.98f},
+    {103.0f, 0.636f, 4694.003f},
+    {102.0f, 0.976f, 15720.839f},
+    {102.0f, 4.267f, 7.114f},
+    {99.0f, 6.21f, 2146.17f},
+    {98.0f, 0.68f, 155.42f},
+    {86.0f, 5.98f, 161000.69f},
+    {85.0f, 1.3f, 6275.96f},
+    {85.0f, 3.67f, 71430.7f},
+    {80.0f, 1.81f, 17260.15f},
+    {79.0f, 3.04f, 12036.46f},
+    {75.0f, 1.76f, 5088.63f},
+    {74.0f, 3.5f, 3154.69f},
+    {74.0f, 4.68f, 801.82f},
+    {70.0f, 0.83f, 9437.76f},
+    {62.0f, 3.98f, 8827.39f},
+    {61.0f, 1.82f, 7084.9f},
+    {57.0f, 2.78f, 6286.6f},
+    {56.0f, 4.39f, 14143.5f},
+    {56.0f, 3.47f, 6279.55f},
+    {52.0f, 0.19f, 12139.55f},
+    {52.0f, 1.33f, 1748.02f},
+    {51.0f, 0.28f, 5856.48f},
+    {49.0f, 0.49f, 1194.45f},
+    {41.0f, 5.37f, 8429.24f},
+    {41.0f, 2.4f, 19651.05f},
+    {39.0f, 6.17f, 10447.39f},
+    {37.0f, 6.04f, 10213.29f},
+    {37.0f, 2.57f, 1059.38f},
+    {36.0f, 1.71f, 2352.87f},
+    {36.0f, 1.78f, 6812.77f},
+    {33.0f, 0.59f, 17789.85f},
+    {30.0f, 0.44f, 83996.85f},
+    {30.0f, 2.74f, 1349.87f},
+    {25.0f, 3.16f, 4690.48f},
+    // L1, without the mean motion term
+    {206059.0f, 2.678235f, 6283.07585f},
+    {4303.0f, 2.6351f, 12566.1517f},
+    {425.0f, 1.59f, 3.523f},
+    {119.0f, 5.796f, 26.298f},
+    {109.0f, 2.966f, 1577.344f},
+    {93.0f, 2.59f, 18849.23f},
+    {72.0f, 1.14f, 529.69f},
+    {68.0f, 1.87f, 398.15f},
+    {67.0f, 4.41f, 5507.55f},
+    {59.0f, 2.89f, 5223.69f},
+    {56.0f, 2.17f, 155.42f},
+    {45.0f, 0.4f, 796.3f},
+    {36.0f, 0.47f, 775.52f},
+    {29.0f, 2.65f, 7.11f},
+    {21.0f, 5.34f, 0.98f},
+    {19.0f, 1.85f, 5486.78f},
+    {19.0f, 4.97f, 213.3f},
+    {17.0f, 2.99f, 6275.96f},
+    {16.0f, 0.03f, 2544.31f},
+    {16.0f, 1.43f, 2146.17f},
+    {15.0f, 1.21f, 10977.08f},
+    {12.0f, 2.83f, 1748.02f},
+    {12.0f, 3.26f, 5088.63f},
+    {12.0f, 5.27f, 1194.45f},
+    {12.0f, 2.08f, 4694.0f},
+    {11.0f, 0.77f, 553.57f},
+    {10.0f, 1.3f, 6286.6f},
+    {10.0f, 4.24f, 1349.87f},
+    {9.0f, 2.7f, 242.73f},
+    {9.0f, 5.64f, 951.72f},
+    {8.0f, 5.3f, 2352.87f},
+    {6.0f, 2.65f, 9437.76f},
+    {6.0f, 4.67f, 4690.48f},
+    // L2
+    {52919.0f, 0.0f, 0.0f},
+    {8720.0f, 1.0721f, 6283.0758f},
+    {309.0f, 0.867f, 12566.152f},
+    {27.0f, 0.05f, 3.52f},
+    {16.0f, 5.19f, 26.3f},
+    {16.0f, 3.68f, 155.42f},
+    {10.0f, 0.76f, 18849.23f},
+    {9.0f, 2.06f, 77713.77f},
+    {7.0f, 0.83f, 775.52f},
+    {5.0f, 4.66f, 1577.34f},
+    {4.0f, 1.03f, 7.11f},
+    {4.0f, 3.44f, 5573.14f},
+    {3.0f, 5.14f, 796.3f},
+    {3.0f, 6.05f, 5507.55f},
+    {3.0f, 1.19f, 242.73f},
+    {3.0f, 6.12f, 529.69f},
+    {3.0f, 0.31f, 398.15f},
+    {3.0f, 2.28f, 553.57f},
+    {2.0f, 4.38f, 5223.69f},
+    {2.0f, 3.75f, 0.98f},
+    // L3
+    {289.0f, 5.844f, 6283.076f},
+    {35.0f, 0.0f, 0.0f},
+    {17.0f, 5.49f, 12566.15f},
+    {3.0f, 5.2f, 155.42f},
+    {1.0f, 4.72f, 3.52f},
+    {1.0f, 5.3f, 18849.23f},
+    {1.0f, 5.97f, 242.73f},
+    // L4
+    {114.0f, 3.142f, 0.0f},
+    {8.0f, 4.13f, 6283.08f},
+    {1.0f, 3.84f, 12566.15f},
+    // L5
+    {1.0f, 3.14f, 0.0f},
+};
+
+static const float B_TERMS[B_ROWS][TERM_COUNT] = {
+    // B0
+    {280.0f, 3.199f, 84334.662f},
+    {102.0f, 5.422f, 5507.553f},
+    {80.0f, 3.88f, 5223.69f},
+    {44.0f, 3.7f, 2352.87f},
+    {32.0f, 4.0f, 1577.34f},
+    // B1
+    {9.0f, 3.9f, 5507.55f},
+    {6.0f, 1.73f, 5223.69f},
+};
+
+static const float R_TERMS[R_ROWS][TERM_COUNT] = {
+    // R0
+    {100013989.0f, 0.0f, 0.0f},
+    {1670700.0f, 3.0984635f, 6283.07585f},
+    {13956.0f, 3.05525f, 12566.1517f},
+    {3084.0f, 5.1985f, 77713.7715f},
+    {1628.0f, 1.1739f, 5753.3849f},
+    {1576.0f, 2.8469f, 7860.4194f},
+    {925.0f, 5.453f, 11506.77f},
+    {542.0f, 4.564f, 3930.21f},
+    {472.0f, 3.661f, 5884.927f},
+    {346.0f, 0.964f, 5507.553f},
+    {329.0f, 5.9f, 5223.694f},
+    {307.0f, 0.299f, 5573.143f},
+    {243.0f, 4.273f, 11790.629f},
+    {212.0f, 5.847f, 1577.344f},
+    {186.0f, 5.022f, 10977.079f},
+    {175.0f, 3.012f, 18849.228f},
+    {110.0f, 5.055f, 5486.778f},
+    {98.0f, 0.89f, 6069.78f},
+    {86.0f, 5.69f, 15720.84f},
+    {86.0f, 1.27f, 161000.69f},
+    {65.0f, 0.27f, 17260.15f},
+    {63.0f, 0.92f, 529.69f},
+    {57.0f, 2.01f, 83996.85f},
+    {56.0f, 5.24f, 71430.7f},
+    {49.0f, 3.25f, 2544.31f},
+    {47.0f, 2.58f, 775.52f},
+    {45.0f, 5.54f, 9437.76f},
+    {43.0f, 6.01f, 6275.96f},
+    {39.0f, 5.36f, 4694.0f},
+    {38.0f, 2.39f, 8827.39f},
+    {37.0f, 0.83f, 19651.05f},
+    {37.0f, 4.9f, 12139.55f},
+    {36.0f, 1.67f, 12036.46f},
+    {35.0f, 1.84f, 2942.46f},
+    {33.0f, 0.24f, 7084.9f},
+    {32.0f, 0.18f, 5088.63f},
+    {32.0f, 1.78f, 398.15f},
+    {28.0f, 1.21f, 6286.6f},
+    {28.0f, 1.9f, 6279.55f},
+    {26.0f, 4.59f, 10447.39f},
+    // R1
+    {103019.0f, 1.10749f, 6283.07585f},
+    {1721.0f, 1.0644f, 12566.1517f},
+    {702.0f, 3.142f, 0.0f},
+    {32.0f, 1.02f, 18849.23f},
+    {31.0f, 2.84f, 5507.55f},
+    {25.0f, 1.32f, 5223.69f},
+    {18.0f, 1.42f, 1577.34f},
+    {10.0f, 5.91f, 10977.08f},
+    {9.0f, 1.42f, 6275.96f},
+    {9.0f, 0.27f, 5486.78f},
+    // R2
+    {4359.0f, 5.7846f, 6283.0758f},
+    {124.0f, 5.579f, 12566.152f},
+    {12.0f, 3.14f, 0.0f},
+    {9.0f, 3.63f, 77713.77f},
+    {6.0f, 1.87f, 5573.14f},
+    {3.0f, 5.47f, 18849.23f},
+    // R3
+    {145.0f, 4.273f, 6283.076f},
+    {7.0f, 3.92f, 12566.15f},
+    // R4
+    {4.0f, 2.56f, 6283.08f},
+};
+
+static const signed char Y_TERMS[Y_COUNT][TERM_Y_COUNT] = {
+    {0, 0, 0, 0, 1},
+    {-2, 0, 0, 2, 2},
+    {0, 0, 0, 2, 2},
+    {0, 0, 0, 0, 2},
+    {0, 1, 0, 0, 0},
+    {0, 0, 1, 0, 0},
+    {-2, 1, 0, 2, 2},
+    {0, 0, 0, 2, 1},
+    {0, 0, 1, 2, 2},
+    {-2, -1, 0, 2, 2},
+    {-2, 0, 1, 0, 0},
+    {-2, 0, 0, 2, 1},
+    {0, 0, -1, 2, 2},
+    {2, 0, 0, 0, 0},
+    {0, 0, 1, 0, 1},
+    {2, 0, -1, 2, 2},
+    {0, 0, -1, 0, 1},
+    {0, 0, 1, 2, 1},
+    {-2, 0, 2, 0, 0},
+    {0, 0, -2, 2, 1},
+    {2, 0, 0, 2, 2},
+    {0, 0, 2, 2, 2},
+    {0, 0, 2, 0, 0},
+    {-2, 0, 1, 2, 2},
+    {0, 0, 0, 2, 0},
+    {-2, 0, 0, 2, 0},
+    {0, 0, -1, 2, 1},
+    {0, 2, 0, 0, 0},
+    {2, 0, -1, 0, 1},
+    {-2, 2, 0, 2, 2},
+    {0, 1, 0, 0, 1},
+    {-2, 0, 1, 0, 1},
+    {0, -1, 0, 0, 1},
+    {0, 0, 2, -2, 0},
+    {2, 0, -1, 2, 1},
+    {2, 0, 1, 2, 2},
+    {0, 1, 0, 2, 2},
+    {-2, 1, 1, 0, 0},
+    {0, -1, 0, 2, 2},
+    {2, 0, 0, 2, 1},
+    {2, 0, 1, 0, 0},
+    {-2, 0, 2, 2, 2},
+    {-2, 0, 1, 2, 1},
+    {2, 0, -2, 0, 1},
+    {2, 0, 0, 0, 1},
+    {0, -1, 1, 0, 0},
+    {-2, -1, 0, 2, 1},
+    {-2, 0, 0, 0, 1},
+    {0, 0, 2, 2, 1},
+    {-2, 0, 2, 0, 1},
+    {-2, 1, 0, 2, 1},
+    {0, 0, 1, -2, 0},
+    {-1, 0, 1, 0, 0},
+    {-2, 1, 0, 0, 0},
+    {1, 0, 0, 0, 0},
+    {0, 0, 1, 2, 0},
+    {0, 0, -2, 2, 2},
+    {-1, -1, 1, 0, 0},
+    {0, 1, 1, 0, 0},
+    {0, -1, 1, 2, 2},
+    {2, -1, -1, 2, 2},
+    {0, 0, 3, 2, 2},
+    {2, -1, 0, 2, 2},
+};
+
+static const float PE_TERMS[Y_COUNT][TERM_PE_COUNT] = {
+    {-171996.0f, -174.2f, 92025.0f, 8.9f},
+    {-13187.0f, -1.6f, 5736.0f, -3.1f},
+    {-2274.0f, -0.2f, 977.0f, -0.5f},
+    {2062.0f, 0.2f, -895.0f, 0.5f},
+    {1426.0f, -3.4f, 54.0f, -0.1f},
+    {712.0f, 0.1f, -7.0f, 0.0f},
+    {-517.0f, 1.2f, 224.0f, -0.6f},
+    {-386.0f, -0.4f, 200.0f, 0.0f},
+    {-301.0f, 0.0f, 129.0f, -0.1f},
+    {217.0f, -0.5f, -95.0f, 0.3f},
+    {-158.0f, 0.0f, 0.0f, 0.0f},
+    {129.0f, 0.1f, -70.0f, 0.0f},
+    {123.0f, 0.0f, -53.0f, 0.0f},
+    {63.0f, 0.0f, 0.0f, 0.0f},
+    {63.0f, 0.1f, -33.0f, 0.0f},
+    {-59.0f, 0.0f, 26.0f, 0.0f},
+    {-58.0f, -0.1f, 32.0f, 0.0f},
+    {-51.0f, 0.0f, 27.0f, 0.0f},
+    {48.0f, 0.0f, 0.0f, 0.0f},
+    {46.0f, 0.0f, -24.0f, 0.0f},
+    {-38.0f, 0.0f, 16.0f, 0.0f},
+    {-31.0f, 0.0f, 13.0f, 0.0f},
+    {29.0f, 0.0f, 0.0f, 0.0f},
+    {29.0f, 0.0f, -12.0f, 0.0f},
+    {26.0f, 0.0f, 0.0f, 0.0f},
+    {-22.0f, 0.0f, 0.0f, 0.0f},
+    {21.0f, 0.0f, -10.0f, 0.0f},
+    {17.0f, -0.1f, 0.0f, 0.0f},
+    {16.0f, 0.0f, -8.0f, 0.0f},
+    {-16.0f, 0.1f, 7.0f, 0.0f},
+    {-15.0f, 0.0f, 9.0f, 0.0f},
+    {-13.0f, 0.0f, 7.0f, 0.0f},
+    {-12.0f, 0.0f, 6.0f, 0.0f},
+    {11.0f, 0.0f, 0.0f, 0.0f},
+    {-10.0f, 0.0f, 5.0f, 0.0f},
+    {-8.0f, 0.0f, 3.0f, 0.0f},
+    {7.0f, 0.0f, -3.0f, 0.0f},
+    {-7.0f, 0.0f, 0.0f, 0.0f},
+    {-7.0f, 0.0f, 3.0f, 0.0f},
+    {-7.0f, 0.0f, 3.0f, 0.0f},
+    {6.0f, 0.0f, 0.0f, 0.0f},
+    {6.0f, 0.0f, -3.0f, 0.0f},
+    {6.0f, 0.0f, -3.0f, 0.0f},
+    {-6.0f, 0.0f, 3.0f, 0.0f},
+    {-6.0f, 0.0f, 3.0f, 0.0f},
+    {5.0f, 0.0f, 0.0f, 0.0f},
+    {-5.0f, 0.0f, 3.0f, 0.0f},
+    {-5.0f, 0.0f, 3.0f, 0.0f},
+    {-5.0f, 0.0f, 3.0f, 0.0f},
+    {4.0f, 0.0f, 0.0f, 0.0f},
+    {4.0f, 0.0f, 0.0f, 0.0f},
+    {4.0f, 0.0f, 0.0f, 0.0f},
+    {-4.0f, 0.0f, 0.0f, 0.0f},
+    {-4.0f, 0.0f, 0.0f, 0.0f},
+    {-4.0f, 0.0f, 0.0f, 0.0f},
+    {3.0f, 0.0f, 0.0f, 0.0f},
+    {-3.0f, 0.0f, 0.0f, 0.0f},
+    {-3.0f, 0.0f, 0.0f, 0.0f},
+    {-3.0f, 0.0f, 0.0f, 0.0f},
+    {-3.0f, 0.0f, 0.0f, 0.0f},
+    {-3.0f, 0.0f, 0.0f, 0.0f},
+    {-3.0f, 0.0f, 0.0f, 0.0f},
+    {-3.0f, 0.0f, 0.0f, 0.0f},
+};
+
+static float limit_degrees(float degrees) {
+    float limited = degrees - 360.0f * floorf(degrees / 360.0f);
+    return limited < 0.0f ? limited + 360.0f : limited;
+}
+
+static float third_order_polynomial(float a, float b, float c, float d, float x) {
+    return ((a * x + b) * x + c) * x + d;
+}
+
+/// Sum a polynomial in jme of periodic series, stored one after another in a table
+static float earth_values(const float terms[][TERM_COUNT], const int *subcount, int count, float jme) {
+    float sum = 0.0f, power = 1.0f;
+    int i, j, row = 0;
+    for (i = 0; i < count; i++) {
+        float series = 0.0f;
+        for (j = 0; j < subcount[i]; j++, row++) {
+            series += terms[row][TERM_A] * cosf(terms[row][TERM_B] + terms[row][TERM_C] * jme);
+        }
+        sum += series * power;
+        power *= jme;
+    }
+    return sum / 1.0e8f;
+}
+
+/// Nutation in longitude and obliquity [degrees]
+static void nutation_longitude_and_obliquity(float jce, float *del_psi, float *del_epsilon) {
+    float x[TERM_X_COUNT], sum_psi = 0.0f, sum_epsilon = 0.0f;
+    int i, j;
+
+    // Reduced to a single revolution, so that the sums of the arguments stay small
+    x[TERM_X0] = limit_degrees(third_order_polynomial(1.0f / 189474.0f, -0.0019142f, 445267.11148f, 297.85036f, jce));
+    x[TERM_X1] = limit_degrees(third_order_polynomial(-1.0f / 300000.0f, -0.0001603f, 35999.05034f, 357.52772f, jce));
+    x[TERM_X2] = limit_degrees(third_order_polynomial(1.0f / 56250.0f, 0.0086972f, 477198.867398f, 134.96298f, jce));
+    x[TERM_X3] = limit_degrees(third_order_polynomial(1.0f / 327270.0f, -0.0036825f, 483202.017538f, 93.27191f, jce));
+    x[TERM_X4] = limit_degrees(third_order_polynomial(1.0f / 450000.0f, 0.0020708f, -1934.136261f, 125.04452f, jce));
+
+    for (i = 0; i < Y_COUNT; i++) {
+        float argument = 0.0f;
+        for (j = 0; j < TERM_Y_COUNT; j++) {
+            argument += x[j] * (float) Y_TERMS[i][j];
+        }
+        argument *= DEG_TO_RAD_F;
+        sum_psi += (PE_TERMS[i][TERM_PSI_A] + jce * PE_TERMS[i][TERM_PSI_B]) * sinf(argument);
+        sum_epsilon += (PE_TERMS[i][TERM_EPS_C] + jce * PE_TERMS[i][TERM_EPS_D]) * cosf(argument);
+    }
+    *del_psi = sum_psi / 36000000.0f;
+    *del_epsilon = sum_epsilon / 36000000.0f;
+}
+
+/// Mean obliquity of the ecliptic [arc seconds]
+static float ecliptic_mean_obliquity(float jme) {
+    static const float coefficients[] = {
+        2.45f, 5.79f, 27.87f, 7.12f, -39.05f, -249.67f, -51.38f, 1999.25f, -1.55f, -4680.93f, 84381.448f};
+    float u = jme / 10.0f, sum = 0.0f;
+    size_t i;
+    for (i = 0; i < sizeof(coefficients) / sizeof(coefficients[0]); i++) {
+        sum = sum * u + coefficients[i];
+    }
+    return sum;
+}
+
+SpaError spa_float_calculate_ephemeris(spa_float_ephemeris *ephemeris, double jd, double delta_t) {
+    double days, jc, jce_wide, mean_motion, nu0;
+    float jce, jme, l, b, r, del_psi, del_epsilon, epsilon, lambda, beta, sin_lambda;
+
+    // Same range as the SPA: -2000-01-01 00:00 to 6000-12-31 23:59:59
+    if (jd < SPA_MIN_JD || jd > SPA_MAX_JD) {
+        return SpaError_UnsupportedDate;
+    }
+    if (fabs(delta_t) > SPA_MAX_DELTA_T) {
+        return SpaError_InvalidDeltaT;
+    }
+
+    // The growing time arguments in double precision
+    days = jd - 2451545.0;
+    jce_wide = (days + delta_t / 86400.0) / 36525.0;
+    mean_motion = EARTH_MEAN_MOTION * (jce_wide / 10.0);
+    mean_motion -= TWO_PI * floor(mean_motion / TWO_PI);
+    jc = days / 36525.0;
+    nu0 = 280.46061837 + 360.98564736629 * days + jc * jc * (0.000387933 - jc / 38710000.0);
+    nu0 -= 360.0 * floor(nu0 / 360.0);
+    jce = (float) jce_wide;
+    jme = jce / 10.0f;
+
+    // Heliocentric position of the earth, and the geocentric longitude and latitude of the sun
+    l = earth_values(L_TERMS, l_subcount, L_COUNT, jme) + (float) mean_motion;
+    b = earth_values(B_TERMS, b_subcount, B_COUNT, jme);
+    r = earth_values(R_TERMS, r_subcount, R_COUNT, jme);
+    beta = -b;
+
+    // Apparent longitude, corrected for nutation and aberration, and the true obliquity
+    nutation_longitude_and_obliquity(jce, &del_psi, &del_epsilon);
+    epsilon = (del_epsilon + ecliptic_mean_obliquity(jme) / 3600.0f) * DEG_TO_RAD_F;
+    lambda = limit_degrees(l * RAD_TO_DEG_F + 180.0f + del_psi - 20.4898f / (3600.0f * r)) * DEG_TO_RAD_F;
+
+    sin_lambda = sinf(lambda);
+    ephemeris->nu = (float) nu0 + del_psi * cosf(epsilon);
+    ephemeris->alpha =
+        limit_degrees(atan2f(sin_lambda * cosf(epsilon) - tanf(beta) * sinf(epsilon), cosf(lambda)) * RAD_TO_DEG_F);
+    ephemeris->delta = asinf(sinf(beta) * cosf(epsilon) + cosf(beta) * sinf(epsilon) * sin_lambda) * RAD_TO_DEG_F;
+    ephemeris->xi = 8.794f / (3600.0f * r);
+
+    ephemeris->sin_delta = sinf(ephemeris->delta * DEG_TO_RAD_F);
+    ephemeris->cos_delta = cosf(ephemeris->delta * DEG_TO_RAD_F);
+    ephemeris->sin_xi = sinf(ephemeris->xi * DEG_TO_RAD_F);
+    return SpaError_Success;
+}
+
+void spa_float_ephemeris_widen(spa_ephemeris *ephemeris, const spa_float_ephemeris *source, double jd, double delta_t) {
+    ephemeris->jd = jd;
+    ephemeris->delta_t = delta_t;
+    ephemeris->nu = source->nu;
+    ephemeris->alpha = source->alpha;
+    ephemeris->delta = source->delta;
+    ephemeris->xi = source->xi;
+    ephemeris->sin_delta = source->sin_delta;
+    ephemeris->cos_delta = source->cos_delta;
+    ephemeris->sin_xi = source->sin_xi;
+}
+
+void spa_float_observer_init(spa_float_observer *observer, const spa_observer *source) {
+    observer->longitude = (float) source->longitude;
+    observer->sin_lat = (float) source->sin_lat;
+    observer->cos_lat = (float) source->cos_lat;
+    observer->x = (float) source->x;
+    observer->y = (float) source->y;
+    observer->refract_scale = (float) source->refract_scale;
+    observer->refract_limit = (float) source->refract_limit;
+}
+
+float spa_float_calculate_elevation(const spa_float_ephemeris *ephemeris, const spa_float_observer *observer) {
+    return spa_float_observer_refraction_corrected(observer,
+                                                   spa_float_calculate_elevation_uncorrected(ephemeris, observer));
+}
+
+float spa_float_calculate_elevation_uncorrected(const spa_float_ephemeris *ephemeris,
+                                                const spa_float_observer *observer) {
+    float h, sin_h, cos_h, x_sin_xi, denominator, delta_alpha, delta_prime, sin_e;
+
+    // Observer hour angle, and the topocentric parallax in right ascension and declination
+    h = limit_degrees(ephemeris->nu + observer->longitude - ephemeris->alpha) * DEG_TO_RAD_F;
+    sin_h = sinf(h);
+    cos_h = cosf(h);
+    x_sin_xi = observer->x * ephemeris->sin_xi;
+    denominator = ephemeris->cos_delta - x_sin_xi * cos_h;
+    delta_alpha = atan2f(-x_sin_xi * sin_h, denominator);
+    delta_prime = atan2f((ephemeris->sin_delta - observer->y * ephemeris->sin_xi) * cosf(delta_alpha), denominator);
+
+    // Rounding can take the sine just past 1 with the sun overhead
+    sin_e = observer->sin_lat * sinf(delta_prime) + observer->cos_lat * cosf(delta_prime) * cosf(h - delta_alpha);
+    return asinf(sin_e < 1.0f ? sin_e : 1.0f) * RAD_TO_DEG_F;
+}
+
+float spa_float_observer_refraction_corrected(const spa_float_observer *observer, float e0) {
+    float del_e = observer->refract_scale / (60.0f * tanf((e0 + 10.3f / (e0 + 5.11f)) * DEG_TO_RAD_F));
+    return e0 >= observer->refract_limit ? e0 + del_e : e0;
+}
+
+void spa_float_calculate_elevations(int count,
+                                    const spa_float_ephemeris *ephemerides,
+                                    const spa_float_observer *observers,
+                                    float *elevations) {
+    int i;
+    for (i = 0; i < count; i++) {
+        elevations[i] = spa_float_calculate_elevation(&ephemerides[i], &observers[i]);
+    }
+}
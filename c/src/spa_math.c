@@ -0,0 +1,367 @@
+//
+//  spa_math.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+#define SPA_MATH_NO_REDIRECT
+#include "spa_math.h"
+#include <stdint.h>
+#ifdef SPA_MATH_SELECTABLE
+#include <math.h>
+#endif
+
+#define PI 3.14159265358979323846
+#define PI_2 1.57079632679489661923
+#define PI_6 0.52359877559829887308
+#define TWO_OVER_PI 0.63661977236758134308
+#define SQRT_3 1.73205080756887729353
+#define TAN_PI_12 0.26794919243112270647
+
+/// pi/2 split into the first 33 bits, which multiplied by a quadrant below 2^20 is exact, and the rest
+#define PI_2_HIGH 1.57079632673412561417e+00
+#define PI_2_LOW 6.07710050650619224932e-11
+
+/// The same split for float, exact for quadrants below 2^16
+#define PI_2_HIGH_F 1.5703125f
+#define PI_2_LOW_F 4.83826794897e-4f
+
+#ifdef SPA_MATH_SELECTABLE
+static bool use_libm = false;
+
+void spa_math_use_libm(bool libm) {
+    use_libm = libm;
+}
+
+#define SELECT_LIBM(call)                                                                                              \
+    if (use_libm) {                                                                                                    \
+        return call;                                                                                                   \
+    }
+#else
+#define SELECT_LIBM(call)
+#endif
+
+//-------------------------------------------------------------------------
+// Double precision
+//-------------------------------------------------------------------------
+
+/// Doubles at least this large are whole numbers
+#define FLOOR_LIMIT 4503599627370496.0
+
+double spa_math_floor(double x) {
+    double truncated;
+    SELECT_LIBM(floor(x))
+    if (!(x > -FLOOR_LIMIT && x < FLOOR_LIMIT)) {
+        return x;
+    }
+    truncated = (double) (int64_t) x;
+    return truncated > x ? truncated - 1.0 : truncated;
+}
+
+double spa_math_ceil(double x) {
+    SELECT_LIBM(ceil(x))
+    return -spa_math_floor(-x);
+}
+
+double spa_math_fabs(double x) {
+    SELECT_LIBM(fabs(x))
+    return x < 0.0 ? -x : x;
+}
+
+double spa_math_fmod(double x, double y) {
+    double quotient;
+    SELECT_LIBM(fmod(x, y))
+    quotient = x / y;
+    // Truncated towards zero, so the result has the sign of x
+    quotient = quotient < 0.0 ? -spa_math_floor(-quotient) : spa_math_floor(quotient);
+    return x - quotient * y;
+}
+
+double spa_math_pow(double x, double y) {
+    double result = 1.0;
+    int64_t exponent = (int64_t) (y < 0.0 ? -y : y);
+    SELECT_LIBM(pow(x, y))
+    while (exponent-- > 0) {
+        result *= x;
+    }
+    return y < 0.0 ? 1.0 / result : result;
+}
+
+/// Reduce x to [-pi/4, pi/4] (up to rounding)
+/// @param x Angle [radians]
+/// @param[out] quadrant Number of pi/2 that were subtracted, modulo 4
+/// @return x - quadrant * pi/2
+static double reduce(double x, int *quadrant) {
+    double k = spa_math_floor(x * TWO_OVER_PI + 0.5);
+    *quadrant = (int) ((int64_t) k & 3);
+    return (x - k * PI_2_HIGH) - k * PI_2_LOW;
+}
+
+/// Taylor series of sin to r^15 for |r| <= pi/4, truncation error below 1e-16
+static double sin_kernel(double r) {
+    double r2 = r * r;
+    return r + r * r2 *
+                   (-1.0 / 6.0 +
+                    r2 * (1.0 / 120.0 +
+                          r2 * (-1.0 / 5040.0 +
+                                r2 * (1.0 / 362880.0 +
+                                      r2 * (-1.0 / 39916800.0 +
+                                            r2 * (1.0 / 6227020800.0 + r2 * (-1.0 / 1307674368000.0)))))));
+}
+
+/// Taylor series of cos to r^16 for |r| <= pi/4, truncation error below 1e-17
+static double cos_kernel(double r) {
+    double r2 = r * r;
+    return 1.0 +
+           r2 * (-1.0 / 2.0 +
+                 r2 * (1.0 / 24.0 +
+                       r2 * (-1.0 / 720.0 +
+                             r2 * (1.0 / 40320.0 +
+                                   r2 * (-1.0 / 3628800.0 +
+                                         r2 * (1.0 / 479001600.0 +
+                                               r2 * (-1.0 / 87178291200.0 + r2 * (1.0 / 20922789888000.0))))))));
+}
+
+double spa_math_sin(double x) {
+    int quadrant;
+    double r;
+    SELECT_LIBM(sin(x))
+    r = reduce(x, &quadrant);
+    switch (quadrant) {
+    case 0:
+        return sin_kernel(r);
+    case 1:
+        return cos_kernel(r);
+    case 2:
+        return -sin_kernel(r);
+    default:
+        return -cos_kernel(r);
+    }
+}
+
+double spa_math_cos(double x) {
+    int quadrant;
+    double r;
+    SELECT_LIBM(cos(x))
+    r = reduce(x, &quadrant);
+    switch (quadrant) {
+    case 0:
+        return cos_kernel(r);
+    case 1:
+        return -sin_kernel(r);
+    case 2:
+        return -cos_kernel(r);
+    default:
+        return sin_kernel(r);
+    }
+}
+
+double spa_math_tan(double x) {
+    int quadrant;
+    double r;
+    SELECT_LIBM(tan(x))
+    r = reduce(x, &quadrant);
+    return (quadrant & 1) ? -cos_kernel(r) / sin_kernel(r) : sin_kernel(r) / cos_kernel(r);
+}
+
+/// Series of atan to r^25 for |r| <= tan(pi/12), truncation error below 1e-16
+static double atan_kernel(double r) {
+    double r2 = r * r, sum = 0.0;
+    int n;
+    for (n = 12; n >= 1; n--) {
+        sum = r2 * ((n & 1 ? -1.0 : 1.0) / (2 * n + 1) + sum);
+    }
+    return r + r * sum;
+}
+
+double spa_math_atan(double x) {
+    bool negative = x < 0.0, inverted;
+    double result, offset = 0.0;
+    SELECT_LIBM(atan(x))
+    x = negative ? -x : x;
+    // atan(x) = pi/2 - atan(1/x), then atan(x) = pi/6 + atan((sqrt(3) x - 1) / (sqrt(3) + x)) brings it below pi/12
+    inverted = x > 1.0;
+    x = inverted ? 1.0 / x : x;
+    if (x > TAN_PI_12) {
+        x = (x * SQRT_3 - 1.0) / (SQRT_3 + x);
+        offset = PI_6;
+    }
+    result = offset + atan_kernel(x);
+    result = inverted ? PI_2 - result : result;
+    return negative ? -result : result;
+}
+
+double spa_math_atan2(double y, double x) {
+    SELECT_LIBM(atan2(y, x))
+    if (x > 0.0) {
+        return spa_math_atan(y / x);
+    }
+    if (x < 0.0) {
+        return spa_math_atan(y / x) + (y < 0.0 ? -PI : PI);
+    }
+    return y > 0.0 ? PI_2 : (y < 0.0 ? -PI_2 : 0.0);
+}
+
+/// Square root by Newton's method, from a first guess with half the exponent
+static double square_root(double x) {
+    union {
+        double d;
+        uint64_t u;
+    } bits;
+    double r;
+    int i;
+    if (!(x > 0.0)) {
+        return 0.0;
+    }
+    bits.d = x;
+    bits.u = (bits.u >> 1) + 0x1FF8000000000000ULL;
+    r = bits.d;
+    // The first guess is within 6%, and each iteration squares the relative error
+    for (i = 0; i < 5; i++) {
+        r = 0.5 * (r + x / r);
+    }
+    return r;
+}
+
+double spa_math_asin(double x) {
+    SELECT_LIBM(asin(x))
+    return spa_math_atan2(x, square_root((1.0 - x) * (1.0 + x)));
+}
+
+double spa_math_acos(double x) {
+    SELECT_LIBM(acos(x))
+    return spa_math_atan2(square_root((1.0 - x) * (1.0 + x)), x);
+}
+
+//-------------------------------------------------------------------------
+// Single precision
+//-------------------------------------------------------------------------
+
+/// Floats at least this large are whole numbers
+#define FLOOR_LIMIT_F 8388608.0f
+
+float spa_math_floorf(float x) {
+    float truncated;
+    SELECT_LIBM(floorf(x))
+    if (!(x > -FLOOR_LIMIT_F && x < FLOOR_LIMIT_F)) {
+        return x;
+    }
+    truncated = (float) (int32_t) x;
+    return truncated > x ? truncated - 1.0f : truncated;
+}
+
+static float reducef(float x, int *quadrant) {
+    float k = spa_math_floorf(x * (float) TWO_OVER_PI + 0.5f);
+    *quadrant = (int) ((int32_t) k & 3);
+    return (x - k * PI_2_HIGH_F) - k * PI_2_LOW_F;
+}
+
+/// Taylor series of sin to r^9 for |r| <= pi/4, truncation error below 2e-9
+static float sin_kernelf(float r) {
+    float r2 = r * r;
+    return r + r * r2 * (-1.0f / 6.0f + r2 * (1.0f / 120.0f + r2 * (-1.0f / 5040.0f + r2 * (1.0f / 362880.0f))));
+}
+
+/// Taylor series of cos to r^10 for |r| <= pi/4, truncation error below 2e-10
+static float cos_kernelf(float r) {
+    float r2 = r * r;
+    return 1.0f +
+           r2 * (-1.0f / 2.0f +
+                 r2 * (1.0f / 24.0f + r2 * (-1.0f / 720.0f + r2 * (1.0f / 40320.0f + r2 * (-1.0f / 3628800.0f)))));
+}
+
+float spa_math_sinf(float x) {
+    int quadrant;
+    float r;
+    SELECT_LIBM(sinf(x))
+    r = reducef(x, &quadrant);
+    switch (quadrant) {
+    case 0:
+        return sin_kernelf(r);
+    case 1:
+        return cos_kernelf(r);
+    case 2:
+        return -sin_kernelf(r);
+    default:
+        return -cos_kernelf(r);
+    }
+}
+
+float spa_math_cosf(float x) {
+    int quadrant;
+    float r;
+    SELECT_LIBM(cosf(x))
+    r = reducef(x, &quadrant);
+    switch (quadrant) {
+    case 0:
+        return cos_kernelf(r);
+    case 1:
+        return -sin_kernelf(r);
+    case 2:
+        return -cos_kernelf(r);
+    default:
+        return sin_kernelf(r);
+    }
+}
+
+float spa_math_tanf(float x) {
+    int quadrant;
+    float r;
+    SELECT_LIBM(tanf(x))
+    r = reducef(x, &quadrant);
+    return (quadrant & 1) ? -cos_kernelf(r) / sin_kernelf(r) : sin_kernelf(r) / cos_kernelf(r);
+}
+
+/// atan, with the series to r^13 for |r| <= tan(pi/12), truncation error below 1e-9
+static float atanf_reduced(float x) {
+    bool negative = x < 0.0f, inverted;
+    float r, r2, result, offset = 0.0f;
+    x = negative ? -x : x;
+    inverted = x > 1.0f;
+    x = inverted ? 1.0f / x : x;
+    if (x > (float) TAN_PI_12) {
+        x = (x * (float) SQRT_3 - 1.0f) / ((float) SQRT_3 + x);
+        offset = (float) PI_6;
+    }
+    r = x;
+    r2 = r * r;
+    result = r2 * (1.0f / 9.0f + r2 * (-1.0f / 11.0f + r2 / 13.0f));
+    result = r + r * r2 * (-1.0f / 3.0f + r2 * (1.0f / 5.0f + r2 * (-1.0f / 7.0f + result)));
+    result += offset;
+    result = inverted ? (float) PI_2 - result : result;
+    return negative ? -result : result;
+}
+
+float spa_math_atan2f(float y, float x) {
+    SELECT_LIBM(atan2f(y, x))
+    if (x > 0.0f) {
+        return atanf_reduced(y / x);
+    }
+    if (x < 0.0f) {
+        return atanf_reduced(y / x) + (y < 0.0f ? -(float) PI : (float) PI);
+    }
+    return y > 0.0f ? (float) PI_2 : (y < 0.0f ? -(float) PI_2 : 0.0f);
+}
+
+static float square_rootf(float x) {
+    union {
+        float f;
+        uint32_t u;
+    } bits;
+    float r;
+    int i;
+    if (!(x > 0.0f)) {
+        return 0.0f;
+    }
+    bits.f = x;
+    bits.u = (bits.u >> 1) + 0x1FC00000u;
+    r = bits.f;
+    for (i = 0; i < 4; i++) {
+        r = 0.5f * (r + x / r);
+    }
+    return r;
+}
+
+float spa_math_asinf(float x) {
+    SELECT_LIBM(asinf(x))
+    return spa_math_atan2f(x, square_rootf((1.0f - x) * (1.0f + x)));
+}
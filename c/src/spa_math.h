@@ -0,0 +1,72 @@
+//
+//  spa_math.h
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+//  The math functions used by the library, from libm or from the library's own approximations.
+//
+//  Include this instead of <math.h> in the library sources. When built with SPA_INTERNAL_MATH the libm names used by
+//  the library are redirected to the approximations in spa_math.c, so the library does not need libm at all (the
+//  nostdlib build always uses them). The approximations use Cody-Waite range reduction and series truncated to what the
+//  SPA needs: within a few ulp in double, as the periodic term sums and the SIMD kernels are compared with the scalar
+//  path to 1e-10 degrees, and 1e-7 in float. Sunrise and sunset are the same as with libm, see test_spa_math, and CI
+//  also runs every test with SSC_INTERNAL_MATH.
+//
+//  SPA_MATH_SELECTABLE also redirects, but can switch back to libm at runtime, so that tests can compare both.
+//
+#ifndef SUNRISE_SUNSET_CALCULATOR_SPA_MATH_H
+#define SUNRISE_SUNSET_CALCULATOR_SPA_MATH_H
+
+#include <stdbool.h>
+
+double spa_math_sin(double x);
+double spa_math_cos(double x);
+double spa_math_tan(double x);
+double spa_math_asin(double x);
+double spa_math_acos(double x);
+double spa_math_atan(double x);
+double spa_math_atan2(double y, double x);
+double spa_math_floor(double x);
+double spa_math_ceil(double x);
+double spa_math_fabs(double x);
+double spa_math_fmod(double x, double y);
+/// Only whole exponents, which is all the SPA raises to
+double spa_math_pow(double x, double y);
+
+float spa_math_sinf(float x);
+float spa_math_cosf(float x);
+float spa_math_tanf(float x);
+float spa_math_asinf(float x);
+float spa_math_atan2f(float y, float x);
+float spa_math_floorf(float x);
+
+#ifdef SPA_MATH_SELECTABLE
+/// Switch between libm and the approximations (the default)
+/// @param libm True to use libm
+void spa_math_use_libm(bool libm);
+#endif
+
+#if (defined(SPA_INTERNAL_MATH) || defined(SPA_MATH_SELECTABLE)) && !defined(SPA_MATH_NO_REDIRECT)
+#define sin spa_math_sin
+#define cos spa_math_cos
+#define tan spa_math_tan
+#define asin spa_math_asin
+#define acos spa_math_acos
+#define atan spa_math_atan
+#define atan2 spa_math_atan2
+#define floor spa_math_floor
+#define ceil spa_math_ceil
+#define fabs spa_math_fabs
+#define fmod spa_math_fmod
+#define pow spa_math_pow
+#define sinf spa_math_sinf
+#define cosf spa_math_cosf
+#define tanf spa_math_tanf
+#define asinf spa_math_asinf
+#define atan2f spa_math_atan2f
+#define floorf spa_math_floorf
+#else
+#include <math.h>
+#endif
+
+#endif //SUNRISE_SUNSET_CALCULATOR_SPA_MATH_H
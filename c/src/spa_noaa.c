@@ -0,0 +1,61 @@
+//
+//  spa_noaa.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+#include "spa_noaa.h"
+#define _USE_MATH_DEFINES
+#include "spa_math.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define DEG_TO_RAD (M_PI / 180.0)
+#define RAD_TO_DEG (180.0 / M_PI)
+
+SpaError spa_noaa_calculate_ephemeris(spa_ephemeris *ephemeris, double jd, double delta_t) {
+    double t, l0, m, e, c, true_longitude, true_anomaly, r, omega, lambda, epsilon0, epsilon, alpha, delta;
+    double sin_m, sin_lambda;
+
+    // Same range as the SPA: -2000-01-01 00:00 to 6000-12-31 23:59:59
+    if (jd < SPA_MIN_JD || jd > SPA_MAX_JD) {
+        return SpaError_UnsupportedDate;
+    }
+    if (fabs(delta_t) > SPA_MAX_DELTA_T) {
+        return SpaError_InvalidDeltaT;
+    }
+
+    // Julian ephemeris century
+    t = (jd + delta_t / 86400.0 - 2451545.0) / 36525.0;
+
+    // Geometric mean longitude and anomaly of the sun, eccentricity of earth's orbit
+    l0 = 280.46646 + t * (36000.76983 + t * 0.0003032);
+    m = 357.52911 + t * (35999.05029 - t * 0.0001537);
+    e = 0.016708634 - t * (0.000042037 + t * 0.0000001267);
+
+    // Equation of the centre
+    sin_m = sin(m * DEG_TO_RAD);
+    c = sin_m * (1.914602 - t * (0.004817 + t * 0.000014)) + sin(2.0 * m * DEG_TO_RAD) * (0.019993 - t * 0.000101) +
+        sin(3.0 * m * DEG_TO_RAD) * 0.000289;
+    true_longitude = l0 + c;
+    true_anomaly = m + c;
+    r = 1.000001018 * (1.0 - e * e) / (1.0 + e * cos(true_anomaly * DEG_TO_RAD));
+
+    // Apparent longitude, corrected for aberration and the main nutation term
+    omega = 125.04 - 1934.136 * t;
+    lambda = true_longitude - 0.00569 - 0.00478 * sin(omega * DEG_TO_RAD);
+
+    // Mean obliquity, and true obliquity with the main nutation term
+    epsilon0 = 23.0 + (26.0 + (21.448 - t * (46.815 + t * (0.00059 - t * 0.001813))) / 60.0) / 60.0;
+    epsilon = epsilon0 + 0.00256 * cos(omega * DEG_TO_RAD);
+
+    sin_lambda = sin(lambda * DEG_TO_RAD);
+    alpha = atan2(cos(epsilon * DEG_TO_RAD) * sin_lambda, cos(lambda * DEG_TO_RAD)) * RAD_TO_DEG;
+    delta = asin(sin(epsilon * DEG_TO_RAD) * sin_lambda) * RAD_TO_DEG;
+
+    // Equation of the equinoxes from the main nutation in longitude term
+    spa_ephemeris_from_geocentric(
+        ephemeris, jd, delta_t, alpha, delta, r, -0.00478 * sin(omega * DEG_TO_RAD) * cos(epsilon * DEG_TO_RAD));
+    return SpaError_Success;
+}
@@ -0,0 +1,449 @@
+//
+//  spa_simd.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+#include "spa_simd.h"
+#include "spa_math.h"
+#include <stddef.h>
+
+#if !defined(SPA_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64))
+#define SPA_SIMD_X86
+#endif
+
+#ifdef SPA_SIMD_X86
+
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SPA_TARGET(features)
+#else
+#include <cpuid.h>
+#define SPA_TARGET(features) __attribute__((target(features)))
+#endif
+
+// The vectorised cosine reduces x by multiples of pi, r = x - q*pi, using a three part split of pi so that q*PI_A and
+// q*PI_B are exact for |q| < 2^20. Earth periodic term arguments stay below 10^6 radians over the supported dates.
+#define COS_INV_PI 0.3183098861837907
+#define COS_PI_A 3.1415926534682512
+#define COS_PI_B 1.2154201012607932e-10
+#define COS_PI_C 4.044532497591901e-21
+// Adding then subtracting 1.5 * 2^52 rounds to the nearest integer, which is left in the low mantissa bits
+#define COS_ROUND_MAGIC 6755399441055744.0
+
+// Taylor series of cos(r) in r^2 for |r| <= pi/2, truncation error below 2e-17
+#define COS_C1 (-1.0 / 2.0)
+#define COS_C2 (1.0 / 24.0)
+#define COS_C3 (-1.0 / 720.0)
+#define COS_C4 (1.0 / 40320.0)
+#define COS_C5 (-1.0 / 3628800.0)
+#define COS_C6 (1.0 / 479001600.0)
+#define COS_C7 (-1.0 / 87178291200.0)
+#define COS_C8 (1.0 / 20922789888000.0)
+#define COS_C9 (-1.0 / 6402373705728000.0)
+#define COS_C10 (1.0 / 2432902008176640000.0)
+
+// Cephes atan, atan(a) = a + a z P(z) / Q(z) with z = a^2 after reducing |x| to |a| <= 0.66, error below 2.3e-16
+#define ATAN_P0 (-8.750608600031904122785e-1)
+#define ATAN_P1 (-1.615753718733365076637e1)
+#define ATAN_P2 (-7.500855792314704667340e1)
+#define ATAN_P3 (-1.228866684490136173410e2)
+#define ATAN_P4 (-6.485021904942025371773e1)
+#define ATAN_Q0 2.485846490142306297962e1
+#define ATAN_Q1 1.650270098316988542046e2
+#define ATAN_Q2 4.328810604912902668951e2
+#define ATAN_Q3 4.853903996359136964868e2
+#define ATAN_Q4 1.945506571482613964425e2
+#define ATAN_T3P8 2.41421356237309504880       // tan(3 pi / 8), above which atan(x) = pi/2 + atan(-1/x)
+#define ATAN_MID 0.66                           // above which atan(x) = pi/4 + atan((x - 1) / (x + 1))
+#define ATAN_MOREBITS 6.123233995736765886130e-17 // pi/2 - (double) pi/2
+
+#define SIMD_PI 3.1415926535897932384626433832795028841971
+#define SIMD_DEG2RAD (SIMD_PI / 180.0)
+#define SIMD_RAD2DEG (180.0 / SIMD_PI)
+
+static double tail_summation(const double terms[][3], int start, int count, double jme) {
+    int i;
+    double sum = 0;
+    for (i = start; i < count; i++) {
+        sum += terms[i][0] * cos(terms[i][1] + terms[i][2] * jme);
+    }
+    return sum;
+}
+
+/*------------------------------------ SSE2 ------------------------------------*/
+
+static __m128d cos_sse2(__m128d x) {
+    const __m128d magic = _mm_set1_pd(COS_ROUND_MAGIC);
+    __m128d t = _mm_add_pd(_mm_mul_pd(x, _mm_set1_pd(COS_INV_PI)), magic);
+    __m128d q = _mm_sub_pd(t, magic);
+    __m128d r = _mm_sub_pd(x, _mm_mul_pd(q, _mm_set1_pd(COS_PI_A)));
+    r = _mm_sub_pd(r, _mm_mul_pd(q, _mm_set1_pd(COS_PI_B)));
+    r = _mm_sub_pd(r, _mm_mul_pd(q, _mm_set1_pd(COS_PI_C)));
+    __m128d z = _mm_mul_pd(r, r);
+    __m128d p = _mm_set1_pd(COS_C10);
+    p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(COS_C9));
+    p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(COS_C8));
+    p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(COS_C7));
+    p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(COS_C6));
+    p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(COS_C5));
+    p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(COS_C4));
+    p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(COS_C3));
+    p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(COS_C2));
+    p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(COS_C1));
+    p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(1.0));
+    // cos(r + q*pi) = (-1)^q cos(r), the parity of q is the lowest mantissa bit of t
+    __m128i sign = _mm_slli_epi64(_mm_castpd_si128(t), 63);
+    return _mm_xor_pd(p, _mm_castsi128_pd(sign));
+}
+
+static double summation_sse2(const double terms[][3], int count, double jme) {
+    __m128d acc = _mm_setzero_pd();
+    __m128d vjme = _mm_set1_pd(jme);
+    double lanes[2];
+    int i;
+    for (i = 0; i + 2 <= count; i += 2) {
+        __m128d a = _mm_set_pd(terms[i + 1][0], terms[i][0]);
+        __m128d b = _mm_set_pd(terms[i + 1][1], terms[i][1]);
+        __m128d c = _mm_set_pd(terms[i + 1][2], terms[i][2]);
+        __m128d x = _mm_add_pd(b, _mm_mul_pd(c, vjme));
+        acc = _mm_add_pd(acc, _mm_mul_pd(a, cos_sse2(x)));
+    }
+    _mm_storeu_pd(lanes, acc);
+    return lanes[0] + lanes[1] + tail_summation(terms, i, count, jme);
+}
+
+/// Select a where the mask is set and b elsewhere, SSE2 has no blend
+static __m128d select_sse2(__m128d mask, __m128d a, __m128d b) {
+    return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+}
+
+static __m128d atan_sse2(__m128d x) {
+    const __m128d sign_mask = _mm_set1_pd(-0.0);
+    const __m128d one = _mm_set1_pd(1.0);
+    __m128d sign = _mm_and_pd(x, sign_mask);
+    __m128d a = _mm_andnot_pd(sign_mask, x);
+    __m128d big = _mm_cmpgt_pd(a, _mm_set1_pd(ATAN_T3P8));
+    __m128d mid = _mm_andnot_pd(big, _mm_cmpgt_pd(a, _mm_set1_pd(ATAN_MID)));
+    __m128d y = select_sse2(big, _mm_set1_pd(SIMD_PI / 2), select_sse2(mid, _mm_set1_pd(SIMD_PI / 4), _mm_setzero_pd()));
+    __m128d more =
+        select_sse2(big, _mm_set1_pd(ATAN_MOREBITS), select_sse2(mid, _mm_set1_pd(0.5 * ATAN_MOREBITS), _mm_setzero_pd()));
+    a = select_sse2(big,
+                    _mm_div_pd(_mm_set1_pd(-1.0), a),
+                    select_sse2(mid, _mm_div_pd(_mm_sub_pd(a, one), _mm_add_pd(a, one)), a));
+    __m128d z = _mm_mul_pd(a, a);
+    __m128d p = _mm_set1_pd(ATAN_P0);
+    p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(ATAN_P1));
+    p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(ATAN_P2));
+    p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(ATAN_P3));
+    p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(ATAN_P4));
+    __m128d q = _mm_add_pd(z, _mm_set1_pd(ATAN_Q0));
+    q = _mm_add_pd(_mm_mul_pd(q, z), _mm_set1_pd(ATAN_Q1));
+    q = _mm_add_pd(_mm_mul_pd(q, z), _mm_set1_pd(ATAN_Q2));
+    q = _mm_add_pd(_mm_mul_pd(q, z), _mm_set1_pd(ATAN_Q3));
+    q = _mm_add_pd(_mm_mul_pd(q, z), _mm_set1_pd(ATAN_Q4));
+    __m128d t = _mm_add_pd(_mm_mul_pd(a, _mm_div_pd(_mm_mul_pd(z, p), q)), a);
+    return _mm_or_pd(_mm_add_pd(y, _mm_add_pd(t, more)), sign);
+}
+
+// The topocentric elevation from the direction of the sun from the observer, A towards the meridian, B towards the
+// east and C towards the pole, which is the same as the parallax corrected declination and hour angle of the scalar
+// path without the two atan2 and the asin
+static void elevations_sse2(const spa_observer_block *block, int count, double *elevations) {
+    double out[SPA_SIMD_BLOCK];
+    int i;
+    for (i = 0; i < count; i += 2) {
+        __m128d h = _mm_mul_pd(_mm_loadu_pd(&block->hour_angle[i]), _mm_set1_pd(SIMD_DEG2RAD));
+        __m128d sin_xi = _mm_loadu_pd(&block->sin_xi[i]);
+        __m128d cos_delta = _mm_loadu_pd(&block->cos_delta[i]);
+        __m128d sin_lat = _mm_loadu_pd(&block->sin_lat[i]);
+        __m128d cos_lat = _mm_loadu_pd(&block->cos_lat[i]);
+        __m128d a = _mm_sub_pd(_mm_mul_pd(cos_delta, cos_sse2(h)), _mm_mul_pd(_mm_loadu_pd(&block->x[i]), sin_xi));
+        __m128d b = _mm_mul_pd(cos_delta, cos_sse2(_mm_sub_pd(h, _mm_set1_pd(SIMD_PI / 2))));
+        __m128d c = _mm_sub_pd(_mm_loadu_pd(&block->sin_delta[i]), _mm_mul_pd(_mm_loadu_pd(&block->y[i]), sin_xi));
+        __m128d up = _mm_add_pd(_mm_mul_pd(sin_lat, c), _mm_mul_pd(cos_lat, a));
+        __m128d north = _mm_sub_pd(_mm_mul_pd(cos_lat, c), _mm_mul_pd(sin_lat, a));
+        __m128d across = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(north, north), _mm_mul_pd(b, b)));
+        __m128d e0 = _mm_mul_pd(atan_sse2(_mm_div_pd(up, across)), _mm_set1_pd(SIMD_RAD2DEG));
+        // Refraction, scale / (60 tan(e0 + 10.3 / (e0 + 5.11))) from the refraction limit up
+        __m128d r = _mm_add_pd(e0, _mm_div_pd(_mm_set1_pd(10.3), _mm_add_pd(e0, _mm_set1_pd(5.11))));
+        r = _mm_mul_pd(r, _mm_set1_pd(SIMD_DEG2RAD));
+        __m128d del_e =
+            _mm_div_pd(_mm_mul_pd(_mm_loadu_pd(&block->refract_scale[i]), cos_sse2(r)),
+                       _mm_mul_pd(_mm_set1_pd(60.0), cos_sse2(_mm_sub_pd(r, _mm_set1_pd(SIMD_PI / 2)))));
+        del_e = _mm_and_pd(_mm_cmpge_pd(e0, _mm_loadu_pd(&block->refract_limit[i])), del_e);
+        _mm_storeu_pd(&out[i], _mm_add_pd(e0, del_e));
+    }
+    for (i = 0; i < count; i++) {
+        elevations[i] = out[i];
+    }
+}
+
+/*------------------------------------ AVX2 ------------------------------------*/
+
+SPA_TARGET("avx2,fma") static __m256d cos_avx2(__m256d x) {
+    const __m256d magic = _mm256_set1_pd(COS_ROUND_MAGIC);
+    __m256d t = _mm256_fmadd_pd(x, _mm256_set1_pd(COS_INV_PI), magic);
+    __m256d q = _mm256_sub_pd(t, magic);
+    __m256d r = _mm256_fnmadd_pd(q, _mm256_set1_pd(COS_PI_A), x);
+    r = _mm256_fnmadd_pd(q, _mm256_set1_pd(COS_PI_B), r);
+    r = _mm256_fnmadd_pd(q, _mm256_set1_pd(COS_PI_C), r);
+    __m256d z = _mm256_mul_pd(r, r);
+    __m256d p = _mm256_set1_pd(COS_C10);
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(COS_C9));
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(COS_C8));
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(COS_C7));
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(COS_C6));
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(COS_C5));
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(COS_C4));
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(COS_C3));
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(COS_C2));
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(COS_C1));
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(1.0));
+    __m256i sign = _mm256_slli_epi64(_mm256_castpd_si256(t), 63);
+    return _mm256_xor_pd(p, _mm256_castsi256_pd(sign));
+}
+
+SPA_TARGET("avx2,fma") static double summation_avx2(const double terms[][3], int count, double jme) {
+    const __m128i stride = _mm_setr_epi32(0, 3, 6, 9);
+    __m256d acc = _mm256_setzero_pd();
+    __m256d vjme = _mm256_set1_pd(jme);
+    double lanes[4];
+    int i;
+    for (i = 0; i + 4 <= count; i += 4) {
+        __m256d a = _mm256_i32gather_pd(&terms[i][0], stride, 8);
+        __m256d b = _mm256_i32gather_pd(&terms[i][1], stride, 8);
+        __m256d c = _mm256_i32gather_pd(&terms[i][2], stride, 8);
+        __m256d x = _mm256_fmadd_pd(c, vjme, b);
+        acc = _mm256_fmadd_pd(a, cos_avx2(x), acc);
+    }
+    _mm256_storeu_pd(lanes, acc);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + tail_summation(terms, i, count, jme);
+}
+
+SPA_TARGET("avx2,fma") static __m256d atan_avx2(__m256d x) {
+    const __m256d sign_mask = _mm256_set1_pd(-0.0);
+    const __m256d one = _mm256_set1_pd(1.0);
+    __m256d sign = _mm256_and_pd(x, sign_mask);
+    __m256d a = _mm256_andnot_pd(sign_mask, x);
+    __m256d big = _mm256_cmp_pd(a, _mm256_set1_pd(ATAN_T3P8), _CMP_GT_OQ);
+    __m256d mid = _mm256_andnot_pd(big, _mm256_cmp_pd(a, _mm256_set1_pd(ATAN_MID), _CMP_GT_OQ));
+    __m256d y = _mm256_blendv_pd(
+        _mm256_blendv_pd(_mm256_setzero_pd(), _mm256_set1_pd(SIMD_PI / 4), mid), _mm256_set1_pd(SIMD_PI / 2), big);
+    __m256d more = _mm256_blendv_pd(_mm256_blendv_pd(_mm256_setzero_pd(), _mm256_set1_pd(0.5 * ATAN_MOREBITS), mid),
+                                    _mm256_set1_pd(ATAN_MOREBITS),
+                                    big);
+    a = _mm256_blendv_pd(_mm256_blendv_pd(a, _mm256_div_pd(_mm256_sub_pd(a, one), _mm256_add_pd(a, one)), mid),
+                         _mm256_div_pd(_mm256_set1_pd(-1.0), a),
+                         big);
+    __m256d z = _mm256_mul_pd(a, a);
+    __m256d p = _mm256_set1_pd(ATAN_P0);
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(ATAN_P1));
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(ATAN_P2));
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(ATAN_P3));
+    p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(ATAN_P4));
+    __m256d q = _mm256_add_pd(z, _mm256_set1_pd(ATAN_Q0));
+    q = _mm256_fmadd_pd(q, z, _mm256_set1_pd(ATAN_Q1));
+    q = _mm256_fmadd_pd(q, z, _mm256_set1_pd(ATAN_Q2));
+    q = _mm256_fmadd_pd(q, z, _mm256_set1_pd(ATAN_Q3));
+    q = _mm256_fmadd_pd(q, z, _mm256_set1_pd(ATAN_Q4));
+    __m256d t = _mm256_fmadd_pd(a, _mm256_div_pd(_mm256_mul_pd(z, p), q), a);
+    return _mm256_or_pd(_mm256_add_pd(y, _mm256_add_pd(t, more)), sign);
+}
+
+// As elevations_sse2()
+SPA_TARGET("avx2,fma") static void elevations_avx2(const spa_observer_block *block, int count, double *elevations) {
+    double out[SPA_SIMD_BLOCK];
+    int i;
+    for (i = 0; i < count; i += 4) {
+        __m256d h = _mm256_mul_pd(_mm256_loadu_pd(&block->hour_angle[i]), _mm256_set1_pd(SIMD_DEG2RAD));
+        __m256d sin_xi = _mm256_loadu_pd(&block->sin_xi[i]);
+        __m256d cos_delta = _mm256_loadu_pd(&block->cos_delta[i]);
+        __m256d sin_lat = _mm256_loadu_pd(&block->sin_lat[i]);
+        __m256d cos_lat = _mm256_loadu_pd(&block->cos_lat[i]);
+        __m256d a = _mm256_fmsub_pd(cos_delta, cos_avx2(h), _mm256_mul_pd(_mm256_loadu_pd(&block->x[i]), sin_xi));
+        __m256d b = _mm256_mul_pd(cos_delta, cos_avx2(_mm256_sub_pd(h, _mm256_set1_pd(SIMD_PI / 2))));
+        __m256d c = _mm256_fnmadd_pd(_mm256_loadu_pd(&block->y[i]), sin_xi, _mm256_loadu_pd(&block->sin_delta[i]));
+        __m256d up = _mm256_fmadd_pd(sin_lat, c, _mm256_mul_pd(cos_lat, a));
+        __m256d north = _mm256_fmsub_pd(cos_lat, c, _mm256_mul_pd(sin_lat, a));
+        __m256d across = _mm256_sqrt_pd(_mm256_fmadd_pd(north, north, _mm256_mul_pd(b, b)));
+        __m256d e0 = _mm256_mul_pd(atan_avx2(_mm256_div_pd(up, across)), _mm256_set1_pd(SIMD_RAD2DEG));
+        __m256d r = _mm256_add_pd(e0, _mm256_div_pd(_mm256_set1_pd(10.3), _mm256_add_pd(e0, _mm256_set1_pd(5.11))));
+        r = _mm256_mul_pd(r, _mm256_set1_pd(SIMD_DEG2RAD));
+        __m256d del_e =
+            _mm256_div_pd(_mm256_mul_pd(_mm256_loadu_pd(&block->refract_scale[i]), cos_avx2(r)),
+                          _mm256_mul_pd(_mm256_set1_pd(60.0), cos_avx2(_mm256_sub_pd(r, _mm256_set1_pd(SIMD_PI / 2)))));
+        del_e = _mm256_and_pd(_mm256_cmp_pd(e0, _mm256_loadu_pd(&block->refract_limit[i]), _CMP_GE_OQ), del_e);
+        _mm256_storeu_pd(&out[i], _mm256_add_pd(e0, del_e));
+    }
+    for (i = 0; i < count; i++) {
+        elevations[i] = out[i];
+    }
+}
+
+/*----------------------------------- AVX-512 ----------------------------------*/
+
+SPA_TARGET("avx512f") static __m512d cos_avx512(__m512d x) {
+    const __m512d magic = _mm512_set1_pd(COS_ROUND_MAGIC);
+    __m512d t = _mm512_fmadd_pd(x, _mm512_set1_pd(COS_INV_PI), magic);
+    __m512d q = _mm512_sub_pd(t, magic);
+    __m512d r = _mm512_fnmadd_pd(q, _mm512_set1_pd(COS_PI_A), x);
+    r = _mm512_fnmadd_pd(q, _mm512_set1_pd(COS_PI_B), r);
+    r = _mm512_fnmadd_pd(q, _mm512_set1_pd(COS_PI_C), r);
+    __m512d z = _mm512_mul_pd(r, r);
+    __m512d p = _mm512_set1_pd(COS_C10);
+    p = _mm512_fmadd_pd(p, z, _mm512_set1_pd(COS_C9));
+    p = _mm512_fmadd_pd(p, z, _mm512_set1_pd(COS_C8));
+    p = _mm512_fmadd_pd(p, z, _mm512_set1_pd(COS_C7));
+    p = _mm512_fmadd_pd(p, z, _mm512_set1_pd(COS_C6));
+    p = _mm512_fmadd_pd(p, z, _mm512_set1_pd(COS_C5));
+    p = _mm512_fmadd_pd(p, z, _mm512_set1_pd(COS_C4));
+    p = _mm512_fmadd_pd(p, z, _mm512_set1_pd(COS_C3));
+    p = _mm512_fmadd_pd(p, z, _mm512_set1_pd(COS_C2));
+    p = _mm512_fmadd_pd(p, z, _mm512_set1_pd(COS_C1));
+    p = _mm512_fmadd_pd(p, z, _mm512_set1_pd(1.0));
+    __m512i sign = _mm512_slli_epi64(_mm512_castpd_si512(t), 63);
+    return _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(p), sign));
+}
+
+SPA_TARGET("avx512f") static double summation_avx512(const double terms[][3], int count, double jme) {
+    const __m256i stride = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+    __m512d acc = _mm512_setzero_pd();
+    __m512d vjme = _mm512_set1_pd(jme);
+    int i;
+    for (i = 0; i + 8 <= count; i += 8) {
+        __m512d a = _mm512_i32gather_pd(stride, &terms[i][0], 8);
+        __m512d b = _mm512_i32gather_pd(stride, &terms[i][1], 8);
+        __m512d c = _mm512_i32gather_pd(stride, &terms[i][2], 8);
+        __m512d x = _mm512_fmadd_pd(c, vjme, b);
+        acc = _mm512_fmadd_pd(a, cos_avx512(x), acc);
+    }
+    return _mm512_reduce_add_pd(acc) + tail_summation(terms, i, count, jme);
+}
+
+/*------------------------------- CPU detection --------------------------------*/
+
+static void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4]) {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, (int) leaf, (int) subleaf);
+    regs[0] = (unsigned int) info[0];
+    regs[1] = (unsigned int) info[1];
+    regs[2] = (unsigned int) info[2];
+    regs[3] = (unsigned int) info[3];
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static unsigned long long xgetbv0(void) {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int lo, hi;
+    __asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((unsigned long long) hi << 32) | lo;
+#endif
+}
+
+static SpaSimdLevel detect_x86(void) {
+    unsigned int regs[4];
+    unsigned long long xcr0;
+    bool osxsave, avx, fma;
+
+    cpuid(0, 0, regs);
+    if (regs[0] < 7) {
+        return SpaSimd_SSE2; // SSE2 is part of the x86-64 baseline
+    }
+    cpuid(1, 0, regs);
+    osxsave = (regs[2] >> 27) & 1;
+    avx = (regs[2] >> 28) & 1;
+    fma = (regs[2] >> 12) & 1;
+    if (!osxsave || !avx || !fma) {
+        return SpaSimd_SSE2;
+    }
+    // The OS must save the YMM (and for AVX-512 the opmask and ZMM) registers
+    xcr0 = xgetbv0();
+    if ((xcr0 & 0x6) != 0x6) {
+        return SpaSimd_SSE2;
+    }
+    cpuid(7, 0, regs);
+    if ((regs[1] >> 16) & 1 && (xcr0 & 0xE6) == 0xE6) {
+        return SpaSimd_AVX512;
+    }
+    if ((regs[1] >> 5) & 1) {
+        return SpaSimd_AVX2;
+    }
+    return SpaSimd_SSE2;
+}
+
+#endif // SPA_SIMD_X86
+
+// The selected level is read by every SPA call, from any thread, so it is only accessed atomically. Relaxed ordering
+// is enough as it guards no other data. The library is C99, so these are compiler intrinsics rather than stdatomic.h.
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define level_load(level) _InterlockedOr(level, 0)
+#define level_store(level, value) _InterlockedExchange(level, value)
+#else
+#define level_load(level) __atomic_load_n(level, __ATOMIC_RELAXED)
+#define level_store(level, value) __atomic_store_n(level, value, __ATOMIC_RELAXED)
+#endif
+
+// -1 until the first use, threads racing to the first use all store the detected level
+static long selected_level = -1;
+
+SpaSimdLevel spa_simd_detect(void) {
+#ifdef SPA_SIMD_X86
+    return detect_x86();
+#else
+    return SpaSimd_Scalar;
+#endif
+}
+
+SpaSimdLevel spa_simd_get_level(void) {
+    long level = level_load(&selected_level);
+    if (level < 0) {
+        level = (long) spa_simd_detect();
+        level_store(&selected_level, level);
+    }
+    return (SpaSimdLevel) level;
+}
+
+bool spa_simd_set_level(SpaSimdLevel level) {
+    if ((int) level < (int) SpaSimd_Scalar || (int) level > (int) spa_simd_detect()) {
+        return false;
+    }
+    level_store(&selected_level, (long) level);
+    return true;
+}
+
+spa_term_summation spa_simd_kernel(void) {
+    switch (spa_simd_get_level()) {
+#ifdef SPA_SIMD_X86
+    case SpaSimd_SSE2:
+        return summation_sse2;
+    case SpaSimd_AVX2:
+        return summation_avx2;
+    case SpaSimd_AVX512:
+        return summation_avx512;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+spa_elevation_kernel spa_simd_elevation_kernel(void) {
+    switch (spa_simd_get_level()) {
+#ifdef SPA_SIMD_X86
+    case SpaSimd_SSE2:
+        return elevations_sse2;
+    // Every CPU with AVX-512F also has AVX2 and FMA, and a block is too short to gain from wider vectors
+    case SpaSimd_AVX2:
+    case SpaSimd_AVX512:
+        return elevations_avx2;
+#endif
+    default:
+        return NULL;
+    }
+}
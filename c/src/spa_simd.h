@@ -0,0 +1,64 @@
+//
+//  spa_simd.h
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+//  Vectorised kernels for the SPA earth periodic term summations, selected at runtime.
+//
+#ifndef SUNRISE_SUNSET_CALCULATOR_SPA_SIMD_H
+#define SUNRISE_SUNSET_CALCULATOR_SPA_SIMD_H
+
+#include <stdbool.h>
+
+typedef enum {
+    SpaSimd_Scalar = 0, ///< Portable scalar loop using libm cos
+    SpaSimd_SSE2 = 1,   ///< 2 doubles per vector
+    SpaSimd_AVX2 = 2,   ///< 4 doubles per vector, requires AVX2 and FMA
+    SpaSimd_AVX512 = 3, ///< 8 doubles per vector, requires AVX-512F
+} SpaSimdLevel;
+
+/// Sum of A*cos(B + C*jme) over rows of {A, B, C} earth periodic terms
+typedef double (*spa_term_summation)(const double terms[][3], int count, double jme);
+
+/// The highest level supported by both this build and the running CPU
+/// Always SpaSimd_Scalar when built with SPA_NO_SIMD or on non x86-64 targets
+SpaSimdLevel spa_simd_detect(void);
+
+/// The level currently used by the SPA, defaults to spa_simd_detect()
+SpaSimdLevel spa_simd_get_level(void);
+
+/// Override the level used by the SPA (e.g. for testing)
+/// @param level Level to use
+/// @return False if the level is not supported, in which case the current level is unchanged
+bool spa_simd_set_level(SpaSimdLevel level);
+
+/// The kernel for the current level
+/// @return NULL when the scalar path should be used
+spa_term_summation spa_simd_kernel(void);
+
+/// Items given to an observer stage kernel at once, a multiple of every vector width
+#define SPA_SIMD_BLOCK 16
+
+/// Per-item inputs of the observer stage as a structure of arrays, see spa_calculate_elevations()
+typedef struct {
+    double hour_angle[SPA_SIMD_BLOCK]; ///< Observer hour angle, not necessarily reduced to [0, 360) [degrees]
+    double sin_delta[SPA_SIMD_BLOCK];
+    double cos_delta[SPA_SIMD_BLOCK];
+    double sin_xi[SPA_SIMD_BLOCK];
+    double x[SPA_SIMD_BLOCK];
+    double y[SPA_SIMD_BLOCK];
+    double sin_lat[SPA_SIMD_BLOCK];
+    double cos_lat[SPA_SIMD_BLOCK];
+    double refract_scale[SPA_SIMD_BLOCK];
+    double refract_limit[SPA_SIMD_BLOCK];
+} spa_observer_block;
+
+/// Topocentric elevation angles (corrected) of the first count items of a block [degrees], within 1e-11 degrees of
+/// spa_calculate_elevation(). Every item of the block must hold valid inputs, including those after count.
+typedef void (*spa_elevation_kernel)(const spa_observer_block *block, int count, double *elevations);
+
+/// The observer stage kernel for the current level
+/// @return NULL when the scalar path should be used
+spa_elevation_kernel spa_simd_elevation_kernel(void);
+
+#endif //SUNRISE_SUNSET_CALCULATOR_SPA_SIMD_H
@@ -6,16 +6,20 @@
 //
 #include "ssc.h"
 #define _USE_MATH_DEFINES
-#include <math.h>
+#include "spa_math.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
 
 uint32_t sunrise_sunset_default_step_size(double latitude) {
     double latitude_abs = fabs(latitude);
-    if (latitude_abs < 60.0) {
-        return 14400;
-    } else if (latitude_abs < 64.0) {
-        return 3600;
+    if (latitude_abs < SSC_HIGH_LATITUDE) {
+        return SSC_DEFAULT_STEP_SIZE;
+    } else if (latitude_abs < SSC_EXTREME_LATITUDE) {
+        return SSC_HIGH_LATITUDE_STEP_SIZE;
     } else {
-        return 600;
+        return SSC_EXTREME_LATITUDE_STEP_SIZE;
     }
 }
 
@@ -29,6 +33,11 @@ void SunriseSunsetParameters_init(SunriseSunsetParameters *params, unix_t time,
     params->temperature = SSC_DEFAULT_TEMPERATURE;
     params->atmos_refract = SSC_DEFAULT_ATMOSPHERIC_REFRACTION;
     params->step_size = sunrise_sunset_default_step_size(latitude);
+    params->nutation = SpaNutation_Full;
+    params->nutation_interval = SSC_DEFAULT_NUTATION_INTERVAL;
+    params->ephemeris_table = NULL;
+    params->search = SunriseSunsetSearch_Step;
+    params->engine = SunriseSunsetEngine_Spa;
 }
 
 /// Convert a Unix timestamp to Julian Day
@@ -37,11 +46,16 @@ static inline double jd_from_unix(unix_t t) {
     return ((double) t / 86400.0) + 2440587.5;
 }
 
+/// Convert a fractional Unix timestamp to Julian Day
+static inline double jd_from_unix_seconds(double t) {
+    return (t / 86400.0) + 2440587.5;
+}
+
 /// Return true if the sun is currently visible
 /// @see <a href="https://github.com/skyfielders/python-skyfield/blob/aa59e2d4711c3a95804170889f138402edbf4237/skyfield/almanac.py#L239">Skyfield implementation</a>
-/// @param[in] result Results from solar position algorithm
-static inline bool sun_is_up(const spa_data *result) {
-    return result->e >= -0.8333;
+/// @param elevation Topocentric elevation angle of the sun [degrees]
+static inline bool sun_is_up(double elevation) {
+    return elevation >= SSC_SUNRISE_ELEVATION;
 }
 
 #define ENSURE_SPA_RESULT(res)                                                                                         \
@@ -49,62 +63,1553 @@ static inline bool sun_is_up(const spa_data *result) {
         return res;                                                                                                    \
     }
 
+/// Everything needed to evaluate the solar elevation for one location, set up once from the parameters.
+typedef struct {
+    spa_observer observer;           ///< Precomputed observer constants
+    spa_nutation nutation;           ///< Nutation series and interpolation cache
+    double delta_t;                  ///< Difference between earth rotation time and terrestrial time
+    const spa_chebyshev *table;      ///< Optional ephemeris table
+    SunriseSunsetEngine engine;      ///< Algorithm for times not covered by the table
+    double horizon;                  ///< Uncorrected elevation at which the sun becomes visible [degrees]
+    bool lean;                       ///< If the search can use spa_calculate_elevation_lean()
+    SunriseSunsetSearchStats *stats; ///< Statistics of the current search, NULL disables
+} SunriseSunsetContext;
+
+/// Calculate the time dependent stage of the SPA, from the ephemeris table when it covers the time
+/// @param[out] ephemeris Ephemeris to fill
+/// @param jd Julian day
+/// @param delta_t Difference between earth rotation time and terrestrial time
+/// @param engine Algorithm to use when the table does not cover the time
+/// @param[in, out] nutation Nutation series and interpolation cache of the SPA engine
+/// @param[in] table Optional ephemeris table
+/// @return SpaError code
+static SpaError calculate_ephemeris(spa_ephemeris *ephemeris,
+                                    double jd,
+                                    double delta_t,
+                                    SunriseSunsetEngine engine,
+                                    spa_nutation *nutation,
+                                    const spa_chebyshev *table) {
+    if (table != NULL && spa_chebyshev_calculate_ephemeris(table, ephemeris, jd, delta_t) == SpaError_Success) {
+        return SpaError_Success;
+    }
+    if (engine == SunriseSunsetEngine_Noaa) {
+        return spa_noaa_calculate_ephemeris(ephemeris, jd, delta_t);
+    }
+    if (engine == SunriseSunsetEngine_SpaFloat) {
+        spa_float_ephemeris narrow;
+        SpaError spa_result = spa_float_calculate_ephemeris(&narrow, jd, delta_t);
+        ENSURE_SPA_RESULT(spa_result);
+        spa_float_ephemeris_widen(ephemeris, &narrow, jd, delta_t);
+        return SpaError_Success;
+    }
+    return spa_calculate_ephemeris_nutation(ephemeris, jd, delta_t, nutation);
+}
+
+/// Find the uncorrected elevation at and above which the refraction corrected elevation reaches a threshold.
+/// Refraction only starts at the observer's refraction limit, so the corrected elevation jumps there, and the
+/// threshold is found on the uncorrected elevation instead which is continuous in time.
+/// @param[in] observer Observer to find the threshold for
+/// @param threshold Refraction corrected elevation within [-90, 90], so that the bracket moves at most five times
+///                  [degrees]
+/// @return Uncorrected elevation [degrees]
+static double uncorrected_elevation_threshold(const spa_observer *observer, double threshold) {
+    double low = -10.0, high = 10.0, mid;
+    int i;
+    // Move the bracket in whole widths until it contains the threshold
+    while (spa_observer_refraction_corrected(observer, high) < threshold) {
+        low += 20.0;
+        high += 20.0;
+    }
+    while (spa_observer_refraction_corrected(observer, low) >= threshold) {
+        low -= 20.0;
+        high -= 20.0;
+    }
+    for (i = 0; i < 50; i++) {
+        mid = (low + high) / 2.0;
+        if (spa_observer_refraction_corrected(observer, mid) >= threshold) {
+            high = mid;
+        } else {
+            low = mid;
+        }
+    }
+    return high;
+}
+
+/// Find the uncorrected elevation above which the sun is visible once refraction is applied
+/// @param[in] observer Observer to find the threshold for
+/// @return Uncorrected elevation [degrees]
+static double visible_elevation_threshold(const spa_observer *observer) {
+    return uncorrected_elevation_threshold(observer, SSC_SUNRISE_ELEVATION);
+}
+
+/// Time over which the visibility cannot change, because the sun is too far below the horizon at its highest (or
+/// above at its lowest) for the declination to bring it back within that time. The bound holds at any time of day, so
+/// a search can jump straight to its end and check again there.
+/// @param latitude Observer latitude [degrees]
+/// @param horizon Uncorrected elevation at which the sun becomes visible [degrees]
+/// @param delta Geocentric declination of the sun at the current time [degrees]
+/// @param visible True if the sun is currently visible
+/// @return Seconds that can be skipped, 0 if the visibility may change at any moment
+static int64_t polar_skip(double latitude, double horizon, double delta, bool visible) {
+    double margin, seconds;
+    if (visible) {
+        // Margin of the lowest elevation, at lower culmination, above the horizon
+        margin = (fabs(latitude + delta) - 90.0) - horizon;
+    } else {
+        // Margin of the highest elevation, at upper culmination, below the horizon
+        margin = horizon - (90.0 - fabs(latitude - delta));
+    }
+    seconds = floor((margin - SSC_PARALLAX_MARGIN) / SSC_MAX_DECLINATION_RATE * 86400.0);
+    return seconds > 0.0 ? (int64_t) seconds : 0;
+}
+
+/// Validate the parameters and set up a SunriseSunsetContext for them
+/// @param[out] context Context to initialise
+/// @param[in] params Input parameters
+/// @return SpaError code
+static SpaError solar_context_init(SunriseSunsetContext *context, const SunriseSunsetParameters *params) {
+    context->delta_t = params->delta_t;
+    context->table = params->ephemeris_table;
+    context->engine = params->engine;
+    spa_nutation_init(&context->nutation, params->nutation, params->nutation_interval);
+    SpaError spa_result = spa_observer_init(&context->observer,
+                                           params->latitude,
+                                           params->longitude,
+                                           params->elevation,
+                                           params->pressure,
+                                           params->temperature,
+                                           params->atmos_refract);
+    ENSURE_SPA_RESULT(spa_result);
+    context->horizon = params->search != SunriseSunsetSearch_Step || fabs(params->latitude) >= SSC_POLAR_LATITUDE
+                           ? visible_elevation_threshold(&context->observer)
+                           : 0.0;
+    context->lean = params->engine == SunriseSunsetEngine_Spa && params->ephemeris_table == NULL;
+    context->stats = NULL;
+    return SpaError_Success;
+}
+
+/// Calculate the time dependent stage of the SPA for the context at a given time
+/// @param[in, out] context Solar context for the location
+/// @param jd Julian day
+/// @param[out] ephemeris Ephemeris to fill
+/// @return SpaError code
+static SpaError solar_ephemeris(SunriseSunsetContext *context, double jd, spa_ephemeris *ephemeris) {
+    if (context->stats != NULL) {
+        context->stats->evaluations++;
+    }
+    return calculate_ephemeris(ephemeris, jd, context->delta_t, context->engine, &context->nutation, context->table);
+}
+
+/// Calculate what the search needs to know about the sun at a given time, without storing an ephemeris when the
+/// context can use spa_calculate_elevation_lean()
+/// @param[in, out] context Solar context for the location
+/// @param jd Julian day
+/// @param outputs SpaOutput_Geocentric for the declination, SpaOutput_Topocentric for the uncorrected elevation and
+///                the observer hour angle (not limited to [0, 360) without the lean evaluation)
+/// @param[out] values Out parameter for the corrected elevation and the outputs asked for
+/// @return SpaError code
+static SpaError solar_evaluate(SunriseSunsetContext *context, double jd, unsigned outputs, spa_lean_outputs *values) {
+    spa_ephemeris ephemeris;
+    SpaError spa_result;
+    if (context->lean) {
+        if (context->stats != NULL) {
+            context->stats->evaluations++;
+        }
+        spa_result = spa_validate_time(jd, context->delta_t);
+        ENSURE_SPA_RESULT(spa_result);
+        spa_calculate_elevation_lean(&context->observer, jd, context->delta_t, &context->nutation, outputs, values);
+        return SpaError_Success;
+    }
+    spa_result = solar_ephemeris(context, jd, &ephemeris);
+    ENSURE_SPA_RESULT(spa_result);
+    values->delta = ephemeris.delta;
+    values->h = ephemeris.nu + context->observer.longitude - ephemeris.alpha;
+    values->e0 = spa_calculate_elevation_uncorrected(&ephemeris, &context->observer);
+    values->e = spa_observer_refraction_corrected(&context->observer, values->e0);
+    return SpaError_Success;
+}
+
+/// Calculate the solar elevation for an observer at a given time
+/// @param[in, out] context Solar context for the location
+/// @param time Unix timestamp to calculate the elevation at
+/// @param[out] elevation Out parameter to store the topocentric elevation angle [degrees]
+/// @return SpaError code
+static SpaError solar_elevation(SunriseSunsetContext *context, unix_t time, double *elevation) {
+    spa_lean_outputs values;
+    SpaError spa_result = solar_evaluate(context, jd_from_unix(time), SpaOutput_Elevation, &values);
+    ENSURE_SPA_RESULT(spa_result);
+    *elevation = values.e;
+    return SpaError_Success;
+}
+
+/// Calculate the uncorrected solar elevation relative to the visible threshold at a fractional time
+/// @param[in, out] context Solar context for the location
+/// @param time Fractional Unix timestamp
+/// @param[out] offset Uncorrected elevation minus the context horizon [degrees], positive when visible
+/// @return SpaError code
+static SpaError solar_horizon_offset(SunriseSunsetContext *context, double time, double *offset) {
+    spa_lean_outputs values;
+    SpaError spa_result = solar_evaluate(context, jd_from_unix_seconds(time), SpaOutput_Topocentric, &values);
+    ENSURE_SPA_RESULT(spa_result);
+    *offset = values.e0 - context->horizon;
+    return SpaError_Success;
+}
+
+/// Find the next time when the solar visibility changes, giving up once the search steps past a limit
+/// @param[in, out] context Solar context for the location
+/// @param start Unix timestamp to start search from
+/// @param step_size Step size in seconds. A negative step size will search backwards
+/// @param currently_visible True if the sun is currently visible at the start time
+/// @param limit Unix timestamp after which (or before which, searching backwards) to stop stepping
+/// @param[out] found Set to false if the limit was reached without a change in visibility
+/// @param[out] result Out parameter to store timestamp of next event, or where the search stopped
+/// @return SpaError code
+static SpaError search_for_change_in_visibility_until(SunriseSunsetContext *context,
+                                                      unix_t start,
+                                                      int64_t step_size,
+                                                      bool currently_visible,
+                                                      unix_t limit,
+                                                      bool *found,
+                                                      unix_t *result) {
+    int64_t step_abs = step_size > 0 ? step_size : -step_size;
+    bool polar = fabs(context->observer.latitude) >= SSC_POLAR_LATITUDE;
+    spa_lean_outputs values;
+    SpaError spa_result;
+    bool bracketed = false;
+    *found = true;
+    while (step_size != 0) {
+        if (!bracketed && (step_size > 0 ? start > limit : start < limit)) {
+            *found = false;
+            break;
+        }
+        // The declination is only needed for the polar skip
+        spa_result = solar_evaluate(context,
+                                    jd_from_unix(start),
+                                    polar && !bracketed ? SpaOutput_Geocentric : SpaOutput_Elevation,
+                                    &values);
+        ENSURE_SPA_RESULT(spa_result);
+        if (sun_is_up(values.e) != currently_visible) {
+            step_size = -(step_size / 2);
+            currently_visible = !currently_visible;
+            bracketed = true;
+            if (context->stats != NULL) {
+                context->stats->bisections++;
+            }
+        } else {
+            // During polar day and night jump to within a step of the earliest time the visibility could change
+            int64_t steps = 1;
+            if (polar && !bracketed) {
+                int64_t skip_steps =
+                    polar_skip(context->observer.latitude, context->horizon, values.delta, currently_visible) /
+                    step_abs;
+                steps = skip_steps > 1 ? skip_steps : 1;
+            }
+            start += steps * step_size;
+            if (context->stats != NULL && !bracketed) {
+                context->stats->steps++;
+                context->stats->skipped += (steps - 1) * step_abs;
+            }
+        }
+    }
+    *result = start;
+    return SpaError_Success;
+}
+
 /// Find the next time when the solar visibility changes
-/// @param[in, out] data Solar position algorithm parameters
+/// @param[in, out] context Solar context for the location
 /// @param start Unix timestamp to start search from
 /// @param step_size Step size in seconds. A negative step size will search backwards
 /// @param currently_visible True if the sun is currently visible at the start time
 /// @param[out] result Out parameter to store timestamp of next event
 /// @return SpaError code
-static SpaError search_for_change_in_visibility(spa_data *data,
+static SpaError search_for_change_in_visibility(SunriseSunsetContext *context,
                                                 unix_t start,
                                                 int64_t step_size,
                                                 bool currently_visible,
                                                 unix_t *result) {
-    int spa_result;
-    while (step_size != 0) {
-        data->jd = jd_from_unix(start);
-        spa_result = spa_calculate(data);
+    bool found;
+    return search_for_change_in_visibility_until(
+        context, start, step_size, currently_visible, step_size > 0 ? INT64_MAX : INT64_MIN, &found, result);
+}
+
+/// Sun hour angle change per second of time, ignoring the motion of the sun itself [degrees]
+#define SSC_HOUR_ANGLE_RATE (360.0 / 86400.0)
+/// Events that the sunrise equation puts this close after the start of a backward search (or before the start of a
+/// forward search) are assumed to be the event just found by the SPA on the other side of the start [degrees]
+#define SSC_PREDICTOR_MARGIN 5.0
+/// The refined event must be within this much of the prediction [seconds]
+#define SSC_PREDICTOR_WINDOW 3600.0
+/// Refinement stops once a step is smaller than this [seconds]
+#define SSC_PREDICTOR_TOLERANCE 0.5
+#define SSC_PREDICTOR_MAX_ITERATIONS 8
+
+/// Visibility at a whole second, for checking a refined event
+static SpaError solar_visible_at(SunriseSunsetContext *context, unix_t time, bool *visible) {
+    double elevation;
+    SpaError spa_result = solar_elevation(context, time, &elevation);
+    ENSURE_SPA_RESULT(spa_result);
+    *visible = sun_is_up(elevation);
+    return SpaError_Success;
+}
+
+/// Find the next time when the solar visibility changes, by predicting it from the sunrise equation and refining
+/// the prediction with a Newton step followed by secant steps on the uncorrected elevation.
+/// @param[in, out] context Solar context for the location, initialised for SunriseSunsetSearch_Predictor
+/// @param[in] ephemeris Ephemeris at the start time
+/// @param start Unix timestamp to start search from
+/// @param forward True to search forwards in time, otherwise backwards
+/// @param currently_visible True if the sun is currently visible at the start time
+/// @param[out] found Set to false if the prediction could not be used and another search is needed
+/// @param[out] result Out parameter to store timestamp of next event, the first second of the new visibility
+/// @return SpaError code
+static SpaError predict_change_in_visibility(SunriseSunsetContext *context,
+                                             const spa_ephemeris *ephemeris,
+                                             unix_t start,
+                                             bool forward,
+                                             bool currently_visible,
+                                             bool *found,
+                                             unix_t *result) {
+    const spa_observer *observer = &context->observer;
+    bool rising = forward != currently_visible;
+    // Visibility just before and just after the event, in time order
+    bool before = !rising, after = rising;
+    double cos_h0, h0, target, hour_angle, slope, predicted, t_a, t_b, t_next, f_a, f_b;
+    bool visible_prev, visible;
+    unix_t second;
+    SpaError spa_result;
+    int i;
+
+    *found = false;
+
+    // Sunrise equation for the hour angle of the event, using the declination at the start time
+    cos_h0 = (sin(context->horizon * M_PI / 180.0) - observer->sin_lat * ephemeris->sin_delta) /
+             (observer->cos_lat * ephemeris->cos_delta);
+    if (!(fabs(cos_h0) <= 1.0)) {
+        // The sun does not rise or set within a day
+        return SpaError_Success;
+    }
+    h0 = acos(cos_h0) * 180.0 / M_PI;
+    target = rising ? -h0 : h0;
+    hour_angle = ephemeris->nu + observer->longitude - ephemeris->alpha;
+
+    // Hour angle still to go until the event in the search direction
+    target = fmod(target - hour_angle, 360.0);
+    if (target < 0) {
+        target += 360.0;
+    }
+    if (forward && target > 360.0 - SSC_PREDICTOR_MARGIN) {
+        target -= 360.0;
+    } else if (!forward) {
+        target -= 360.0;
+        if (target < SSC_PREDICTOR_MARGIN - 360.0) {
+            target += 360.0;
+        }
+    }
+    predicted = (double) start + target / SSC_HOUR_ANGLE_RATE;
+
+    // Rate of change of the elevation at the event, for the first (Newton) step
+    slope = -observer->cos_lat * ephemeris->cos_delta * sin((rising ? -h0 : h0) * M_PI / 180.0) /
+            cos(context->horizon * M_PI / 180.0) * SSC_HOUR_ANGLE_RATE;
+    if (fabs(slope) < 1e-9) {
+        return SpaError_Success;
+    }
+
+    t_a = predicted;
+    spa_result = solar_horizon_offset(context, t_a, &f_a);
+    ENSURE_SPA_RESULT(spa_result);
+    t_b = t_a - f_a / slope;
+    for (i = 0; i < SSC_PREDICTOR_MAX_ITERATIONS; i++) {
+        if (!(fabs(t_b - predicted) < SSC_PREDICTOR_WINDOW)) {
+            return SpaError_Success;
+        }
+        if (fabs(t_b - t_a) < SSC_PREDICTOR_TOLERANCE) {
+            break;
+        }
+        spa_result = solar_horizon_offset(context, t_b, &f_b);
         ENSURE_SPA_RESULT(spa_result);
-        if (sun_is_up(data) != currently_visible) {
-            step_size = -(step_size / 2);
-            currently_visible = !currently_visible;
+        if (f_b == f_a) {
+            return SpaError_Success;
+        }
+        t_next = t_b - f_b * (t_b - t_a) / (f_b - f_a);
+        t_a = t_b;
+        f_a = f_b;
+        t_b = t_next;
+    }
+    if (i == SSC_PREDICTOR_MAX_ITERATIONS) {
+        return SpaError_Success;
+    }
+
+    // Check the change in visibility with the corrected elevation at whole seconds, moving by a second at most twice
+    second = (unix_t) ceil(t_b);
+    spa_result = solar_visible_at(context, second - 1, &visible_prev);
+    ENSURE_SPA_RESULT(spa_result);
+    spa_result = solar_visible_at(context, second, &visible);
+    ENSURE_SPA_RESULT(spa_result);
+    for (i = 0; i < 2 && !(visible_prev == before && visible == after); i++) {
+        if (visible == before) {
+            second++;
+            visible_prev = visible;
+            spa_result = solar_visible_at(context, second, &visible);
         } else {
-            start += step_size;
+            second--;
+            visible = visible_prev;
+            spa_result = solar_visible_at(context, second - 1, &visible_prev);
         }
+        ENSURE_SPA_RESULT(spa_result);
     }
-    *result = start;
+    if (!(visible_prev == before && visible == after)) {
+        return SpaError_Success;
+    }
+    // The event must be on the searched side of the start time
+    if (forward ? second <= start : second > start) {
+        return SpaError_Success;
+    }
+
+    *found = true;
+    *result = second;
     return SpaError_Success;
 }
 
+/// End time for searches that should continue until they find an event, halved so it cannot overflow
+#define SSC_UNBOUNDED (INT64_MAX / 2)
+/// An uncorrected elevation sample of the transit search and sunrise_sunset_crossings()
+typedef struct {
+    unix_t time;      ///< Unix timestamp of the sample
+    double elevation; ///< Uncorrected elevation [degrees]
+} CrossingSample;
+
+/// Calculate the uncorrected solar elevation at a given time
+/// @param[in, out] context Solar context for the location
+/// @param time Unix timestamp
+/// @param[out] elevation Out parameter for the uncorrected elevation [degrees]
+/// @return SpaError code
+static SpaError solar_elevation_uncorrected(SunriseSunsetContext *context, unix_t time, double *elevation) {
+    spa_lean_outputs values;
+    SpaError spa_result = solar_evaluate(context, jd_from_unix(time), SpaOutput_Topocentric, &values);
+    ENSURE_SPA_RESULT(spa_result);
+    *elevation = values.e0;
+    return SpaError_Success;
+}
+
+/// Unix timestamp of the local mean solar midnight at or before a time
+static unix_t local_mean_midnight(unix_t time, double longitude) {
+    unix_t offset = (unix_t) floor(longitude / 360.0 * 86400.0 + 0.5), days = (time + offset) / 86400;
+    if ((time + offset) % 86400 < 0) {
+        days--;
+    }
+    return days * 86400 - offset;
+}
+
+/// Secant steps of the refinement of a crossing before it falls back to bisection
+#define SSC_CROSSING_SECANT_ITERATIONS 8
+
+/// Find the first second on the far side of a threshold between two samples either side of it, by regula falsi with
+/// the Illinois modification on whole seconds
+/// @param[in, out] context Solar context for the location
+/// @param horizon Uncorrected threshold [degrees]
+/// @param before Sample before the crossing
+/// @param after Sample after the crossing, on the other side of the threshold
+/// @param[out] crossing Out parameter for the first second on the same side as the after sample
+/// @return SpaError code
+static SpaError refine_crossing(SunriseSunsetContext *context,
+                                double horizon,
+                                CrossingSample before,
+                                CrossingSample after,
+                                unix_t *crossing) {
+    double before_offset = before.elevation - horizon, after_offset = after.elevation - horizon, offset;
+    bool before_above = before_offset >= 0.0;
+    int retained = 0, iterations = 0;
+    SpaError spa_result;
+    unix_t time;
+
+    while (after.time - before.time > 1) {
+        if (iterations++ < SSC_CROSSING_SECANT_ITERATIONS) {
+            double fraction = before_offset / (before_offset - after_offset);
+            time = before.time + (unix_t) floor(fraction * (double) (after.time - before.time) + 0.5);
+        } else {
+            time = before.time + (after.time - before.time) / 2;
+        }
+        time = time <= before.time ? before.time + 1 : (time >= after.time ? after.time - 1 : time);
+        spa_result = solar_elevation_uncorrected(context, time, &offset);
+        ENSURE_SPA_RESULT(spa_result);
+        offset -= horizon;
+        // Halve the offset of an end that is kept twice in a row, so that it cannot hold the interpolation back
+        if ((offset >= 0.0) == before_above) {
+            before.time = time;
+            before_offset = offset;
+            after_offset = retained > 0 ? after_offset / 2.0 : after_offset;
+            retained = 1;
+        } else {
+            after.time = time;
+            after_offset = offset;
+            before_offset = retained < 0 ? before_offset / 2.0 : before_offset;
+            retained = -1;
+        }
+    }
+    *crossing = after.time;
+    return SpaError_Success;
+}
+
+/// Margin either side of the local mean noon or midnight within which the actual culmination may fall, covering the
+/// equation of time [seconds]
+#define SSC_CULMINATION_MARGIN 1800
+
+/// Find the transit (upper culmination) or nadir (lower culmination) near a time, by Newton steps on the local hour
+/// angle in whole seconds
+/// @param[in, out] context Solar context for the location
+/// @param guess Unix timestamp within a few hours of the culmination, e.g. the local mean noon or midnight
+/// @param transit True for the transit, false for the nadir
+/// @param[out] time Out parameter for the culmination to the nearest second
+/// @param[out] values Out parameter for the evaluation at that second, with the declination and hour angle
+/// @return SpaError code
+static SpaError find_culmination(SunriseSunsetContext *context,
+                                 unix_t guess,
+                                 bool transit,
+                                 unix_t *time,
+                                 spa_lean_outputs *values) {
+    SpaError spa_result;
+    double hour_angle, step;
+    int i;
+
+    *time = guess;
+    for (i = 0; i < SSC_PREDICTOR_MAX_ITERATIONS; i++) {
+        // The transit search also needs the declination, for the polar skip
+        spa_result = solar_evaluate(context, jd_from_unix(*time), SpaOutput_Geocentric | SpaOutput_Topocentric, values);
+        ENSURE_SPA_RESULT(spa_result);
+        // Hour angle from the culmination, in [-180, 180)
+        hour_angle = values->h - (transit ? 0.0 : 180.0);
+        hour_angle -= 360.0 * floor((hour_angle + 180.0) / 360.0);
+        step = floor(-hour_angle / SSC_HOUR_ANGLE_RATE + 0.5);
+        if (step == 0.0) {
+            break;
+        }
+        *time += (unix_t) step;
+    }
+    return SpaError_Success;
+}
+
+SpaError sunrise_sunset_transit(const SunriseSunsetParameters *params, SunriseSunsetTransit *transit) {
+    SunriseSunsetContext context;
+    spa_lean_outputs values;
+    SpaError spa_result;
+    unix_t midnight = local_mean_midnight(params->time, params->longitude);
+
+    spa_result = solar_context_init(&context, params);
+    ENSURE_SPA_RESULT(spa_result);
+    spa_result = find_culmination(&context, midnight + 43200, true, &transit->transit, &values);
+    ENSURE_SPA_RESULT(spa_result);
+    transit->max_elevation = values.e;
+    spa_result = find_culmination(&context, midnight, false, &transit->nadir, &values);
+    ENSURE_SPA_RESULT(spa_result);
+    transit->min_elevation = values.e;
+    return SpaError_Success;
+}
+
+/// Find the next (or previous) change in visibility by bracketing it between consecutive culminations, between which
+/// the elevation only rises or only falls, then refining it within the bracket. Whole days of polar day or night are
+/// skipped using the declination.
+/// @param[in, out] context Solar context for the location, with the horizon set up
+/// @param start Unix timestamp to search from
+/// @param elevation Uncorrected elevation at the start [degrees]
+/// @param forward True to search forwards in time, otherwise backwards
+/// @param currently_visible True if the sun is visible at the start time
+/// @param limit Unix timestamp after which (or before which, searching backwards) to stop searching
+/// @param[out] found Set to false if there is no change in visibility before the limit
+/// @param[out] result Out parameter for the first second of the new visibility (or of the current visibility,
+///                    searching backwards)
+/// @return SpaError code
+static SpaError transit_change_in_visibility(SunriseSunsetContext *context,
+                                             unix_t start,
+                                             double elevation,
+                                             bool forward,
+                                             bool currently_visible,
+                                             unix_t limit,
+                                             bool *found,
+                                             unix_t *result) {
+    unix_t midnight = local_mean_midnight(start, context->observer.longitude);
+    int64_t direction = forward ? 1 : -1, index, skip;
+    CrossingSample cursor, culmination;
+    spa_lean_outputs values;
+    SpaError spa_result;
+
+    // Local mean noons and midnights are numbered from the midnight before the start, start with the first one that
+    // the actual culmination could be on the far side of the start from
+    index = (start - midnight) / 43200;
+    if (forward ? start - (midnight + index * 43200) >= SSC_CULMINATION_MARGIN
+                : midnight + (index + 1) * 43200 - start < SSC_CULMINATION_MARGIN) {
+        index++;
+    }
+    cursor.time = start;
+    cursor.elevation = elevation;
+    *found = false;
+
+    while (forward ? cursor.time < limit : cursor.time > limit) {
+        spa_result = find_culmination(context, midnight + index * 43200, index % 2 != 0, &culmination.time, &values);
+        ENSURE_SPA_RESULT(spa_result);
+        culmination.elevation = values.e0;
+        index += direction;
+        if (context->stats != NULL) {
+            context->stats->steps++;
+        }
+        if (forward ? culmination.time <= cursor.time : culmination.time >= cursor.time) {
+            continue;
+        }
+        if ((culmination.elevation >= context->horizon) != currently_visible) {
+            spa_result = forward ? refine_crossing(context, context->horizon, cursor, culmination, result)
+                                 : refine_crossing(context, context->horizon, culmination, cursor, result);
+            ENSURE_SPA_RESULT(spa_result);
+            *found = true;
+            return SpaError_Success;
+        }
+        cursor = culmination;
+
+        // Jump over whole days of polar day or night, continuing from the culmination at the end of the jump
+        skip = fabs(context->observer.latitude) >= SSC_POLAR_LATITUDE
+                   ? polar_skip(context->observer.latitude, context->horizon, values.delta, currently_visible)
+                   : 0;
+        if (skip >= 86400 && (forward ? limit - cursor.time > skip : cursor.time - limit > skip)) {
+            if (context->stats != NULL) {
+                context->stats->skipped += skip;
+            }
+            index += direction * (skip / 43200 - 1);
+            spa_result = find_culmination(context, midnight + index * 43200, index % 2 != 0, &cursor.time, &values);
+            ENSURE_SPA_RESULT(spa_result);
+            cursor.elevation = values.e0;
+            index += direction;
+        }
+    }
+    *result = limit;
+    return SpaError_Success;
+}
+
+/// Find the next time when the solar visibility changes using the configured search
+/// @param[in, out] context Solar context for the location
+/// @param[in] params Input parameters
+/// @param[in] ephemeris Ephemeris at the start time
+/// @param forward True to search forwards in time, otherwise backwards
+/// @param currently_visible True if the sun is currently visible at the start time
+/// @param[out] result Out parameter to store timestamp of next event
+/// @return SpaError code
+static SpaError find_change_in_visibility(SunriseSunsetContext *context,
+                                          const SunriseSunsetParameters *params,
+                                          const spa_ephemeris *ephemeris,
+                                          bool forward,
+                                          bool currently_visible,
+                                          unix_t *result) {
+    int64_t step_signed = forward ? (int64_t) params->step_size : -(int64_t) params->step_size;
+    if (params->search == SunriseSunsetSearch_Transit) {
+        bool found;
+        return transit_change_in_visibility(context,
+                                            params->time,
+                                            spa_calculate_elevation_uncorrected(ephemeris, &context->observer),
+                                            forward,
+                                            currently_visible,
+                                            forward ? SSC_UNBOUNDED : -SSC_UNBOUNDED,
+                                            &found,
+                                            result);
+    }
+    if (params->search == SunriseSunsetSearch_Predictor) {
+        bool found;
+        SpaError spa_result = predict_change_in_visibility(
+            context, ephemeris, params->time, forward, currently_visible, &found, result);
+        ENSURE_SPA_RESULT(spa_result);
+        if (found) {
+            return SpaError_Success;
+        }
+    }
+    return search_for_change_in_visibility(context, params->time, step_signed, currently_visible, result);
+}
+
 SpaError sunrise_sunset_calculate(const SunriseSunsetParameters *params, SunriseSunsetResult *result) {
-    spa_data data;
-    int spa_result;
-
-    data.jd = jd_from_unix(params->time);
-    data.delta_t = params->delta_t;
-    data.longitude = params->longitude;
-    data.latitude = params->latitude;
-    data.elevation = params->elevation;
-    data.pressure = params->pressure;
-    data.temperature = params->temperature;
-    data.atmos_refract = params->atmos_refract;
+    return sunrise_sunset_calculate_stats(params, result, NULL);
+}
+
+static void search_stats_init(SunriseSunsetSearchStats *stats) {
+    stats->evaluations = 0;
+    stats->steps = 0;
+    stats->bisections = 0;
+    stats->skipped = 0;
+    stats->span = 0;
+}
+
+SpaError sunrise_sunset_calculate_stats(const SunriseSunsetParameters *params,
+                                        SunriseSunsetResult *result,
+                                        SunriseSunsetStats *stats) {
+    SunriseSunsetContext context;
+    spa_ephemeris ephemeris;
+    SpaError spa_result;
+
+    if (stats != NULL) {
+        search_stats_init(&stats->backward);
+        search_stats_init(&stats->forward);
+        stats->evaluations = 1;
+    }
+    spa_result = solar_context_init(&context, params);
+    ENSURE_SPA_RESULT(spa_result);
 
     // Determine current visibility at start time
-    spa_result = spa_calculate(&data);
+    spa_result = solar_ephemeris(&context, jd_from_unix(params->time), &ephemeris);
     ENSURE_SPA_RESULT(spa_result);
-    result->visible = sun_is_up(&data);
+    result->visible = sun_is_up(spa_calculate_elevation(&ephemeris, &context.observer));
 
     unix_t *backward_out = result->visible ? &result->rise : &result->set;
     unix_t *forward_out = result->visible ? &result->set : &result->rise;
-    int64_t step_signed = (int64_t) params->step_size;
 
     // Search backwards from start time
-    spa_result = search_for_change_in_visibility(&data, params->time, -step_signed, result->visible, backward_out);
+    context.stats = stats != NULL ? &stats->backward : NULL;
+    spa_result = find_change_in_visibility(&context, params, &ephemeris, false, result->visible, backward_out);
     ENSURE_SPA_RESULT(spa_result);
     // Search forwards from start time
-    spa_result = search_for_change_in_visibility(&data, params->time, step_signed, result->visible, forward_out);
+    context.stats = stats != NULL ? &stats->forward : NULL;
+    spa_result = find_change_in_visibility(&context, params, &ephemeris, true, result->visible, forward_out);
     ENSURE_SPA_RESULT(spa_result);
 
+    if (stats != NULL) {
+        stats->backward.span = params->time - *backward_out;
+        stats->forward.span = *forward_out - params->time;
+        stats->evaluations += stats->backward.evaluations + stats->forward.evaluations;
+    }
     return SpaError_Success;
 }
+
+void SunriseSunsetAggregateStats_init(SunriseSunsetAggregateStats *aggregate) {
+    aggregate->calls = 0;
+    aggregate->evaluations = 0;
+    aggregate->steps = 0;
+    aggregate->bisections = 0;
+    aggregate->skipped = 0;
+    aggregate->max_evaluations = 0;
+    aggregate->max_span = 0;
+}
+
+void sunrise_sunset_stats_add(SunriseSunsetAggregateStats *aggregate, const SunriseSunsetStats *stats) {
+    int64_t span = stats->backward.span > stats->forward.span ? stats->backward.span : stats->forward.span;
+    aggregate->calls++;
+    aggregate->evaluations += stats->evaluations;
+    aggregate->steps += stats->backward.steps + stats->forward.steps;
+    aggregate->bisections += stats->backward.bisections + stats->forward.bisections;
+    aggregate->skipped += stats->backward.skipped + stats->forward.skipped;
+    aggregate->max_evaluations =
+        stats->evaluations > aggregate->max_evaluations ? stats->evaluations : aggregate->max_evaluations;
+    aggregate->max_span = span > aggregate->max_span ? span : aggregate->max_span;
+}
+
+void sunrise_sunset_stats_merge(SunriseSunsetAggregateStats *aggregate, const SunriseSunsetAggregateStats *other) {
+    aggregate->calls += other->calls;
+    aggregate->evaluations += other->evaluations;
+    aggregate->steps += other->steps;
+    aggregate->bisections += other->bisections;
+    aggregate->skipped += other->skipped;
+    aggregate->max_evaluations =
+        other->max_evaluations > aggregate->max_evaluations ? other->max_evaluations : aggregate->max_evaluations;
+    aggregate->max_span = other->max_span > aggregate->max_span ? other->max_span : aggregate->max_span;
+}
+
+/// Find the next time when the visibility changes from a time where it is known, skipping polar day and night.
+/// Each step search is limited to a day so that the skip can be applied again.
+/// @param[in, out] context Solar context for the location, with the horizon set up
+/// @param[in] params Input parameters, for the search strategy and step size
+/// @param cursor Unix timestamp to search from
+/// @param forward True to search forwards in time, otherwise backwards
+/// @param visible True if the sun is visible at the cursor
+/// @param end Unix timestamp to stop searching at, after the cursor (or before it, searching backwards)
+/// @param[out] found Set to false if there is no change in visibility up to the end
+/// @param[out] event Out parameter to store the first second of the new visibility (or of the current visibility,
+///                   searching backwards)
+/// @return SpaError code
+static SpaError next_change_in_visibility(SunriseSunsetContext *context,
+                                          const SunriseSunsetParameters *params,
+                                          unix_t cursor,
+                                          bool forward,
+                                          bool visible,
+                                          unix_t end,
+                                          bool *found,
+                                          unix_t *event) {
+    int64_t direction = forward ? 1 : -1;
+    spa_ephemeris ephemeris;
+    SpaError spa_result;
+    unix_t limit;
+    int64_t skip;
+
+    *found = false;
+    while (forward ? cursor < end : cursor > end) {
+        spa_result = solar_ephemeris(context, jd_from_unix(cursor), &ephemeris);
+        ENSURE_SPA_RESULT(spa_result);
+
+        // Jump over days of polar day or night without searching, the searches skip the rest of the way
+        skip = polar_skip(context->observer.latitude, context->horizon, ephemeris.delta, visible);
+        if (skip >= 86400) {
+            cursor = (end - cursor) * direction > skip ? cursor + skip * direction : end;
+            continue;
+        }
+
+        if (params->search == SunriseSunsetSearch_Transit) {
+            double elevation = spa_calculate_elevation_uncorrected(&ephemeris, &context->observer);
+            spa_result = transit_change_in_visibility(context, cursor, elevation, forward, visible, end, found, event);
+            ENSURE_SPA_RESULT(spa_result);
+            *found = *found && (forward ? *event <= end : *event >= end);
+            return SpaError_Success;
+        }
+
+        if (params->search == SunriseSunsetSearch_Predictor) {
+            spa_result = predict_change_in_visibility(context, &ephemeris, cursor, forward, visible, found, event);
+            ENSURE_SPA_RESULT(spa_result);
+            if (*found) {
+                *found = forward ? *event <= end : *event >= end;
+                return SpaError_Success;
+            }
+        }
+
+        limit = (end - cursor) * direction > 86400 ? cursor + 86400 * direction : end;
+        spa_result = search_for_change_in_visibility_until(
+            context, cursor, (int64_t) params->step_size * direction, visible, limit, found, event);
+        ENSURE_SPA_RESULT(spa_result);
+        if (*found) {
+            // The step search finishes within a second either side of the change, the next search must start
+            // from the first second of the later visibility so that it does not find the same change again
+            bool visible_at_event;
+            spa_result = solar_visible_at(context, *event, &visible_at_event);
+            ENSURE_SPA_RESULT(spa_result);
+            if ((visible_at_event == visible) == forward) {
+                (*event)++;
+            }
+            *found = forward ? *event <= end : *event >= end;
+            return SpaError_Success;
+        }
+        cursor = *event;
+    }
+    return SpaError_Success;
+}
+
+SpaError sunrise_sunset_events(const SunriseSunsetParameters *params,
+                               unix_t start,
+                               unix_t end,
+                               SunriseSunsetEvent *events,
+                               size_t capacity,
+                               size_t *count) {
+    SunriseSunsetContext context;
+    SpaError spa_result;
+    unix_t cursor = start, event;
+    bool visible, found;
+
+    *count = 0;
+    spa_result = solar_context_init(&context, params);
+    ENSURE_SPA_RESULT(spa_result);
+    context.horizon = visible_elevation_threshold(&context.observer);
+    spa_result = solar_visible_at(&context, cursor, &visible);
+    ENSURE_SPA_RESULT(spa_result);
+
+    // Search on from each event in turn
+    while (*count < capacity) {
+        spa_result = next_change_in_visibility(&context, params, cursor, true, visible, end, &found, &event);
+        ENSURE_SPA_RESULT(spa_result);
+        if (!found) {
+            break;
+        }
+        events[*count].time = event;
+        events[*count].rise = !visible;
+        (*count)++;
+        cursor = event;
+        visible = !visible;
+    }
+    return SpaError_Success;
+}
+
+SpaError sunrise_sunset_calculate_event(const SunriseSunsetParameters *params, bool rise, SunriseSunsetResult *result) {
+    SunriseSunsetContext context;
+    SpaError spa_result;
+    unix_t event;
+    bool forward, found;
+
+    spa_result = solar_context_init(&context, params);
+    ENSURE_SPA_RESULT(spa_result);
+    context.horizon = visible_elevation_threshold(&context.observer);
+    spa_result = solar_visible_at(&context, params->time, &result->visible);
+    ENSURE_SPA_RESULT(spa_result);
+
+    // The sun rose before the time if it is visible and rises after it if not, and the other way round for the set
+    forward = result->visible != rise;
+    spa_result = next_change_in_visibility(&context,
+                                           params,
+                                           params->time,
+                                           forward,
+                                           result->visible,
+                                           forward ? SSC_UNBOUNDED : -SSC_UNBOUNDED,
+                                           &found,
+                                           &event);
+    ENSURE_SPA_RESULT(spa_result);
+    result->rise = rise ? event : 0;
+    result->set = rise ? 0 : event;
+    return SpaError_Success;
+}
+
+/// Most evaluations to refine a predicted event of sunrise_sunset_table() before the day is searched instead
+#define SSC_TABLE_MAX_EVALUATIONS 8
+/// Slowest change in elevation through the horizon that a predicted event is refined at, 1 degree per hour. Slower
+/// crossings are where the sun grazes the horizon near the polar circles, and events may appear or vanish within a
+/// day [degrees per second]
+#define SSC_TABLE_MIN_SLOPE (1.0 / 3600.0)
+/// A refined event must be within this much of its prediction [seconds]
+#define SSC_TABLE_WINDOW 3600.0
+/// Predicted events must be at least this far from the ends of their day, so that an event of the day before or after
+/// cannot be taken for it [seconds]
+#define SSC_TABLE_EDGE 3600
+
+/// Refine a predicted sunrise or sunset to the pair of whole seconds either side of it, by Newton steps on the
+/// uncorrected elevation with its rate of change from the hour angle
+/// @param[in, out] context Solar context for the location, with the horizon set up
+/// @param predicted Unix timestamp of the prediction
+/// @param rising True for a sunrise, false for a sunset
+/// @param[out] found Set to false if the event could not be refined from the prediction
+/// @param[out] event Out parameter for the first second of the new visibility
+/// @return SpaError code
+static SpaError table_refine_event(SunriseSunsetContext *context,
+                                   unix_t predicted,
+                                   bool rising,
+                                   bool *found,
+                                   unix_t *event) {
+    unix_t time = predicted, before = 0, after = 0, next;
+    bool have_before = false, have_after = false, is_after;
+    double offset, slope, crossing;
+    spa_lean_outputs values;
+    SpaError spa_result;
+    int i;
+
+    *found = false;
+    for (i = 0; i < SSC_TABLE_MAX_EVALUATIONS; i++) {
+        spa_result =
+            solar_evaluate(context, jd_from_unix(time), SpaOutput_Geocentric | SpaOutput_Topocentric, &values);
+        ENSURE_SPA_RESULT(spa_result);
+        offset = values.e0 - context->horizon;
+        is_after = (offset >= 0.0) == rising;
+        if (is_after && (!have_after || time < after)) {
+            after = time;
+            have_after = true;
+        } else if (!is_after && (!have_before || time > before)) {
+            before = time;
+            have_before = true;
+        }
+        if (have_before && have_after) {
+            if (after - before == 1) {
+                *found = true;
+                *event = after;
+                return SpaError_Success;
+            }
+            if (after < before) {
+                // Not a single crossing
+                return SpaError_Success;
+            }
+        }
+
+        // Rate of change of the elevation, from the hour angle alone
+        slope = -context->observer.cos_lat * cos(values.delta * M_PI / 180.0) * sin(values.h * M_PI / 180.0) /
+                cos(values.e0 * M_PI / 180.0) * SSC_HOUR_ANGLE_RATE;
+        if (!(rising ? slope >= SSC_TABLE_MIN_SLOPE : slope <= -SSC_TABLE_MIN_SLOPE)) {
+            return SpaError_Success;
+        }
+        // Estimate of the first second after the event, the next evaluation is it or the second before it
+        crossing = ceil((double) time - offset / slope);
+        if (!(fabs(crossing - (double) predicted) < SSC_TABLE_WINDOW)) {
+            return SpaError_Success;
+        }
+        next = is_after ? (unix_t) crossing - 1 : (unix_t) crossing;
+        next = is_after ? (next < time ? next : time - 1) : (next > time ? next : time + 1);
+        if (have_before && next <= before) {
+            next = before + 1;
+        }
+        if (have_after && next >= after) {
+            next = after - 1;
+        }
+        time = next;
+    }
+    return SpaError_Success;
+}
+
+/// Search a day of sunrise_sunset_table() without any predictions, as sunrise_sunset_events() does
+/// @param[in, out] context Solar context for the location, with the horizon set up
+/// @param[in] params Input parameters with SunriseSunsetSearch_Transit
+/// @param midnight Unix timestamp of the start of the day
+/// @param[out] day The first sunrise and sunset of the day
+/// @param[out] event_count Number of sunrises and sunsets during the day
+/// @param[out] visible_at_end If the sun is visible at the end of the day
+/// @return SpaError code
+static SpaError table_search_day(SunriseSunsetContext *context,
+                                 const SunriseSunsetParameters *params,
+                                 unix_t midnight,
+                                 SunriseSunsetDay *day,
+                                 size_t *event_count,
+                                 bool *visible_at_end) {
+    unix_t cursor = midnight, event;
+    SpaError spa_result;
+    bool visible, found = true;
+
+    spa_result = solar_visible_at(context, midnight, &visible);
+    ENSURE_SPA_RESULT(spa_result);
+    day->visible = visible;
+    day->has_rise = false;
+    day->has_set = false;
+    *event_count = 0;
+    while (found) {
+        spa_result = next_change_in_visibility(
+            context, params, cursor, true, visible, midnight + 86400, &found, &event);
+        ENSURE_SPA_RESULT(spa_result);
+        if (found) {
+            if (visible && !day->has_set) {
+                day->set = event;
+                day->has_set = true;
+            } else if (!visible && !day->has_rise) {
+                day->rise = event;
+                day->has_rise = true;
+            }
+            (*event_count)++;
+            cursor = event;
+            visible = !visible;
+        }
+    }
+    *visible_at_end = visible;
+    return SpaError_Success;
+}
+
+SpaError sunrise_sunset_table(const SunriseSunsetParameters *params,
+                              size_t day_count,
+                              SunriseSunsetDay *days,
+                              SunriseSunsetTableStats *stats) {
+    SunriseSunsetParameters search = *params;
+    SunriseSunsetSearchStats search_stats;
+    SunriseSunsetContext context;
+    SpaError spa_result;
+    unix_t midnight = local_mean_midnight(params->time, params->longitude);
+    // Sunrise and sunset of the last two days from their midnights, [0] is the day before
+    unix_t rise_offsets[2] = {0, 0}, set_offsets[2] = {0, 0};
+    size_t known = 0, event_count, d;
+    bool visible = false;
+
+    search.search = SunriseSunsetSearch_Transit;
+    spa_result = solar_context_init(&context, &search);
+    ENSURE_SPA_RESULT(spa_result);
+    search_stats_init(&search_stats);
+    context.stats = &search_stats;
+    if (stats != NULL) {
+        stats->events = 0;
+        stats->seeded = 0;
+        stats->searched = 0;
+    }
+
+    for (d = 0; d < day_count; d++, midnight += 86400) {
+        SunriseSunsetDay *day = &days[d];
+        bool rise_found = false, set_found = false;
+
+        // Predict each event from the day before, and the day before that if it also had both
+        if (known > 0) {
+            unix_t rise = midnight + (known > 1 ? 2 * rise_offsets[0] - rise_offsets[1] : rise_offsets[0]);
+            unix_t set = midnight + (known > 1 ? 2 * set_offsets[0] - set_offsets[1] : set_offsets[0]);
+            spa_result = table_refine_event(&context, rise, true, &rise_found, &day->rise);
+            ENSURE_SPA_RESULT(spa_result);
+            if (rise_found) {
+                spa_result = table_refine_event(&context, set, false, &set_found, &day->set);
+                ENSURE_SPA_RESULT(spa_result);
+            }
+        }
+        // Both refined events must be well inside the day, in the order of the visibility at its start
+        if (rise_found && set_found && day->rise >= midnight + SSC_TABLE_EDGE &&
+            day->rise <= midnight + 86400 - SSC_TABLE_EDGE && day->set >= midnight + SSC_TABLE_EDGE &&
+            day->set <= midnight + 86400 - SSC_TABLE_EDGE && (day->set < day->rise) == visible) {
+            day->has_rise = true;
+            day->has_set = true;
+            day->visible = visible;
+            event_count = 2;
+            if (stats != NULL) {
+                stats->seeded += 2;
+            }
+        } else {
+            spa_result = table_search_day(&context, &search, midnight, day, &event_count, &visible);
+            ENSURE_SPA_RESULT(spa_result);
+            if (stats != NULL) {
+                stats->searched++;
+            }
+        }
+        if (stats != NULL) {
+            stats->events += event_count;
+        }
+
+        if (day->has_rise && day->has_set && event_count == 2) {
+            rise_offsets[1] = rise_offsets[0];
+            set_offsets[1] = set_offsets[0];
+            rise_offsets[0] = day->rise - midnight;
+            set_offsets[0] = day->set - midnight;
+            known = known < 2 ? known + 1 : 2;
+        } else {
+            known = 0;
+        }
+    }
+    if (stats != NULL) {
+        stats->evaluations = search_stats.evaluations;
+    }
+    return SpaError_Success;
+}
+
+/// Spacing of the shared samples that sunrise_sunset_crossings() brackets every threshold with [seconds]
+#define SSC_CROSSING_STEP 7200
+/// Most samples sunrise_sunset_crossings() keeps, the steps of the day plus those added at its extremes
+#define SSC_CROSSING_MAX_SAMPLES 48
+/// Allowance for the error of a parabola through three samples at the highest or lowest elevation [degrees]
+#define SSC_CROSSING_PEAK_MARGIN 0.1
+/// Rounds of parabolic interpolation towards the extremes of the day
+#define SSC_CROSSING_PEAK_ITERATIONS 4
+
+/// Check if any threshold might be crossed twice between the samples around a highest or lowest elevation.
+/// The thresholds are refraction corrected, so they are widened by the most refraction there can be.
+/// @param sample Elevation of the highest (or lowest) sample [degrees]
+/// @param extreme Interpolated highest (or lowest) elevation [degrees]
+/// @param highest True at the highest elevation of the day, false at the lowest
+/// @param[in] thresholds Refraction corrected thresholds [degrees]
+/// @param threshold_count Number of thresholds
+/// @param refraction Most refraction the observer can apply [degrees]
+static bool crossing_hidden(double sample,
+                            double extreme,
+                            bool highest,
+                            const double *thresholds,
+                            size_t threshold_count,
+                            double refraction) {
+    size_t k;
+    for (k = 0; k < threshold_count; k++) {
+        if (highest ? sample < thresholds[k] && thresholds[k] <= extreme + SSC_CROSSING_PEAK_MARGIN + refraction
+                    : sample >= thresholds[k] - refraction && thresholds[k] > extreme - SSC_CROSSING_PEAK_MARGIN) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Add samples at the highest and lowest elevations of the day, found by successive parabolic interpolation, wherever a
+/// threshold might be crossed and crossed back between two samples
+/// @param[in, out] context Solar context for the location
+/// @param[in, out] samples Samples in time order
+/// @param[in, out] sample_count Number of samples
+/// @param[in] thresholds Refraction corrected thresholds [degrees]
+/// @param threshold_count Number of thresholds
+/// @return SpaError code
+static SpaError crossing_sample_extremes(SunriseSunsetContext *context,
+                                         CrossingSample *samples,
+                                         size_t *sample_count,
+                                         const double *thresholds,
+                                         size_t threshold_count) {
+    const spa_observer *observer = &context->observer;
+    double refraction = spa_observer_refraction_corrected(observer, observer->refract_limit) - observer->refract_limit;
+    CrossingSample swap;
+    SpaError spa_result;
+    size_t i, j, k;
+    int round;
+
+    for (round = 0; round < SSC_CROSSING_PEAK_ITERATIONS; round++) {
+        bool inserted = false;
+        for (i = 1; i + 1 < *sample_count && *sample_count < SSC_CROSSING_MAX_SAMPLES; i++) {
+            double y0 = samples[i - 1].elevation, y1 = samples[i].elevation, y2 = samples[i + 1].elevation;
+            double a = (double) (samples[i - 1].time - samples[i].time);
+            double c = (double) (samples[i + 1].time - samples[i].time);
+            double q, p, x;
+            bool highest = y1 > y0 && y1 >= y2, lowest = y1 < y0 && y1 <= y2;
+            unix_t time;
+            if (!highest && !lowest) {
+                continue;
+            }
+            // Parabola y1 + p x + q x^2 through the three samples, with x relative to the middle one
+            q = ((y2 - y1) / c - (y0 - y1) / a) / (c - a);
+            p = (y2 - y1) / c - q * c;
+            if (q == 0.0 || !crossing_hidden(y1, y1 - p * p / (4.0 * q), highest, thresholds, threshold_count,
+                                             refraction)) {
+                continue;
+            }
+            x = floor(-p / (2.0 * q) + 0.5);
+            x = x <= a ? a + 1.0 : (x >= c ? c - 1.0 : x);
+            time = samples[i].time + (unix_t) x;
+            if (x == 0.0 || time <= samples[i - 1].time || time >= samples[i + 1].time) {
+                continue;
+            }
+            // Swapped down into place, as in insert_crossing()
+            spa_result = solar_elevation_uncorrected(context, time, &swap.elevation);
+            ENSURE_SPA_RESULT(spa_result);
+            swap.time = time;
+            samples[*sample_count] = swap;
+            for (k = *sample_count, j = x < 0.0 ? i : i + 1; k > j; k--) {
+                swap = samples[k];
+                samples[k] = samples[k - 1];
+                samples[k - 1] = swap;
+            }
+            (*sample_count)++;
+            inserted = true;
+            i++;
+        }
+        if (!inserted) {
+            break;
+        }
+    }
+    return SpaError_Success;
+}
+
+/// Insert a crossing into a buffer in time order, dropping the latest crossing if the buffer is full
+static void insert_crossing(SunriseSunsetCrossing *crossings,
+                            size_t capacity,
+                            size_t *count,
+                            const SunriseSunsetCrossing *crossing) {
+    SunriseSunsetCrossing swap;
+    size_t i;
+    if (*count == capacity) {
+        if (capacity == 0 || crossings[capacity - 1].time <= crossing->time) {
+            return;
+        }
+        (*count)--;
+    }
+    // Swapped into place rather than shifting the later crossings up, which compilers turn into memmove() and the
+    // nostdlib build does not have
+    crossings[*count] = *crossing;
+    for (i = (*count)++; i > 0 && crossings[i - 1].time > crossings[i].time; i--) {
+        swap = crossings[i];
+        crossings[i] = crossings[i - 1];
+        crossings[i - 1] = swap;
+    }
+}
+
+SpaError sunrise_sunset_crossings(const SunriseSunsetParameters *params,
+                                  const double *thresholds,
+                                  size_t threshold_count,
+                                  SunriseSunsetCrossing *crossings,
+                                  size_t capacity,
+                                  size_t *count) {
+    SunriseSunsetContext context;
+    CrossingSample samples[SSC_CROSSING_MAX_SAMPLES];
+    SunriseSunsetCrossing crossing;
+    SpaError spa_result;
+    unix_t start = local_mean_midnight(params->time, params->longitude), end = start + 86400, time;
+    size_t sample_count = 0, i, k;
+
+    *count = 0;
+    for (k = 0; k < threshold_count; k++) {
+        // Written so that NaN fails too
+        if (!(fabs(thresholds[k]) <= 90.0)) {
+            return SpaError_InvalidThreshold;
+        }
+    }
+    spa_result = solar_context_init(&context, params);
+    ENSURE_SPA_RESULT(spa_result);
+
+    // The shared evaluations, a step either side of the day so that the extremes at its ends are seen
+    for (time = start - SSC_CROSSING_STEP; time <= end + SSC_CROSSING_STEP; time += SSC_CROSSING_STEP) {
+        samples[sample_count].time = time;
+        spa_result = solar_elevation_uncorrected(&context, time, &samples[sample_count].elevation);
+        ENSURE_SPA_RESULT(spa_result);
+        sample_count++;
+    }
+    spa_result = crossing_sample_extremes(&context, samples, &sample_count, thresholds, threshold_count);
+    ENSURE_SPA_RESULT(spa_result);
+
+    // Between extremes the elevation is monotonic, so each pair of samples brackets at most one crossing of each
+    for (k = 0; k < threshold_count; k++) {
+        double horizon = uncorrected_elevation_threshold(&context.observer, thresholds[k]);
+        for (i = 0; i + 1 < sample_count; i++) {
+            bool above = samples[i + 1].elevation >= horizon;
+            if (samples[i].time < start || samples[i + 1].time > end || (samples[i].elevation >= horizon) == above) {
+                continue;
+            }
+            spa_result = refine_crossing(&context, horizon, samples[i], samples[i + 1], &crossing.time);
+            ENSURE_SPA_RESULT(spa_result);
+            crossing.threshold = k;
+            crossing.rising = above;
+            insert_crossing(crossings, capacity, count, &crossing);
+        }
+    }
+    return SpaError_Success;
+}
+
+/// Number of following intervals a calculator steps through before recalculating from scratch
+#define SSC_CALCULATOR_MAX_ADVANCE 2
+
+/// Set up the solar context of a calculator, which searches with the visible horizon at all latitudes
+static SpaError calculator_context_init(const SunriseSunsetCalculator *calculator, SunriseSunsetContext *context) {
+    SpaError spa_result = solar_context_init(context, &calculator->params);
+    ENSURE_SPA_RESULT(spa_result);
+    context->horizon = visible_elevation_threshold(&context->observer);
+    return SpaError_Success;
+}
+
+SpaError SunriseSunsetCalculator_init(SunriseSunsetCalculator *calculator, const SunriseSunsetParameters *params) {
+    SunriseSunsetContext context;
+    calculator->params = *params;
+    calculator->cached = false;
+    return calculator_context_init(calculator, &context);
+}
+
+/// Calculate the interval containing a time from scratch
+static SpaError calculator_refresh(SunriseSunsetCalculator *calculator, SunriseSunsetContext *context, unix_t time) {
+    spa_ephemeris ephemeris;
+    SpaError spa_result;
+    bool visible, found;
+    unix_t start, end;
+
+    calculator->params.time = time;
+    spa_result = solar_ephemeris(context, jd_from_unix(time), &ephemeris);
+    ENSURE_SPA_RESULT(spa_result);
+    visible = sun_is_up(spa_calculate_elevation(&ephemeris, &context->observer));
+
+    // Both directions skip polar day and night, and give the first second of the later visibility
+    spa_result = next_change_in_visibility(
+        context, &calculator->params, time, false, visible, -SSC_UNBOUNDED, &found, &start);
+    ENSURE_SPA_RESULT(spa_result);
+    spa_result =
+        next_change_in_visibility(context, &calculator->params, time, true, visible, SSC_UNBOUNDED, &found, &end);
+    ENSURE_SPA_RESULT(spa_result);
+
+    calculator->visible = visible;
+    calculator->interval_start = start;
+    calculator->interval_end = end;
+    calculator->cached = true;
+    return SpaError_Success;
+}
+
+SpaError sunrise_sunset_calculator_query(SunriseSunsetCalculator *calculator,
+                                         unix_t time,
+                                         SunriseSunsetResult *result) {
+    SunriseSunsetContext context;
+    SpaError spa_result;
+    unix_t next;
+    bool found;
+    int i;
+
+    if (!calculator->cached || time < calculator->interval_start || time >= calculator->interval_end) {
+        // The context is only needed to search, queries within the interval do not set it up
+        spa_result = calculator_context_init(calculator, &context);
+        ENSURE_SPA_RESULT(spa_result);
+
+        // Step forwards an event at a time while the time has only just passed the interval
+        for (i = 0; calculator->cached && time >= calculator->interval_end && i < SSC_CALCULATOR_MAX_ADVANCE; i++) {
+            calculator->cached = false;
+            spa_result = next_change_in_visibility(&context,
+                                                   &calculator->params,
+                                                   calculator->interval_end,
+                                                   true,
+                                                   !calculator->visible,
+                                                   SSC_UNBOUNDED,
+                                                   &found,
+                                                   &next);
+            ENSURE_SPA_RESULT(spa_result);
+            calculator->visible = !calculator->visible;
+            calculator->interval_start = calculator->interval_end;
+            calculator->interval_end = next;
+            calculator->cached = true;
+        }
+        if (!calculator->cached || time < calculator->interval_start || time >= calculator->interval_end) {
+            calculator->cached = false;
+            spa_result = calculator_refresh(calculator, &context, time);
+            ENSURE_SPA_RESULT(spa_result);
+        }
+    }
+
+    result->visible = calculator->visible;
+    result->rise = calculator->visible ? calculator->interval_start : calculator->interval_end;
+    result->set = calculator->visible ? calculator->interval_end : calculator->interval_start;
+    return SpaError_Success;
+}
+
+void SunriseSunsetBatchInput_init(SunriseSunsetBatchInput *input,
+                                  size_t count,
+                                  const unix_t *time,
+                                  const double *latitude,
+                                  const double *longitude) {
+    input->count = count;
+    input->time = time;
+    input->latitude = latitude;
+    input->longitude = longitude;
+    input->elevation = NULL;
+    input->pressure = NULL;
+    input->temperature = NULL;
+    input->step_size = NULL;
+    input->delta_t = 0.0;
+    input->shared_elevation = SSC_DEFAULT_ELEVATION;
+    input->shared_pressure = SSC_DEFAULT_PRESSURE;
+    input->shared_temperature = SSC_DEFAULT_TEMPERATURE;
+    input->atmos_refract = SSC_DEFAULT_ATMOSPHERIC_REFRACTION;
+    input->nutation = SpaNutation_Full;
+    input->nutation_interval = SSC_DEFAULT_NUTATION_INTERVAL;
+    input->ephemeris_table = NULL;
+    input->engine = SunriseSunsetEngine_Spa;
+}
+
+/// Number of items that are searched in lockstep by sunrise_sunset_calculate_batch()
+#define SSC_BATCH_LANES 16
+
+typedef enum {
+    BatchPhase_Visibility,
+    BatchPhase_Backward,
+    BatchPhase_Forward,
+    BatchPhase_Done,
+} BatchPhase;
+
+/// The state of one item in a batch, equivalent to the locals of sunrise_sunset_calculate()
+typedef struct {
+    size_t item;              ///< Index of the item in the input columns
+    BatchPhase phase;         ///< Which part of the calculation the lane is in
+    unix_t time;              ///< Input time of the item
+    int64_t step_size;        ///< Input step size of the item
+    bool visible;             ///< If the sun is visible at the input time
+    unix_t cursor;            ///< Time to evaluate the elevation at next
+    int64_t step;             ///< Current signed step of the search
+    bool search_visible;      ///< Visibility at the last evaluated point of the search
+    spa_nutation nutation;    ///< Nutation series and interpolation cache of the item
+    SunriseSunsetStats stats; ///< Statistics of the item
+    bool polar;               ///< If polar day and night are skipped, see SSC_POLAR_LATITUDE
+    double latitude;          ///< Input latitude of the item
+    double horizon;           ///< Uncorrected elevation at which the sun becomes visible, when polar [degrees]
+} BatchLane;
+
+static void batch_lane_begin_search(BatchLane *lane, BatchPhase phase) {
+    lane->phase = phase;
+    lane->cursor = lane->time;
+    lane->step = phase == BatchPhase_Backward ? -lane->step_size : lane->step_size;
+    lane->search_visible = lane->visible;
+}
+
+/// Advance a lane using the elevation at its cursor, mirrors search_for_change_in_visibility()
+/// @return True once the lane has finished its item
+static bool batch_lane_advance(BatchLane *lane,
+                               const spa_ephemeris *ephemeris,
+                               double elevation,
+                               const SunriseSunsetBatchOutput *output) {
+    SunriseSunsetSearchStats *stats = lane->phase == BatchPhase_Backward ? &lane->stats.backward : &lane->stats.forward;
+    lane->stats.evaluations++;
+    if (lane->phase == BatchPhase_Visibility) {
+        lane->visible = sun_is_up(elevation);
+        output->visible[lane->item] = lane->visible;
+        batch_lane_begin_search(lane, BatchPhase_Backward);
+    } else if (sun_is_up(elevation) != lane->search_visible) {
+        lane->step = -(lane->step / 2);
+        lane->search_visible = !lane->search_visible;
+        stats->evaluations++;
+        stats->bisections++;
+    } else {
+        int64_t step_abs = lane->step > 0 ? lane->step : -lane->step;
+        int64_t steps = 1;
+        // Steps after the first change in visibility are part of the bisection
+        if (lane->polar && stats->bisections == 0) {
+            int64_t skip_steps =
+                polar_skip(lane->latitude, lane->horizon, ephemeris->delta, lane->search_visible) / step_abs;
+            steps = skip_steps > 1 ? skip_steps : 1;
+        }
+        lane->cursor += steps * lane->step;
+        stats->evaluations++;
+        if (stats->bisections == 0) {
+            stats->steps++;
+            stats->skipped += (steps - 1) * step_abs;
+        }
+    }
+    // A search has found its event once the step size reaches zero
+    while (lane->phase != BatchPhase_Done && lane->step == 0) {
+        if (lane->phase == BatchPhase_Backward) {
+            (lane->visible ? output->rise : output->set)[lane->item] = lane->cursor;
+            lane->stats.backward.span = lane->time - lane->cursor;
+            batch_lane_begin_search(lane, BatchPhase_Forward);
+        } else {
+            (lane->visible ? output->set : output->rise)[lane->item] = lane->cursor;
+            lane->stats.forward.span = lane->cursor - lane->time;
+            lane->phase = BatchPhase_Done;
+            if (output->stats != NULL) {
+                sunrise_sunset_stats_add(output->stats, &lane->stats);
+            }
+        }
+    }
+    return lane->phase == BatchPhase_Done;
+}
+
+SpaError sunrise_sunset_calculate_batch(const SunriseSunsetBatchInput *input, const SunriseSunsetBatchOutput *output) {
+    BatchLane lanes[SSC_BATCH_LANES];
+    spa_observer observers[SSC_BATCH_LANES];
+    spa_ephemeris ephemerides[SSC_BATCH_LANES];
+    double elevations[SSC_BATCH_LANES];
+    SpaError first_error = SpaError_Success;
+    size_t next = 0;
+    int active = 0;
+    int lane, kept;
+
+    for (;;) {
+        // Fill any free lanes with the next items
+        while (active < SSC_BATCH_LANES && next < input->count) {
+            size_t i = next++;
+            SpaError status = spa_observer_init(&observers[active],
+                                                input->latitude[i],
+                                                input->longitude[i],
+                                                input->elevation ? input->elevation[i] : input->shared_elevation,
+                                                input->pressure ? input->pressure[i] : input->shared_pressure,
+                                                input->temperature ? input->temperature[i] : input->shared_temperature,
+                                                input->atmos_refract);
+            output->status[i] = status;
+            if (status != SpaError_Success) {
+                first_error = first_error == SpaError_Success ? status : first_error;
+                continue;
+            }
+            lanes[active].item = i;
+            lanes[active].phase = BatchPhase_Visibility;
+            lanes[active].time = input->time[i];
+            lanes[active].step_size = (int64_t) (input->step_size ? input->step_size[i]
+                                                 : sunrise_sunset_default_step_size(input->latitude[i]));
+            lanes[active].cursor = input->time[i];
+            spa_nutation_init(&lanes[active].nutation, input->nutation, input->nutation_interval);
+            lanes[active].polar = fabs(input->latitude[i]) >= SSC_POLAR_LATITUDE;
+            lanes[active].latitude = input->latitude[i];
+            lanes[active].horizon = lanes[active].polar ? visible_elevation_threshold(&observers[active]) : 0.0;
+            lanes[active].stats.evaluations = 0;
+            search_stats_init(&lanes[active].stats.backward);
+            search_stats_init(&lanes[active].stats.forward);
+            active++;
+        }
+        if (active == 0) {
+            break;
+        }
+
+        // Time dependent stage, shared between neighbouring lanes evaluating the same time.
+        // Lanes that have stepped outside of the supported date range are dropped here.
+        kept = 0;
+        for (lane = 0; lane < active; lane++) {
+            double jd = jd_from_unix(lanes[lane].cursor);
+            SpaError status = SpaError_Success;
+            if (kept > 0 && ephemerides[kept - 1].jd == jd) {
+                ephemerides[kept] = ephemerides[kept - 1];
+            } else {
+                status = calculate_ephemeris(&ephemerides[kept],
+                                             jd,
+                                             input->delta_t,
+                                             input->engine,
+                                             &lanes[lane].nutation,
+                                             input->ephemeris_table);
+            }
+            if (status != SpaError_Success) {
+                output->status[lanes[lane].item] = status;
+                first_error = first_error == SpaError_Success ? status : first_error;
+                continue;
+            }
+            if (kept != lane) {
+                lanes[kept] = lanes[lane];
+                observers[kept] = observers[lane];
+            }
+            kept++;
+        }
+        active = kept;
+
+        // Observer dependent stage across all lanes
+        spa_calculate_elevations(active, ephemerides, observers, elevations);
+
+        // Advance each lane and compact the ones still in progress
+        kept = 0;
+        for (lane = 0; lane < active; lane++) {
+            if (batch_lane_advance(&lanes[lane], &ephemerides[lane], elevations[lane], output)) {
+                continue;
+            }
+            if (kept != lane) {
+                lanes[kept] = lanes[lane];
+                observers[kept] = observers[lane];
+            }
+            kept++;
+        }
+        active = kept;
+    }
+
+    return first_error;
+}
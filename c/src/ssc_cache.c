@@ -0,0 +1,271 @@
+//
+//  ssc_cache.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+#include "ssc_cache.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+typedef CRITICAL_SECTION cache_mutex;
+#define cache_mutex_init(mutex) InitializeCriticalSection(mutex)
+#define cache_mutex_destroy(mutex) DeleteCriticalSection(mutex)
+#define cache_mutex_lock(mutex) EnterCriticalSection(mutex)
+#define cache_mutex_unlock(mutex) LeaveCriticalSection(mutex)
+#else
+#include <pthread.h>
+typedef pthread_mutex_t cache_mutex;
+#define cache_mutex_init(mutex) pthread_mutex_init(mutex, NULL)
+#define cache_mutex_destroy(mutex) pthread_mutex_destroy(mutex)
+#define cache_mutex_lock(mutex) pthread_mutex_lock(mutex)
+#define cache_mutex_unlock(mutex) pthread_mutex_unlock(mutex)
+#endif
+
+/// Bytes between the counters of neighbouring shards, so that shards used by different threads do not share a cache
+/// line
+#define CACHE_LINE 64
+
+/// The events found around a time, which answer any query with the same key between them
+typedef struct {
+    uint64_t latitude;  ///< Rounded latitude, see cache_round()
+    uint64_t longitude; ///< Rounded longitude, see cache_round()
+    uint64_t params;    ///< Hash of the other parameters
+    unix_t rise;
+    unix_t set;
+    uint64_t used; ///< Clock of the shard when the entry was last stored or hit, 0 when the entry is empty
+    bool visible;
+} CacheEntry;
+
+typedef struct {
+    cache_mutex mutex;
+    uint64_t clock; ///< Counts the uses of the shard, to find the least recently used entry of a bucket
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t stores;
+    uint64_t evictions;
+    uint64_t entries;
+    char padding[CACHE_LINE];
+} CacheShard;
+
+struct SunriseSunsetCache {
+    double resolution;
+    size_t bucket_mask; ///< Number of buckets minus one, a power of two minus one
+    size_t shard_mask;  ///< Number of shards minus one, bucket b is in shard b & shard_mask
+    CacheShard *shards;
+    CacheEntry *entries; ///< SSC_CACHE_WAYS entries of each bucket
+};
+
+void SunriseSunsetCacheConfig_init(SunriseSunsetCacheConfig *config) {
+    config->entries = SSC_CACHE_DEFAULT_ENTRIES;
+    config->resolution = SSC_CACHE_DEFAULT_RESOLUTION;
+    config->shards = SSC_CACHE_DEFAULT_SHARDS;
+}
+
+/// Smallest power of two that is at least n
+static size_t power_of_two(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+SunriseSunsetCache *sunrise_sunset_cache_create(const SunriseSunsetCacheConfig *config) {
+    SunriseSunsetCache *cache;
+    size_t buckets, shards, i;
+
+    // Finer resolutions than a nanodegree would overflow the keys, and are no use anyway
+    if (config->entries == 0 || config->shards == 0 || !(config->resolution >= 0.0) || config->resolution > 1.0 ||
+        (config->resolution > 0.0 && config->resolution < 1e-9)) {
+        return NULL;
+    }
+    buckets = power_of_two((config->entries + SSC_CACHE_WAYS - 1) / SSC_CACHE_WAYS);
+    shards = power_of_two(config->shards);
+    // Every shard has at least one bucket
+    if (shards > buckets) {
+        shards = buckets;
+    }
+    cache = (SunriseSunsetCache *) malloc(sizeof(SunriseSunsetCache));
+    if (cache == NULL) {
+        return NULL;
+    }
+    cache->resolution = config->resolution;
+    cache->bucket_mask = buckets - 1;
+    cache->shard_mask = shards - 1;
+    cache->shards = (CacheShard *) calloc(shards, sizeof(CacheShard));
+    cache->entries = (CacheEntry *) calloc(buckets * SSC_CACHE_WAYS, sizeof(CacheEntry));
+    if (cache->shards == NULL || cache->entries == NULL) {
+        free(cache->shards);
+        free(cache->entries);
+        free(cache);
+        return NULL;
+    }
+    for (i = 0; i < shards; i++) {
+        cache_mutex_init(&cache->shards[i].mutex);
+    }
+    return cache;
+}
+
+void sunrise_sunset_cache_destroy(SunriseSunsetCache *cache) {
+    size_t i;
+    if (cache == NULL) {
+        return;
+    }
+    for (i = 0; i <= cache->shard_mask; i++) {
+        cache_mutex_destroy(&cache->shards[i].mutex);
+    }
+    free(cache->shards);
+    free(cache->entries);
+    free(cache);
+}
+
+/// The splitmix64 finaliser, which mixes every bit of its input into every bit of the hash
+static uint64_t mix(uint64_t hash) {
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ull;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBull;
+    return hash ^ (hash >> 31);
+}
+
+static uint64_t double_bits(double value) {
+    uint64_t bits;
+    // Adding zero turns -0.0 into 0.0, so that the two are the same key
+    value += 0.0;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+/// Hash every parameter other than the time and location
+static uint64_t params_hash(const SunriseSunsetParameters *params) {
+    uint64_t hash = 0;
+    hash = mix(hash ^ double_bits(params->delta_t));
+    hash = mix(hash ^ double_bits(params->elevation));
+    hash = mix(hash ^ double_bits(params->pressure));
+    hash = mix(hash ^ double_bits(params->temperature));
+    hash = mix(hash ^ double_bits(params->atmos_refract));
+    hash = mix(hash ^ double_bits(params->nutation_interval));
+    hash = mix(hash ^ (uint64_t) (uintptr_t) params->ephemeris_table);
+    hash = mix(hash ^ params->step_size ^ (uint64_t) params->nutation << 32);
+    return mix(hash ^ (uint64_t) params->search ^ (uint64_t) params->engine << 32);
+}
+
+/// Round a coordinate to the resolution of the cache, giving the rounded value and its key
+static double cache_round(const SunriseSunsetCache *cache, double value, double limit, uint64_t *key) {
+    double cell;
+    if (cache->resolution == 0.0) {
+        *key = double_bits(value);
+        return value;
+    }
+    cell = floor(value / cache->resolution + 0.5);
+    *key = (uint64_t) (int64_t) cell;
+    value = cell * cache->resolution;
+    return value > limit ? limit : value < -limit ? -limit : value;
+}
+
+static bool entry_contains(const CacheEntry *entry, unix_t time) {
+    return entry->visible ? entry->rise < time && time < entry->set : entry->set < time && time < entry->rise;
+}
+
+SpaError sunrise_sunset_cache_calculate(SunriseSunsetCache *cache,
+                                        const SunriseSunsetParameters *params,
+                                        SunriseSunsetResult *result,
+                                        bool *hit) {
+    SunriseSunsetParameters rounded;
+    CacheEntry key, *bucket, *entry;
+    CacheShard *shard;
+    size_t index, i;
+    SpaError spa_result;
+
+    if (hit != NULL) {
+        *hit = false;
+    }
+    // Leave out of range coordinates for sunrise_sunset_calculate() to reject, rather than round them into range
+    if (!(fabs(params->latitude) <= 90.0 && fabs(params->longitude) <= 180.0)) {
+        return sunrise_sunset_calculate(params, result);
+    }
+    rounded = *params;
+    rounded.latitude = cache_round(cache, params->latitude, 90.0, &key.latitude);
+    rounded.longitude = cache_round(cache, params->longitude, 180.0, &key.longitude);
+    key.params = params_hash(params);
+    index = (size_t) mix(key.params ^ mix(key.latitude ^ mix(key.longitude))) & cache->bucket_mask;
+    bucket = &cache->entries[index * SSC_CACHE_WAYS];
+    shard = &cache->shards[index & cache->shard_mask];
+
+    cache_mutex_lock(&shard->mutex);
+    shard->clock++;
+    for (i = 0; i < SSC_CACHE_WAYS; i++) {
+        entry = &bucket[i];
+        if (entry->used != 0 && entry->latitude == key.latitude && entry->longitude == key.longitude &&
+            entry->params == key.params && entry_contains(entry, params->time)) {
+            entry->used = shard->clock;
+            shard->hits++;
+            result->rise = entry->rise;
+            result->set = entry->set;
+            result->visible = entry->visible;
+            cache_mutex_unlock(&shard->mutex);
+            if (hit != NULL) {
+                *hit = true;
+            }
+            return SpaError_Success;
+        }
+    }
+    shard->misses++;
+    cache_mutex_unlock(&shard->mutex);
+
+    // Search without the lock, so other queries of the shard are not held up
+    spa_result = sunrise_sunset_calculate(&rounded, result);
+    if (spa_result != SpaError_Success) {
+        return spa_result;
+    }
+
+    cache_mutex_lock(&shard->mutex);
+    shard->clock++;
+    // Replace an empty entry, another thread's copy of the same interval, or else the least recently used entry
+    entry = &bucket[0];
+    for (i = 0; i < SSC_CACHE_WAYS; i++) {
+        if (bucket[i].used != 0 && bucket[i].latitude == key.latitude && bucket[i].longitude == key.longitude &&
+            bucket[i].params == key.params && bucket[i].rise == result->rise && bucket[i].set == result->set) {
+            entry = &bucket[i];
+            break;
+        }
+        if (bucket[i].used < entry->used) {
+            entry = &bucket[i];
+        }
+    }
+    if (i == SSC_CACHE_WAYS) {
+        shard->stores++;
+        if (entry->used != 0) {
+            shard->evictions++;
+        } else {
+            shard->entries++;
+        }
+    }
+    entry->latitude = key.latitude;
+    entry->longitude = key.longitude;
+    entry->params = key.params;
+    entry->rise = result->rise;
+    entry->set = result->set;
+    entry->visible = result->visible;
+    entry->used = shard->clock;
+    cache_mutex_unlock(&shard->mutex);
+    return SpaError_Success;
+}
+
+void sunrise_sunset_cache_stats(SunriseSunsetCache *cache, SunriseSunsetCacheStats *stats) {
+    size_t i;
+    memset(stats, 0, sizeof(*stats));
+    stats->capacity = (uint64_t) (cache->bucket_mask + 1) * SSC_CACHE_WAYS;
+    for (i = 0; i <= cache->shard_mask; i++) {
+        CacheShard *shard = &cache->shards[i];
+        cache_mutex_lock(&shard->mutex);
+        stats->hits += shard->hits;
+        stats->misses += shard->misses;
+        stats->stores += shard->stores;
+        stats->evictions += shard->evictions;
+        stats->entries += shard->entries;
+        cache_mutex_unlock(&shard->mutex);
+    }
+}
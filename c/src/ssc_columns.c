@@ -0,0 +1,165 @@
+//
+//  ssc_columns.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+#include "ssc_columns.h"
+
+#define HEADER_SIZE ((uint32_t) sizeof(ssc_columns_header))
+/// Most rows a file can hold, so that no single column size overflows (layout() checks the total)
+#define MAX_ROWS (((size_t) -1) / 64)
+
+/// Native size of each value of each column [bytes]
+static const uint32_t COLUMN_WIDTHS[SscColumn_Count] = {
+    sizeof(unix_t),
+    sizeof(double),
+    sizeof(double),
+    sizeof(double),
+    sizeof(double),
+    sizeof(double),
+    sizeof(unix_t),
+    sizeof(unix_t),
+    sizeof(bool),
+    sizeof(SpaError),
+};
+
+static size_t align(size_t size) {
+    return (size + SSC_COLUMNS_ALIGNMENT - 1) / SSC_COLUMNS_ALIGNMENT * SSC_COLUMNS_ALIGNMENT;
+}
+
+/// Lay out the columns after the header
+/// @param row_count Number of rows, at most MAX_ROWS
+/// @param[out] offsets Offset of each column, 0 if it is not present
+/// @return Size of the header and columns [bytes], 0 if it does not fit in a size_t
+static size_t layout(size_t row_count, uint32_t column_mask, uint64_t *offsets) {
+    size_t offset = align(HEADER_SIZE);
+    int column;
+    for (column = 0; column < SscColumn_Count; column++) {
+        offsets[column] = 0;
+        if (column_mask & SSC_COLUMN(column)) {
+            size_t column_size = align(row_count * COLUMN_WIDTHS[column]);
+            if (column_size > ((size_t) -1) - offset) {
+                return 0;
+            }
+            offsets[column] = offset;
+            offset += column_size;
+        }
+    }
+    return offset;
+}
+
+static void *column_data(void *data, const ssc_columns_header *header, SscColumn column) {
+    return header->offsets[column] != 0 ? (char *) data + header->offsets[column] : NULL;
+}
+
+static void set_view(ssc_columns *columns, void *data) {
+    ssc_columns_header *header = (ssc_columns_header *) data;
+    columns->header = header;
+    columns->row_count = (size_t) header->row_count;
+    columns->time = (unix_t *) column_data(data, header, SscColumn_Time);
+    columns->latitude = (double *) column_data(data, header, SscColumn_Latitude);
+    columns->longitude = (double *) column_data(data, header, SscColumn_Longitude);
+    columns->elevation = (double *) column_data(data, header, SscColumn_Elevation);
+    columns->pressure = (double *) column_data(data, header, SscColumn_Pressure);
+    columns->temperature = (double *) column_data(data, header, SscColumn_Temperature);
+    columns->rise = (unix_t *) column_data(data, header, SscColumn_Rise);
+    columns->set = (unix_t *) column_data(data, header, SscColumn_Set);
+    columns->visible = (bool *) column_data(data, header, SscColumn_Visible);
+    columns->status = (SpaError *) column_data(data, header, SscColumn_Status);
+}
+
+size_t ssc_columns_size(size_t row_count, uint32_t column_mask) {
+    uint64_t offsets[SscColumn_Count];
+    if (row_count > MAX_ROWS || column_mask >= SSC_COLUMN(SscColumn_Count)) {
+        return 0;
+    }
+    return layout(row_count, column_mask, offsets);
+}
+
+SscColumnsError
+ssc_columns_create(ssc_columns *columns, void *buffer, size_t size, size_t row_count, uint32_t column_mask) {
+    ssc_columns_header *header = (ssc_columns_header *) buffer;
+    size_t required = ssc_columns_size(row_count, column_mask);
+    int i;
+
+    if (required == 0 || size < required || (uintptr_t) buffer % sizeof(double) != 0) {
+        return SscColumnsError_InvalidColumns;
+    }
+    for (i = 0; i < (int) sizeof(header->magic); i++) {
+        header->magic[i] = i < (int) sizeof(SSC_COLUMNS_MAGIC) ? SSC_COLUMNS_MAGIC[i] : '\0';
+    }
+    header->version = SSC_COLUMNS_VERSION;
+    header->header_size = HEADER_SIZE;
+    header->row_count = row_count;
+    header->column_mask = column_mask;
+    header->alignment = SSC_COLUMNS_ALIGNMENT;
+    header->byte_order = 1.0;
+    layout(row_count, column_mask, header->offsets);
+    for (i = 0; i < SscColumn_Count; i++) {
+        header->widths[i] = COLUMN_WIDTHS[i];
+    }
+    set_view(columns, buffer);
+    return SscColumnsError_Success;
+}
+
+SscColumnsError ssc_columns_init(ssc_columns *columns, void *data, size_t size) {
+    const ssc_columns_header *header = (const ssc_columns_header *) data;
+    uint64_t offsets[SscColumn_Count];
+    size_t required;
+    int i;
+
+    if (size < HEADER_SIZE || (uintptr_t) data % sizeof(double) != 0) {
+        return SscColumnsError_InvalidFormat;
+    }
+    for (i = 0; i < (int) sizeof(SSC_COLUMNS_MAGIC); i++) {
+        if (header->magic[i] != SSC_COLUMNS_MAGIC[i]) {
+            return SscColumnsError_InvalidFormat;
+        }
+    }
+    if (header->version != SSC_COLUMNS_VERSION || header->byte_order != 1.0 || header->header_size != HEADER_SIZE ||
+        header->alignment != SSC_COLUMNS_ALIGNMENT || header->row_count > MAX_ROWS ||
+        header->column_mask >= SSC_COLUMN(SscColumn_Count)) {
+        return SscColumnsError_InvalidFormat;
+    }
+    // The layout is fully determined by the rows and columns, so any other offsets or widths are not this format
+    required = layout((size_t) header->row_count, header->column_mask, offsets);
+    if (required == 0 || size < required) {
+        return SscColumnsError_InvalidFormat;
+    }
+    for (i = 0; i < SscColumn_Count; i++) {
+        if (header->offsets[i] != offsets[i] || header->widths[i] != COLUMN_WIDTHS[i]) {
+            return SscColumnsError_InvalidFormat;
+        }
+    }
+    set_view(columns, data);
+    return SscColumnsError_Success;
+}
+
+SscColumnsError ssc_columns_batch_init(const ssc_columns *columns,
+                                       size_t first,
+                                       size_t count,
+                                       SunriseSunsetBatchInput *input,
+                                       SunriseSunsetBatchOutput *output) {
+    uint32_t mask = columns->header->column_mask;
+    if (first > columns->row_count || count > columns->row_count - first ||
+        (mask & SSC_COLUMNS_INPUT) != SSC_COLUMNS_INPUT ||
+        ((mask & SSC_COLUMNS_ATMOSPHERE) != 0 && (mask & SSC_COLUMNS_ATMOSPHERE) != SSC_COLUMNS_ATMOSPHERE) ||
+        (output != NULL && (mask & SSC_COLUMNS_RESULT) != SSC_COLUMNS_RESULT)) {
+        return SscColumnsError_InvalidColumns;
+    }
+    SunriseSunsetBatchInput_init(
+        input, count, columns->time + first, columns->latitude + first, columns->longitude + first);
+    if (columns->elevation != NULL) {
+        input->elevation = columns->elevation + first;
+        input->pressure = columns->pressure + first;
+        input->temperature = columns->temperature + first;
+    }
+    if (output != NULL) {
+        output->rise = columns->rise + first;
+        output->set = columns->set + first;
+        output->visible = columns->visible + first;
+        output->status = columns->status + first;
+        output->stats = NULL;
+    }
+    return SscColumnsError_Success;
+}
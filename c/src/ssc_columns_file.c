@@ -0,0 +1,149 @@
+//
+//  ssc_columns_file.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+#include "ssc_columns.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+/// Map a whole file, extending it to size first if size is not 0
+static SscColumnsError map(ssc_columns_file *file, const char *path, bool writable, size_t size) {
+    DWORD access = writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ;
+    DWORD creation = size != 0 ? CREATE_ALWAYS : OPEN_EXISTING;
+    LARGE_INTEGER file_size;
+    HANDLE handle, mapping;
+    void *view;
+
+    handle = CreateFileA(path, access, FILE_SHARE_READ, NULL, creation, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return SscColumnsError_Io;
+    }
+    file_size.QuadPart = (LONGLONG) size;
+    if (size == 0 && (!GetFileSizeEx(handle, &file_size) || file_size.QuadPart == 0)) {
+        CloseHandle(handle);
+        return SscColumnsError_InvalidFormat;
+    }
+    // Mapping a new file with a size extends it with zeros
+    mapping = CreateFileMappingA(handle,
+                                 NULL,
+                                 writable ? PAGE_READWRITE : PAGE_READONLY,
+                                 (DWORD) ((uint64_t) file_size.QuadPart >> 32),
+                                 (DWORD) file_size.QuadPart,
+                                 NULL);
+    CloseHandle(handle);
+    if (mapping == NULL) {
+        return SscColumnsError_Io;
+    }
+    view = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+    if (view == NULL) {
+        CloseHandle(mapping);
+        return SscColumnsError_Io;
+    }
+    file->mapping = view;
+    file->size = (size_t) file_size.QuadPart;
+    file->handle = mapping;
+    return SscColumnsError_Success;
+}
+
+void ssc_columns_unmap_file(ssc_columns_file *file) {
+    if (file->mapping != NULL) {
+        UnmapViewOfFile(file->mapping);
+        CloseHandle((HANDLE) file->handle);
+    }
+    file->mapping = NULL;
+    file->handle = NULL;
+    file->size = 0;
+}
+
+#else
+
+/// Map a whole file, extending it to size first if size is not 0
+static SscColumnsError map(ssc_columns_file *file, const char *path, bool writable, size_t size) {
+    struct stat status;
+    void *mapping;
+    int fd;
+
+    fd = size != 0 ? open(path, O_RDWR | O_CREAT | O_TRUNC, 0644) : open(path, writable ? O_RDWR : O_RDONLY);
+    if (fd < 0) {
+        return SscColumnsError_Io;
+    }
+    // Truncating to the size extends a new file with zeros
+    if (size != 0 && ftruncate(fd, (off_t) size) != 0) {
+        close(fd);
+        return SscColumnsError_Io;
+    }
+    if (size == 0) {
+        if (fstat(fd, &status) != 0) {
+            close(fd);
+            return SscColumnsError_Io;
+        }
+        if (status.st_size <= 0) {
+            close(fd);
+            return SscColumnsError_InvalidFormat;
+        }
+        size = (size_t) status.st_size;
+    }
+    mapping = mmap(NULL, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping keeps its own reference to the file
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return SscColumnsError_Io;
+    }
+    file->mapping = mapping;
+    file->size = size;
+    file->handle = NULL;
+    return SscColumnsError_Success;
+}
+
+void ssc_columns_unmap_file(ssc_columns_file *file) {
+    if (file->mapping != NULL) {
+        munmap(file->mapping, file->size);
+    }
+    file->mapping = NULL;
+    file->handle = NULL;
+    file->size = 0;
+}
+
+#endif
+
+SscColumnsError
+ssc_columns_create_file(ssc_columns_file *file, const char *path, size_t row_count, uint32_t column_mask) {
+    size_t size = ssc_columns_size(row_count, column_mask);
+    SscColumnsError result;
+
+    if (size == 0) {
+        return SscColumnsError_InvalidColumns;
+    }
+    result = map(file, path, true, size);
+    if (result != SscColumnsError_Success) {
+        return result;
+    }
+    result = ssc_columns_create(&file->columns, file->mapping, file->size, row_count, column_mask);
+    if (result != SscColumnsError_Success) {
+        ssc_columns_unmap_file(file);
+    }
+    return result;
+}
+
+SscColumnsError ssc_columns_map_file(ssc_columns_file *file, const char *path, bool writable) {
+    SscColumnsError result = map(file, path, writable, 0);
+    if (result != SscColumnsError_Success) {
+        return result;
+    }
+    result = ssc_columns_init(&file->columns, file->mapping, file->size);
+    if (result != SscColumnsError_Success) {
+        ssc_columns_unmap_file(file);
+    }
+    return result;
+}
@@ -0,0 +1,152 @@
+//
+//  ssc_daemon_client.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+#include "ssc_daemon.h"
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+/// Write all of a buffer, retrying after signals and partial writes
+static bool write_all(int socket, const void *data, size_t size) {
+    const char *p = (const char *) data;
+    while (size > 0) {
+        ssize_t written = send(socket, p, size, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        p += written;
+        size -= (size_t) written;
+    }
+    return true;
+}
+
+/// Read all of a buffer, retrying after signals and partial reads
+static bool read_all(int socket, void *data, size_t size) {
+    char *p = (char *) data;
+    while (size > 0) {
+        ssize_t read_size = recv(socket, p, size, 0);
+        if (read_size < 0 && errno == EINTR) {
+            continue;
+        }
+        if (read_size <= 0) {
+            return false;
+        }
+        p += read_size;
+        size -= (size_t) read_size;
+    }
+    return true;
+}
+
+/// Size of each record of a message [bytes]
+static size_t record_size(uint16_t type, bool response) {
+    if (type == SscDaemonMessage_Calculate) {
+        return response ? sizeof(ssc_daemon_result) : sizeof(ssc_daemon_query);
+    }
+    return type == SscDaemonMessage_Stats && response ? sizeof(ssc_daemon_stats) : 0;
+}
+
+SscDaemonError ssc_daemon_connect(ssc_daemon_client *client, const char *path) {
+    struct sockaddr_un address;
+    size_t length = strlen(path);
+
+    client->socket = -1;
+    if (length >= sizeof(address.sun_path)) {
+        return SscDaemonError_Io;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path, length + 1);
+    client->socket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (client->socket < 0) {
+        return SscDaemonError_Io;
+    }
+    if (connect(client->socket, (const struct sockaddr *) &address, sizeof(address)) != 0) {
+        ssc_daemon_disconnect(client);
+        return SscDaemonError_Io;
+    }
+    return SscDaemonError_Success;
+}
+
+void ssc_daemon_disconnect(ssc_daemon_client *client) {
+    if (client->socket >= 0) {
+        close(client->socket);
+    }
+    client->socket = -1;
+}
+
+SscDaemonError ssc_daemon_send(ssc_daemon_client *client, const ssc_daemon_header *header, const void *records) {
+    ssc_daemon_header sent = *header;
+    sent.magic = SSC_DAEMON_MAGIC;
+    if (!write_all(client->socket, &sent, sizeof(sent)) ||
+        !write_all(client->socket, records, (size_t) sent.count * record_size(sent.type, false))) {
+        return SscDaemonError_Io;
+    }
+    return SscDaemonError_Success;
+}
+
+SscDaemonError
+ssc_daemon_receive(ssc_daemon_client *client, ssc_daemon_header *header, void *records, size_t capacity) {
+    size_t size;
+    if (!read_all(client->socket, header, sizeof(*header))) {
+        return SscDaemonError_Io;
+    }
+    size = (size_t) header->count * record_size(header->type, true);
+    if (header->magic != SSC_DAEMON_MAGIC || size > capacity) {
+        return SscDaemonError_Protocol;
+    }
+    return read_all(client->socket, records, size) ? SscDaemonError_Success : SscDaemonError_Io;
+}
+
+SscDaemonError ssc_daemon_calculate(ssc_daemon_client *client,
+                                    SunriseSunsetSearch search,
+                                    SunriseSunsetEngine engine,
+                                    const ssc_daemon_query *queries,
+                                    uint32_t count,
+                                    ssc_daemon_result *results) {
+    ssc_daemon_header header;
+    SscDaemonError result;
+
+    header.type = SscDaemonMessage_Calculate;
+    header.search = (uint8_t) search;
+    header.engine = (uint8_t) engine;
+    header.id = 0;
+    header.count = count;
+    result = ssc_daemon_send(client, &header, queries);
+    if (result == SscDaemonError_Success) {
+        result = ssc_daemon_receive(client, &header, results, count * sizeof(ssc_daemon_result));
+    }
+    if (result == SscDaemonError_Success && (header.type != SscDaemonMessage_Calculate || header.count != count)) {
+        result = SscDaemonError_Protocol;
+    }
+    return result;
+}
+
+SscDaemonError ssc_daemon_stats_query(ssc_daemon_client *client, ssc_daemon_stats *stats) {
+    ssc_daemon_header header;
+    SscDaemonError result;
+
+    header.type = SscDaemonMessage_Stats;
+    header.search = 0;
+    header.engine = 0;
+    header.id = 0;
+    header.count = 0;
+    result = ssc_daemon_send(client, &header, NULL);
+    if (result == SscDaemonError_Success) {
+        result = ssc_daemon_receive(client, &header, stats, sizeof(*stats));
+    }
+    if (result == SscDaemonError_Success && (header.type != SscDaemonMessage_Stats || header.count != 1)) {
+        result = SscDaemonError_Protocol;
+    }
+    return result;
+}
@@ -0,0 +1,211 @@
+//
+//  ssc_grid.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+#include "ssc_grid.h"
+#include "spa_math.h"
+
+#define ENSURE_SPA_RESULT(res)                                                                                         \
+    if (res != SpaError_Success) {                                                                                     \
+        return res;                                                                                                    \
+    }
+
+void SunriseSunsetGrid_init(SunriseSunsetGrid *grid,
+                            double latitude,
+                            double longitude,
+                            double latitude_step,
+                            double longitude_step,
+                            size_t rows,
+                            size_t columns) {
+    SunriseSunsetParameters_init(&grid->params, 0, latitude, longitude);
+    grid->latitude = latitude;
+    grid->longitude = longitude;
+    grid->latitude_step = latitude_step;
+    grid->longitude_step = longitude_step;
+    grid->rows = rows;
+    grid->columns = columns;
+    grid->block_size = SSC_GRID_DEFAULT_BLOCK_SIZE;
+    grid->tolerance = SSC_GRID_DEFAULT_TOLERANCE;
+}
+
+typedef struct {
+    const SunriseSunsetGrid *grid;
+    const SunriseSunsetGridOutput *output;
+    unix_t day;
+} GridJob;
+
+/// Local mean solar noon of a cell
+static unix_t cell_noon(const GridJob *job, size_t column) {
+    double longitude = job->grid->longitude + job->grid->longitude_step * (double) column;
+    return job->day + 43200 - (unix_t) floor(longitude * 240.0 + 0.5);
+}
+
+/// Calculate a cell exactly, unless it already has been
+static SpaError calculate_cell(const GridJob *job, size_t row, size_t column) {
+    const SunriseSunsetGrid *grid = job->grid;
+    size_t index = row * grid->columns + column;
+    SunriseSunsetParameters params;
+    SunriseSunsetResult result;
+    SpaError spa_result;
+
+    if (job->output->exact[index]) {
+        return SpaError_Success;
+    }
+    params = grid->params;
+    params.time = cell_noon(job, column);
+    params.latitude = grid->latitude + grid->latitude_step * (double) row;
+    params.longitude = grid->longitude + grid->longitude_step * (double) column;
+    params.step_size = sunrise_sunset_default_step_size(params.latitude);
+    spa_result = sunrise_sunset_calculate(&params, &result);
+    ENSURE_SPA_RESULT(spa_result);
+    job->output->rise[index] = result.rise;
+    job->output->set[index] = result.set;
+    job->output->visible[index] = result.visible;
+    job->output->exact[index] = true;
+    return SpaError_Success;
+}
+
+/// Offsets of sunrise and sunset from local noon of a cell
+static void cell_offsets(const GridJob *job, size_t row, size_t column, double *rise, double *set) {
+    size_t index = row * job->grid->columns + column;
+    unix_t noon = cell_noon(job, column);
+    *rise = (double) (job->output->rise[index] - noon);
+    *set = (double) (job->output->set[index] - noon);
+}
+
+/// A block of the grid between two rows and two columns, inclusive
+typedef struct {
+    size_t row0, row1, column0, column1;
+    double rise[4]; ///< Offsets from local noon at the corners: (row0, column0), (row0, column1), (row1, column0) ...
+    double set[4];
+} GridBlock;
+
+static void block_corners(const GridJob *job, GridBlock *block) {
+    cell_offsets(job, block->row0, block->column0, &block->rise[0], &block->set[0]);
+    cell_offsets(job, block->row0, block->column1, &block->rise[1], &block->set[1]);
+    cell_offsets(job, block->row1, block->column0, &block->rise[2], &block->set[2]);
+    cell_offsets(job, block->row1, block->column1, &block->rise[3], &block->set[3]);
+}
+
+/// Bilinear interpolation between the corners of a block
+static double block_interpolate(const GridBlock *block, const double *corners, size_t row, size_t column) {
+    double u = block->row1 > block->row0 ? (double) (row - block->row0) / (double) (block->row1 - block->row0) : 0.0;
+    double v = block->column1 > block->column0
+                   ? (double) (column - block->column0) / (double) (block->column1 - block->column0)
+                   : 0.0;
+    return (1.0 - u) * ((1.0 - v) * corners[0] + v * corners[1]) + u * ((1.0 - v) * corners[2] + v * corners[3]);
+}
+
+/// Check an exactly calculated cell against the interpolation of the block
+static bool block_accepts(const GridJob *job, const GridBlock *block, size_t row, size_t column) {
+    const SunriseSunsetGridOutput *output = job->output;
+    size_t columns = job->grid->columns;
+    double rise, set;
+    if (output->visible[row * columns + column] != output->visible[block->row0 * columns + block->column0]) {
+        return false;
+    }
+    cell_offsets(job, row, column, &rise, &set);
+    // Outside of polar day and night both events are within a day of noon, beyond that they can be weeks away and
+    // change too quickly across the grid to interpolate
+    if (fabs(rise) >= 86400.0 || fabs(set) >= 86400.0) {
+        return false;
+    }
+    return fabs(block_interpolate(block, block->rise, row, column) - rise) <= job->grid->tolerance &&
+           fabs(block_interpolate(block, block->set, row, column) - set) <= job->grid->tolerance;
+}
+
+static SpaError calculate_block(const GridJob *job, size_t row0, size_t row1, size_t column0, size_t column1) {
+    const SunriseSunsetGrid *grid = job->grid;
+    const SunriseSunsetGridOutput *output = job->output;
+    size_t row_mid = (row0 + row1) / 2, column_mid = (column0 + column1) / 2;
+    size_t checks[5][2] = {{row0, column_mid}, {row1, column_mid}, {row_mid, column0}, {row_mid, column1},
+                           {row_mid, column_mid}};
+    GridBlock block = {row0, row1, column0, column1, {0}, {0}};
+    SpaError spa_result;
+    bool accepted;
+    size_t i, row, column;
+
+    for (i = 0; i < 5; i++) {
+        spa_result = calculate_cell(job, checks[i][0], checks[i][1]);
+        ENSURE_SPA_RESULT(spa_result);
+    }
+    // Cells of a block of at most 2x2 are all corners, so they have all been calculated
+    if (row1 - row0 <= 1 && column1 - column0 <= 1) {
+        return SpaError_Success;
+    }
+
+    block_corners(job, &block);
+    accepted = output->visible[row0 * grid->columns + column0] == output->visible[row0 * grid->columns + column1] &&
+               output->visible[row0 * grid->columns + column0] == output->visible[row1 * grid->columns + column0] &&
+               output->visible[row0 * grid->columns + column0] == output->visible[row1 * grid->columns + column1];
+    for (i = 0; i < 5 && accepted; i++) {
+        accepted = block_accepts(job, &block, checks[i][0], checks[i][1]);
+    }
+
+    if (!accepted) {
+        // Split in four, or in two along a side that is already a single cell wide
+        size_t row_splits = row1 - row0 > 1 ? 2 : 1, column_splits = column1 - column0 > 1 ? 2 : 1;
+        size_t r, c;
+        for (r = 0; r < row_splits; r++) {
+            for (c = 0; c < column_splits; c++) {
+                spa_result = calculate_block(job,
+                                             row_splits == 1 ? row0 : (r == 0 ? row0 : row_mid),
+                                             row_splits == 1 ? row1 : (r == 0 ? row_mid : row1),
+                                             column_splits == 1 ? column0 : (c == 0 ? column0 : column_mid),
+                                             column_splits == 1 ? column1 : (c == 0 ? column_mid : column1));
+                ENSURE_SPA_RESULT(spa_result);
+            }
+        }
+        return SpaError_Success;
+    }
+
+    for (row = row0; row <= row1; row++) {
+        for (column = column0; column <= column1; column++) {
+            size_t index = row * grid->columns + column;
+            unix_t noon;
+            if (output->exact[index]) {
+                continue;
+            }
+            noon = cell_noon(job, column);
+            output->rise[index] = noon + (unix_t) floor(block_interpolate(&block, block.rise, row, column) + 0.5);
+            output->set[index] = noon + (unix_t) floor(block_interpolate(&block, block.set, row, column) + 0.5);
+            output->visible[index] = output->visible[row0 * grid->columns + column0];
+        }
+    }
+    return SpaError_Success;
+}
+
+SpaError sunrise_sunset_grid_calculate(const SunriseSunsetGrid *grid,
+                                      unix_t day,
+                                      const SunriseSunsetGridOutput *output) {
+    GridJob job = {grid, output, day};
+    size_t block_size = grid->block_size > 0 ? grid->block_size : 1;
+    size_t i, row0, column0;
+    SpaError spa_result;
+
+    if (grid->rows == 0 || grid->columns == 0) {
+        return SpaError_Success;
+    }
+    for (i = 0; i < grid->rows * grid->columns; i++) {
+        output->exact[i] = false;
+    }
+    // The coarse lattice, blocks share their edges with their neighbours
+    for (row0 = 0; row0 + 1 < grid->rows || row0 == 0; row0 += block_size) {
+        size_t row1 = row0 + block_size < grid->rows ? row0 + block_size : grid->rows - 1;
+        for (column0 = 0; column0 + 1 < grid->columns || column0 == 0; column0 += block_size) {
+            size_t column1 = column0 + block_size < grid->columns ? column0 + block_size : grid->columns - 1;
+            spa_result = calculate_cell(&job, row0, column0);
+            ENSURE_SPA_RESULT(spa_result);
+            spa_result = calculate_cell(&job, row0, column1);
+            ENSURE_SPA_RESULT(spa_result);
+            spa_result = calculate_cell(&job, row1, column0);
+            ENSURE_SPA_RESULT(spa_result);
+            spa_result = calculate_cell(&job, row1, column1);
+            ENSURE_SPA_RESULT(spa_result);
+            spa_result = calculate_block(&job, row0, row1, column0, column1);
+            ENSURE_SPA_RESULT(spa_result);
+        }
+    }
+    return SpaError_Success;
+}
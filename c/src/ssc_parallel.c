@@ -0,0 +1,248 @@
+//
+//  ssc_parallel.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+#include "ssc_parallel.h"
+#include <stdlib.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+typedef CRITICAL_SECTION parallel_mutex;
+typedef HANDLE parallel_thread;
+#define parallel_mutex_init(mutex) InitializeCriticalSection(mutex)
+#define parallel_mutex_destroy(mutex) DeleteCriticalSection(mutex)
+#define parallel_mutex_lock(mutex) EnterCriticalSection(mutex)
+#define parallel_mutex_unlock(mutex) LeaveCriticalSection(mutex)
+#else
+#include <pthread.h>
+#include <unistd.h>
+typedef pthread_mutex_t parallel_mutex;
+typedef pthread_t parallel_thread;
+#define parallel_mutex_init(mutex) pthread_mutex_init(mutex, NULL)
+#define parallel_mutex_destroy(mutex) pthread_mutex_destroy(mutex)
+#define parallel_mutex_lock(mutex) pthread_mutex_lock(mutex)
+#define parallel_mutex_unlock(mutex) pthread_mutex_unlock(mutex)
+#endif
+
+size_t sunrise_sunset_parallel_processors(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (size_t) info.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (size_t) count : 1;
+#endif
+}
+
+void SunriseSunsetParallelJob_init(SunriseSunsetParallelJob *job,
+                                   size_t location_count,
+                                   const double *latitude,
+                                   const double *longitude,
+                                   unix_t start,
+                                   size_t day_count) {
+    SunriseSunsetParameters_init(&job->params, start, 0.0, 0.0);
+    job->location_count = location_count;
+    job->latitude = latitude;
+    job->longitude = longitude;
+    job->step_size = NULL;
+    job->day_count = day_count;
+    job->start = start;
+    job->interval = 86400;
+    job->threads = sunrise_sunset_parallel_processors();
+    job->chunk_size = SSC_PARALLEL_DEFAULT_CHUNK_SIZE;
+}
+
+/// The chunks a worker has left, taken from the front by the worker and from the back by thieves
+typedef struct {
+    parallel_mutex mutex;
+    size_t head; ///< Next chunk to take
+    size_t tail; ///< One past the last chunk
+} ParallelQueue;
+
+typedef struct {
+    const SunriseSunsetParallelJob *job;
+    const SunriseSunsetBatchOutput *output;
+    ParallelQueue *queues;
+    size_t index;
+    size_t worker_count;
+    size_t item_count;
+    SunriseSunsetAggregateStats stats; ///< Statistics of the items of this worker
+} ParallelWorker;
+
+static bool queue_pop(ParallelQueue *queue, size_t *chunk) {
+    bool taken;
+    parallel_mutex_lock(&queue->mutex);
+    taken = queue->head < queue->tail;
+    if (taken) {
+        *chunk = queue->head++;
+    }
+    parallel_mutex_unlock(&queue->mutex);
+    return taken;
+}
+
+/// Move the later half of the chunks of another worker to the queue of this worker
+static bool queue_steal(ParallelWorker *worker) {
+    size_t i, head = 0, tail = 0;
+    for (i = 1; i < worker->worker_count && head == tail; i++) {
+        ParallelQueue *victim = &worker->queues[(worker->index + i) % worker->worker_count];
+        parallel_mutex_lock(&victim->mutex);
+        if (victim->head < victim->tail) {
+            head = victim->tail - (victim->tail - victim->head + 1) / 2;
+            tail = victim->tail;
+            victim->tail = head;
+        }
+        parallel_mutex_unlock(&victim->mutex);
+    }
+    if (head == tail) {
+        return false;
+    }
+    parallel_mutex_lock(&worker->queues[worker->index].mutex);
+    worker->queues[worker->index].head = head;
+    worker->queues[worker->index].tail = tail;
+    parallel_mutex_unlock(&worker->queues[worker->index].mutex);
+    return true;
+}
+
+static void run_chunk(ParallelWorker *worker, size_t chunk) {
+    const SunriseSunsetParallelJob *job = worker->job;
+    const SunriseSunsetBatchOutput *output = worker->output;
+    SunriseSunsetParameters params = job->params;
+    SunriseSunsetResult result;
+    SunriseSunsetStats stats;
+    size_t i, end = (chunk + 1) * job->chunk_size;
+
+    for (i = chunk * job->chunk_size; i < end && i < worker->item_count; i++) {
+        size_t location = i / job->day_count, day = i % job->day_count;
+        params.time = job->start + (unix_t) day * job->interval;
+        params.latitude = job->latitude[location];
+        params.longitude = job->longitude[location];
+        params.step_size =
+            job->step_size ? job->step_size[location] : sunrise_sunset_default_step_size(job->latitude[location]);
+        output->status[i] = sunrise_sunset_calculate_stats(&params, &result, output->stats ? &stats : NULL);
+        output->set[i] = result.set;
+        output->rise[i] = result.rise;
+        output->visible[i] = result.visible;
+        if (output->stats != NULL && output->status[i] == SpaError_Success) {
+            sunrise_sunset_stats_add(&worker->stats, &stats);
+        }
+    }
+}
+
+static void run_worker(ParallelWorker *worker) {
+    size_t chunk;
+    do {
+        while (queue_pop(&worker->queues[worker->index], &chunk)) {
+            run_chunk(worker, chunk);
+        }
+    } while (queue_steal(worker));
+}
+
+#ifdef _WIN32
+static DWORD WINAPI worker_thread(LPVOID argument) {
+    run_worker((ParallelWorker *) argument);
+    return 0;
+}
+
+static bool thread_start(parallel_thread *thread, ParallelWorker *worker) {
+    *thread = CreateThread(NULL, 0, worker_thread, worker, 0, NULL);
+    return *thread != NULL;
+}
+
+static void thread_join(parallel_thread thread) {
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+#else
+static void *worker_thread(void *argument) {
+    run_worker((ParallelWorker *) argument);
+    return NULL;
+}
+
+static bool thread_start(parallel_thread *thread, ParallelWorker *worker) {
+    return pthread_create(thread, NULL, worker_thread, worker) == 0;
+}
+
+static void thread_join(parallel_thread thread) {
+    pthread_join(thread, NULL);
+}
+#endif
+
+SpaError sunrise_sunset_parallel_run(const SunriseSunsetParallelJob *job, const SunriseSunsetBatchOutput *output) {
+    size_t item_count = job->location_count * job->day_count;
+    size_t chunk_size = job->chunk_size > 0 ? job->chunk_size : 1;
+    size_t chunk_count = (item_count + chunk_size - 1) / chunk_size;
+    size_t worker_count = job->threads > 0 ? job->threads : 1;
+    SunriseSunsetParallelJob chunked = *job;
+    ParallelQueue *queues;
+    ParallelWorker *workers;
+    parallel_thread *threads;
+    bool *started;
+    size_t i;
+
+    if (item_count == 0) {
+        return SpaError_Success;
+    }
+    if (worker_count > chunk_count) {
+        worker_count = chunk_count;
+    }
+    chunked.chunk_size = chunk_size;
+
+    queues = (ParallelQueue *) malloc(worker_count * sizeof(ParallelQueue));
+    workers = (ParallelWorker *) malloc(worker_count * sizeof(ParallelWorker));
+    threads = (parallel_thread *) malloc(worker_count * sizeof(parallel_thread));
+    started = (bool *) malloc(worker_count * sizeof(bool));
+    if (queues == NULL || workers == NULL || threads == NULL || started == NULL) {
+        // Without memory for the workers run everything on the calling thread
+        ParallelWorker worker = {&chunked, output, NULL, 0, 1, item_count, {0, 0, 0, 0, 0, 0, 0}};
+        for (i = 0; i < chunk_count; i++) {
+            run_chunk(&worker, i);
+        }
+        if (output->stats != NULL) {
+            sunrise_sunset_stats_merge(output->stats, &worker.stats);
+        }
+    } else {
+        // An equal share of consecutive chunks for each worker
+        for (i = 0; i < worker_count; i++) {
+            parallel_mutex_init(&queues[i].mutex);
+            queues[i].head = chunk_count * i / worker_count;
+            queues[i].tail = chunk_count * (i + 1) / worker_count;
+            workers[i].job = &chunked;
+            workers[i].output = output;
+            workers[i].queues = queues;
+            workers[i].index = i;
+            workers[i].worker_count = worker_count;
+            workers[i].item_count = item_count;
+            SunriseSunsetAggregateStats_init(&workers[i].stats);
+        }
+        // The calling thread is worker 0, the share of a thread that fails to start is stolen by the others
+        for (i = 1; i < worker_count; i++) {
+            started[i] = thread_start(&threads[i], &workers[i]);
+        }
+        run_worker(&workers[0]);
+        for (i = 1; i < worker_count; i++) {
+            if (started[i]) {
+                thread_join(threads[i]);
+            }
+        }
+        for (i = 0; i < worker_count; i++) {
+            parallel_mutex_destroy(&queues[i].mutex);
+            if (output->stats != NULL) {
+                sunrise_sunset_stats_merge(output->stats, &workers[i].stats);
+            }
+        }
+    }
+    free(queues);
+    free(workers);
+    free(threads);
+    free(started);
+
+    for (i = 0; i < item_count; i++) {
+        if (output->status[i] != SpaError_Success) {
+            return output->status[i];
+        }
+    }
+    return SpaError_Success;
+}
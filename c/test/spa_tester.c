@@ -24,12 +24,18 @@
 //   1617 Cole Blvd, Golden, CO 80401      //
 /////////////////////////////////////////////
 
-#include <assert.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdbool.h>
 #include "spa.h"
 
+// Unlike assert() the checks also run in builds with NDEBUG
+#define CHECK(condition)                                                   \
+    if (!(condition)) {                                                    \
+        printf("Check failed on line %d: %s\n", __LINE__, #condition);     \
+        return 1;                                                          \
+    }
+
 static bool test_double(double expected, double actual) {
     double error = fabs(expected - actual) / expected;
     return error < 1.0e-5;
@@ -48,7 +54,7 @@ int main()
     spa.atmos_refract = 0.5667;
 
     int result = spa_calculate(&spa);
-    assert(result == SpaError_Success);
+    CHECK(result == SpaError_Success);
 
     printf("Julian Day:    %.6f\n",spa.jd);
     printf("L:             %.6e degrees\n",spa.l);
@@ -59,13 +65,75 @@ int main()
     printf("Delta Epsilon: %.6e degrees\n",spa.del_epsilon);
     printf("Epsilon:       %.6f degrees\n",spa.epsilon);
 
-    assert(test_double(2.401826e+01, spa.l));
-    assert(test_double(-1.011219e-04, spa.b));
-    assert(test_double(0.996542, spa.r));
-    assert(test_double(11.105902, spa.h));
-    assert(test_double(-3.998404e-03, spa.del_psi));
-    assert(test_double(1.666568e-03, spa.del_epsilon));
-    assert(test_double(23.440465, spa.epsilon));
+    CHECK(test_double(2.401826e+01, spa.l));
+    CHECK(test_double(-1.011219e-04, spa.b));
+    CHECK(test_double(0.996542, spa.r));
+    CHECK(test_double(11.105902, spa.h));
+    CHECK(test_double(-3.998404e-03, spa.del_psi));
+    CHECK(test_double(1.666568e-03, spa.del_epsilon));
+    CHECK(test_double(23.440465, spa.epsilon));
+
+    // The split ephemeris/observer evaluation must agree with spa_calculate
+    spa_ephemeris ephemeris;
+    spa_observer observer;
+    result = spa_calculate_ephemeris(&ephemeris, spa.jd, spa.delta_t);
+    CHECK(result == SpaError_Success);
+    result = spa_observer_init(&observer, spa.latitude, spa.longitude, spa.elevation,
+                               spa.pressure, spa.temperature, spa.atmos_refract);
+    CHECK(result == SpaError_Success);
+
+    printf("E:             %.6f degrees\n",spa.e);
+
+    CHECK(ephemeris.alpha == spa.alpha);
+    CHECK(ephemeris.delta == spa.delta);
+    CHECK(spa_calculate_elevation(&ephemeris, &observer) == spa.e);
+
+    // The lean evaluation must agree too, and store the intermediates that are asked for
+    spa_lean_outputs lean;
+    CHECK(spa_validate_time(spa.jd, spa.delta_t) == SpaError_Success);
+    CHECK(spa_calculate_elevation_lean(&observer, spa.jd, spa.delta_t, NULL, SpaOutput_Elevation, NULL) == spa.e);
+    CHECK(spa_calculate_elevation_lean(&observer, spa.jd, spa.delta_t, NULL,
+                                       SpaOutput_Geocentric | SpaOutput_Nutation | SpaOutput_Topocentric,
+                                       &lean) == spa.e);
+    CHECK(lean.e == spa.e);
+    CHECK(lean.nu == spa.nu && lean.alpha == spa.alpha && lean.delta == spa.delta && lean.xi == spa.xi);
+    CHECK(lean.del_psi == spa.del_psi && lean.del_epsilon == spa.del_epsilon && lean.epsilon == spa.epsilon);
+    CHECK(lean.h == spa.h && lean.del_alpha == spa.del_alpha && lean.delta_prime == spa.delta_prime);
+    CHECK(lean.h_prime == spa.h_prime && lean.e0 == spa.e0);
+
+    // Truncated and interpolated nutation stay within their documented error bounds
+    spa_ephemeris approximate;
+    spa_nutation nutation;
+    spa_nutation_init(&nutation, SpaNutation_Truncated, 0);
+    result = spa_calculate_ephemeris_nutation(&approximate, spa.jd, spa.delta_t, &nutation);
+    CHECK(result == SpaError_Success);
+    CHECK(fabs(approximate.alpha - ephemeris.alpha) < 0.1/3600);
+    CHECK(fabs(approximate.delta - ephemeris.delta) < 0.1/3600);
+
+    spa_nutation_init(&nutation, SpaNutation_Full, 0.25);
+    for (int i = -8; i <= 8; i++) {
+        result = spa_calculate_ephemeris_nutation(&approximate, spa.jd + i/16.0, spa.delta_t, &nutation);
+        CHECK(result == SpaError_Success);
+        result = spa_calculate_ephemeris(&ephemeris, spa.jd + i/16.0, spa.delta_t);
+        CHECK(result == SpaError_Success);
+        CHECK(fabs(approximate.alpha - ephemeris.alpha) < 0.001/3600);
+        CHECK(fabs(approximate.delta - ephemeris.delta) < 0.001/3600);
+    }
+
+    spa_nutation_init(&nutation, SpaNutation_Truncated, 0.25);
+    spa_nutation lean_nutation = nutation;
+    for (int i = -8; i <= 8; i++) {
+        result = spa_calculate_ephemeris_nutation(&approximate, spa.jd + i/16.0, spa.delta_t, &nutation);
+        CHECK(result == SpaError_Success);
+        CHECK(spa_calculate_elevation_lean(&observer, spa.jd + i/16.0, spa.delta_t, &lean_nutation,
+                                           SpaOutput_Elevation, NULL) == spa_calculate_elevation(&approximate,
+                                                                                                 &observer));
+    }
+
+    CHECK(spa_calculate_ephemeris(&ephemeris, 0, spa.delta_t) == SpaError_UnsupportedDate);
+    CHECK(spa_validate_time(0, spa.delta_t) == SpaError_UnsupportedDate);
+    CHECK(spa_validate_time(spa.jd, 9000) == SpaError_InvalidDeltaT);
+    CHECK(spa_observer_init(&observer, 91, 0, 0, 1013.25, 16, 0.5667) == SpaError_InvalidLatitude);
 
     return 0;
 }
@@ -81,5 +149,6 @@ int main()
 //Delta Psi:     -3.998404e-03 degrees
 //Delta Epsilon: 1.666568e-03 degrees
 //Epsilon:       23.440465 degrees
+//E:             39.888393 degrees
 //
 /////////////////////////////////////////////
@@ -0,0 +1,137 @@
+//
+//  test_spa_chebyshev.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+#include "spa_chebyshev.h"
+#include "ssc.h"
+#include "util.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <tinytest.h>
+
+#define TABLE_PATH "test_spa_chebyshev.bin"
+#define JDE_START 2458849.5 // 2020-01-01
+#define JDE_END 2459580.5   // 2022-01-01
+
+// Compare table lookups against the full SPA at random times in the table
+static void test_accuracy() {
+    spa_chebyshev_file file;
+    spa_ephemeris expected, actual;
+    double max_alpha = 0, max_delta = 0, max_nu = 0, max_xi = 0;
+    int i;
+
+    ASSERT_EQUALS(SpaChebyshevError_Success,
+                  spa_chebyshev_write_file(TABLE_PATH,
+                                           JDE_START,
+                                           JDE_END,
+                                           SPA_CHEBYSHEV_DEFAULT_SEGMENT_DAYS,
+                                           SPA_CHEBYSHEV_DEFAULT_COEFFICIENTS));
+    ASSERT_EQUALS(SpaChebyshevError_Success, spa_chebyshev_map_file(&file, TABLE_PATH));
+
+    srand(5);
+    for (i = 0; i < 5000; i++) {
+        double jd = JDE_START + 1.0 + (JDE_END - JDE_START - 2.0) * rand() / (double) RAND_MAX;
+        double delta_t = 69.0;
+        ASSERT_EQUALS(SpaError_Success, spa_calculate_ephemeris(&expected, jd, delta_t));
+        ASSERT_EQUALS(SpaError_Success, spa_chebyshev_calculate_ephemeris(&file.table, &actual, jd, delta_t));
+        max_alpha = fmax(max_alpha, fabs(remainder(expected.alpha - actual.alpha, 360.0)));
+        max_delta = fmax(max_delta, fabs(expected.delta - actual.delta));
+        max_nu = fmax(max_nu, fabs(remainder(expected.nu - actual.nu, 360.0)));
+        max_xi = fmax(max_xi, fabs(expected.xi - actual.xi));
+    }
+    printf("Max error (arc seconds): alpha %.3g, delta %.3g, nu %.3g, xi %.3g\n",
+           max_alpha * 3600,
+           max_delta * 3600,
+           max_nu * 3600,
+           max_xi * 3600);
+    // Well below 0.001 arc seconds, which is less than a millisecond of solar motion
+    ASSERT("Alpha accurate", max_alpha * 3600 < 1e-3);
+    ASSERT("Delta accurate", max_delta * 3600 < 1e-3);
+    ASSERT("Nu accurate", max_nu * 3600 < 1e-3);
+    ASSERT("Xi accurate", max_xi * 3600 < 1e-6);
+
+    // Outside of the table
+    ASSERT_EQUALS(SpaError_UnsupportedDate,
+                  spa_chebyshev_calculate_ephemeris(&file.table, &actual, JDE_START - 1.0, 0));
+    ASSERT_EQUALS(SpaError_UnsupportedDate,
+                  spa_chebyshev_calculate_ephemeris(&file.table, &actual, file.table.jde_end + 1.0, 0));
+    ASSERT_EQUALS(SpaError_InvalidDeltaT, spa_chebyshev_calculate_ephemeris(&file.table, &actual, JDE_START, 9000));
+
+    spa_chebyshev_unmap_file(&file);
+    remove(TABLE_PATH);
+}
+
+// Sunrise and sunset from a table should match the full SPA, and fall back to it outside of the table
+static void test_sunrise_sunset() {
+    spa_chebyshev_file file;
+    SunriseSunsetParameters params;
+    SunriseSunsetResult expected, actual;
+    time_t times[] = {
+        time_t_for_time(2020, 3, 20, 12, 0),
+        time_t_for_time(2021, 6, 21, 3, 0),
+        time_t_for_time(2021, 12, 21, 20, 0),
+        time_t_for_time(2030, 1, 1, 0, 0), // Outside of the table
+    };
+    double latitudes[] = {BRISTOL_LAT, -34.9285, 0.0, 64.0, -60.0};
+    size_t i, j;
+
+    ASSERT_EQUALS(SpaChebyshevError_Success,
+                  spa_chebyshev_write_file(TABLE_PATH,
+                                           JDE_START,
+                                           JDE_END,
+                                           SPA_CHEBYSHEV_DEFAULT_SEGMENT_DAYS,
+                                           SPA_CHEBYSHEV_DEFAULT_COEFFICIENTS));
+    ASSERT_EQUALS(SpaChebyshevError_Success, spa_chebyshev_map_file(&file, TABLE_PATH));
+
+    for (i = 0; i < sizeof(times) / sizeof(times[0]); i++) {
+        for (j = 0; j < sizeof(latitudes) / sizeof(latitudes[0]); j++) {
+            SunriseSunsetParameters_init(&params, times[i], latitudes[j], BRISTOL_LON);
+            ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &expected));
+            params.ephemeris_table = &file.table;
+            ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &actual));
+            ASSERT("Sunrise matches", llabs(expected.rise - actual.rise) <= 1);
+            ASSERT("Sunset matches", llabs(expected.set - actual.set) <= 1);
+            ASSERT_EQUALS(expected.visible, actual.visible);
+        }
+    }
+
+    spa_chebyshev_unmap_file(&file);
+    remove(TABLE_PATH);
+}
+
+static void test_invalid() {
+    spa_chebyshev table;
+    spa_chebyshev_file file;
+    double buffer[64];
+    size_t size = spa_chebyshev_size(JDE_START, JDE_START + 16, 8, 4);
+    FILE *f;
+
+    ASSERT_EQUALS(0, spa_chebyshev_size(JDE_START, JDE_START, 8, 12));
+    ASSERT_EQUALS(0, spa_chebyshev_size(JDE_START, JDE_END, 0, 12));
+    ASSERT_EQUALS(0, spa_chebyshev_size(JDE_START, JDE_END, 8, SPA_CHEBYSHEV_MAX_COEFFICIENTS + 1));
+    ASSERT("Fits in buffer", size <= sizeof(buffer));
+    ASSERT_EQUALS(SpaChebyshevError_InvalidRange,
+                  spa_chebyshev_generate(buffer, size - 1, JDE_START, JDE_START + 16, 8, 4));
+    ASSERT_EQUALS(SpaChebyshevError_Success, spa_chebyshev_generate(buffer, size, JDE_START, JDE_START + 16, 8, 4));
+    ASSERT_EQUALS(SpaChebyshevError_Success, spa_chebyshev_init(&table, buffer, size));
+    ASSERT_EQUALS(SpaChebyshevError_InvalidFormat, spa_chebyshev_init(&table, buffer, size - 1));
+    ((spa_chebyshev_header *) buffer)->version = SPA_CHEBYSHEV_VERSION + 1;
+    ASSERT_EQUALS(SpaChebyshevError_InvalidFormat, spa_chebyshev_init(&table, buffer, size));
+
+    ASSERT_EQUALS(SpaChebyshevError_Io, spa_chebyshev_map_file(&file, "does/not/exist.bin"));
+    f = fopen(TABLE_PATH, "wb");
+    ASSERT("Opened file", f != NULL);
+    fputs("not a table", f);
+    fclose(f);
+    ASSERT_EQUALS(SpaChebyshevError_InvalidFormat, spa_chebyshev_map_file(&file, TABLE_PATH));
+    remove(TABLE_PATH);
+}
+
+int main() {
+    RUN(test_accuracy);
+    RUN(test_sunrise_sunset);
+    RUN(test_invalid);
+    return TEST_REPORT();
+}
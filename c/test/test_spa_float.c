@@ -0,0 +1,153 @@
+//
+//  test_spa_float.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+#include "spa_float.h"
+#include "ssc.h"
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include <tinytest.h>
+
+#define UNIX_J2000 946728000 // 2000-01-01 12:00
+#define SECONDS_PER_YEAR 31557600
+
+// Largest geocentric position error against the SPA in the years [first, last]
+static void ephemeris_error(int first, int last, int year_step, double *max_alpha, double *max_delta) {
+    spa_ephemeris expected, widened;
+    spa_float_ephemeris actual;
+    int year, day;
+
+    *max_alpha = 0;
+    *max_delta = 0;
+    for (year = first; year <= last; year += year_step) {
+        for (day = 0; day < 365; day += 3) {
+            // The range starts at the first day of -2000 and ends at the last day of 6000
+            double jd = 990576.0 + (year + 2000) * 365.25 + day + 0.37 - (year == 6000 ? 366 : 0);
+            ASSERT_EQUALS(SpaError_Success, spa_calculate_ephemeris(&expected, jd, 67.0));
+            ASSERT_EQUALS(SpaError_Success, spa_float_calculate_ephemeris(&actual, jd, 67.0));
+            spa_float_ephemeris_widen(&widened, &actual, jd, 67.0);
+            *max_alpha = fmax(*max_alpha, fabs(remainder(expected.alpha - widened.alpha, 360.0)));
+            *max_alpha = fmax(*max_alpha, fabs(remainder(expected.nu - widened.nu, 360.0)));
+            *max_delta = fmax(*max_delta, fabs(expected.delta - widened.delta));
+        }
+    }
+}
+
+// Geocentric position error against the SPA, around the present and over the whole supported date range
+static void test_ephemeris_error() {
+    spa_float_ephemeris actual;
+    double alpha, delta;
+
+    ephemeris_error(1900, 2100, 5, &alpha, &delta);
+    printf("1900 to 2100:  alpha/nu %.6f, delta %.6f [degrees]\n", alpha, delta);
+    ASSERT("Alpha within 0.0003 degrees", alpha < 0.0003);
+    ASSERT("Delta within 0.0003 degrees", delta < 0.0003);
+
+    ephemeris_error(-2000, 6000, 250, &alpha, &delta);
+    printf("-2000 to 6000: alpha/nu %.6f, delta %.6f [degrees]\n", alpha, delta);
+    ASSERT("Alpha within 0.008 degrees", alpha < 0.008);
+    ASSERT("Delta within 0.003 degrees", delta < 0.003);
+
+    ASSERT_EQUALS(SpaError_UnsupportedDate, spa_float_calculate_ephemeris(&actual, 990575.0, 0));
+    ASSERT_EQUALS(SpaError_UnsupportedDate, spa_float_calculate_ephemeris(&actual, 3912881.0, 0));
+    ASSERT_EQUALS(SpaError_InvalidDeltaT, spa_float_calculate_ephemeris(&actual, 2451545.0, 9000));
+}
+
+// The float observer stage against the double one, from the same ephemeris
+static void test_elevation_error() {
+    spa_ephemeris expected_ephemeris;
+    spa_float_ephemeris ephemerides[64];
+    spa_observer expected_observer;
+    spa_float_observer observers[64];
+    float elevations[64];
+    double max_error = 0;
+    int i;
+
+    for (i = 0; i < 64; i++) {
+        double jd = 2459000.5 + i * 5.37;
+        ASSERT_EQUALS(SpaError_Success, spa_float_calculate_ephemeris(&ephemerides[i], jd, 67.0));
+        spa_float_ephemeris_widen(&expected_ephemeris, &ephemerides[i], jd, 67.0);
+        ASSERT_EQUALS(
+            SpaError_Success,
+            spa_observer_init(&expected_observer, 2.8 * i - 89.0, 5.6 * i - 179.0, 30.0 * i, 1013, 10, 0.5667));
+        spa_float_observer_init(&observers[i], &expected_observer);
+        max_error = fmax(max_error,
+                         fabs(spa_calculate_elevation(&expected_ephemeris, &expected_observer) -
+                              spa_float_calculate_elevation(&ephemerides[i], &observers[i])));
+    }
+    spa_float_calculate_elevations(64, ephemerides, observers, elevations);
+    for (i = 0; i < 64; i++) {
+        ASSERT_EQUALS(spa_float_calculate_elevation(&ephemerides[i], &observers[i]), elevations[i]);
+    }
+    printf("Max elevation error %.7f [degrees]\n", max_error);
+    ASSERT("Elevation within 0.0001 degrees", max_error < 0.0001);
+}
+
+// Sunrise and sunset error against the SPA for latitude bands over a range of years
+static int64_t sunrise_sunset_error(double latitude, int first, int last, int year_step) {
+    SunriseSunsetParameters params;
+    SunriseSunsetResult expected, actual;
+    int64_t max_error = 0;
+    int year, k;
+
+    for (year = first; year <= last; year += year_step) {
+        for (k = 0; k < 12; k++) {
+            unix_t time = UNIX_J2000 + (int64_t) (year - 2000) * SECONDS_PER_YEAR + k * 30 * 86400 + 3600 * k;
+            SunriseSunsetParameters_init(&params, time, latitude, 30.0 * k - 165.0);
+            params.search = SunriseSunsetSearch_Predictor;
+            sunrise_sunset_calculate(&params, &expected);
+            params.engine = SunriseSunsetEngine_SpaFloat;
+            sunrise_sunset_calculate(&params, &actual);
+            if (expected.visible != actual.visible) {
+                return INT64_MAX;
+            }
+            max_error = llabs(expected.rise - actual.rise) > max_error ? llabs(expected.rise - actual.rise) : max_error;
+            max_error = llabs(expected.set - actual.set) > max_error ? llabs(expected.set - actual.set) : max_error;
+        }
+    }
+    return max_error;
+}
+
+static void test_sunrise_sunset_error() {
+    double latitudes[] = {-60.0, -45.0, -30.0, -15.0, 0.0, 15.0, 30.0, 45.0, 60.0, 66.0};
+    size_t i;
+
+    printf("Latitude  Max sunrise/sunset error 1900 to 2100, -2000 to 6000 [seconds]\n");
+    for (i = 0; i < sizeof(latitudes) / sizeof(latitudes[0]); i++) {
+        int64_t present = sunrise_sunset_error(latitudes[i], 1900, 2100, 20);
+        int64_t range = sunrise_sunset_error(latitudes[i], -1999, 5999, 1000);
+        printf("%8.1f  %lld, %lld\n", latitudes[i], (long long) present, (long long) range);
+        ASSERT("Within 2 seconds between 1900 and 2100", present <= 2);
+        ASSERT("Within 5 seconds over the whole range", range <= 5);
+    }
+}
+
+static void test_throughput() {
+    spa_ephemeris expected;
+    spa_float_ephemeris actual;
+    clock_t start;
+    double spa, spa_float;
+    int i;
+
+    start = clock();
+    for (i = 0; i < 2000; i++) {
+        spa_calculate_ephemeris(&expected, 2459000.5 + i * 0.01, 67.0);
+    }
+    spa = (double) (clock() - start) / CLOCKS_PER_SEC / 2000;
+    start = clock();
+    for (i = 0; i < 2000; i++) {
+        spa_float_calculate_ephemeris(&actual, 2459000.5 + i * 0.01, 67.0);
+    }
+    spa_float = (double) (clock() - start) / CLOCKS_PER_SEC / 2000;
+    printf("SPA: %.2f us/ephemeris, float: %.2f us/ephemeris\n", spa * 1e6, spa_float * 1e6);
+}
+
+int main() {
+    RUN(test_ephemeris_error);
+    RUN(test_elevation_error);
+    RUN(test_sunrise_sunset_error);
+    RUN(test_throughput);
+    return TEST_REPORT();
+}
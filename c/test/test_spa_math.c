@@ -0,0 +1,143 @@
+//
+//  test_spa_math.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+//  Built with SPA_MATH_SELECTABLE, so that the whole library can be switched between libm and the internal math.
+//
+#include "ssc.h"
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include <tinytest.h>
+#define SPA_MATH_NO_REDIRECT
+#include "spa_math.h"
+
+#define UNIX_J2000 946728000 // 2000-01-01 12:00
+#define SECONDS_PER_YEAR 31557600
+
+static double max_error_1(double (*actual)(double), double (*expected)(double), double low, double high, int count) {
+    double max_error = 0;
+    int i;
+    for (i = 0; i <= count; i++) {
+        double x = low + (high - low) * i / count;
+        max_error = fmax(max_error, fabs(actual(x) - expected(x)));
+    }
+    return max_error;
+}
+
+static double max_error_1f(float (*actual)(float), float (*expected)(float), double low, double high, int count) {
+    double max_error = 0;
+    int i;
+    for (i = 0; i <= count; i++) {
+        float x = (float) (low + (high - low) * i / count);
+        max_error = fmax(max_error, fabs((double) actual(x) - (double) expected(x)));
+    }
+    return max_error;
+}
+
+// Each function against libm, over the range of arguments the SPA uses
+static void test_functions() {
+    double atan2_error = 0, atan2f_error = 0;
+    int i, j;
+
+    // Periodic terms are evaluated up to about 3e5 radians
+    ASSERT("sin", max_error_1(spa_math_sin, sin, -3e5, 3e5, 1000003) < 1e-15);
+    ASSERT("cos", max_error_1(spa_math_cos, cos, -3e5, 3e5, 1000003) < 1e-15);
+    ASSERT("tan", max_error_1(spa_math_tan, tan, -1.5, 1.5, 100003) < 1e-13);
+    ASSERT("atan", max_error_1(spa_math_atan, atan, -100.0, 100.0, 100003) < 1e-15);
+    ASSERT("asin", max_error_1(spa_math_asin, asin, -1.0, 1.0, 100000) < 1e-15);
+    ASSERT("acos", max_error_1(spa_math_acos, acos, -1.0, 1.0, 100000) < 1e-15);
+    for (i = -50; i <= 50; i++) {
+        for (j = -50; j <= 50; j++) {
+            atan2_error = fmax(atan2_error, fabs(spa_math_atan2(i * 0.37, j * 0.41) - atan2(i * 0.37, j * 0.41)));
+            atan2f_error = fmax(atan2f_error,
+                                fabs((double) spa_math_atan2f(i * 0.37f, j * 0.41f) - atan2f(i * 0.37f, j * 0.41f)));
+        }
+    }
+    ASSERT("atan2", atan2_error < 1e-15);
+    ASSERT("atan2f", atan2f_error < 1e-6);
+
+    // Float arguments up to 1e3 radians, past that float has lost the precision of the argument anyway
+    ASSERT("sinf", max_error_1f(spa_math_sinf, sinf, -1e3, 1e3, 100003) < 1e-6);
+    ASSERT("cosf", max_error_1f(spa_math_cosf, cosf, -1e3, 1e3, 100003) < 1e-6);
+    ASSERT("tanf", max_error_1f(spa_math_tanf, tanf, -1.5, 1.5, 100003) < 1e-5);
+    ASSERT("asinf", max_error_1f(spa_math_asinf, asinf, -1.0, 1.0, 100000) < 1e-6);
+
+    ASSERT_EQUALS(-3.0, spa_math_floor(-2.5));
+    ASSERT_EQUALS(2.0, spa_math_floor(2.5));
+    ASSERT_EQUALS(-2.0, spa_math_floor(-2.0));
+    ASSERT_EQUALS(1e300, spa_math_floor(1e300));
+    ASSERT_EQUALS(3.0, spa_math_ceil(2.5));
+    ASSERT_EQUALS(-2.0f, spa_math_floorf(-1.5f));
+    ASSERT_EQUALS(fmod(-725.0, 360.0), spa_math_fmod(-725.0, 360.0));
+    ASSERT_EQUALS(fmod(725.0, 360.0), spa_math_fmod(725.0, 360.0));
+    ASSERT_EQUALS(pow(0.021, 5), spa_math_pow(0.021, 5));
+    ASSERT_EQUALS(1.0, spa_math_pow(0.021, 0));
+    ASSERT_EQUALS(2.5, spa_math_fabs(-2.5));
+}
+
+// Sunrise and sunset from the library built on the internal math, against the same library on libm
+static void test_sunrise_sunset() {
+    double latitudes[] = {-65.0, -60.0, -45.0, -30.0, -15.0, 0.0, 15.0, 30.0, 45.0, 60.0, 65.0, 78.2};
+    SunriseSunsetEngine engines[] = {SunriseSunsetEngine_Spa, SunriseSunsetEngine_SpaFloat, SunriseSunsetEngine_Noaa};
+    SunriseSunsetParameters params;
+    SunriseSunsetResult expected, actual;
+    int64_t max_error = 0;
+    int compared = 0, identical = 0;
+    size_t i, engine;
+    int k;
+
+    for (engine = 0; engine < sizeof(engines) / sizeof(engines[0]); engine++) {
+        for (i = 0; i < sizeof(latitudes) / sizeof(latitudes[0]); i++) {
+            for (k = 0; k < 24; k++) {
+                unix_t time = UNIX_J2000 + (int64_t) (k - 12) * SECONDS_PER_YEAR / 3 + 3600 * k;
+                SunriseSunsetParameters_init(&params, time, latitudes[i], 15.0 * k - 172.0);
+                params.engine = engines[engine];
+                params.search = k % 2 ? SunriseSunsetSearch_Predictor : SunriseSunsetSearch_Step;
+                spa_math_use_libm(true);
+                ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &expected));
+                spa_math_use_libm(false);
+                ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &actual));
+                ASSERT_EQUALS(expected.visible, actual.visible);
+                max_error = llabs(expected.rise - actual.rise) > max_error ? llabs(expected.rise - actual.rise)
+                                                                           : max_error;
+                max_error = llabs(expected.set - actual.set) > max_error ? llabs(expected.set - actual.set)
+                                                                         : max_error;
+                compared++;
+                identical += expected.rise == actual.rise && expected.set == actual.set;
+            }
+        }
+    }
+    printf("Identical: %d of %d, max error %llds\n", identical, compared, (long long) max_error);
+    // A second boundary can fall between the two, but nothing more
+    ASSERT("Within a second", max_error <= 1);
+    ASSERT("Almost all identical", identical >= compared * 99 / 100);
+}
+
+static double seconds_per_call(bool libm, int count) {
+    SunriseSunsetParameters params;
+    SunriseSunsetResult result;
+    clock_t start = clock();
+    int i;
+    spa_math_use_libm(libm);
+    for (i = 0; i < count; i++) {
+        SunriseSunsetParameters_init(&params, UNIX_J2000 + (unix_t) i * 97 * 3600, -55.0 + i % 110, i % 360 - 180.0);
+        sunrise_sunset_calculate(&params, &result);
+    }
+    spa_math_use_libm(false);
+    return (double) (clock() - start) / CLOCKS_PER_SEC / count;
+}
+
+static void test_throughput() {
+    double libm = seconds_per_call(true, 300);
+    double internal = seconds_per_call(false, 300);
+    printf("libm: %.1f us/call, internal: %.1f us/call\n", libm * 1e6, internal * 1e6);
+}
+
+int main() {
+    RUN(test_functions);
+    RUN(test_sunrise_sunset);
+    RUN(test_throughput);
+    return TEST_REPORT();
+}
@@ -0,0 +1,119 @@
+//
+//  test_spa_simd.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+#include "spa.h"
+#include "spa_simd.h"
+#include <math.h>
+#include <stdio.h>
+#include <tinytest.h>
+
+// Bounds on the difference from the scalar libm path, 1e-8 degrees is under a microsecond of solar motion
+#define MAX_L_ERROR 1.0e-8 // degrees
+#define MAX_B_ERROR 1.0e-9 // degrees
+#define MAX_R_ERROR 1.0e-12 // AU
+#define MAX_E_ERROR 1.0e-8 // degrees
+// The observer stage kernels against spa_calculate_elevation(), from the same ephemeris
+#define MAX_OBSERVER_ERROR 1.0e-10 // degrees
+#define OBSERVERS 37
+
+#define JD_MIN 990575.5  // -2000-01-01
+#define JD_MAX 3912880.0 // 6000-12-31
+#define SAMPLES 5000
+
+static const char *level_names[] = {"scalar", "sse2", "avx2", "avx512"};
+
+static void init_spa(spa_data *spa, double jd) {
+    spa->jd = jd;
+    spa->delta_t = 67;
+    spa->longitude = -105.1786;
+    spa->latitude = 39.742476;
+    spa->elevation = 1830.14;
+    spa->pressure = 820;
+    spa->temperature = 11;
+    spa->atmos_refract = 0.5667;
+}
+
+// Every kernel supported by this CPU must agree with the scalar summation across the whole date range
+static void test_kernels_match_scalar() {
+    SpaSimdLevel detected = spa_simd_detect();
+    spa_data scalar, vector;
+    int level, i;
+
+    for (level = SpaSimd_Scalar + 1; level <= (int) detected; level++) {
+        double max_l = 0, max_b = 0, max_r = 0, max_e = 0;
+        for (i = 0; i < SAMPLES; i++) {
+            double jd = JD_MIN + (JD_MAX - JD_MIN) * i / (SAMPLES - 1);
+            init_spa(&scalar, jd);
+            init_spa(&vector, jd);
+            ASSERT("Set scalar", spa_simd_set_level(SpaSimd_Scalar));
+            ASSERT_EQUALS(SpaError_Success, spa_calculate(&scalar));
+            ASSERT("Set level", spa_simd_set_level((SpaSimdLevel) level));
+            ASSERT_EQUALS(SpaError_Success, spa_calculate(&vector));
+            // Longitude wraps at 360 degrees
+            max_l = fmax(max_l, fabs(remainder(scalar.l - vector.l, 360.0)));
+            max_b = fmax(max_b, fabs(scalar.b - vector.b));
+            max_r = fmax(max_r, fabs(scalar.r - vector.r));
+            max_e = fmax(max_e, fabs(scalar.e - vector.e));
+        }
+        printf("%s: max |dL| %.3e, |dB| %.3e, |dR| %.3e, |dE| %.3e\n",
+               level_names[level],
+               max_l,
+               max_b,
+               max_r,
+               max_e);
+        ASSERT("L within bound", max_l < MAX_L_ERROR);
+        ASSERT("B within bound", max_b < MAX_B_ERROR);
+        ASSERT("R within bound", max_r < MAX_R_ERROR);
+        ASSERT("E within bound", max_e < MAX_E_ERROR);
+    }
+    spa_simd_set_level(detected);
+}
+
+// The observer stage kernels agree with the scalar elevation at any latitude and time, for any count
+static void test_elevation_kernels() {
+    SpaSimdLevel detected = spa_simd_detect();
+    spa_ephemeris ephemerides[OBSERVERS];
+    spa_observer observers[OBSERVERS];
+    double expected[OBSERVERS], elevations[OBSERVERS + 1];
+    int level, i, count;
+
+    for (i = 0; i < OBSERVERS; i++) {
+        ASSERT_EQUALS(SpaError_Success, spa_calculate_ephemeris(&ephemerides[i], 2459215.5 + 9.37 * i, 67));
+        ASSERT_EQUALS(SpaError_Success,
+                      spa_observer_init(&observers[i], -90.0 + 5.0 * i, -180.0 + 9.7 * i, 30.0 * i, 1010, 11, 0.5667));
+        expected[i] = spa_calculate_elevation(&ephemerides[i], &observers[i]);
+    }
+    for (level = SpaSimd_Scalar; level <= (int) detected; level++) {
+        double max_error = 0;
+        ASSERT("Set level", spa_simd_set_level((SpaSimdLevel) level));
+        for (count = 1; count <= OBSERVERS; count++) {
+            elevations[count] = 1000.0;
+            spa_calculate_elevations(count, ephemerides, observers, elevations);
+            ASSERT("Nothing written past count", elevations[count] == 1000.0);
+            for (i = 0; i < count; i++) {
+                max_error = fmax(max_error, fabs(elevations[i] - expected[i]));
+            }
+        }
+        printf("%s: max |dE| %.3e\n", level_names[level], max_error);
+        ASSERT("E within bound", max_error < MAX_OBSERVER_ERROR);
+    }
+    spa_simd_set_level(detected);
+}
+
+static void test_levels() {
+    ASSERT("Scalar is always available", spa_simd_set_level(SpaSimd_Scalar));
+    ASSERT_EQUALS(SpaSimd_Scalar, spa_simd_get_level());
+    ASSERT("Unknown level rejected", !spa_simd_set_level((SpaSimdLevel) (SpaSimd_AVX512 + 1)));
+    ASSERT_EQUALS(SpaSimd_Scalar, spa_simd_get_level());
+    ASSERT("Detected level is available", spa_simd_set_level(spa_simd_detect()));
+}
+
+int main() {
+    printf("Detected: %s\n", level_names[spa_simd_detect()]);
+    RUN(test_levels);
+    RUN(test_kernels_match_scalar);
+    RUN(test_elevation_kernels);
+    return TEST_REPORT();
+}
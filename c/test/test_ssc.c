@@ -7,6 +7,8 @@
 #include "ssc.h"
 #include "util.h"
 #include <assert.h>
+#include <math.h>
+#include <stdio.h>
 #include <tinytest.h>
 
 #define ACCURACY_SECONDS 60
@@ -102,10 +104,630 @@ static void test_adelaide() {
     ASSERT_VALID_RESULT(result, rose, sets, true);
 }
 
+// Check the batch API gives identical results to individual calls, including for invalid items
+static void test_batch() {
+#define BATCH_COUNT 40
+    unix_t times[BATCH_COUNT];
+    double lats[BATCH_COUNT];
+    double lons[BATCH_COUNT];
+    unix_t sets[BATCH_COUNT];
+    unix_t rises[BATCH_COUNT];
+    bool visible[BATCH_COUNT];
+    SpaError status[BATCH_COUNT];
+    SunriseSunsetBatchInput input;
+    SunriseSunsetAggregateStats batch_stats, expected_stats;
+    SunriseSunsetBatchOutput output = {sets, rises, visible, status, &batch_stats};
+    SunriseSunsetParameters params;
+    SunriseSunsetResult result;
+    SunriseSunsetStats stats;
+    time_t start = time_t_for_time(2021, 2, 16, 0, 0);
+    int i;
+
+    for (i = 0; i < BATCH_COUNT; i++) {
+        // Shared times in runs of 4, to exercise the shared ephemeris
+        times[i] = start + (i / 4) * 7919;
+        lats[i] = -80.0 + 4.1 * i;
+        lons[i] = -170.0 + 8.5 * i;
+    }
+    lats[7] = 91.0;
+    SunriseSunsetBatchInput_init(&input, BATCH_COUNT, times, lats, lons);
+    SunriseSunsetAggregateStats_init(&batch_stats);
+    ASSERT_EQUALS(SpaError_InvalidLatitude, sunrise_sunset_calculate_batch(&input, &output));
+
+    SunriseSunsetAggregateStats_init(&expected_stats);
+    for (i = 0; i < BATCH_COUNT; i++) {
+        SunriseSunsetParameters_init(&params, times[i], lats[i], lons[i]);
+        ASSERT_EQUALS(sunrise_sunset_calculate_stats(&params, &result, &stats), status[i]);
+        if (status[i] == SpaError_Success) {
+            ASSERT_EQUALS(result.rise, rises[i]);
+            ASSERT_EQUALS(result.set, sets[i]);
+            ASSERT_EQUALS(result.visible, visible[i]);
+            sunrise_sunset_stats_add(&expected_stats, &stats);
+        }
+    }
+    ASSERT_EQUALS(SpaError_InvalidLatitude, status[7]);
+
+    // The same statistics as the individual calls
+    ASSERT_EQUALS(BATCH_COUNT - 1, batch_stats.calls);
+    ASSERT_EQUALS(expected_stats.evaluations, batch_stats.evaluations);
+    ASSERT_EQUALS(expected_stats.steps, batch_stats.steps);
+    ASSERT_EQUALS(expected_stats.bisections, batch_stats.bisections);
+    ASSERT_EQUALS(expected_stats.max_evaluations, batch_stats.max_evaluations);
+    ASSERT_EQUALS(expected_stats.max_span, batch_stats.max_span);
+#undef BATCH_COUNT
+}
+
+// Cheaper nutation evaluation must stay within a couple of seconds of the full series
+static void test_nutation_modes() {
+    SunriseSunsetParameters params;
+    SunriseSunsetResult full, fast;
+    time_t start = time_t_for_time(2021, 3, 1, 12, 0);
+    int i, mode;
+
+    for (i = 0; i < 20; i++) {
+        for (mode = 0; mode < 3; mode++) {
+            SunriseSunsetParameters_init(&params, start + i * 86400 * 17, BRISTOL_LAT, BRISTOL_LON);
+            ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &full));
+            params.nutation = mode == 0 ? SpaNutation_Full : SpaNutation_Truncated;
+            params.nutation_interval = mode == 1 ? 0.0 : SSC_FAST_NUTATION_INTERVAL;
+            ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &fast));
+            ASSERT_EQUALS(full.visible, fast.visible);
+            ASSERT("Sunrise within 2s", llabs(full.rise - fast.rise) <= 2);
+            ASSERT("Sunset within 2s", llabs(full.set - fast.set) <= 2);
+        }
+    }
+}
+
+// The predictor search should find the same events as the step search, including where it falls back near the poles
+static void test_predictor_search() {
+    SunriseSunsetParameters params;
+    SunriseSunsetResult step, predictor;
+    double latitudes[] = {
+        -66.0, -60.0, -45.0, -30.0, -10.0, 0.0, 10.0, 30.0, BRISTOL_LAT, 60.0, 64.0, 68.0, 80.0, 89.0};
+    double longitudes[] = {-150.0, BRISTOL_LON, 100.0};
+    time_t start = time_t_for_time(2021, 1, 1, 0, 0);
+    size_t i, j, k;
+
+    for (i = 0; i < sizeof(latitudes) / sizeof(latitudes[0]); i++) {
+        for (j = 0; j < sizeof(longitudes) / sizeof(longitudes[0]); j++) {
+            for (k = 0; k < 7; k++) {
+                time_t time = start + (time_t) k * (52 * 86400 + 7 * 3600 + 13 * 60);
+                SunriseSunsetParameters_init(&params, time, latitudes[i], longitudes[j]);
+                ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &step));
+                params.search = SunriseSunsetSearch_Predictor;
+                ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &predictor));
+                ASSERT_EQUALS(step.visible, predictor.visible);
+                ASSERT("Sunrise within 2s", llabs(step.rise - predictor.rise) <= 2);
+                ASSERT("Sunset within 2s", llabs(step.set - predictor.set) <= 2);
+                ASSERT("Input between events", predictor.visible ? predictor.rise <= time && time < predictor.set
+                                                                 : predictor.set <= time && time < predictor.rise);
+            }
+        }
+    }
+}
+
+// Refraction corrected elevation through the public SPA API, independent of the search
+static double corrected_elevation(const SunriseSunsetParameters *params, unix_t time) {
+    spa_observer observer;
+    spa_ephemeris ephemeris;
+    spa_observer_init(&observer,
+                      params->latitude,
+                      params->longitude,
+                      params->elevation,
+                      params->pressure,
+                      params->temperature,
+                      params->atmos_refract);
+    spa_calculate_ephemeris(&ephemeris, (double) time / 86400.0 + 2440587.5, params->delta_t);
+    return spa_calculate_elevation(&ephemeris, &observer);
+}
+
+// Local mean midnight at or before a (positive) time
+static unix_t mean_midnight(unix_t time, double lon) {
+    unix_t offset = (unix_t) floor(lon / 360.0 * 86400.0 + 0.5);
+    return (time + offset) / 86400 * 86400 - offset;
+}
+
+// The transit search should find the same events as a fine step search, with a bounded number of evaluations away
+// from polar day and night. The default step can miss days of a few minutes at the edge of polar night.
+static void test_transit_search() {
+    SunriseSunsetParameters params;
+    SunriseSunsetResult step, transit;
+    SunriseSunsetStats stats;
+    double latitudes[] = {
+        -66.0, -60.0, -45.0, -30.0, -10.0, 0.0, 10.0, 30.0, BRISTOL_LAT, 60.0, 64.0, 68.0, 80.0, 89.0};
+    double longitudes[] = {-150.0, BRISTOL_LON, 100.0};
+    time_t start = time_t_for_time(2021, 1, 1, 0, 0);
+    size_t i, j, k;
+
+    for (i = 0; i < sizeof(latitudes) / sizeof(latitudes[0]); i++) {
+        for (j = 0; j < sizeof(longitudes) / sizeof(longitudes[0]); j++) {
+            for (k = 0; k < 7; k++) {
+                time_t time = start + (time_t) k * (52 * 86400 + 7 * 3600 + 13 * 60);
+                SunriseSunsetParameters_init(&params, time, latitudes[i], longitudes[j]);
+                params.step_size = 60;
+                ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &step));
+                params.search = SunriseSunsetSearch_Transit;
+                ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate_stats(&params, &transit, &stats));
+                ASSERT_EQUALS(step.visible, transit.visible);
+                ASSERT("Sunrise within 1s", llabs(step.rise - transit.rise) <= 1);
+                ASSERT("Sunset within 1s", llabs(step.set - transit.set) <= 1);
+                ASSERT("Input between events", transit.visible ? transit.rise <= time && time < transit.set
+                                                               : transit.set <= time && time < transit.rise);
+                if (fabs(latitudes[i]) < 60.0) {
+                    ASSERT("Bounded evaluations", stats.backward.evaluations <= 40 && stats.forward.evaluations <= 40);
+                }
+            }
+        }
+    }
+
+    // A day of an hour and a half inside the Arctic circle, which four hour steps from before it jump over
+    SunriseSunsetParameters_init(&params, time_t_for_time(2021, 12, 21, 5, 0), 67.0, 25.7);
+    params.step_size = 60;
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &step));
+    params.time = step.rise + 1;
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &transit));
+    ASSERT("Short day", transit.visible && transit.set - transit.rise < 2 * 3600);
+    params.time = time_t_for_time(2021, 12, 21, 5, 0);
+    params.step_size = 14400;
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &transit));
+    ASSERT("Skipped by the step search", transit.rise > step.rise + 86400);
+    params.search = SunriseSunsetSearch_Transit;
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &transit));
+    ASSERT_EQUALS(step.visible, transit.visible);
+    ASSERT("Sunrise within 1s", llabs(step.rise - transit.rise) <= 1);
+    ASSERT("Sunset within 1s", llabs(step.set - transit.set) <= 1);
+}
+
+// Solar noon and midnight are where the elevation is highest and lowest, the declination moves the extremes by less
+// than a minute
+static void test_transit() {
+    double latitudes[] = {-45.0, 0.0, BRISTOL_LAT, 70.0};
+    SunriseSunsetParameters params;
+    SunriseSunsetTransit transit;
+    SunriseSunsetResult result;
+    unix_t offsets[] = {-600, -300, 300, 600};
+    time_t time = time_t_for_time(2021, 6, 21, 12, 0);
+    size_t i, j;
+    unix_t t;
+    int day;
+
+    for (day = 0; day < 365; day += 23) {
+        for (i = 0; i < sizeof(latitudes) / sizeof(latitudes[0]); i++) {
+            SunriseSunsetParameters_init(&params, time + day * 86400, latitudes[i], 15.0 * (day % 24) - 170.0);
+            ASSERT_EQUALS(SpaError_Success, sunrise_sunset_transit(&params, &transit));
+            ASSERT("Nadir before transit", transit.nadir < transit.transit && transit.transit - transit.nadir < 44000);
+            ASSERT("Near mean noon", llabs(transit.transit - mean_midnight(params.time, params.longitude) - 43200) < 1200);
+            ASSERT_EQUALS(corrected_elevation(&params, transit.transit), transit.max_elevation);
+            ASSERT_EQUALS(corrected_elevation(&params, transit.nadir), transit.min_elevation);
+            for (j = 0; j < 4; j++) {
+                ASSERT("Highest", corrected_elevation(&params, transit.transit + offsets[j]) < transit.max_elevation);
+                ASSERT("Lowest", corrected_elevation(&params, transit.nadir + offsets[j]) > transit.min_elevation);
+            }
+            for (t = -60; t <= 60; t++) {
+                ASSERT("Near highest", corrected_elevation(&params, transit.transit + t) < transit.max_elevation + 1e-3);
+                ASSERT("Near lowest", corrected_elevation(&params, transit.nadir + t) > transit.min_elevation - 1e-3);
+            }
+        }
+    }
+
+    // Solar noon in Bristol on the summer solstice is at 12:12 UTC, with the sun 62 degrees high
+    SunriseSunsetParameters_init(&params, time, BRISTOL_LAT, BRISTOL_LON);
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_transit(&params, &transit));
+    ASSERT("Solar noon", llabs(transit.transit - time_t_for_time(2021, 6, 21, 12, 12)) <= 60);
+    ASSERT("Highest elevation", fabs(transit.max_elevation - 62.0) < 0.1);
+    ASSERT("Lowest elevation", fabs(transit.min_elevation + 15.1) < 0.1);
+
+    // Noon is between sunrise and sunset
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &result));
+    ASSERT("Between", result.rise < transit.transit && transit.transit < result.set);
+
+    SunriseSunsetParameters_init(&params, time, BRISTOL_LAT, 181.0);
+    ASSERT_EQUALS(SpaError_InvalidLongitude, sunrise_sunset_transit(&params, &transit));
+}
+
+// Each day of the table matches the events found by sunrise_sunset_events() through the day
+static void test_table_impl(double lat, double lon, time_t start, size_t day_count, SunriseSunsetTableStats *stats) {
+    static SunriseSunsetDay days[400];
+    SunriseSunsetParameters params;
+    SunriseSunsetEvent events[16];
+    unix_t midnight = mean_midnight(start, lon);
+    size_t count, d, i;
+
+    SunriseSunsetParameters_init(&params, start, lat, lon);
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_table(&params, day_count, days, stats));
+    params.search = SunriseSunsetSearch_Transit;
+    for (d = 0; d < day_count; d++, midnight += 86400) {
+        bool has_rise = false, has_set = false;
+        ASSERT_EQUALS(SpaError_Success, sunrise_sunset_events(&params, midnight, midnight + 86400, events, 16, &count));
+        ASSERT_EQUALS(corrected_elevation(&params, midnight) >= SSC_SUNRISE_ELEVATION, days[d].visible);
+        for (i = 0; i < count; i++) {
+            if (events[i].rise && !has_rise) {
+                ASSERT_EQUALS(events[i].time, days[d].rise);
+                has_rise = true;
+            } else if (!events[i].rise && !has_set) {
+                ASSERT_EQUALS(events[i].time, days[d].set);
+                has_set = true;
+            }
+        }
+        ASSERT_EQUALS(has_rise, days[d].has_rise);
+        ASSERT_EQUALS(has_set, days[d].has_set);
+    }
+}
+
+static void test_table() {
+    double latitudes[] = {-70.0, -60.0, -34.92, 0.0, 23.4, BRISTOL_LAT, 60.0, 64.0, 66.0, 66.6, 67.0, 70.0, 80.0};
+    time_t start = time_t_for_time(2021, 1, 1, 12, 0);
+    SunriseSunsetTableStats stats;
+    SunriseSunsetParameters params;
+    SunriseSunsetDay days[2];
+    size_t i;
+
+    for (i = 0; i < sizeof(latitudes) / sizeof(latitudes[0]); i++) {
+        test_table_impl(latitudes[i], 15.0 * (double) i - 100.0, start, 365, &stats);
+        printf("Latitude %g: %llu events, %.2f evaluations per event, %llu days searched\n",
+               latitudes[i],
+               (unsigned long long) stats.events,
+               (double) stats.evaluations / (double) (stats.events > 0 ? stats.events : 1),
+               (unsigned long long) stats.searched);
+        if (fabs(latitudes[i]) <= 60.0) {
+            ASSERT_EQUALS(730, (int) stats.events);
+            ASSERT("Only the first day searched", stats.searched == 1);
+            ASSERT("Few evaluations per event", stats.evaluations <= 4 * stats.events);
+        }
+    }
+    // Svalbard through the end of polar night, the first days are searched until there are events to predict from
+    test_table_impl(SVALBARD_LAT, SVALBARD_LON, time_t_for_time(2021, 2, 1, 0, 0), 40, &stats);
+    ASSERT("Searched then seeded", stats.searched > 10 && stats.seeded > 10);
+
+    // Statistics are optional
+    SunriseSunsetParameters_init(&params, start, BRISTOL_LAT, BRISTOL_LON);
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_table(&params, 2, days, NULL));
+    ASSERT("Day", days[1].has_rise && days[1].has_set && days[1].rise < days[1].set && !days[1].visible);
+
+    // Invalid parameters
+    SunriseSunsetParameters_init(&params, start, 91.0, BRISTOL_LON);
+    ASSERT_EQUALS(SpaError_InvalidLatitude, sunrise_sunset_table(&params, 2, days, NULL));
+}
+
+// Every event should agree with sunrise_sunset_calculate() just before it, and events should alternate
+static void test_events_impl(double lat, double lon, time_t start, time_t end, SunriseSunsetSearch search) {
+    SunriseSunsetParameters params;
+    SunriseSunsetResult result;
+    SunriseSunsetEvent events[128];
+    size_t count, i;
+
+    SunriseSunsetParameters_init(&params, start, lat, lon);
+    params.search = search;
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_events(&params, start, end, events, 128, &count));
+    ASSERT("Buffer not full", count < 128);
+
+    // Check against the next event after the start, and the one after each event
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &result));
+    if (count == 0) {
+        ASSERT("No events in window", (result.visible ? result.set : result.rise) > end);
+    }
+    for (i = 0; i < count; i++) {
+        ASSERT("In window", start < events[i].time && events[i].time <= end);
+        ASSERT("Alternates", i == 0 || events[i].rise != events[i - 1].rise);
+        ASSERT_EQUALS(events[i].rise, !result.visible);
+        ASSERT("Matches next event", llabs((events[i].rise ? result.rise : result.set) - events[i].time) <= 2);
+
+        params.time = events[i].time;
+        ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &result));
+        ASSERT_EQUALS(events[i].rise, result.visible);
+        ASSERT("Next event after window", i + 1 < count || (result.visible ? result.set : result.rise) > end);
+    }
+}
+
+static void test_events() {
+    time_t start = time_t_for_time(2021, 7, 28, 22, 0);
+    SunriseSunsetParameters params;
+    SunriseSunsetEvent events[4];
+    size_t count;
+
+    test_events_impl(BRISTOL_LAT, BRISTOL_LON, start, start + 30 * 86400, SunriseSunsetSearch_Step);
+    test_events_impl(BRISTOL_LAT, BRISTOL_LON, start, start + 30 * 86400, SunriseSunsetSearch_Predictor);
+    test_events_impl(ADELAIDE_LAT, ADELAIDE_LON, start, start + 30 * 86400, SunriseSunsetSearch_Predictor);
+
+    // Polar night, polar day, and the transitions between them with short days
+    test_events_impl(SVALBARD_LAT,
+                     SVALBARD_LON,
+                     time_t_for_time(2020, 12, 1, 0, 0),
+                     time_t_for_time(2021, 1, 10, 0, 0),
+                     SunriseSunsetSearch_Predictor);
+    test_events_impl(SVALBARD_LAT,
+                     SVALBARD_LON,
+                     time_t_for_time(2021, 6, 1, 0, 0),
+                     time_t_for_time(2021, 7, 10, 0, 0),
+                     SunriseSunsetSearch_Step);
+    test_events_impl(SVALBARD_LAT,
+                     SVALBARD_LON,
+                     time_t_for_time(2021, 2, 1, 0, 0),
+                     time_t_for_time(2021, 3, 1, 0, 0),
+                     SunriseSunsetSearch_Predictor);
+    test_events_impl(SVALBARD_LAT,
+                     SVALBARD_LON,
+                     time_t_for_time(2021, 2, 1, 0, 0),
+                     time_t_for_time(2021, 3, 1, 0, 0),
+                     SunriseSunsetSearch_Step);
+    test_events_impl(-89.0, 0.0, time_t_for_time(2021, 1, 1, 0, 0), time_t_for_time(2022, 1, 1, 0, 0),
+                     SunriseSunsetSearch_Predictor);
+    test_events_impl(BRISTOL_LAT, BRISTOL_LON, start, start + 30 * 86400, SunriseSunsetSearch_Transit);
+    test_events_impl(SVALBARD_LAT,
+                     SVALBARD_LON,
+                     time_t_for_time(2021, 2, 1, 0, 0),
+                     time_t_for_time(2021, 3, 1, 0, 0),
+                     SunriseSunsetSearch_Transit);
+    test_events_impl(-89.0, 0.0, time_t_for_time(2021, 1, 1, 0, 0), time_t_for_time(2022, 1, 1, 0, 0),
+                     SunriseSunsetSearch_Transit);
+
+    // A full buffer stops early and can be continued from the last event
+    SunriseSunsetParameters_init(&params, start, BRISTOL_LAT, BRISTOL_LON);
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_events(&params, start, start + 5 * 86400, events, 4, &count));
+    ASSERT_EQUALS(4, count);
+    ASSERT_EQUALS(SpaError_Success,
+                  sunrise_sunset_events(&params, events[3].time, start + 5 * 86400, events, 4, &count));
+    ASSERT_EQUALS(4, count);
+    ASSERT_EQUALS(SpaError_Success,
+                  sunrise_sunset_events(&params, events[3].time, start + 5 * 86400, events, 4, &count));
+    ASSERT_EQUALS(2, count);
+
+    // Invalid parameters
+    SunriseSunsetParameters_init(&params, start, 91.0, BRISTOL_LON);
+    ASSERT_EQUALS(SpaError_InvalidLatitude, sunrise_sunset_events(&params, start, start + 86400, events, 4, &count));
+}
+
+// Each crossing should be the first second on the new side, match the sunrise events, and sampling the day every
+// sample_interval seconds should not find any change it missed
+static void test_crossings_impl(double lat, double lon, time_t time, time_t sample_interval) {
+    double thresholds[] = {SSC_SUNRISE_ELEVATION,
+                           SSC_CIVIL_TWILIGHT_ELEVATION,
+                           SSC_NAUTICAL_TWILIGHT_ELEVATION,
+                           SSC_ASTRONOMICAL_TWILIGHT_ELEVATION,
+                           SSC_GOLDEN_HOUR_ELEVATION};
+    SunriseSunsetParameters params;
+    SunriseSunsetCrossing crossings[32];
+    SunriseSunsetEvent events[8];
+    unix_t start = mean_midnight(time, lon), t;
+    size_t count, event_count, i, k, sampled, found, sunrise = 0;
+
+    SunriseSunsetParameters_init(&params, time, lat, lon);
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_crossings(&params, thresholds, 5, crossings, 32, &count));
+    for (i = 0; i < count; i++) {
+        double threshold = thresholds[crossings[i].threshold];
+        ASSERT("In day", start < crossings[i].time && crossings[i].time <= start + 86400);
+        ASSERT("In order", i == 0 || crossings[i - 1].time <= crossings[i].time);
+        ASSERT_EQUALS(crossings[i].rising, corrected_elevation(&params, crossings[i].time) >= threshold);
+        ASSERT_EQUALS(crossings[i].rising, corrected_elevation(&params, crossings[i].time - 1) < threshold);
+    }
+
+    // The sunrise threshold gives exactly the sunrises and sunsets
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_events(&params, start, start + 86400, events, 8, &event_count));
+    for (i = 0; i < count; i++) {
+        if (crossings[i].threshold == 0) {
+            ASSERT("Matches event", sunrise < event_count && events[sunrise].time == crossings[i].time &&
+                                        events[sunrise].rise == crossings[i].rising);
+            sunrise++;
+        }
+    }
+    ASSERT_EQUALS(event_count, sunrise);
+
+    for (k = 0; k < 5; k++) {
+        bool above = corrected_elevation(&params, start) >= thresholds[k];
+        sampled = 0;
+        for (t = start + sample_interval; t <= start + 86400; t += sample_interval) {
+            bool now = corrected_elevation(&params, t) >= thresholds[k];
+            sampled += now != above;
+            above = now;
+        }
+        found = 0;
+        for (i = 0; i < count; i++) {
+            found += crossings[i].threshold == k;
+        }
+        ASSERT_EQUALS(sampled, found);
+    }
+}
+
+static void test_crossings() {
+    double thresholds[] = {SSC_CIVIL_TWILIGHT_ELEVATION, SSC_SUNRISE_ELEVATION};
+    time_t start = time_t_for_time(2021, 1, 3, 12, 0);
+    SunriseSunsetParameters params;
+    SunriseSunsetCrossing crossings[4];
+    size_t count;
+    double lat;
+    int day;
+
+    for (day = 0; day < 365; day += 19) {
+        test_crossings_impl(BRISTOL_LAT, BRISTOL_LON, start + day * 86400, 300);
+        test_crossings_impl(ADELAIDE_LAT, ADELAIDE_LON, start + day * 86400 + 7 * 3600, 300);
+        test_crossings_impl(SVALBARD_LAT, SVALBARD_LON, start + day * 86400 - 5 * 3600, 300);
+    }
+    // The golden hour threshold grazes the highest elevation of the day around the winter solstice
+    for (lat = 60.3; lat <= 60.8; lat += 0.05) {
+        test_crossings_impl(lat, 10.0, time_t_for_time(2021, 12, 21, 12, 0), 30);
+    }
+
+    // Astronomical twilight lasts all night in a Bristol summer
+    SunriseSunsetParameters_init(&params, time_t_for_time(2021, 6, 21, 12, 0), BRISTOL_LAT, BRISTOL_LON);
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_crossings(&params, thresholds + 0, 1, crossings, 4, &count));
+    ASSERT_EQUALS(2, count);
+    thresholds[0] = SSC_ASTRONOMICAL_TWILIGHT_ELEVATION;
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_crossings(&params, thresholds, 1, crossings, 4, &count));
+    ASSERT_EQUALS(0, count);
+
+    // A full buffer keeps the earliest crossings
+    thresholds[0] = SSC_CIVIL_TWILIGHT_ELEVATION;
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_crossings(&params, thresholds, 2, crossings, 3, &count));
+    ASSERT_EQUALS(3, count);
+    ASSERT("Civil dawn, sunrise, sunset", crossings[0].threshold == 0 && crossings[0].rising &&
+                                              crossings[1].threshold == 1 && crossings[1].rising &&
+                                              crossings[2].threshold == 1 && !crossings[2].rising);
+
+    // The zenith and nadir are valid thresholds that are never crossed, anything past them is invalid
+    thresholds[0] = 90.0;
+    thresholds[1] = -90.0;
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_crossings(&params, thresholds, 2, crossings, 4, &count));
+    ASSERT_EQUALS(0, count);
+    thresholds[1] = -90.5;
+    ASSERT_EQUALS(SpaError_InvalidThreshold, sunrise_sunset_crossings(&params, thresholds, 2, crossings, 4, &count));
+    ASSERT_EQUALS(0, count);
+    thresholds[1] = 1e300;
+    ASSERT_EQUALS(SpaError_InvalidThreshold, sunrise_sunset_crossings(&params, thresholds, 2, crossings, 4, &count));
+    thresholds[1] = INFINITY;
+    ASSERT_EQUALS(SpaError_InvalidThreshold, sunrise_sunset_crossings(&params, thresholds, 2, crossings, 4, &count));
+    thresholds[1] = NAN;
+    ASSERT_EQUALS(SpaError_InvalidThreshold, sunrise_sunset_crossings(&params, thresholds, 2, crossings, 4, &count));
+
+    thresholds[1] = SSC_SUNRISE_ELEVATION;
+    SunriseSunsetParameters_init(&params, start, 91.0, BRISTOL_LON);
+    ASSERT_EQUALS(SpaError_InvalidLatitude, sunrise_sunset_crossings(&params, thresholds, 2, crossings, 4, &count));
+}
+
+static void test_calculator_impl(double lat, double lon, time_t start, time_t end, time_t step) {
+    SunriseSunsetCalculator calculator;
+    SunriseSunsetParameters params;
+    SunriseSunsetResult expected, actual;
+    time_t t;
+
+    SunriseSunsetParameters_init(&params, start, lat, lon);
+    params.search = SunriseSunsetSearch_Predictor;
+    ASSERT_EQUALS(SpaError_Success, SunriseSunsetCalculator_init(&calculator, &params));
+    for (t = start; t < end; t += step) {
+        params.time = t;
+        ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &expected));
+        ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculator_query(&calculator, t, &actual));
+        ASSERT_EQUALS(expected.visible, actual.visible);
+        ASSERT("Set before time", actual.set <= t || actual.visible);
+        ASSERT("Rise before time", actual.rise <= t || !actual.visible);
+        ASSERT("Rise within 2 seconds", llabs(expected.rise - actual.rise) <= 2);
+        ASSERT("Set within 2 seconds", llabs(expected.set - actual.set) <= 2);
+    }
+}
+
+static void test_calculator() {
+    time_t start = time_t_for_time(2021, 7, 28, 22, 0);
+    SunriseSunsetCalculator calculator;
+    SunriseSunsetParameters params;
+    SunriseSunsetResult first, result;
+
+    // Monotonic queries, with steps both shorter and longer than a day
+    test_calculator_impl(BRISTOL_LAT, BRISTOL_LON, start, start + 5 * 86400, 1200);
+    test_calculator_impl(ADELAIDE_LAT, ADELAIDE_LON, start, start + 40 * 86400, 86400 + 3517);
+    test_calculator_impl(SVALBARD_LAT, SVALBARD_LON, time_t_for_time(2021, 2, 10, 0, 0),
+                         time_t_for_time(2021, 2, 20, 0, 0), 3 * 3600);
+    test_calculator_impl(SVALBARD_LAT, SVALBARD_LON, time_t_for_time(2021, 4, 1, 0, 0),
+                         time_t_for_time(2021, 10, 1, 0, 0), 9 * 86400);
+
+    // Queries back in time, and within the cached interval, give the same result
+    SunriseSunsetParameters_init(&params, start, BRISTOL_LAT, BRISTOL_LON);
+    ASSERT_EQUALS(SpaError_Success, SunriseSunsetCalculator_init(&calculator, &params));
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculator_query(&calculator, start, &first));
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculator_query(&calculator, start + 30 * 86400, &result));
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculator_query(&calculator, start, &result));
+    ASSERT_EQUALS(first.rise, result.rise);
+    ASSERT_EQUALS(first.set, result.set);
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculator_query(&calculator, first.set, &result));
+    ASSERT_EQUALS(first.set, result.set);
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculator_query(&calculator, first.rise - 1, &result));
+    ASSERT_EQUALS(first.rise, result.rise);
+
+    // Invalid parameters
+    SunriseSunsetParameters_init(&params, start, 91.0, BRISTOL_LON);
+    ASSERT_EQUALS(SpaError_InvalidLatitude, SunriseSunsetCalculator_init(&calculator, &params));
+}
+
+// A single event searched for in one direction is the same as that event of the full calculation, also through
+// polar day and night
+static void test_calculate_event() {
+    double latitudes[] = {ADELAIDE_LAT, BRISTOL_LAT, 66.0, SVALBARD_LAT};
+    SunriseSunsetSearch searches[] = {
+        SunriseSunsetSearch_Step, SunriseSunsetSearch_Predictor, SunriseSunsetSearch_Transit};
+    SunriseSunsetParameters params;
+    SunriseSunsetResult expected, rise, set;
+    time_t start = time_t_for_time(2021, 1, 1, 0, 0);
+    size_t i, j;
+    int k;
+
+    for (i = 0; i < sizeof(latitudes) / sizeof(latitudes[0]); i++) {
+        for (j = 0; j < sizeof(searches) / sizeof(searches[0]); j++) {
+            for (k = 0; k < 12; k++) {
+                SunriseSunsetParameters_init(&params, start + (time_t) k * (31 * 86400 + 5 * 3600), latitudes[i], 15.0);
+                params.search = searches[j];
+                ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &expected));
+                ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate_event(&params, true, &rise));
+                ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate_event(&params, false, &set));
+                ASSERT_EQUALS(expected.visible, rise.visible);
+                ASSERT_EQUALS(expected.visible, set.visible);
+                ASSERT("Sunrise within 1s", llabs(expected.rise - rise.rise) <= 1);
+                ASSERT("Sunset within 1s", llabs(expected.set - set.set) <= 1);
+                ASSERT("Other event cleared", rise.set == 0 && set.rise == 0);
+            }
+        }
+    }
+    SunriseSunsetParameters_init(&params, start, 91.0, BRISTOL_LON);
+    ASSERT_EQUALS(SpaError_InvalidLatitude, sunrise_sunset_calculate_event(&params, true, &rise));
+}
+
+static void test_stats() {
+    SunriseSunsetParameters params;
+    SunriseSunsetResult expected, result;
+    SunriseSunsetStats stats, predictor_stats;
+    SunriseSunsetAggregateStats aggregate;
+
+    // Bristol, the sun rises and sets within a day
+    SunriseSunsetParameters_init(&params, time_t_for_time(2021, 7, 28, 22, 0), BRISTOL_LAT, BRISTOL_LON);
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &expected));
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate_stats(&params, &result, &stats));
+    ASSERT_EQUALS(expected.rise, result.rise);
+    ASSERT_EQUALS(expected.set, result.set);
+    ASSERT_EQUALS(1 + stats.backward.evaluations + stats.forward.evaluations, stats.evaluations);
+    ASSERT("Evaluations", stats.backward.evaluations >= stats.backward.steps + stats.backward.bisections);
+    ASSERT_EQUALS(params.time - result.set, stats.backward.span);
+    ASSERT_EQUALS(result.rise - params.time, stats.forward.span);
+    // A 4 hour step is halved 14 times down to zero
+    ASSERT_EQUALS(14, stats.forward.bisections);
+    ASSERT("Steps cover the span", (int64_t) stats.forward.steps * params.step_size >= stats.forward.span);
+
+    params.search = SunriseSunsetSearch_Predictor;
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate_stats(&params, &result, &predictor_stats));
+    ASSERT("Predictor needs fewer evaluations", predictor_stats.evaluations < stats.evaluations / 4);
+    ASSERT_EQUALS(0, predictor_stats.forward.steps);
+
+    // Polar night in Svalbard is skipped for weeks in both directions, only about the last day is stepped through
+    SunriseSunsetParameters_init(&params, time_t_for_time(2020, 12, 21, 12, 0), SVALBARD_LAT, SVALBARD_LON);
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate_stats(&params, &result, &stats));
+    ASSERT("Weeks skipped", stats.backward.skipped > 14 * 86400 && stats.forward.skipped > 14 * 86400);
+    ASSERT("Few steps", stats.backward.steps < 200 && stats.forward.steps < 200);
+    ASSERT("Over a month scanned", stats.backward.span > 30 * 86400 && stats.forward.span > 30 * 86400);
+
+    SunriseSunsetAggregateStats_init(&aggregate);
+    sunrise_sunset_stats_add(&aggregate, &stats);
+    sunrise_sunset_stats_add(&aggregate, &predictor_stats);
+    ASSERT_EQUALS(2, aggregate.calls);
+    ASSERT_EQUALS(stats.evaluations + predictor_stats.evaluations, aggregate.evaluations);
+    ASSERT_EQUALS(stats.evaluations, aggregate.max_evaluations);
+    ASSERT_EQUALS(stats.backward.span > stats.forward.span ? stats.backward.span : stats.forward.span,
+                  aggregate.max_span);
+
+    // Statistics are optional
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate_stats(&params, &result, NULL));
+}
+
 int main() {
     RUN(test_platform);
     RUN(test_bristol);
     RUN(test_outer_bounds);
     RUN(test_adelaide);
+    RUN(test_batch);
+    RUN(test_nutation_modes);
+    RUN(test_predictor_search);
+    RUN(test_transit_search);
+    RUN(test_transit);
+    RUN(test_table);
+    RUN(test_events);
+    RUN(test_crossings);
+    RUN(test_calculator);
+    RUN(test_calculate_event);
+    RUN(test_stats);
     return TEST_REPORT();
 }
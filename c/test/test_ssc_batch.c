@@ -0,0 +1,351 @@
+//
+//  test_ssc_batch.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+//  Runs the ssc_batch and ssc_columns_convert executables given as the arguments on files of rows, and checks every
+//  row they write against sunrise_sunset_calculate().
+//
+#include "ssc.h"
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <tinytest.h>
+#include <unistd.h>
+
+#define INPUT_PATH "test_ssc_batch_input.txt"
+#define OUTPUT_PATH "test_ssc_batch_output.txt"
+#define COLUMNS_PATH "test_ssc_batch.ssc"
+#define UNIX_2021 1609459200 // 2021-01-01 00:00
+#define ROWS 600
+/// Every this many rows is malformed
+#define MALFORMED_EVERY 37
+/// Every this many rows has an invalid latitude, so is parsed but fails to calculate
+#define INVALID_EVERY 53
+/// Every this many rows has its own atmosphere
+#define ATMOSPHERE_EVERY 5
+#define LINE_BYTES 256
+
+typedef struct {
+    unix_t time;
+    double latitude;
+    double longitude;
+    double elevation;
+    double pressure;
+    double temperature;
+    bool atmosphere;
+    bool malformed;
+} TestRow;
+
+static const char *batch_path, *convert_path;
+static TestRow rows[ROWS];
+
+static void random_rows() {
+    size_t i;
+    for (i = 0; i < ROWS; i++) {
+        rows[i].time = UNIX_2021 + rand() % (86400 * 365);
+        rows[i].latitude = i % INVALID_EVERY == 1 ? 95.0 : (rand() % 17800 - 8900) / 100.0;
+        rows[i].longitude = (rand() % 35800 - 17900) / 100.0;
+        rows[i].atmosphere = i % ATMOSPHERE_EVERY == 2;
+        rows[i].elevation = rows[i].atmosphere ? rand() % 3000 : SSC_DEFAULT_ELEVATION;
+        rows[i].pressure = rows[i].atmosphere ? 950 + rand() % 100 : SSC_DEFAULT_PRESSURE;
+        rows[i].temperature = rows[i].atmosphere ? rand() % 40 - 10 : SSC_DEFAULT_TEMPERATURE;
+        rows[i].malformed = i % MALFORMED_EVERY == 3;
+    }
+}
+
+static SpaError expected_result(const TestRow *row, SunriseSunsetResult *result) {
+    SunriseSunsetParameters params;
+    SunriseSunsetParameters_init(&params, row->time, row->latitude, row->longitude);
+    params.elevation = row->elevation;
+    params.pressure = row->pressure;
+    params.temperature = row->temperature;
+    return sunrise_sunset_calculate(&params, result);
+}
+
+/// Run an executable to completion, with stdin and stdout redirected to files when given
+/// @return Exit code, or -1 if it did not exit normally
+static int run(char *const arguments[], const char *input, const char *output) {
+    posix_spawn_file_actions_t actions;
+    pid_t pid;
+    int status = -1;
+
+    posix_spawn_file_actions_init(&actions);
+    if (input != NULL) {
+        posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, input, O_RDONLY, 0);
+    }
+    if (output != NULL) {
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    if (posix_spawn(&pid, arguments[0], &actions, NULL, arguments, NULL) != 0 || waitpid(pid, &status, 0) != pid) {
+        status = -1;
+    }
+    posix_spawn_file_actions_destroy(&actions);
+    return status != -1 && WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+/// Write the rows as CSV, in each of the ways a row can be malformed
+static void write_csv(bool header, bool malformed) {
+    FILE *file = fopen(INPUT_PATH, "w");
+    size_t i;
+    ASSERT("Created input", file != NULL);
+    if (header) {
+        fputs("time,lat,lon\n", file);
+    }
+    for (i = 0; i < ROWS; i++) {
+        const TestRow *row = &rows[i];
+        if (row->malformed) {
+            if (!malformed) {
+                continue;
+            }
+            switch (i / MALFORMED_EVERY % 4) {
+            case 0:
+                fputs("not a row\n", file);
+                break;
+            case 1:
+                fprintf(file, "%lld,%.2f\n", (long long) row->time, row->latitude);
+                break;
+            case 2:
+                fprintf(file, "%lld,%.2f,%.2f,100\n", (long long) row->time, row->latitude, row->longitude);
+                break;
+            default:
+                fprintf(file, "%lld,%.2f,east\n", (long long) row->time, row->latitude);
+                break;
+            }
+        } else if (row->atmosphere) {
+            fprintf(file,
+                    "%lld, %.2f, %.2f, %.1f, %.1f, %.1f\r\n",
+                    (long long) row->time,
+                    row->latitude,
+                    row->longitude,
+                    row->elevation,
+                    row->pressure,
+                    row->temperature);
+        } else {
+            fprintf(file, "%lld,%.2f,%.2f\n", (long long) row->time, row->latitude, row->longitude);
+        }
+    }
+    fclose(file);
+}
+
+/// Write the rows as NDJSON, in each of the ways a row can be malformed
+static void write_ndjson() {
+    FILE *file = fopen(INPUT_PATH, "w");
+    size_t i;
+    ASSERT("Created input", file != NULL);
+    for (i = 0; i < ROWS; i++) {
+        const TestRow *row = &rows[i];
+        if (row->malformed) {
+            switch (i / MALFORMED_EVERY % 3) {
+            case 0:
+                fprintf(file, "{\"time\":%lld,\"lat\":%.2f}\n", (long long) row->time, row->latitude);
+                break;
+            case 1:
+                // Only part of the atmosphere
+                fprintf(file,
+                        "{\"time\":%lld,\"lat\":%.2f,\"lon\":%.2f,\"pressure\":1000}\n",
+                        (long long) row->time,
+                        row->latitude,
+                        row->longitude);
+                break;
+            default:
+                fputs("[1609459200, 51.45, -2.59]\n", file);
+                break;
+            }
+        } else if (row->atmosphere) {
+            fprintf(file,
+                    "{\"lon\": %.2f, \"time\": %lld, \"lat\": %.2f, \"elevation\": %.1f, \"pressure\": %.1f, "
+                    "\"temperature\": %.1f}\n",
+                    row->longitude,
+                    (long long) row->time,
+                    row->latitude,
+                    row->elevation,
+                    row->pressure,
+                    row->temperature);
+        } else {
+            fprintf(file,
+                    "{\"time\":%lld,\"lat\":%.2f,\"lon\":%.2f,\"name\":\"row \\\"%zu\\\"\",\"id\":%zu}\n",
+                    (long long) row->time,
+                    row->latitude,
+                    row->longitude,
+                    i,
+                    i);
+        }
+    }
+    fclose(file);
+}
+
+/// The output line ssc_batch should write for a row
+static void expected_line(const TestRow *row, bool ndjson, char *line) {
+    SunriseSunsetResult result;
+    SpaError status;
+    if (row->malformed) {
+        strcpy(line, ndjson ? "{\"status\":-1}\n" : ",,,,-1\n");
+        return;
+    }
+    status = expected_result(row, &result);
+    if (status != SpaError_Success) {
+        sprintf(line, ndjson ? "{\"time\":%lld,\"status\":%d}\n" : "%lld,,,,%d\n", (long long) row->time, (int) status);
+    } else if (ndjson) {
+        sprintf(line,
+                "{\"time\":%lld,\"rise\":%lld,\"set\":%lld,\"visible\":%s,\"status\":0}\n",
+                (long long) row->time,
+                (long long) result.rise,
+                (long long) result.set,
+                result.visible ? "true" : "false");
+    } else {
+        sprintf(line,
+                "%lld,%lld,%lld,%d,0\n",
+                (long long) row->time,
+                (long long) result.rise,
+                (long long) result.set,
+                result.visible ? 1 : 0);
+    }
+}
+
+/// Check that the output has a line for each row in order, the same as sunrise_sunset_calculate()
+static void check_output(bool ndjson, bool malformed) {
+    char line[LINE_BYTES], expected[LINE_BYTES];
+    FILE *file = fopen(OUTPUT_PATH, "r");
+    size_t i, mismatches = 0, checked = 0;
+
+    ASSERT("Opened output", file != NULL);
+    if (!ndjson) {
+        ASSERT("Header", fgets(line, sizeof(line), file) != NULL && strcmp(line, "time,rise,set,visible,status\n") == 0);
+    }
+    for (i = 0; i < ROWS; i++) {
+        if (rows[i].malformed && !malformed) {
+            continue;
+        }
+        expected_line(&rows[i], ndjson, expected);
+        if (fgets(line, sizeof(line), file) == NULL || strcmp(line, expected) != 0) {
+            mismatches++;
+        }
+        checked++;
+    }
+    ASSERT("Nothing after the rows", fgets(line, sizeof(line), file) == NULL);
+    fclose(file);
+    printf("Checked %zu rows\n", checked);
+    ASSERT_EQUALS(0, mismatches);
+}
+
+// CSV from stdin, with and without a header, every row in order whatever the thread that calculated it
+static void test_csv() {
+    char *arguments[] = {(char *) batch_path, "-t", "4", NULL};
+
+    ASSERT("Batch path given", batch_path != NULL);
+    write_csv(true, true);
+    ASSERT_EQUALS(1, run(arguments, INPUT_PATH, OUTPUT_PATH));
+    check_output(false, true);
+    write_csv(false, true);
+    ASSERT_EQUALS(1, run(arguments, INPUT_PATH, OUTPUT_PATH));
+    check_output(false, true);
+    // Rows that fail to calculate do not fail the run, only malformed rows do
+    write_csv(true, false);
+    ASSERT_EQUALS(0, run(arguments, INPUT_PATH, OUTPUT_PATH));
+    check_output(false, false);
+}
+
+static void test_ndjson() {
+    char *arguments[] = {(char *) batch_path, "-t", "4", NULL};
+    write_ndjson();
+    ASSERT_EQUALS(1, run(arguments, INPUT_PATH, OUTPUT_PATH));
+    check_output(true, true);
+}
+
+static void test_usage() {
+    char *unknown[] = {(char *) batch_path, "-x", NULL};
+    char *columns_stdin[] = {(char *) batch_path, "-f", "columns", NULL};
+    ASSERT_EQUALS(2, run(unknown, NULL, OUTPUT_PATH));
+    ASSERT_EQUALS(2, run(columns_stdin, NULL, OUTPUT_PATH));
+}
+
+// CSV to a columns file, calculated in place by ssc_batch and converted back to CSV
+static void test_columns_round_trip() {
+    char *to_columns[] = {(char *) convert_path, INPUT_PATH, COLUMNS_PATH, NULL};
+    char *calculate[] = {(char *) batch_path, "-f", "columns", "-t", "4", COLUMNS_PATH, NULL};
+    char *to_csv[] = {(char *) convert_path, COLUMNS_PATH, OUTPUT_PATH, NULL};
+    char line[LINE_BYTES];
+    FILE *file;
+    size_t i, mismatches = 0;
+
+    ASSERT("Convert path given", convert_path != NULL);
+    file = fopen(INPUT_PATH, "w");
+    ASSERT("Created input", file != NULL);
+    fputs("time,lat,lon,elevation,pressure,temperature,rise,set,visible,status\n", file);
+    for (i = 0; i < ROWS; i++) {
+        fprintf(file,
+                "%lld,%.2f,%.2f,%.1f,%.2f,%.1f,,,,\n",
+                (long long) rows[i].time,
+                rows[i].latitude,
+                rows[i].longitude,
+                rows[i].elevation,
+                rows[i].pressure,
+                rows[i].temperature);
+    }
+    fclose(file);
+
+    ASSERT_EQUALS(0, run(to_columns, NULL, NULL));
+    // The rows with an invalid latitude fail, which fails the run
+    ASSERT_EQUALS(1, run(calculate, NULL, NULL));
+    ASSERT_EQUALS(0, run(to_csv, NULL, NULL));
+
+    file = fopen(OUTPUT_PATH, "r");
+    ASSERT("Opened output", file != NULL);
+    ASSERT("Header",
+           fgets(line, sizeof(line), file) != NULL &&
+               strcmp(line, "time,lat,lon,elevation,pressure,temperature,rise,set,visible,status\n") == 0);
+    for (i = 0; i < ROWS; i++) {
+        SunriseSunsetResult expected;
+        SpaError expected_status = expected_result(&rows[i], &expected);
+        long long time, rise, set;
+        double latitude, longitude, elevation, pressure, temperature;
+        int visible, status;
+        if (fgets(line, sizeof(line), file) == NULL ||
+            sscanf(line,
+                   "%lld,%lf,%lf,%lf,%lf,%lf,%lld,%lld,%d,%d",
+                   &time,
+                   &latitude,
+                   &longitude,
+                   &elevation,
+                   &pressure,
+                   &temperature,
+                   &rise,
+                   &set,
+                   &visible,
+                   &status) != 10) {
+            mismatches++;
+            continue;
+        }
+        // The inputs are kept, and the results are those of sunrise_sunset_calculate()
+        if (time != rows[i].time || latitude != rows[i].latitude || longitude != rows[i].longitude ||
+            elevation != rows[i].elevation || pressure != rows[i].pressure || temperature != rows[i].temperature ||
+            status != (int) expected_status) {
+            mismatches++;
+        } else if (expected_status == SpaError_Success &&
+                   (rise != expected.rise || set != expected.set || (visible != 0) != expected.visible)) {
+            mismatches++;
+        }
+    }
+    ASSERT("Nothing after the rows", fgets(line, sizeof(line), file) == NULL);
+    fclose(file);
+    ASSERT_EQUALS(0, mismatches);
+}
+
+int main(int argc, char *argv[]) {
+    batch_path = argc > 1 ? argv[1] : NULL;
+    convert_path = argc > 2 ? argv[2] : NULL;
+    srand(1);
+    random_rows();
+    RUN(test_csv);
+    RUN(test_ndjson);
+    RUN(test_usage);
+    RUN(test_columns_round_trip);
+    remove(INPUT_PATH);
+    remove(OUTPUT_PATH);
+    remove(COLUMNS_PATH);
+    return TEST_REPORT();
+}
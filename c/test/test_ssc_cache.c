@@ -0,0 +1,266 @@
+//
+//  test_ssc_cache.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+#include "ssc_cache.h"
+#include "util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <tinytest.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+typedef HANDLE test_thread;
+#else
+#include <pthread.h>
+typedef pthread_t test_thread;
+#endif
+
+#define CITIES 50
+#define THREADS 4
+#define THREAD_QUERIES 400
+
+static double latitude[CITIES], longitude[CITIES];
+static unix_t start;
+
+/// Check a result against sunrise_sunset_calculate() at the location, exactly unless it came from the cache
+static bool check_result(const SunriseSunsetParameters *params, const SunriseSunsetResult *result, bool hit) {
+    SunriseSunsetResult expected;
+    int64_t tolerance = hit ? 1 : 0;
+    return sunrise_sunset_calculate(params, &expected) == SpaError_Success && expected.visible == result->visible &&
+           llabs(expected.rise - result->rise) <= tolerance && llabs(expected.set - result->set) <= tolerance;
+}
+
+// A query inside an interval found earlier is answered from the cache
+static void test_hits() {
+    SunriseSunsetCacheConfig config;
+    SunriseSunsetCache *cache;
+    SunriseSunsetCacheStats stats;
+    SunriseSunsetParameters params;
+    SunriseSunsetResult result, first;
+    bool hit;
+    int i;
+
+    SunriseSunsetCacheConfig_init(&config);
+    config.resolution = 0.0;
+    cache = sunrise_sunset_cache_create(&config);
+    ASSERT("Created", cache != NULL);
+    SunriseSunsetParameters_init(&params, start, BRISTOL_LAT, BRISTOL_LON);
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_cache_calculate(cache, &params, &first, &hit));
+    ASSERT("First query misses", !hit);
+    ASSERT("Same as the library", check_result(&params, &first, false));
+
+    // Every hour until the next event is inside the interval
+    for (i = 1; params.time + 3600 < (first.visible ? first.set : first.rise); i++) {
+        params.time += 3600;
+        ASSERT_EQUALS(SpaError_Success, sunrise_sunset_cache_calculate(cache, &params, &result, &hit));
+        ASSERT("Hit", hit);
+        ASSERT_EQUALS(first.rise, result.rise);
+        ASSERT_EQUALS(first.set, result.set);
+        ASSERT("Within a second of the library", check_result(&params, &result, true));
+    }
+    // After the next event is a new interval
+    params.time = (first.visible ? first.set : first.rise) + 60;
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_cache_calculate(cache, &params, &result, &hit));
+    ASSERT("Past the interval misses", !hit);
+    ASSERT("Same as the library", check_result(&params, &result, false));
+
+    sunrise_sunset_cache_stats(cache, &stats);
+    ASSERT_EQUALS(i - 1, (int) stats.hits);
+    ASSERT_EQUALS(2, (int) stats.misses);
+    ASSERT_EQUALS(2, (int) stats.stores);
+    ASSERT_EQUALS(2, (int) stats.entries);
+    ASSERT_EQUALS(0, (int) stats.evictions);
+    sunrise_sunset_cache_destroy(cache);
+}
+
+// Nearby locations share the entries of their rounded location, other parameters do not share entries
+static void test_keys() {
+    SunriseSunsetCacheConfig config;
+    SunriseSunsetCache *cache;
+    SunriseSunsetParameters params, rounded;
+    SunriseSunsetResult result;
+    bool hit;
+
+    SunriseSunsetCacheConfig_init(&config);
+    config.resolution = 0.01;
+    cache = sunrise_sunset_cache_create(&config);
+    ASSERT("Created", cache != NULL);
+    SunriseSunsetParameters_init(&params, start, 51.4545, -2.5879);
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_cache_calculate(cache, &params, &result, &hit));
+    ASSERT("Miss", !hit);
+    rounded = params;
+    rounded.latitude = 5145 * 0.01;
+    rounded.longitude = -259 * 0.01;
+    ASSERT("The events of the rounded location", check_result(&rounded, &result, false));
+
+    params.latitude = 51.4501;
+    params.longitude = -2.5949;
+    params.time += 60;
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_cache_calculate(cache, &params, &result, &hit));
+    ASSERT("Same cell hits", hit);
+    params.latitude = 51.4551;
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_cache_calculate(cache, &params, &result, &hit));
+    ASSERT("Next cell misses", !hit);
+    params.engine = SunriseSunsetEngine_Noaa;
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_cache_calculate(cache, &params, &result, &hit));
+    ASSERT("Other engine misses", !hit);
+    params.engine = SunriseSunsetEngine_Spa;
+    params.pressure = 1000.0;
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_cache_calculate(cache, &params, &result, &hit));
+    ASSERT("Other pressure misses", !hit);
+    sunrise_sunset_cache_destroy(cache);
+}
+
+// Memory is bounded, the least recently used intervals are replaced
+static void test_bounded() {
+    SunriseSunsetCacheConfig config;
+    SunriseSunsetCache *cache;
+    SunriseSunsetCacheStats stats;
+    SunriseSunsetParameters params;
+    SunriseSunsetResult result;
+    bool hit;
+    int i;
+
+    SunriseSunsetCacheConfig_init(&config);
+    config.entries = 64;
+    config.shards = 4;
+    cache = sunrise_sunset_cache_create(&config);
+    ASSERT("Created", cache != NULL);
+    for (i = 0; i < 500; i++) {
+        SunriseSunsetParameters_init(&params, start, -60.0 + 0.25 * i, 0.0);
+        ASSERT_EQUALS(SpaError_Success, sunrise_sunset_cache_calculate(cache, &params, &result, &hit));
+    }
+    sunrise_sunset_cache_stats(cache, &stats);
+    ASSERT_EQUALS(64, (int) stats.capacity);
+    ASSERT_EQUALS(500, (int) stats.misses);
+    ASSERT("Full", stats.entries <= stats.capacity && stats.entries > 32);
+    ASSERT_EQUALS(stats.stores, stats.entries + stats.evictions);
+
+    // The most recent location is still there
+    params.time += 60;
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_cache_calculate(cache, &params, &result, &hit));
+    ASSERT("Recent hits", hit);
+    sunrise_sunset_cache_destroy(cache);
+}
+
+static void test_invalid() {
+    SunriseSunsetCacheConfig config;
+    SunriseSunsetCache *cache;
+    SunriseSunsetParameters params;
+    SunriseSunsetResult result;
+    SunriseSunsetCacheStats stats;
+    bool hit;
+
+    SunriseSunsetCacheConfig_init(&config);
+    config.entries = 0;
+    ASSERT("No entries", sunrise_sunset_cache_create(&config) == NULL);
+    SunriseSunsetCacheConfig_init(&config);
+    config.resolution = -1.0;
+    ASSERT("Negative resolution", sunrise_sunset_cache_create(&config) == NULL);
+    SunriseSunsetCacheConfig_init(&config);
+    cache = sunrise_sunset_cache_create(&config);
+    ASSERT("Created", cache != NULL);
+    SunriseSunsetParameters_init(&params, start, 91.0, 0.0);
+    ASSERT_EQUALS(SpaError_InvalidLatitude, sunrise_sunset_cache_calculate(cache, &params, &result, &hit));
+    SunriseSunsetParameters_init(&params, start, 0.0, 0.0);
+    params.pressure = -1.0;
+    ASSERT_EQUALS(SpaError_InvalidPressure, sunrise_sunset_cache_calculate(cache, &params, &result, &hit));
+    sunrise_sunset_cache_stats(cache, &stats);
+    ASSERT_EQUALS(0, (int) stats.stores);
+    sunrise_sunset_cache_destroy(cache);
+}
+
+typedef struct {
+    SunriseSunsetCache *cache;
+    unsigned seed;
+    int failures;
+} ThreadJob;
+
+/// Query random cities at random times over three days, checking every result
+#ifdef _WIN32
+static DWORD WINAPI query_thread(LPVOID argument) {
+#else
+static void *query_thread(void *argument) {
+#endif
+    ThreadJob *job = (ThreadJob *) argument;
+    SunriseSunsetParameters params;
+    SunriseSunsetResult result;
+    bool hit;
+    int i;
+
+    for (i = 0; i < THREAD_QUERIES; i++) {
+        size_t city;
+        // A linear congruential generator, as rand() is not thread safe
+        job->seed = job->seed * 1103515245u + 12345u;
+        city = (job->seed >> 16) % CITIES;
+        job->seed = job->seed * 1103515245u + 12345u;
+        SunriseSunsetParameters_init(
+            &params, start + (unix_t) ((job->seed >> 8) % (86400u * 3)), latitude[city], longitude[city]);
+        if (sunrise_sunset_cache_calculate(job->cache, &params, &result, &hit) != SpaError_Success ||
+            !check_result(&params, &result, hit)) {
+            job->failures++;
+        }
+    }
+    return 0;
+}
+
+// Threads sharing a cache each get the results they would on their own
+static void test_threads() {
+    SunriseSunsetCacheConfig config;
+    SunriseSunsetCache *cache;
+    SunriseSunsetCacheStats stats;
+    ThreadJob jobs[THREADS];
+    test_thread threads[THREADS];
+    int i;
+
+    SunriseSunsetCacheConfig_init(&config);
+    config.resolution = 0.0;
+    cache = sunrise_sunset_cache_create(&config);
+    ASSERT("Created", cache != NULL);
+    for (i = 0; i < CITIES; i++) {
+        latitude[i] = -55.0 + 2.2 * i;
+        longitude[i] = -170.0 + 6.9 * i;
+    }
+    for (i = 0; i < THREADS; i++) {
+        jobs[i].cache = cache;
+        jobs[i].seed = (unsigned) i + 1;
+        jobs[i].failures = 0;
+#ifdef _WIN32
+        threads[i] = CreateThread(NULL, 0, query_thread, &jobs[i], 0, NULL);
+        ASSERT("Thread started", threads[i] != NULL);
+#else
+        ASSERT_EQUALS(0, pthread_create(&threads[i], NULL, query_thread, &jobs[i]));
+#endif
+    }
+    for (i = 0; i < THREADS; i++) {
+#ifdef _WIN32
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+#else
+        pthread_join(threads[i], NULL);
+#endif
+        ASSERT_EQUALS(0, jobs[i].failures);
+    }
+    sunrise_sunset_cache_stats(cache, &stats);
+    printf("Hits %llu, misses %llu, entries %llu\n",
+           (unsigned long long) stats.hits,
+           (unsigned long long) stats.misses,
+           (unsigned long long) stats.entries);
+    ASSERT_EQUALS(THREADS * THREAD_QUERIES, (int) (stats.hits + stats.misses));
+    // About 6 intervals of each city in 3 days
+    ASSERT("Mostly hits", stats.hits > stats.misses * 2);
+    sunrise_sunset_cache_destroy(cache);
+}
+
+int main() {
+    start = time_t_for_time(2021, 6, 1, 12, 0);
+    RUN(test_hits);
+    RUN(test_keys);
+    RUN(test_bounded);
+    RUN(test_invalid);
+    RUN(test_threads);
+    return TEST_REPORT();
+}
@@ -0,0 +1,158 @@
+//
+//  test_ssc_columns.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+#include "ssc_columns.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <tinytest.h>
+
+#define COLUMNS_PATH "test_ssc_columns.bin"
+#define UNIX_2021 1609459200 // 2021-01-01 00:00
+#define ROWS 1000
+
+// Every column is aligned and the header round trips through ssc_columns_init()
+static void test_layout() {
+    uint32_t mask = SSC_COLUMNS_INPUT | SSC_COLUMNS_RESULT;
+    size_t size = ssc_columns_size(ROWS, mask);
+    double *buffer = (double *) calloc(size / sizeof(double), sizeof(double));
+    ssc_columns created, view;
+    int column;
+
+    ASSERT("Columns follow the header", size >= sizeof(ssc_columns_header) + ROWS * (3 * 8 + 2 * 8 + 1 + 4));
+    ASSERT_EQUALS(SscColumnsError_InvalidColumns, ssc_columns_create(&created, buffer, size - 1, ROWS, mask));
+    ASSERT_EQUALS(SscColumnsError_Success, ssc_columns_create(&created, buffer, size, ROWS, mask));
+    for (column = 0; column < SscColumn_Count; column++) {
+        uint64_t offset = created.header->offsets[column];
+        ASSERT_EQUALS(offset != 0, (mask & SSC_COLUMN(column)) != 0);
+        ASSERT_EQUALS(0, (int) (offset % SSC_COLUMNS_ALIGNMENT));
+    }
+    ASSERT("Absent columns are NULL", created.elevation == NULL && created.pressure == NULL);
+
+    ASSERT_EQUALS(SscColumnsError_Success, ssc_columns_init(&view, buffer, size));
+    ASSERT_EQUALS(ROWS, (int) view.row_count);
+    ASSERT("Same view", view.time == created.time && view.status == created.status);
+    ASSERT_EQUALS(SscColumnsError_InvalidFormat, ssc_columns_init(&view, buffer, size - 1));
+    view.header->version++;
+    ASSERT_EQUALS(SscColumnsError_InvalidFormat, ssc_columns_init(&view, buffer, size));
+    view.header->version--;
+    view.header->offsets[SscColumn_Rise] += SSC_COLUMNS_ALIGNMENT;
+    ASSERT_EQUALS(SscColumnsError_InvalidFormat, ssc_columns_init(&view, buffer, size));
+    view.header->offsets[SscColumn_Rise] -= SSC_COLUMNS_ALIGNMENT;
+    view.header->magic[0] = 'X';
+    ASSERT_EQUALS(SscColumnsError_InvalidFormat, ssc_columns_init(&view, buffer, size));
+    free(buffer);
+}
+
+// A row count whose columns together wrap a size_t is rejected, rather than laid out in a small buffer
+static void test_overflow() {
+    uint32_t mask = SSC_COLUMN(SscColumn_Count) - 1;
+    size_t size = ssc_columns_size(ROWS, mask);
+    size_t wrapping = ((size_t) -1) / 69 + 1;
+    double *buffer = (double *) calloc(size / sizeof(double), sizeof(double));
+    ssc_columns view;
+
+    ASSERT_EQUALS(0, (int) ssc_columns_size(wrapping, mask));
+    ASSERT_EQUALS(SscColumnsError_InvalidColumns, ssc_columns_create(&view, buffer, size, wrapping, mask));
+    ASSERT_EQUALS(SscColumnsError_Success, ssc_columns_create(&view, buffer, size, ROWS, mask));
+    view.header->row_count = wrapping;
+    ASSERT_EQUALS(SscColumnsError_InvalidFormat, ssc_columns_init(&view, buffer, size));
+    free(buffer);
+}
+
+static void fill_rows(ssc_columns *columns, bool atmosphere) {
+    size_t i;
+    srand(11);
+    for (i = 0; i < columns->row_count; i++) {
+        columns->time[i] = UNIX_2021 + rand() % (86400 * 365);
+        columns->latitude[i] = (rand() % 17800 - 8900) / 100.0;
+        columns->longitude[i] = (rand() % 35800 - 17900) / 100.0;
+        if (atmosphere) {
+            columns->elevation[i] = rand() % 2000;
+            columns->pressure[i] = 950 + rand() % 100;
+            columns->temperature[i] = rand() % 40 - 10;
+        }
+    }
+}
+
+// Calculate in place over a mapped file, in two ranges, then check the file against sunrise_sunset_calculate()
+static void check_in_place(bool atmosphere) {
+    uint32_t mask = SSC_COLUMNS_INPUT | SSC_COLUMNS_RESULT | (atmosphere ? SSC_COLUMNS_ATMOSPHERE : 0);
+    SunriseSunsetBatchInput input;
+    SunriseSunsetBatchOutput output;
+    ssc_columns_file file;
+    size_t i;
+
+    ASSERT_EQUALS(SscColumnsError_Success, ssc_columns_create_file(&file, COLUMNS_PATH, ROWS, mask));
+    fill_rows(&file.columns, atmosphere);
+    ssc_columns_unmap_file(&file);
+
+    ASSERT_EQUALS(SscColumnsError_Success, ssc_columns_map_file(&file, COLUMNS_PATH, true));
+    ASSERT_EQUALS(SscColumnsError_Success, ssc_columns_batch_init(&file.columns, 0, 300, &input, &output));
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate_batch(&input, &output));
+    ASSERT_EQUALS(SscColumnsError_Success, ssc_columns_batch_init(&file.columns, 300, ROWS - 300, &input, &output));
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate_batch(&input, &output));
+    ASSERT_EQUALS(SscColumnsError_InvalidColumns,
+                  ssc_columns_batch_init(&file.columns, 300, ROWS - 299, &input, &output));
+    ssc_columns_unmap_file(&file);
+
+    ASSERT_EQUALS(SscColumnsError_Success, ssc_columns_map_file(&file, COLUMNS_PATH, false));
+    ASSERT_EQUALS(ROWS, (int) file.columns.row_count);
+    for (i = 0; i < ROWS; i++) {
+        SunriseSunsetParameters params;
+        SunriseSunsetResult expected;
+        SunriseSunsetParameters_init(
+            &params, file.columns.time[i], file.columns.latitude[i], file.columns.longitude[i]);
+        if (atmosphere) {
+            params.elevation = file.columns.elevation[i];
+            params.pressure = file.columns.pressure[i];
+            params.temperature = file.columns.temperature[i];
+        }
+        ASSERT_EQUALS(SpaError_Success, file.columns.status[i]);
+        ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &expected));
+        ASSERT_EQUALS(expected.visible, file.columns.visible[i]);
+        ASSERT_EQUALS(expected.rise, file.columns.rise[i]);
+        ASSERT_EQUALS(expected.set, file.columns.set[i]);
+    }
+    ssc_columns_unmap_file(&file);
+    remove(COLUMNS_PATH);
+}
+
+static void test_in_place() {
+    check_in_place(false);
+    check_in_place(true);
+}
+
+static void test_errors() {
+    SunriseSunsetBatchInput input;
+    SunriseSunsetBatchOutput output;
+    ssc_columns_file file;
+    FILE *f;
+
+    ASSERT_EQUALS(SscColumnsError_Io, ssc_columns_map_file(&file, "does/not/exist.bin", false));
+    f = fopen(COLUMNS_PATH, "wb");
+    ASSERT("Opened file", f != NULL);
+    fputs("time,lat,lon\n", f);
+    fclose(f);
+    ASSERT_EQUALS(SscColumnsError_InvalidFormat, ssc_columns_map_file(&file, COLUMNS_PATH, false));
+
+    // Input columns only, which can be read but not calculated in place
+    ASSERT_EQUALS(SscColumnsError_Success, ssc_columns_create_file(&file, COLUMNS_PATH, 10, SSC_COLUMNS_INPUT));
+    ASSERT_EQUALS(SscColumnsError_Success, ssc_columns_batch_init(&file.columns, 0, 10, &input, NULL));
+    ASSERT_EQUALS(SscColumnsError_InvalidColumns, ssc_columns_batch_init(&file.columns, 0, 10, &input, &output));
+    ssc_columns_unmap_file(&file);
+    ASSERT_EQUALS(SscColumnsError_Success,
+                  ssc_columns_create_file(&file, COLUMNS_PATH, 10, SSC_COLUMNS_INPUT | SSC_COLUMN(SscColumn_Pressure)));
+    ASSERT_EQUALS(SscColumnsError_InvalidColumns, ssc_columns_batch_init(&file.columns, 0, 10, &input, NULL));
+    ssc_columns_unmap_file(&file);
+    remove(COLUMNS_PATH);
+}
+
+int main() {
+    RUN(test_layout);
+    RUN(test_overflow);
+    RUN(test_in_place);
+    RUN(test_errors);
+    return TEST_REPORT();
+}
@@ -0,0 +1,188 @@
+//
+//  test_ssc_cpp.cpp
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+#include "ssc.hpp"
+#include "../test/util.h"
+#include <cstdio>
+#include <cstdlib>
+#include <tinytest.h>
+
+#define UNIX_2021 1609459200 // 2021-01-01 00:00
+
+using NoaaCalculator = ssc::Calculator<ssc::Noaa>;
+
+// A year of sunrises and sunsets in Bristol, baked in at compile time
+static constexpr auto bristol_2021 = NoaaCalculator(BRISTOL_LAT, BRISTOL_LON).table<365>(UNIX_2021 + 43200, 86400);
+static_assert(bristol_2021[0].visible, "Noon is in daylight");
+static_assert(bristol_2021[0].rise < UNIX_2021 + 43200 && UNIX_2021 + 43200 < bristol_2021[0].set,
+              "Noon is between sunrise and sunset");
+static_assert(bristol_2021[171].set - bristol_2021[171].rise > bristol_2021[0].set - bristol_2021[0].rise,
+              "Midsummer is longer than new year");
+
+// Visibility only, a single evaluation each
+static constexpr auto bristol_visible =
+    ssc::Calculator<ssc::Noaa, double, ssc::PredictorSearch, ssc::Visible>(BRISTOL_LAT, BRISTOL_LON)
+        .table<24>(UNIX_2021, 3600);
+static_assert(!bristol_visible[0].visible && bristol_visible[12].visible && bristol_visible[12].rise == 0,
+              "Midnight is dark, noon is light");
+
+// Every event of the constant evaluated table against the C library with the NOAA engine
+template <std::size_t N>
+static void compare_with_library(const std::array<ssc::Result, N> &expected_table,
+                                 SunriseSunsetParameters params,
+                                 std::int64_t interval,
+                                 std::int64_t tolerance) {
+    std::int64_t max_error = 0;
+    std::size_t identical = 0;
+    for (std::size_t i = 0; i < N; i++) {
+        SunriseSunsetResult result;
+        ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &result));
+        ASSERT_EQUALS(result.visible, expected_table[i].visible);
+        std::int64_t error = std::llabs(result.rise - expected_table[i].rise);
+        error = std::llabs(result.set - expected_table[i].set) > error ? std::llabs(result.set - expected_table[i].set)
+                                                                     : error;
+        max_error = error > max_error ? error : max_error;
+        identical += error == 0;
+        params.time += interval;
+    }
+    printf("Identical: %zu of %zu, max error %llds\n", identical, N, static_cast<long long>(max_error));
+    ASSERT("Within tolerance", max_error <= tolerance);
+}
+
+static void test_constexpr_table() {
+    SunriseSunsetParameters params;
+    ASSERT_EQUALS(time_t_for_time(2021, 1, 1, 0, 0), UNIX_2021);
+    SunriseSunsetParameters_init(&params, UNIX_2021 + 43200, BRISTOL_LAT, BRISTOL_LON);
+    params.engine = SunriseSunsetEngine_Noaa;
+    compare_with_library(bristol_2021, params, 86400, 1);
+}
+
+// Polar night and day through the step search, at a time of day that changes through the year
+static void test_constexpr_step_search() {
+    constexpr auto svalbard = ssc::Calculator<ssc::Noaa, double, ssc::StepSearch>(SVALBARD_LAT, SVALBARD_LON)
+                                  .table<24>(UNIX_2021 + 1800, 86400 * 15 + 3600);
+    SunriseSunsetParameters params;
+    SunriseSunsetParameters_init(&params, UNIX_2021 + 1800, SVALBARD_LAT, SVALBARD_LON);
+    params.engine = SunriseSunsetEngine_Noaa;
+    compare_with_library(svalbard, params, 86400 * 15 + 3600, 1);
+}
+
+// A custom atmosphere works out the horizon of the search from its refraction correction
+static void test_constexpr_custom_atmosphere() {
+    using Custom = ssc::Calculator<ssc::Noaa, double, ssc::PredictorSearch, ssc::All, ssc::CustomAtmosphere>;
+    constexpr auto adelaide = Custom(ADELAIDE_LAT, ADELAIDE_LON, 500.0, 950.0, 30.0, 0.7).table<30>(UNIX_2021, 43205);
+    SunriseSunsetParameters params;
+    SunriseSunsetParameters_init(&params, UNIX_2021, ADELAIDE_LAT, ADELAIDE_LON);
+    params.engine = SunriseSunsetEngine_Noaa;
+    params.elevation = 500.0;
+    params.pressure = 950.0;
+    params.temperature = 30.0;
+    params.atmos_refract = 0.7;
+    compare_with_library(adelaide, params, 43205, 1);
+}
+
+// Float arithmetic keeps the events within a few seconds
+static void test_constexpr_float() {
+    constexpr auto narrow = ssc::Calculator<ssc::Noaa, float>(BRISTOL_LAT, BRISTOL_LON).table<365>(UNIX_2021 + 43200,
+                                                                                                    86400);
+    std::int64_t max_error = 0;
+    for (std::size_t i = 0; i < narrow.size(); i++) {
+        ASSERT_EQUALS(bristol_2021[i].visible, narrow[i].visible);
+        max_error = std::llabs(bristol_2021[i].rise - narrow[i].rise) > max_error
+                        ? std::llabs(bristol_2021[i].rise - narrow[i].rise)
+                        : max_error;
+        max_error = std::llabs(bristol_2021[i].set - narrow[i].set) > max_error
+                        ? std::llabs(bristol_2021[i].set - narrow[i].set)
+                        : max_error;
+    }
+    printf("Max float error %llds\n", static_cast<long long>(max_error));
+    ASSERT("Within 5 seconds", max_error <= 5);
+}
+
+// The same engine, precision and search as a calculator, with other outputs and atmosphere
+template <class Calculator, unsigned Outputs, class Atmosphere = ssc::StandardAtmosphere>
+using With = ssc::Calculator<typename Calculator::engine_type,
+                             typename Calculator::precision_type,
+                             typename std::conditional<Calculator::search == SunriseSunsetSearch_Step,
+                                                       ssc::StepSearch,
+                                                       ssc::PredictorSearch>::type,
+                             Outputs,
+                             Atmosphere>;
+
+// calculate() gives the same result as the C library for each configuration
+template <class Calculator> static void check_calculate(SunriseSunsetEngine engine, SunriseSunsetSearch search) {
+    Calculator calculator(STLOUIS_LAT, STLOUIS_LON);
+    for (int i = 0; i < 20; i++) {
+        unix_t time = UNIX_2021 + i * 86400 * 17 + i * 3600;
+        SunriseSunsetParameters params;
+        SunriseSunsetResult expected;
+        SunriseSunsetParameters_init(&params, time, STLOUIS_LAT, STLOUIS_LON);
+        params.engine = engine;
+        params.search = search;
+        ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &expected));
+        ssc::Result actual = calculator.calculate(time);
+        ASSERT_EQUALS(expected.visible, actual.visible);
+        ASSERT_EQUALS(expected.rise, actual.rise);
+        ASSERT_EQUALS(expected.set, actual.set);
+        ssc::Result visible = ssc::Calculator<typename Calculator::engine_type,
+                                              typename Calculator::precision_type,
+                                              ssc::StepSearch,
+                                              ssc::Visible>(STLOUIS_LAT, STLOUIS_LON)
+                                  .calculate(time);
+        ASSERT_EQUALS(expected.visible, visible.visible);
+
+        // A single event is only searched for in its direction, to the first second of the new visibility
+        ssc::Result rise = With<Calculator, ssc::Rise>(STLOUIS_LAT, STLOUIS_LON).calculate(time);
+        ssc::Result set = With<Calculator, ssc::Visible | ssc::Set>(STLOUIS_LAT, STLOUIS_LON).calculate(time);
+        ASSERT_EQUALS(expected.visible, rise.visible);
+        ASSERT_EQUALS(expected.visible, set.visible);
+        ASSERT("Sunrise within 1s", std::llabs(expected.rise - rise.rise) <= 1 && rise.set == 0);
+        ASSERT("Sunset within 1s", std::llabs(expected.set - set.set) <= 1 && set.rise == 0);
+
+        // The visibility with a custom atmosphere goes through the refraction correction
+        ssc::Result custom = With<Calculator, ssc::Visible, ssc::CustomAtmosphere>(STLOUIS_LAT,
+                                                                                   STLOUIS_LON,
+                                                                                   SSC_DEFAULT_ELEVATION,
+                                                                                   SSC_DEFAULT_PRESSURE,
+                                                                                   SSC_DEFAULT_TEMPERATURE,
+                                                                                   SSC_DEFAULT_ATMOSPHERIC_REFRACTION)
+                                 .calculate(time);
+        ASSERT_EQUALS(expected.visible, custom.visible);
+    }
+}
+
+static void test_calculate() {
+    check_calculate<ssc::Calculator<>>(SunriseSunsetEngine_Spa, SunriseSunsetSearch_Predictor);
+    check_calculate<ssc::Calculator<ssc::Spa, float>>(SunriseSunsetEngine_SpaFloat, SunriseSunsetSearch_Predictor);
+    check_calculate<ssc::Calculator<ssc::Noaa, double, ssc::StepSearch>>(SunriseSunsetEngine_Noaa,
+                                                                         SunriseSunsetSearch_Step);
+}
+
+static void test_errors() {
+    bool thrown = false;
+    try {
+        ssc::Calculator<>(91.0, 0.0).calculate(UNIX_2021);
+    } catch (const ssc::Error &error) {
+        thrown = error.code() == SpaError_InvalidLatitude;
+    }
+    ASSERT("Invalid latitude", thrown);
+    thrown = false;
+    try {
+        NoaaCalculator(0.0, 181.0).evaluate(UNIX_2021);
+    } catch (const ssc::Error &error) {
+        thrown = error.code() == SpaError_InvalidLongitude;
+    }
+    ASSERT("Invalid longitude", thrown);
+}
+
+int main() {
+    RUN(test_constexpr_table);
+    RUN(test_constexpr_step_search);
+    RUN(test_constexpr_custom_atmosphere);
+    RUN(test_constexpr_float);
+    RUN(test_calculate);
+    RUN(test_errors);
+    return TEST_REPORT();
+}
@@ -0,0 +1,99 @@
+//
+//  test_ssc_grid.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+#include "ssc_grid.h"
+#include "util.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <tinytest.h>
+
+#define MAX_CELLS 20000
+
+static unix_t rise[MAX_CELLS], set[MAX_CELLS];
+static bool visible[MAX_CELLS], exact[MAX_CELLS];
+
+// A grid against sunrise_sunset_calculate() at every cell
+static void test_grid_impl(time_t day, double latitude, double step, size_t rows, size_t columns, double max_exact) {
+    SunriseSunsetGridOutput output = {set, rise, visible, exact};
+    SunriseSunsetGrid grid;
+    SunriseSunsetParameters params;
+    SunriseSunsetResult result;
+    int64_t max_error = 0;
+    size_t row, column, exact_count = 0;
+
+    SunriseSunsetGrid_init(&grid, latitude, -10.0, step, step, rows, columns);
+    grid.params.search = SunriseSunsetSearch_Predictor;
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_grid_calculate(&grid, day, &output));
+
+    for (row = 0; row < rows; row++) {
+        for (column = 0; column < columns; column++) {
+            size_t i = row * columns + column;
+            double longitude = -10.0 + step * (double) column;
+            SunriseSunsetParameters_init(&params,
+                                         day + 43200 - (unix_t) floor(longitude * 240.0 + 0.5),
+                                         latitude + step * (double) row,
+                                         longitude);
+            params.search = SunriseSunsetSearch_Predictor;
+            ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &result));
+            ASSERT_EQUALS(result.visible, visible[i]);
+            if (exact[i]) {
+                exact_count++;
+                ASSERT_EQUALS(result.rise, rise[i]);
+                ASSERT_EQUALS(result.set, set[i]);
+            }
+            max_error = llabs(result.rise - rise[i]) > max_error ? llabs(result.rise - rise[i]) : max_error;
+            max_error = llabs(result.set - set[i]) > max_error ? llabs(result.set - set[i]) : max_error;
+        }
+    }
+    printf("Exact cells: %zu of %zu (%.1f%%), max error %llds\n",
+           exact_count,
+           rows * columns,
+           100.0 * (double) exact_count / (double) (rows * columns),
+           (long long) max_error);
+    ASSERT("Within the tolerance", max_error <= (int64_t) grid.tolerance);
+    ASSERT("Interpolated", (double) exact_count <= max_exact * (double) (rows * columns));
+}
+
+static void test_grid() {
+    // 0.25 degrees from 60S to 60N, where the sun rises and sets every day
+    test_grid_impl(time_t_for_time(2021, 3, 20, 0, 0), -60.0, 0.25, 481, 41, 0.1);
+    test_grid_impl(time_t_for_time(2021, 9, 1, 0, 0), -60.0, 0.25, 481, 41, 0.1);
+    test_grid_impl(time_t_for_time(2021, 12, 21, 0, 0), -60.0, 0.25, 481, 41, 0.1);
+
+    // Into polar day at the arctic circle, which is refined down to single cells
+    test_grid_impl(time_t_for_time(2021, 6, 21, 0, 0), 62.0, 0.1, 51, 9, 1.0);
+}
+
+static void test_grid_shapes() {
+    SunriseSunsetGridOutput output = {set, rise, visible, exact};
+    SunriseSunsetGrid grid;
+    time_t day = time_t_for_time(2021, 7, 28, 0, 0);
+    size_t i;
+
+    // A single cell, a single row, and a grid that does not divide into blocks, all calculated exactly
+    SunriseSunsetGrid_init(&grid, BRISTOL_LAT, BRISTOL_LON, 0.1, 0.1, 1, 1);
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_grid_calculate(&grid, day, &output));
+    ASSERT("Exact", exact[0]);
+    SunriseSunsetGrid_init(&grid, BRISTOL_LAT, BRISTOL_LON, 0.1, 0.1, 1, 37);
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_grid_calculate(&grid, day, &output));
+    SunriseSunsetGrid_init(&grid, BRISTOL_LAT, BRISTOL_LON, -0.1, 0.1, 19, 37);
+    grid.block_size = 4;
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_grid_calculate(&grid, day, &output));
+    for (i = 0; i < 19 * 37; i += 4 * 37) {
+        ASSERT("Lattice is exact", exact[i]);
+    }
+    ASSERT("Last cell is exact", exact[19 * 37 - 1]);
+
+    // Invalid cells
+    SunriseSunsetGrid_init(&grid, 80.0, 0.0, 1.0, 1.0, 20, 1);
+    ASSERT_EQUALS(SpaError_InvalidLatitude, sunrise_sunset_grid_calculate(&grid, day, &output));
+}
+
+int main() {
+    RUN(test_grid);
+    RUN(test_grid_shapes);
+    return TEST_REPORT();
+}
@@ -0,0 +1,105 @@
+//
+//  test_ssc_noaa.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+#include "spa_noaa.h"
+#include "ssc.h"
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include <tinytest.h>
+
+#define UNIX_J2000 946728000 // 2000-01-01 12:00
+#define SECONDS_PER_YEAR 31557600
+
+// Geocentric position error against the SPA over the whole supported date range
+static void test_ephemeris_error() {
+    spa_ephemeris expected, actual;
+    double max_alpha = 0, max_delta = 0, max_nu = 0;
+    int year, day;
+
+    printf("Year   Max alpha error  Max delta error  [degrees]\n");
+    for (year = -2000; year <= 6000; year += 500) {
+        double alpha = 0, delta = 0;
+        for (day = 0; day < 365; day += 3) {
+            // The range starts at the first day of -2000 and ends at the last day of 6000
+            double jd = 990576.0 + (year + 2000) * 365.25 + day + 0.37 - (year == 6000 ? 366 : 0);
+            ASSERT_EQUALS(SpaError_Success, spa_calculate_ephemeris(&expected, jd, 0));
+            ASSERT_EQUALS(SpaError_Success, spa_noaa_calculate_ephemeris(&actual, jd, 0));
+            alpha = fmax(alpha, fabs(remainder(expected.alpha - actual.alpha, 360.0)));
+            delta = fmax(delta, fabs(expected.delta - actual.delta));
+            max_nu = fmax(max_nu, fabs(remainder(expected.nu - actual.nu, 360.0)));
+        }
+        printf("%5d  %15.4f  %15.4f\n", year, alpha, delta);
+        max_alpha = fmax(max_alpha, alpha);
+        max_delta = fmax(max_delta, delta);
+    }
+    ASSERT("Alpha within 0.03 degrees", max_alpha < 0.03);
+    ASSERT("Delta within 0.012 degrees", max_delta < 0.012);
+    ASSERT("Nu within 0.001 degrees", max_nu < 0.001);
+
+    ASSERT_EQUALS(SpaError_UnsupportedDate, spa_noaa_calculate_ephemeris(&actual, 990575.0, 0));
+    ASSERT_EQUALS(SpaError_UnsupportedDate, spa_noaa_calculate_ephemeris(&actual, 3912881.0, 0));
+    ASSERT_EQUALS(SpaError_InvalidDeltaT, spa_noaa_calculate_ephemeris(&actual, 2451545.0, 9000));
+}
+
+// Sunrise and sunset error against the SPA for latitude bands and dates across the supported range
+static void test_sunrise_sunset_error() {
+    double latitudes[] = {-60.0, -45.0, -30.0, -15.0, 0.0, 15.0, 30.0, 45.0, 60.0, 66.0};
+    int years[] = {-1999, -1000, 0, 1000, 2000, 3000, 4000, 5000, 5999};
+    SunriseSunsetParameters params;
+    SunriseSunsetResult expected, actual;
+    size_t i, j;
+    int k;
+
+    printf("Latitude  Max sunrise/sunset error [seconds]\n");
+    for (i = 0; i < sizeof(latitudes) / sizeof(latitudes[0]); i++) {
+        int64_t max_error = 0;
+        for (j = 0; j < sizeof(years) / sizeof(years[0]); j++) {
+            for (k = 0; k < 12; k++) {
+                unix_t time = UNIX_J2000 + (int64_t) (years[j] - 2000) * SECONDS_PER_YEAR + k * 30 * 86400 + 3600 * k;
+                SunriseSunsetParameters_init(&params, time, latitudes[i], 30.0 * k - 165.0);
+                params.search = SunriseSunsetSearch_Predictor;
+                ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &expected));
+                params.engine = SunriseSunsetEngine_Noaa;
+                ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &actual));
+                ASSERT_EQUALS(expected.visible, actual.visible);
+                max_error = llabs(expected.rise - actual.rise) > max_error ? llabs(expected.rise - actual.rise)
+                                                                           : max_error;
+                max_error = llabs(expected.set - actual.set) > max_error ? llabs(expected.set - actual.set)
+                                                                         : max_error;
+            }
+        }
+        printf("%8.1f  %lld\n", latitudes[i], (long long) max_error);
+        // Within a minute, which is the accuracy this engine is intended for
+        ASSERT("Within a minute", max_error <= 60);
+    }
+}
+
+static double seconds_per_call(SunriseSunsetEngine engine, int count) {
+    SunriseSunsetParameters params;
+    SunriseSunsetResult result;
+    clock_t start = clock();
+    int i;
+    for (i = 0; i < count; i++) {
+        SunriseSunsetParameters_init(&params, UNIX_J2000 + (unix_t) i * 97 * 3600, -55.0 + i % 110, i % 360 - 180.0);
+        params.engine = engine;
+        sunrise_sunset_calculate(&params, &result);
+    }
+    return (double) (clock() - start) / CLOCKS_PER_SEC / count;
+}
+
+// Timings are only printed, as they depend on the machine and its load
+static void test_throughput() {
+    double spa = seconds_per_call(SunriseSunsetEngine_Spa, 500);
+    double noaa = seconds_per_call(SunriseSunsetEngine_Noaa, 500);
+    printf("SPA: %.1f us/call, NOAA: %.1f us/call, %.1fx faster\n", spa * 1e6, noaa * 1e6, spa / noaa);
+}
+
+int main() {
+    RUN(test_ephemeris_error);
+    RUN(test_sunrise_sunset_error);
+    RUN(test_throughput);
+    return TEST_REPORT();
+}
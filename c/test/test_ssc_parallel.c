@@ -0,0 +1,91 @@
+//
+//  test_ssc_parallel.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+#include "ssc_parallel.h"
+#include "util.h"
+#include <stdio.h>
+#include <tinytest.h>
+
+#define LOCATIONS 40
+#define DAYS 30
+
+static double latitude[LOCATIONS], longitude[LOCATIONS];
+static unix_t set[LOCATIONS * DAYS], rise[LOCATIONS * DAYS];
+static bool visible[LOCATIONS * DAYS];
+static SpaError status[LOCATIONS * DAYS];
+
+static void test_parallel_impl(size_t threads, size_t chunk_size, SunriseSunsetAggregateStats *stats) {
+    SunriseSunsetBatchOutput output = {set, rise, visible, status, stats};
+    SunriseSunsetParallelJob job;
+    SunriseSunsetParameters params;
+    SunriseSunsetResult result;
+    time_t start = time_t_for_time(2021, 6, 1, 12, 0);
+    size_t location, day;
+
+    SunriseSunsetParallelJob_init(&job, LOCATIONS, latitude, longitude, start, DAYS);
+    job.threads = threads;
+    job.chunk_size = chunk_size;
+    SunriseSunsetAggregateStats_init(stats);
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_parallel_run(&job, &output));
+    ASSERT_EQUALS(LOCATIONS * DAYS, stats->calls);
+
+    // Every item in its own place, the same as calculating it on its own
+    for (location = 0; location < LOCATIONS; location++) {
+        for (day = 0; day < DAYS; day++) {
+            size_t i = location * DAYS + day;
+            SunriseSunsetParameters_init(
+                &params, start + (unix_t) day * 86400, latitude[location], longitude[location]);
+            ASSERT_EQUALS(SpaError_Success, sunrise_sunset_calculate(&params, &result));
+            ASSERT_EQUALS(SpaError_Success, status[i]);
+            ASSERT_EQUALS(result.set, set[i]);
+            ASSERT_EQUALS(result.rise, rise[i]);
+            ASSERT_EQUALS(result.visible, visible[i]);
+        }
+    }
+}
+
+static void test_parallel() {
+    SunriseSunsetBatchOutput output = {set, rise, visible, status, NULL};
+    SunriseSunsetParallelJob job;
+    SunriseSunsetAggregateStats single, multiple;
+    size_t i;
+
+    // High latitudes with short search steps first, so the first threads have the most work and the others steal it
+    for (i = 0; i < LOCATIONS; i++) {
+        latitude[i] = 65.0 - 3.25 * (double) i;
+        longitude[i] = -180.0 + 9.0 * (double) i;
+    }
+    test_parallel_impl(1, 64, &single);
+    test_parallel_impl(4, 64, &multiple);
+    test_parallel_impl(7, 5, &multiple);
+    test_parallel_impl(64, 1, &multiple);
+
+    // The statistics do not depend on the number of threads
+    ASSERT_EQUALS(single.evaluations, multiple.evaluations);
+    ASSERT_EQUALS(single.steps, multiple.steps);
+    ASSERT_EQUALS(single.bisections, multiple.bisections);
+    ASSERT_EQUALS(single.max_evaluations, multiple.max_evaluations);
+    ASSERT_EQUALS(single.max_span, multiple.max_span);
+
+    // The first failed item is returned, and the others are still calculated
+    latitude[3] = 91.0;
+    latitude[9] = -91.0;
+    SunriseSunsetParallelJob_init(&job, LOCATIONS, latitude, longitude, time_t_for_time(2021, 6, 1, 12, 0), DAYS);
+    job.threads = 4;
+    ASSERT_EQUALS(SpaError_InvalidLatitude, sunrise_sunset_parallel_run(&job, &output));
+    ASSERT_EQUALS(SpaError_InvalidLatitude, status[3 * DAYS]);
+    ASSERT_EQUALS(SpaError_InvalidLatitude, status[9 * DAYS + DAYS - 1]);
+    ASSERT_EQUALS(SpaError_Success, status[4 * DAYS]);
+
+    // Nothing to do
+    SunriseSunsetParallelJob_init(&job, 0, latitude, longitude, 0, DAYS);
+    ASSERT_EQUALS(SpaError_Success, sunrise_sunset_parallel_run(&job, &output));
+}
+
+int main() {
+    printf("Processors: %zu\n", sunrise_sunset_parallel_processors());
+    RUN(test_parallel);
+    return TEST_REPORT();
+}
@@ -0,0 +1,275 @@
+//
+//  test_sscd.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+//  Starts the sscd executable given as the first argument and drives it with the client in ssc_daemon.h.
+//
+#include "ssc_daemon.h"
+#include <signal.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <tinytest.h>
+#include <unistd.h>
+
+#define SOCKET_PATH "test_sscd.sock"
+#define UNIX_2021 1609459200 // 2021-01-01 00:00
+#define QUERIES 200
+#define PIPELINED 16
+#define SLOW_QUERIES 4096
+/// Requests the slow reader gives up sending after, far more than the daemon should read ahead
+#define SLOW_REQUESTS 2000
+
+static const char *daemon_path;
+static pid_t daemon_pid;
+static uint64_t sent_queries, sent_calculations;
+
+static void random_queries(ssc_daemon_query *queries, size_t count) {
+    size_t i;
+    for (i = 0; i < count; i++) {
+        queries[i].time = UNIX_2021 + rand() % (86400 * 365);
+        queries[i].latitude = (rand() % 17800 - 8900) / 100.0;
+        queries[i].longitude = (rand() % 35800 - 17900) / 100.0;
+    }
+}
+
+/// Check a result against sunrise_sunset_calculate(), exactly unless it came from the cache
+static bool check_result(const ssc_daemon_query *query,
+                         const ssc_daemon_result *result,
+                         SunriseSunsetSearch search,
+                         SunriseSunsetEngine engine) {
+    SunriseSunsetParameters params;
+    SunriseSunsetResult expected;
+    int64_t tolerance = result->cached ? 1 : 0;
+    SunriseSunsetParameters_init(&params, query->time, query->latitude, query->longitude);
+    params.search = search;
+    params.engine = engine;
+    return (int32_t) sunrise_sunset_calculate(&params, &expected) == result->status && result->status == 0 &&
+           expected.visible == (result->visible != 0) && llabs(expected.rise - result->rise) <= tolerance &&
+           llabs(expected.set - result->set) <= tolerance;
+}
+
+static void test_start() {
+    char *arguments[] = {(char *) daemon_path, "-t", "2", "-c", "4096", SOCKET_PATH, NULL};
+    ssc_daemon_client client;
+    FILE *file;
+    int attempt, status = -1;
+
+    ASSERT("Daemon path given", daemon_path != NULL);
+    // A file that is not a socket is not replaced
+    file = fopen(SOCKET_PATH, "w");
+    ASSERT("Created file", file != NULL);
+    fputs("data", file);
+    fclose(file);
+    ASSERT_EQUALS(0, posix_spawn(&daemon_pid, daemon_path, NULL, NULL, arguments, NULL));
+    ASSERT_EQUALS(daemon_pid, waitpid(daemon_pid, &status, 0));
+    ASSERT("Refused to start", WIFEXITED(status) && WEXITSTATUS(status) == 1);
+    file = fopen(SOCKET_PATH, "r");
+    ASSERT("File kept", file != NULL && fgetc(file) == 'd');
+    fclose(file);
+    remove(SOCKET_PATH);
+
+    ASSERT_EQUALS(0, posix_spawn(&daemon_pid, daemon_path, NULL, NULL, arguments, NULL));
+    // Wait for the daemon to listen
+    for (attempt = 0; attempt < 500 && ssc_daemon_connect(&client, SOCKET_PATH) != SscDaemonError_Success;
+         attempt++) {
+        usleep(10000);
+    }
+    ASSERT("Connected", client.socket >= 0);
+    ssc_daemon_disconnect(&client);
+}
+
+// Queries are answered as the library would, and repeating them is answered from the cache
+static void test_calculate() {
+    ssc_daemon_query queries[QUERIES];
+    ssc_daemon_result results[QUERIES];
+    ssc_daemon_client client;
+    int i, cached = 0;
+
+    srand(3);
+    random_queries(queries, QUERIES);
+    ASSERT_EQUALS(SscDaemonError_Success, ssc_daemon_connect(&client, SOCKET_PATH));
+    ASSERT_EQUALS(SscDaemonError_Success,
+                  ssc_daemon_calculate(
+                      &client, SunriseSunsetSearch_Step, SunriseSunsetEngine_Spa, queries, QUERIES, results));
+    for (i = 0; i < QUERIES; i++) {
+        ASSERT_EQUALS(0, results[i].cached);
+        ASSERT("Same as the library", check_result(&queries[i], &results[i], SunriseSunsetSearch_Step, 0));
+    }
+
+    // An hour later is usually still between the same events
+    for (i = 0; i < QUERIES; i++) {
+        queries[i].time += 3600;
+    }
+    ASSERT_EQUALS(SscDaemonError_Success,
+                  ssc_daemon_calculate(
+                      &client, SunriseSunsetSearch_Step, SunriseSunsetEngine_Spa, queries, QUERIES, results));
+    for (i = 0; i < QUERIES; i++) {
+        cached += results[i].cached;
+        ASSERT("Within a second of the library", check_result(&queries[i], &results[i], SunriseSunsetSearch_Step, 0));
+    }
+    printf("Cached: %d of %d\n", cached, QUERIES);
+    ASSERT("Mostly cached", cached > QUERIES / 2);
+    ssc_daemon_disconnect(&client);
+    sent_queries += 2 * QUERIES;
+    sent_calculations += 2;
+}
+
+// Many requests sent before any response is read, each answered once with its own id
+static void test_pipelining() {
+    static ssc_daemon_query queries[PIPELINED][QUERIES];
+    ssc_daemon_result results[QUERIES];
+    bool answered[PIPELINED] = {false};
+    ssc_daemon_header header;
+    ssc_daemon_client client;
+    uint32_t id;
+    int i;
+
+    srand(4);
+    ASSERT_EQUALS(SscDaemonError_Success, ssc_daemon_connect(&client, SOCKET_PATH));
+    for (id = 0; id < PIPELINED; id++) {
+        random_queries(queries[id], QUERIES);
+        header.type = SscDaemonMessage_Calculate;
+        header.search = (uint8_t) (id % 3);
+        header.engine = (uint8_t) (id / 3 % 3);
+        header.id = id;
+        header.count = QUERIES - id;
+        ASSERT_EQUALS(SscDaemonError_Success, ssc_daemon_send(&client, &header, queries[id]));
+    }
+    for (i = 0; i < PIPELINED; i++) {
+        ASSERT_EQUALS(SscDaemonError_Success, ssc_daemon_receive(&client, &header, results, sizeof(results)));
+        ASSERT_EQUALS(SscDaemonMessage_Calculate, header.type);
+        ASSERT("Known id", header.id < PIPELINED && !answered[header.id]);
+        ASSERT_EQUALS(QUERIES - header.id, header.count);
+        answered[header.id] = true;
+        for (id = 0; id < header.count; id++) {
+            ASSERT("Same as the library",
+                   check_result(&queries[header.id][id],
+                                &results[id],
+                                (SunriseSunsetSearch) header.search,
+                                (SunriseSunsetEngine) header.engine));
+        }
+        sent_queries += header.count;
+    }
+    ssc_daemon_disconnect(&client);
+    sent_calculations += PIPELINED;
+}
+
+// A request that is not valid closes its connection without affecting others
+static void test_invalid_request() {
+    ssc_daemon_client client, other;
+    ssc_daemon_header header = {0, SscDaemonMessage_Calculate, 7, 0, 0, 0};
+    ssc_daemon_stats stats;
+
+    ASSERT_EQUALS(SscDaemonError_Success, ssc_daemon_connect(&client, SOCKET_PATH));
+    ASSERT_EQUALS(SscDaemonError_Success, ssc_daemon_connect(&other, SOCKET_PATH));
+    ASSERT_EQUALS(SscDaemonError_Success, ssc_daemon_send(&client, &header, NULL));
+    ASSERT_EQUALS(SscDaemonError_Io, ssc_daemon_receive(&client, &header, NULL, 0));
+    ASSERT_EQUALS(SscDaemonError_Success, ssc_daemon_stats_query(&other, &stats));
+    ssc_daemon_disconnect(&client);
+    ssc_daemon_disconnect(&other);
+}
+
+static void test_stats() {
+    ssc_daemon_client client;
+    ssc_daemon_stats stats;
+    uint64_t latency_count = 0;
+    int i;
+
+    ASSERT_EQUALS(SscDaemonError_Success, ssc_daemon_connect(&client, SOCKET_PATH));
+    ASSERT_EQUALS(SscDaemonError_Success, ssc_daemon_stats_query(&client, &stats));
+    for (i = 0; i < SSC_DAEMON_LATENCY_BUCKETS; i++) {
+        latency_count += stats.latency[i];
+    }
+    printf("Hits %llu, misses %llu, max queue depth %llu\n",
+           (unsigned long long) stats.cache_hits,
+           (unsigned long long) stats.cache_misses,
+           (unsigned long long) stats.max_queue_depth);
+    ASSERT_EQUALS(sent_queries, stats.queries);
+    ASSERT_EQUALS(stats.queries, stats.cache_hits + stats.cache_misses);
+    ASSERT("Some hits", stats.cache_hits > 0);
+    ASSERT_EQUALS(sent_calculations, latency_count);
+    // Each calculation and the stats requests of this test and test_invalid_request()
+    ASSERT_EQUALS(sent_calculations + 2, stats.requests);
+    ASSERT_EQUALS(0, (int) stats.queue_depth);
+    ASSERT("Queued while pipelining", stats.max_queue_depth >= 1);
+    ASSERT_EQUALS(2, (int) stats.workers);
+    ASSERT("Every connection counted", stats.connections >= 6);
+    ssc_daemon_disconnect(&client);
+}
+
+// A client that pipelines requests and never reads the responses is stopped being read, without holding up others
+static void test_slow_reader() {
+    static ssc_daemon_query queries[SLOW_QUERIES];
+    ssc_daemon_result results[QUERIES];
+    ssc_daemon_header header = {0, SscDaemonMessage_Calculate, 0, 0, 0, SLOW_QUERIES};
+    struct timeval timeout = {1, 0};
+    ssc_daemon_client slow, other;
+    int sent, i;
+
+    // The same query throughout, which is answered from the cache so the responses pile up quickly
+    for (i = 0; i < SLOW_QUERIES; i++) {
+        queries[i].time = UNIX_2021;
+        queries[i].latitude = 51.4545;
+        queries[i].longitude = -2.5879;
+    }
+    ASSERT_EQUALS(SscDaemonError_Success, ssc_daemon_connect(&slow, SOCKET_PATH));
+    ASSERT_EQUALS(0, setsockopt(slow.socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)));
+    for (sent = 0; sent < SLOW_REQUESTS && ssc_daemon_send(&slow, &header, queries) == SscDaemonError_Success;
+         sent++) {
+    }
+    printf("Sent %d requests before the daemon stopped reading\n", sent);
+    ASSERT("Daemon stopped reading", sent < SLOW_REQUESTS);
+
+    srand(5);
+    random_queries(queries, QUERIES);
+    timeout.tv_sec = 5;
+    ASSERT_EQUALS(SscDaemonError_Success, ssc_daemon_connect(&other, SOCKET_PATH));
+    ASSERT_EQUALS(0, setsockopt(other.socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)));
+    ASSERT_EQUALS(SscDaemonError_Success,
+                  ssc_daemon_calculate(
+                      &other, SunriseSunsetSearch_Step, SunriseSunsetEngine_Spa, queries, QUERIES, results));
+    for (i = 0; i < QUERIES; i++) {
+        ASSERT("Same as the library", check_result(&queries[i], &results[i], SunriseSunsetSearch_Step, 0));
+    }
+    ssc_daemon_disconnect(&slow);
+    ssc_daemon_disconnect(&other);
+}
+
+static void test_shutdown() {
+    ssc_daemon_header header = {0, SscDaemonMessage_Shutdown, 0, 0, 42, 0};
+    ssc_daemon_client client;
+    int status = -1;
+
+    ASSERT_EQUALS(SscDaemonError_Success, ssc_daemon_connect(&client, SOCKET_PATH));
+    ASSERT_EQUALS(SscDaemonError_Success, ssc_daemon_send(&client, &header, NULL));
+    ASSERT_EQUALS(SscDaemonError_Success, ssc_daemon_receive(&client, &header, NULL, 0));
+    ASSERT_EQUALS(42, (int) header.id);
+    ASSERT_EQUALS(daemon_pid, waitpid(daemon_pid, &status, 0));
+    ASSERT("Exited cleanly", WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    ssc_daemon_disconnect(&client);
+    ASSERT("Socket removed", ssc_daemon_connect(&client, SOCKET_PATH) == SscDaemonError_Io);
+    daemon_pid = 0;
+}
+
+int main(int argc, char *argv[]) {
+    int result;
+    daemon_path = argc > 1 ? argv[1] : NULL;
+    RUN(test_start);
+    RUN(test_calculate);
+    RUN(test_pipelining);
+    RUN(test_invalid_request);
+    RUN(test_stats);
+    RUN(test_slow_reader);
+    RUN(test_shutdown);
+    result = TEST_REPORT();
+    if (daemon_pid > 0) {
+        kill(daemon_pid, SIGTERM);
+        waitpid(daemon_pid, NULL, 0);
+    }
+    return result;
+}
@@ -0,0 +1,48 @@
+//
+//  spa_chebyshev_gen.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+//  Generates a Chebyshev ephemeris table file covering a range of years.
+//
+#include "spa_chebyshev.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/// Julian day at the start of 1st January of a Gregorian year
+static double jd_from_year(int year) {
+    int y = year - 1;
+    int a = (int) floor(y / 100.0);
+    int b = 2 - a + (int) floor(a / 4.0);
+    return floor(365.25 * (y + 4716)) + floor(30.6001 * 14) + 1 + b - 1524.5;
+}
+
+int main(int argc, char *argv[]) {
+    double segment_days = SPA_CHEBYSHEV_DEFAULT_SEGMENT_DAYS;
+    int coefficients = SPA_CHEBYSHEV_DEFAULT_COEFFICIENTS;
+    double jde_start, jde_end;
+    SpaChebyshevError result;
+
+    if (argc < 4 || argc > 6) {
+        fprintf(stderr, "Usage: %s <output> <start year> <end year> [segment days] [coefficients]\n", argv[0]);
+        return 2;
+    }
+    if (argc > 4) {
+        segment_days = atof(argv[4]);
+    }
+    if (argc > 5) {
+        coefficients = atoi(argv[5]);
+    }
+    // Pad by a day either side so that searches around the ends stay within the table
+    jde_start = jd_from_year(atoi(argv[2])) - 1.0;
+    jde_end = jd_from_year(atoi(argv[3]) + 1) + 1.0;
+
+    result = spa_chebyshev_write_file(argv[1], jde_start, jde_end, segment_days, coefficients);
+    if (result != SpaChebyshevError_Success) {
+        fprintf(stderr, "Failed to generate %s (error %d)\n", argv[1], (int) result);
+        return 1;
+    }
+    printf("Wrote %s: %zu bytes\n", argv[1], spa_chebyshev_size(jde_start, jde_end, segment_days, coefficients));
+    return 0;
+}
@@ -0,0 +1,954 @@
+//
+//  ssc_batch.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+//  Streams rows of (time, latitude, longitude[, elevation, pressure, temperature]) as CSV or NDJSON from a file or
+//  stdin, and writes the sunrise, sunset and visibility of each row in the same order.
+//
+//  The main thread reads the input in large blocks of whole lines. Worker threads each take a whole block, parse,
+//  calculate and format it into the block's own output buffer, and a writer thread writes the blocks out in the order
+//  they were read. Parsing and formatting are hand-rolled and run on the workers, so they scale with the calculation
+//  and the reader and writer only copy bytes.
+//
+//  Columns files (see ssc_columns.h) skip the text entirely, the input file is mapped and the workers calculate
+//  chunks of rows straight into the mapped result columns of the output file, or of the input file itself.
+//
+#include "ssc_columns.h"
+#include "ssc_parallel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+typedef CRITICAL_SECTION batch_mutex;
+typedef CONDITION_VARIABLE batch_cond;
+typedef HANDLE batch_thread;
+#define batch_mutex_init(mutex) InitializeCriticalSection(mutex)
+#define batch_mutex_destroy(mutex) DeleteCriticalSection(mutex)
+#define batch_mutex_lock(mutex) EnterCriticalSection(mutex)
+#define batch_mutex_unlock(mutex) LeaveCriticalSection(mutex)
+#define batch_cond_init(cond) InitializeConditionVariable(cond)
+#define batch_cond_destroy(cond)
+#define batch_cond_wait(cond, mutex) SleepConditionVariableCS(cond, mutex, INFINITE)
+#define batch_cond_broadcast(cond) WakeAllConditionVariable(cond)
+#else
+#include <pthread.h>
+typedef pthread_mutex_t batch_mutex;
+typedef pthread_cond_t batch_cond;
+typedef pthread_t batch_thread;
+#define batch_mutex_init(mutex) pthread_mutex_init(mutex, NULL)
+#define batch_mutex_destroy(mutex) pthread_mutex_destroy(mutex)
+#define batch_mutex_lock(mutex) pthread_mutex_lock(mutex)
+#define batch_mutex_unlock(mutex) pthread_mutex_unlock(mutex)
+#define batch_cond_init(cond) pthread_cond_init(cond, NULL)
+#define batch_cond_destroy(cond) pthread_cond_destroy(cond)
+#define batch_cond_wait(cond, mutex) pthread_cond_wait(cond, mutex)
+#define batch_cond_broadcast(cond) pthread_cond_broadcast(cond)
+#endif
+
+/// Bytes of input read into a block at a time, a block grows past this for a line that does not fit
+#define BATCH_BLOCK_BYTES (1 << 18)
+/// Most bytes a formatted output row can take
+#define BATCH_ROW_BYTES 128
+/// Status written for rows that could not be parsed
+#define BATCH_MALFORMED (-1)
+/// Rows of a columns file calculated at a time
+#define BATCH_COLUMN_ROWS 4096
+
+typedef enum {
+    BatchFormat_Detect,
+    BatchFormat_Csv,
+    BatchFormat_Ndjson,
+    BatchFormat_Columns,
+} BatchFormat;
+
+typedef enum {
+    BatchRole_Worker,  ///< Calculates blocks of text, see run_worker()
+    BatchRole_Writer,  ///< Writes blocks of text, see run_writer()
+    BatchRole_Columns, ///< Calculates chunks of columns, see run_columns_worker()
+} BatchRole;
+
+typedef enum {
+    BlockState_Free,    ///< Can be filled by the reader
+    BlockState_Filled,  ///< Waiting for a worker
+    BlockState_Working, ///< Being calculated by a worker
+    BlockState_Done,    ///< Waiting for the writer
+} BlockState;
+
+/// A block of whole input lines and the output for them
+typedef struct {
+    BlockState state;
+    char *text;             ///< Input lines, followed by a terminating NUL
+    size_t text_length;     ///< Bytes of input
+    size_t text_capacity;   ///< Bytes allocated for the input
+    char *output;           ///< Formatted output rows
+    size_t output_length;   ///< Bytes of output
+    size_t output_capacity; ///< Bytes allocated for the output
+    size_t lines;           ///< Input lines, including empty lines
+    size_t malformed;       ///< Rows that could not be parsed
+    size_t first_malformed; ///< Line within the block of the first row that could not be parsed
+} BatchBlock;
+
+typedef struct {
+    SunriseSunsetParameters params; ///< Parameters shared by every row
+    BatchFormat input_format;
+    BatchFormat output_format;
+    FILE *output;
+    batch_mutex mutex;
+    batch_cond filled;  ///< Signalled when a block is filled, or the input has ended
+    batch_cond done;    ///< Signalled when a block is done, or the input has ended
+    batch_cond freed;   ///< Signalled when a block has been written
+    BatchBlock *blocks; ///< Ring of blocks, block i of the input is at i % block_count
+    size_t block_count;
+    size_t read_count;    ///< Blocks filled by the reader
+    size_t written_count; ///< Blocks written by the writer
+    size_t header_lines;  ///< Lines skipped before the first block, for the line numbers of malformed rows
+    size_t malformed;     ///< Rows that could not be parsed, counted by the writer
+    bool finished;        ///< If the reader has reached the end of the input
+    bool failed;          ///< If writing failed
+} BatchJob;
+
+/// A row of input
+typedef struct {
+    unix_t time;
+    double latitude;
+    double longitude;
+    double elevation;
+    double pressure;
+    double temperature;
+    bool atmosphere; ///< If elevation, pressure and temperature were given
+} BatchRow;
+
+static void *checked_realloc(void *pointer, size_t size) {
+    pointer = realloc(pointer, size);
+    if (pointer == NULL) {
+        fprintf(stderr, "ssc_batch: out of memory\n");
+        exit(1);
+    }
+    return pointer;
+}
+
+//-------------------------------------------------------------------------
+// Parsing
+//-------------------------------------------------------------------------
+
+/// Powers of ten that are exact in a double
+static const double POWERS_OF_TEN[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                       1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+static const char *skip_spaces(const char *p) {
+    while (*p == ' ' || *p == '\t') {
+        p++;
+    }
+    return p;
+}
+
+/// Parse a decimal number. Up to 15 significant digits without an exponent are converted exactly, as one integer
+/// divided by an exact power of ten, anything else falls back to strtod().
+/// @return The end of the number, or NULL if there is no number
+static const char *parse_double(const char *p, double *value) {
+    const char *start = p, *digits_start;
+    uint64_t mantissa = 0;
+    int significant = 0, fraction = 0;
+    bool negative = *p == '-', point = false;
+    char *end;
+
+    if (*p == '-' || *p == '+') {
+        p++;
+    }
+    digits_start = p;
+    while (*p >= '0' && *p <= '9' && significant < 15) {
+        mantissa = mantissa * 10 + (uint64_t) (*p++ - '0');
+        significant += mantissa > 0;
+    }
+    if (*p == '.') {
+        p++;
+        point = true;
+        while (*p >= '0' && *p <= '9' && significant < 15) {
+            mantissa = mantissa * 10 + (uint64_t) (*p++ - '0');
+            significant += mantissa > 0;
+            fraction++;
+        }
+    }
+    if ((*p >= '0' && *p <= '9') || *p == 'e' || *p == 'E' || *p == '.' || fraction > 22) {
+        *value = strtod(start, &end);
+        return end == start ? NULL : end;
+    }
+    // A sign or a point on its own is not a number
+    if (p - digits_start == (point ? 1 : 0)) {
+        return NULL;
+    }
+    *value = (double) mantissa / POWERS_OF_TEN[fraction];
+    *value = negative ? -*value : *value;
+    return p;
+}
+
+/// Parse a whole number of seconds
+/// @return The end of the number, or NULL if there is no number
+static const char *parse_time(const char *p, unix_t *value) {
+    const char *start;
+    bool negative = *p == '-';
+    uint64_t magnitude = 0;
+
+    if (*p == '-' || *p == '+') {
+        p++;
+    }
+    start = p;
+    while (*p >= '0' && *p <= '9' && p - start < 18) {
+        magnitude = magnitude * 10 + (uint64_t) (*p++ - '0');
+    }
+    if (p == start || (*p >= '0' && *p <= '9')) {
+        return NULL;
+    }
+    *value = negative ? -(unix_t) magnitude : (unix_t) magnitude;
+    return p;
+}
+
+/// Parse a CSV row of time, latitude, longitude and optionally elevation, pressure and temperature
+static bool parse_csv_row(const char *p, BatchRow *row) {
+    double *fields[] = {&row->latitude, &row->longitude, &row->elevation, &row->pressure, &row->temperature};
+    int i;
+
+    p = parse_time(skip_spaces(p), &row->time);
+    for (i = 0; p != NULL && i < 5; i++) {
+        p = skip_spaces(p);
+        if (*p != ',') {
+            break;
+        }
+        p = parse_double(skip_spaces(p + 1), fields[i]);
+    }
+    if (p == NULL || (i != 2 && i != 5)) {
+        return false;
+    }
+    p = skip_spaces(p);
+    row->atmosphere = i == 5;
+    return *p == '\0' || *p == '\r' || *p == '\n';
+}
+
+/// Skip a JSON value that is not used, a string or a literal such as a number, true, false or null
+static const char *skip_json_value(const char *p) {
+    if (*p == '"') {
+        for (p++; *p != '"'; p++) {
+            if (*p == '\\' && p[1] != '\0') {
+                p++;
+            } else if (*p == '\0' || *p == '\n') {
+                return NULL;
+            }
+        }
+        return p + 1;
+    }
+    while (*p != ',' && *p != '}' && *p != ' ' && *p != '\t' && *p != '\0' && *p != '\n') {
+        p++;
+    }
+    return p;
+}
+
+static bool json_key_is(const char *key, size_t length, const char *name) {
+    return strlen(name) == length && memcmp(key, name, length) == 0;
+}
+
+/// Parse an NDJSON row, an object with numbers "time", "lat" and "lon" and optionally "elevation", "pressure" and
+/// "temperature" (all three or none). Other members are ignored, but must not be objects or arrays.
+static bool parse_json_row(const char *p, BatchRow *row) {
+    int found = 0, atmosphere = 0;
+
+    p = skip_spaces(p);
+    if (*p++ != '{') {
+        return false;
+    }
+    for (p = skip_spaces(p); *p != '}'; p = skip_spaces(p + 1)) {
+        const char *key = p + 1, *key_end;
+        size_t length;
+        if (*p != '"' || (key_end = strchr(key, '"')) == NULL) {
+            return false;
+        }
+        length = (size_t) (key_end - key);
+        p = skip_spaces(key_end + 1);
+        if (*p != ':') {
+            return false;
+        }
+        p = skip_spaces(p + 1);
+        if (json_key_is(key, length, "time")) {
+            p = parse_time(p, &row->time);
+            found |= 1;
+        } else if (json_key_is(key, length, "lat")) {
+            p = parse_double(p, &row->latitude);
+            found |= 2;
+        } else if (json_key_is(key, length, "lon")) {
+            p = parse_double(p, &row->longitude);
+            found |= 4;
+        } else if (json_key_is(key, length, "elevation")) {
+            p = parse_double(p, &row->elevation);
+            atmosphere |= 1;
+        } else if (json_key_is(key, length, "pressure")) {
+            p = parse_double(p, &row->pressure);
+            atmosphere |= 2;
+        } else if (json_key_is(key, length, "temperature")) {
+            p = parse_double(p, &row->temperature);
+            atmosphere |= 4;
+        } else {
+            p = skip_json_value(p);
+        }
+        if (p == NULL) {
+            return false;
+        }
+        p = skip_spaces(p);
+        if (*p == '}') {
+            break;
+        }
+        if (*p != ',') {
+            return false;
+        }
+    }
+    row->atmosphere = atmosphere == 7;
+    return found == 7 && (atmosphere == 0 || atmosphere == 7);
+}
+
+//-------------------------------------------------------------------------
+// Formatting
+//-------------------------------------------------------------------------
+
+static char *format_string(char *out, const char *string) {
+    while (*string != '\0') {
+        *out++ = *string++;
+    }
+    return out;
+}
+
+static char *format_int64(char *out, int64_t value) {
+    char digits[20];
+    uint64_t magnitude = value < 0 ? 0 - (uint64_t) value : (uint64_t) value;
+    int count = 0;
+    if (value < 0) {
+        *out++ = '-';
+    }
+    do {
+        digits[count++] = (char) ('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    while (count > 0) {
+        *out++ = digits[--count];
+    }
+    return out;
+}
+
+/// Format an output row
+/// @param status Result of the calculation, or BATCH_MALFORMED
+static char *format_row(char *out,
+                        BatchFormat format,
+                        const BatchRow *row,
+                        const SunriseSunsetResult *result,
+                        int status) {
+    if (format == BatchFormat_Csv) {
+        if (status == BATCH_MALFORMED) {
+            out = format_string(out, ",,,");
+        } else {
+            out = format_int64(out, row->time);
+            *out++ = ',';
+            if (status == SpaError_Success) {
+                out = format_int64(out, result->rise);
+                *out++ = ',';
+                out = format_int64(out, result->set);
+                *out++ = ',';
+                *out++ = result->visible ? '1' : '0';
+            } else {
+                out = format_string(out, ",,");
+            }
+        }
+        *out++ = ',';
+        out = format_int64(out, status);
+    } else {
+        if (status == BATCH_MALFORMED) {
+            out = format_string(out, "{\"status\":");
+        } else {
+            out = format_string(out, "{\"time\":");
+            out = format_int64(out, row->time);
+            if (status == SpaError_Success) {
+                out = format_string(out, ",\"rise\":");
+                out = format_int64(out, result->rise);
+                out = format_string(out, ",\"set\":");
+                out = format_int64(out, result->set);
+                out = format_string(out, result->visible ? ",\"visible\":true" : ",\"visible\":false");
+            }
+            out = format_string(out, ",\"status\":");
+        }
+        out = format_int64(out, status);
+        *out++ = '}';
+    }
+    *out++ = '\n';
+    return out;
+}
+
+//-------------------------------------------------------------------------
+// Pipeline
+//-------------------------------------------------------------------------
+
+/// Parse, calculate and format every line of a block
+static void process_block(const BatchJob *job, BatchBlock *block) {
+    const char *line = block->text, *end = block->text + block->text_length;
+    SunriseSunsetParameters params = job->params;
+    SunriseSunsetResult result;
+    BatchRow row;
+    int status;
+
+    block->output_length = 0;
+    block->lines = 0;
+    block->malformed = 0;
+    while (line < end) {
+        const char *next = memchr(line, '\n', (size_t) (end - line));
+        next = next != NULL ? next + 1 : end;
+        block->lines++;
+        if (*skip_spaces(line) == '\n' || *skip_spaces(line) == '\r' || *skip_spaces(line) == '\0') {
+            line = next;
+            continue;
+        }
+
+        if (job->input_format == BatchFormat_Csv ? parse_csv_row(line, &row) : parse_json_row(line, &row)) {
+            params.time = row.time;
+            params.latitude = row.latitude;
+            params.longitude = row.longitude;
+            params.step_size = sunrise_sunset_default_step_size(row.latitude);
+            if (row.atmosphere) {
+                params.elevation = row.elevation;
+                params.pressure = row.pressure;
+                params.temperature = row.temperature;
+            } else {
+                params.elevation = job->params.elevation;
+                params.pressure = job->params.pressure;
+                params.temperature = job->params.temperature;
+            }
+            status = (int) sunrise_sunset_calculate(&params, &result);
+        } else {
+            status = BATCH_MALFORMED;
+            block->first_malformed = block->malformed == 0 ? block->lines - 1 : block->first_malformed;
+            block->malformed++;
+        }
+
+        if (block->output_capacity - block->output_length < BATCH_ROW_BYTES) {
+            block->output_capacity = block->output_capacity * 2 + BATCH_ROW_BYTES;
+            block->output = (char *) checked_realloc(block->output, block->output_capacity);
+        }
+        block->output_length =
+            (size_t) (format_row(block->output + block->output_length, job->output_format, &row, &result, status) -
+                      block->output);
+        line = next;
+    }
+}
+
+static void run_worker(BatchJob *job) {
+    size_t i;
+    batch_mutex_lock(&job->mutex);
+    for (;;) {
+        BatchBlock *block = NULL;
+        // The oldest filled block first, so that the writer is not kept waiting
+        for (i = job->written_count; i < job->read_count && block == NULL; i++) {
+            if (job->blocks[i % job->block_count].state == BlockState_Filled) {
+                block = &job->blocks[i % job->block_count];
+            }
+        }
+        if (block == NULL) {
+            if (job->finished) {
+                break;
+            }
+            batch_cond_wait(&job->filled, &job->mutex);
+            continue;
+        }
+        block->state = BlockState_Working;
+        batch_mutex_unlock(&job->mutex);
+        process_block(job, block);
+        batch_mutex_lock(&job->mutex);
+        block->state = BlockState_Done;
+        batch_cond_broadcast(&job->done);
+    }
+    batch_mutex_unlock(&job->mutex);
+}
+
+static void run_writer(BatchJob *job) {
+    size_t lines = job->header_lines, first_malformed = 0;
+    bool failed;
+    batch_mutex_lock(&job->mutex);
+    for (;;) {
+        BatchBlock *block = &job->blocks[job->written_count % job->block_count];
+        if (job->written_count == job->read_count && job->finished) {
+            break;
+        }
+        if (job->written_count == job->read_count || block->state != BlockState_Done) {
+            batch_cond_wait(&job->done, &job->mutex);
+            continue;
+        }
+        failed = job->failed;
+        batch_mutex_unlock(&job->mutex);
+        // The flag is shared with the reader, it is only set once the mutex is held again
+        failed = failed || fwrite(block->output, 1, block->output_length, job->output) != block->output_length;
+        if (block->malformed > 0) {
+            first_malformed = job->malformed == 0 ? lines + block->first_malformed + 1 : first_malformed;
+            job->malformed += block->malformed;
+        }
+        lines += block->lines;
+        batch_mutex_lock(&job->mutex);
+        job->failed = failed;
+        block->state = BlockState_Free;
+        job->written_count++;
+        batch_cond_broadcast(&job->freed);
+    }
+    batch_mutex_unlock(&job->mutex);
+    if (job->malformed > 0) {
+        fprintf(stderr, "ssc_batch: %zu malformed rows, the first on line %zu\n", job->malformed, first_malformed);
+    }
+}
+
+/// Rows of a columns file, shared out to the workers in chunks
+typedef struct {
+    const SunriseSunsetParameters *params; ///< Parameters shared by every row
+    const ssc_columns *input;              ///< Input columns
+    const ssc_columns *output;             ///< Result columns, which may be the input
+    batch_mutex mutex;
+    size_t next;   ///< First row that has not been claimed by a worker
+    size_t failed; ///< Rows that did not succeed
+} ColumnsJob;
+
+/// Calculate a chunk of rows straight into the result columns
+/// @return Number of rows that did not succeed
+static size_t calculate_columns(const ColumnsJob *job, size_t first, size_t count) {
+    const ssc_columns *in = job->input, *out = job->output;
+    SunriseSunsetParameters params = *job->params;
+    SunriseSunsetBatchInput input;
+    SunriseSunsetBatchOutput output;
+    SunriseSunsetResult result;
+    size_t i, failed = 0;
+
+    if (in != out) {
+        memcpy(out->time + first, in->time + first, count * sizeof(unix_t));
+    }
+    // The batch kernel is the step search, the other searches are calculated a row at a time
+    if (params.search == SunriseSunsetSearch_Step) {
+        ssc_columns_batch_init(in, first, count, &input, NULL);
+        input.delta_t = params.delta_t;
+        input.shared_elevation = params.elevation;
+        input.shared_pressure = params.pressure;
+        input.shared_temperature = params.temperature;
+        input.atmos_refract = params.atmos_refract;
+        input.nutation = params.nutation;
+        input.nutation_interval = params.nutation_interval;
+        input.engine = params.engine;
+        output.rise = out->rise + first;
+        output.set = out->set + first;
+        output.visible = out->visible + first;
+        output.status = out->status + first;
+        output.stats = NULL;
+        sunrise_sunset_calculate_batch(&input, &output);
+    } else {
+        for (i = first; i < first + count; i++) {
+            params.time = in->time[i];
+            params.latitude = in->latitude[i];
+            params.longitude = in->longitude[i];
+            params.step_size = sunrise_sunset_default_step_size(in->latitude[i]);
+            if (in->elevation != NULL) {
+                params.elevation = in->elevation[i];
+                params.pressure = in->pressure[i];
+                params.temperature = in->temperature[i];
+            }
+            out->status[i] = sunrise_sunset_calculate(&params, &result);
+            out->rise[i] = result.rise;
+            out->set[i] = result.set;
+            out->visible[i] = result.visible;
+        }
+    }
+    for (i = first; i < first + count; i++) {
+        failed += out->status[i] != SpaError_Success;
+    }
+    return failed;
+}
+
+static void run_columns_worker(ColumnsJob *job) {
+    size_t first, count, failed;
+    for (;;) {
+        batch_mutex_lock(&job->mutex);
+        first = job->next;
+        count = job->input->row_count - first < BATCH_COLUMN_ROWS ? job->input->row_count - first : BATCH_COLUMN_ROWS;
+        job->next += count;
+        batch_mutex_unlock(&job->mutex);
+        if (count == 0) {
+            break;
+        }
+        failed = calculate_columns(job, first, count);
+        if (failed > 0) {
+            batch_mutex_lock(&job->mutex);
+            job->failed += failed;
+            batch_mutex_unlock(&job->mutex);
+        }
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI worker_thread(LPVOID argument) {
+    run_worker((BatchJob *) argument);
+    return 0;
+}
+
+static DWORD WINAPI writer_thread(LPVOID argument) {
+    run_writer((BatchJob *) argument);
+    return 0;
+}
+
+static DWORD WINAPI columns_thread(LPVOID argument) {
+    run_columns_worker((ColumnsJob *) argument);
+    return 0;
+}
+
+static bool thread_start(batch_thread *thread, BatchRole role, void *argument) {
+    LPTHREAD_START_ROUTINE routine =
+        role == BatchRole_Writer ? writer_thread : role == BatchRole_Columns ? columns_thread : worker_thread;
+    *thread = CreateThread(NULL, 0, routine, argument, 0, NULL);
+    return *thread != NULL;
+}
+
+static void thread_join(batch_thread thread) {
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+#else
+static void *worker_thread(void *argument) {
+    run_worker((BatchJob *) argument);
+    return NULL;
+}
+
+static void *writer_thread(void *argument) {
+    run_writer((BatchJob *) argument);
+    return NULL;
+}
+
+static void *columns_thread(void *argument) {
+    run_columns_worker((ColumnsJob *) argument);
+    return NULL;
+}
+
+static bool thread_start(batch_thread *thread, BatchRole role, void *argument) {
+    void *(*routine)(void *) =
+        role == BatchRole_Writer ? writer_thread : role == BatchRole_Columns ? columns_thread : worker_thread;
+    return pthread_create(thread, NULL, routine, argument) == 0;
+}
+
+static void thread_join(batch_thread thread) {
+    pthread_join(thread, NULL);
+}
+#endif
+
+/// Reads blocks of whole lines, carrying a partial line at the end of one read over to the next block
+typedef struct {
+    FILE *input;
+    char *carry;           ///< Partial line from the previous read
+    size_t carry_length;   ///< Bytes of the partial line
+    size_t carry_capacity; ///< Bytes allocated for the partial line
+    bool eof;              ///< If the end of the input has been read
+} BatchReader;
+
+/// Fill a block with the next whole lines of the input
+/// @return False once the input is exhausted and the block is empty
+static bool read_block(BatchReader *reader, BatchBlock *block) {
+    size_t scan = 0, read_size, end;
+
+    block->text_length = 0;
+    if (block->text_capacity < reader->carry_length + BATCH_BLOCK_BYTES + 1) {
+        block->text_capacity = reader->carry_length + BATCH_BLOCK_BYTES + 1;
+        block->text = (char *) checked_realloc(block->text, block->text_capacity);
+    }
+    memcpy(block->text, reader->carry, reader->carry_length);
+    block->text_length = reader->carry_length;
+    reader->carry_length = 0;
+
+    for (;;) {
+        if (!reader->eof) {
+            read_size = fread(block->text + block->text_length, 1, BATCH_BLOCK_BYTES, reader->input);
+            reader->eof = read_size < BATCH_BLOCK_BYTES;
+            block->text_length += read_size;
+        }
+        // Keep everything up to the last newline, or everything at the end of the input
+        for (end = block->text_length; end > scan && block->text[end - 1] != '\n'; end--) {
+        }
+        if (end > scan || reader->eof) {
+            break;
+        }
+        // A line longer than the block, grow it and read more of the line
+        scan = block->text_length;
+        block->text_capacity = block->text_length + BATCH_BLOCK_BYTES + 1;
+        block->text = (char *) checked_realloc(block->text, block->text_capacity);
+    }
+    if (reader->eof && (end == scan || end == 0)) {
+        end = block->text_length;
+    }
+
+    reader->carry_length = block->text_length - end;
+    if (reader->carry_capacity < reader->carry_length) {
+        reader->carry_capacity = reader->carry_length;
+        reader->carry = (char *) checked_realloc(reader->carry, reader->carry_capacity);
+    }
+    memcpy(reader->carry, block->text + end, reader->carry_length);
+    block->text_length = end;
+    block->text[end] = '\0';
+    return block->text_length > 0;
+}
+
+/// Calculate a columns file, into a new output file or in place when there is no output path
+static int run_columns(const SunriseSunsetParameters *params,
+                       const char *input_path,
+                       const char *output_path,
+                       size_t threads) {
+    ssc_columns_file input, output;
+    SunriseSunsetBatchInput columns_check;
+    ColumnsJob job;
+    batch_thread *workers;
+    size_t started, i;
+    SscColumnsError result;
+
+    result = ssc_columns_map_file(&input, input_path, output_path == NULL);
+    if (result != SscColumnsError_Success) {
+        fprintf(stderr, "ssc_batch: cannot map %s as a columns file\n", input_path);
+        return 1;
+    }
+    if (output_path != NULL) {
+        result = ssc_columns_create_file(
+            &output, output_path, input.columns.row_count, SSC_COLUMN(SscColumn_Time) | SSC_COLUMNS_RESULT);
+        if (result != SscColumnsError_Success) {
+            fprintf(stderr, "ssc_batch: cannot create %s\n", output_path);
+            ssc_columns_unmap_file(&input);
+            return 1;
+        }
+    }
+    job.params = params;
+    job.input = &input.columns;
+    job.output = output_path != NULL ? &output.columns : &input.columns;
+    job.next = 0;
+    job.failed = 0;
+    if (ssc_columns_batch_init(job.input, 0, 0, &columns_check, NULL) != SscColumnsError_Success ||
+        (job.output->header->column_mask & SSC_COLUMNS_RESULT) != SSC_COLUMNS_RESULT) {
+        fprintf(stderr, "ssc_batch: %s does not have the input and result columns\n", input_path);
+        ssc_columns_unmap_file(&input);
+        if (output_path != NULL) {
+            ssc_columns_unmap_file(&output);
+        }
+        return 1;
+    }
+
+    batch_mutex_init(&job.mutex);
+    workers = (batch_thread *) checked_realloc(NULL, threads * sizeof(batch_thread));
+    for (started = 0; started < threads && thread_start(&workers[started], BatchRole_Columns, &job); started++) {
+    }
+    // Without any threads the rows are calculated on this one
+    if (started == 0) {
+        run_columns_worker(&job);
+    }
+    for (i = 0; i < started; i++) {
+        thread_join(workers[i]);
+    }
+    batch_mutex_destroy(&job.mutex);
+    free(workers);
+
+    if (job.failed > 0) {
+        fprintf(stderr, "ssc_batch: %zu rows did not succeed, see their status\n", job.failed);
+    }
+    ssc_columns_unmap_file(&input);
+    if (output_path != NULL) {
+        ssc_columns_unmap_file(&output);
+    }
+    return job.failed > 0 ? 1 : 0;
+}
+
+static void usage(const char *name) {
+    fprintf(stderr,
+            "Usage: %s [options] [input|- [output]]\n"
+            "Rows of time,lat,lon[,elevation,pressure,temperature] as CSV, or NDJSON objects with those members\n"
+            "  -f csv|ndjson|columns     Input format, detected from the first row by default. Columns files are\n"
+            "                            calculated into a new columns file, or in place without an output path\n"
+            "  -o csv|ndjson             Output format, the same as the input by default\n"
+            "  -s step|predictor|transit Search strategy, step by default\n"
+            "  -e spa|noaa|float         Algorithm, spa by default\n"
+            "  -t threads                Calculation threads, one per processor by default\n",
+            name);
+}
+
+static bool parse_format(const char *name, BatchFormat *format) {
+    if (strcmp(name, "csv") == 0) {
+        *format = BatchFormat_Csv;
+    } else if (strcmp(name, "ndjson") == 0) {
+        *format = BatchFormat_Ndjson;
+    } else if (strcmp(name, "columns") == 0) {
+        *format = BatchFormat_Columns;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    const char *input_path = NULL, *output_path = NULL;
+    size_t threads = sunrise_sunset_parallel_processors(), started = 0, i;
+    batch_thread *workers, writer;
+    BatchReader reader = {NULL, NULL, 0, 0, false};
+    BatchJob job;
+    BatchBlock *block;
+    bool failed;
+    int arg;
+
+    SunriseSunsetParameters_init(&job.params, 0, 0.0, 0.0);
+    job.input_format = BatchFormat_Detect;
+    job.output_format = BatchFormat_Detect;
+    for (arg = 1; arg < argc; arg++) {
+        const char *option = argv[arg], *value = arg + 1 < argc ? argv[arg + 1] : "";
+        if (option[0] != '-' || option[1] == '\0') {
+            if (input_path == NULL) {
+                input_path = option;
+            } else if (output_path == NULL) {
+                output_path = option;
+            } else {
+                usage(argv[0]);
+                return 2;
+            }
+            continue;
+        }
+        arg++;
+        if (strcmp(option, "-f") == 0 && parse_format(value, &job.input_format)) {
+        } else if (strcmp(option, "-o") == 0 && parse_format(value, &job.output_format)) {
+        } else if (strcmp(option, "-t") == 0 && atoi(value) > 0) {
+            threads = (size_t) atoi(value);
+        } else if (strcmp(option, "-s") == 0 && strcmp(value, "step") == 0) {
+            job.params.search = SunriseSunsetSearch_Step;
+        } else if (strcmp(option, "-s") == 0 && strcmp(value, "predictor") == 0) {
+            job.params.search = SunriseSunsetSearch_Predictor;
+        } else if (strcmp(option, "-s") == 0 && strcmp(value, "transit") == 0) {
+            job.params.search = SunriseSunsetSearch_Transit;
+        } else if (strcmp(option, "-e") == 0 && strcmp(value, "spa") == 0) {
+            job.params.engine = SunriseSunsetEngine_Spa;
+        } else if (strcmp(option, "-e") == 0 && strcmp(value, "noaa") == 0) {
+            job.params.engine = SunriseSunsetEngine_Noaa;
+        } else if (strcmp(option, "-e") == 0 && strcmp(value, "float") == 0) {
+            job.params.engine = SunriseSunsetEngine_SpaFloat;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (job.input_format == BatchFormat_Columns || job.output_format == BatchFormat_Columns) {
+        if (job.input_format != BatchFormat_Columns || input_path == NULL || strcmp(input_path, "-") == 0 ||
+            (job.output_format != BatchFormat_Columns && job.output_format != BatchFormat_Detect)) {
+            fprintf(stderr, "ssc_batch: columns files need -f columns and an input path\n");
+            return 2;
+        }
+        return run_columns(&job.params, input_path, output_path, threads);
+    }
+
+    reader.input = input_path == NULL || strcmp(input_path, "-") == 0 ? stdin : fopen(input_path, "rb");
+    job.output = output_path == NULL ? stdout : fopen(output_path, "wb");
+    if (reader.input == NULL || job.output == NULL) {
+        fprintf(stderr, "ssc_batch: cannot open %s\n", reader.input == NULL ? input_path : output_path);
+        return 1;
+    }
+
+    // A ring of blocks, enough for every worker to have one while others wait to be read or written
+    job.block_count = threads * 2 + 2;
+    job.blocks = (BatchBlock *) checked_realloc(NULL, job.block_count * sizeof(BatchBlock));
+    memset(job.blocks, 0, job.block_count * sizeof(BatchBlock));
+    workers = (batch_thread *) checked_realloc(NULL, threads * sizeof(batch_thread));
+    job.read_count = 0;
+    job.written_count = 0;
+    job.header_lines = 0;
+    job.malformed = 0;
+    job.finished = false;
+    job.failed = false;
+
+    // The first block decides the formats and skips a CSV header
+    block = &job.blocks[0];
+    if (read_block(&reader, block)) {
+        const char *first = skip_spaces(block->text);
+        if (job.input_format == BatchFormat_Detect) {
+            job.input_format = *first == '{' ? BatchFormat_Ndjson : BatchFormat_Csv;
+        }
+        if (job.input_format == BatchFormat_Csv && *first != '-' && *first != '+' && (*first < '0' || *first > '9')) {
+            const char *line_end = memchr(block->text, '\n', block->text_length);
+            size_t skip = line_end != NULL ? (size_t) (line_end - block->text) + 1 : block->text_length;
+            memmove(block->text, block->text + skip, block->text_length - skip + 1);
+            block->text_length -= skip;
+            job.header_lines = 1;
+        }
+        block->state = BlockState_Filled;
+        job.read_count = 1;
+    }
+    if (job.output_format == BatchFormat_Detect) {
+        job.output_format = job.input_format == BatchFormat_Ndjson ? BatchFormat_Ndjson : BatchFormat_Csv;
+    }
+    if (job.output_format == BatchFormat_Csv) {
+        fputs("time,rise,set,visible,status\n", job.output);
+    }
+
+    batch_mutex_init(&job.mutex);
+    batch_cond_init(&job.filled);
+    batch_cond_init(&job.done);
+    batch_cond_init(&job.freed);
+    if (!thread_start(&writer, BatchRole_Writer, &job)) {
+        fprintf(stderr, "ssc_batch: cannot start the writer thread\n");
+        return 1;
+    }
+    for (started = 0; started < threads && thread_start(&workers[started], BatchRole_Worker, &job); started++) {
+    }
+    if (started == 0) {
+        fprintf(stderr, "ssc_batch: cannot start any calculation threads\n");
+        return 1;
+    }
+
+    for (;;) {
+        block = &job.blocks[job.read_count % job.block_count];
+        batch_mutex_lock(&job.mutex);
+        while (block->state != BlockState_Free && !job.failed) {
+            batch_cond_wait(&job.freed, &job.mutex);
+        }
+        failed = job.failed;
+        batch_mutex_unlock(&job.mutex);
+        if (failed || !read_block(&reader, block)) {
+            break;
+        }
+        batch_mutex_lock(&job.mutex);
+        block->state = BlockState_Filled;
+        job.read_count++;
+        batch_cond_broadcast(&job.filled);
+        batch_mutex_unlock(&job.mutex);
+    }
+    batch_mutex_lock(&job.mutex);
+    job.finished = true;
+    batch_cond_broadcast(&job.filled);
+    batch_cond_broadcast(&job.done);
+    batch_mutex_unlock(&job.mutex);
+
+    for (i = 0; i < started; i++) {
+        thread_join(workers[i]);
+    }
+    thread_join(writer);
+    if (fflush(job.output) != 0) {
+        job.failed = true;
+    }
+    if (job.failed) {
+        fprintf(stderr, "ssc_batch: failed to write the output\n");
+    }
+
+    batch_cond_destroy(&job.filled);
+    batch_cond_destroy(&job.done);
+    batch_cond_destroy(&job.freed);
+    batch_mutex_destroy(&job.mutex);
+    for (i = 0; i < job.block_count; i++) {
+        free(job.blocks[i].text);
+        free(job.blocks[i].output);
+    }
+    free(job.blocks);
+    free(workers);
+    free(reader.carry);
+    if (reader.input != stdin) {
+        fclose(reader.input);
+    }
+    if (job.output != stdout) {
+        fclose(job.output);
+    }
+    return job.failed || job.malformed > 0 ? 1 : 0;
+}
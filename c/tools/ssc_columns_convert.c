@@ -0,0 +1,292 @@
+//
+//  ssc_columns_convert.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+//  Converts between CSV and columns files (see ssc_columns.h), in whichever direction the input needs.
+//
+//  The first line of the CSV names its columns, any of time, lat, lon, elevation, pressure, temperature, rise, set,
+//  visible and status, so that both the input and the output of ssc_batch can be converted. Empty values are zero.
+//
+#include "ssc_columns.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// CSV name of each column
+static const char *const COLUMN_NAMES[SscColumn_Count] = {
+    "time", "lat", "lon", "elevation", "pressure", "temperature", "rise", "set", "visible", "status"};
+
+/// Read a whole file into a NUL terminated buffer
+static char *read_file(const char *path, size_t *length) {
+    FILE *file = fopen(path, "rb");
+    size_t capacity = 1 << 20, read_size;
+    char *buffer = (char *) malloc(capacity + 1), *grown;
+
+    *length = 0;
+    if (file == NULL || buffer == NULL) {
+        free(buffer);
+        return NULL;
+    }
+    while ((read_size = fread(buffer + *length, 1, capacity - *length, file)) > 0) {
+        *length += read_size;
+        if (*length == capacity) {
+            capacity *= 2;
+            grown = (char *) realloc(buffer, capacity + 1);
+            if (grown == NULL) {
+                free(buffer);
+                fclose(file);
+                return NULL;
+            }
+            buffer = grown;
+        }
+    }
+    fclose(file);
+    buffer[*length] = '\0';
+    return buffer;
+}
+
+static const char *next_field(const char *p) {
+    while (*p != ',' && *p != '\n' && *p != '\0') {
+        p++;
+    }
+    return p;
+}
+
+/// Store a field of a row, empty values are zero
+static bool store_field(ssc_columns *columns, SscColumn column, size_t row, const char *p) {
+    char *end;
+    double value = 0.0;
+    long long whole = 0;
+
+    while (*p == ' ') {
+        p++;
+    }
+    if (column == SscColumn_Time || column >= SscColumn_Rise) {
+        whole = strtoll(p, &end, 10);
+    } else {
+        value = strtod(p, &end);
+    }
+    while (*end == ' ' || *end == '\r') {
+        end++;
+    }
+    if (*end != ',' && *end != '\n' && *end != '\0') {
+        return false;
+    }
+    switch (column) {
+    case SscColumn_Time:
+        columns->time[row] = (unix_t) whole;
+        break;
+    case SscColumn_Latitude:
+        columns->latitude[row] = value;
+        break;
+    case SscColumn_Longitude:
+        columns->longitude[row] = value;
+        break;
+    case SscColumn_Elevation:
+        columns->elevation[row] = value;
+        break;
+    case SscColumn_Pressure:
+        columns->pressure[row] = value;
+        break;
+    case SscColumn_Temperature:
+        columns->temperature[row] = value;
+        break;
+    case SscColumn_Rise:
+        columns->rise[row] = (unix_t) whole;
+        break;
+    case SscColumn_Set:
+        columns->set[row] = (unix_t) whole;
+        break;
+    case SscColumn_Visible:
+        columns->visible[row] = whole != 0;
+        break;
+    default:
+        columns->status[row] = (SpaError) whole;
+        break;
+    }
+    return true;
+}
+
+static bool is_blank(const char *line) {
+    while (*line == ' ' || *line == '\r') {
+        line++;
+    }
+    return *line == '\n' || *line == '\0';
+}
+
+/// Start of the line after a line
+static const char *next_line(const char *line) {
+    const char *end = strchr(line, '\n');
+    return end != NULL ? end + 1 : line + strlen(line);
+}
+
+static int csv_to_columns(const char *input_path, const char *output_path) {
+    SscColumn order[SscColumn_Count];
+    ssc_columns_file file;
+    uint32_t mask = 0;
+    size_t length, field_count = 0, rows = 0, row = 0, line_number = 1, i;
+    const char *p, *line, *rows_start;
+    char *text = read_file(input_path, &length);
+    SscColumnsError result;
+
+    if (text == NULL) {
+        fprintf(stderr, "ssc_columns_convert: cannot read %s\n", input_path);
+        return 1;
+    }
+    // The header names the columns
+    for (p = text;; p++) {
+        const char *end = next_field(p), *name_end = end;
+        int column;
+        while (name_end > p && (name_end[-1] == '\r' || name_end[-1] == ' ')) {
+            name_end--;
+        }
+        for (column = 0; column < SscColumn_Count; column++) {
+            if (strlen(COLUMN_NAMES[column]) == (size_t) (name_end - p) &&
+                memcmp(COLUMN_NAMES[column], p, (size_t) (name_end - p)) == 0) {
+                break;
+            }
+        }
+        if (column == SscColumn_Count || (mask & SSC_COLUMN(column)) != 0) {
+            fprintf(stderr, "ssc_columns_convert: unknown or repeated column '%.*s'\n", (int) (name_end - p), p);
+            free(text);
+            return 1;
+        }
+        mask |= SSC_COLUMN(column);
+        order[field_count++] = (SscColumn) column;
+        p = end;
+        if (*p != ',') {
+            break;
+        }
+    }
+    rows_start = next_line(text);
+    for (line = rows_start; *line != '\0'; line = next_line(line)) {
+        rows += !is_blank(line);
+    }
+
+    result = ssc_columns_create_file(&file, output_path, rows, mask);
+    if (result != SscColumnsError_Success) {
+        fprintf(stderr, "ssc_columns_convert: cannot create %s\n", output_path);
+        free(text);
+        return 1;
+    }
+    for (line = rows_start; *line != '\0'; line = next_line(line)) {
+        line_number++;
+        if (is_blank(line)) {
+            continue;
+        }
+        for (i = 0, p = line; i < field_count; i++, p++) {
+            bool stored = store_field(&file.columns, order[i], row, p);
+            p = next_field(p);
+            if (!stored || (*p == ',') != (i + 1 < field_count)) {
+                fprintf(stderr, "ssc_columns_convert: malformed row on line %zu\n", line_number);
+                ssc_columns_unmap_file(&file);
+                free(text);
+                return 1;
+            }
+        }
+        row++;
+    }
+    ssc_columns_unmap_file(&file);
+    free(text);
+    return 0;
+}
+
+/// Write a double with the fewest digits that read back as the same value
+static void write_double(FILE *output, double value) {
+    char text[32];
+    snprintf(text, sizeof(text), "%.15g", value);
+    if (strtod(text, NULL) != value) {
+        snprintf(text, sizeof(text), "%.17g", value);
+    }
+    fputs(text, output);
+}
+
+static int columns_to_csv(ssc_columns_file *file, const char *output_path) {
+    const ssc_columns *columns = &file->columns;
+    FILE *output = fopen(output_path, "wb");
+    bool first = true;
+    size_t row;
+    int column;
+
+    if (output == NULL) {
+        fprintf(stderr, "ssc_columns_convert: cannot open %s\n", output_path);
+        return 1;
+    }
+    for (column = 0; column < SscColumn_Count; column++) {
+        if (columns->header->column_mask & SSC_COLUMN(column)) {
+            fprintf(output, first ? "%s" : ",%s", COLUMN_NAMES[column]);
+            first = false;
+        }
+    }
+    fputc('\n', output);
+    for (row = 0; row < columns->row_count; row++) {
+        first = true;
+        for (column = 0; column < SscColumn_Count; column++) {
+            if ((columns->header->column_mask & SSC_COLUMN(column)) == 0) {
+                continue;
+            }
+            if (!first) {
+                fputc(',', output);
+            }
+            first = false;
+            switch (column) {
+            case SscColumn_Time:
+                fprintf(output, "%lld", (long long) columns->time[row]);
+                break;
+            case SscColumn_Latitude:
+                write_double(output, columns->latitude[row]);
+                break;
+            case SscColumn_Longitude:
+                write_double(output, columns->longitude[row]);
+                break;
+            case SscColumn_Elevation:
+                write_double(output, columns->elevation[row]);
+                break;
+            case SscColumn_Pressure:
+                write_double(output, columns->pressure[row]);
+                break;
+            case SscColumn_Temperature:
+                write_double(output, columns->temperature[row]);
+                break;
+            case SscColumn_Rise:
+                fprintf(output, "%lld", (long long) columns->rise[row]);
+                break;
+            case SscColumn_Set:
+                fprintf(output, "%lld", (long long) columns->set[row]);
+                break;
+            case SscColumn_Visible:
+                fputc(columns->visible[row] ? '1' : '0', output);
+                break;
+            default:
+                fprintf(output, "%d", (int) columns->status[row]);
+                break;
+            }
+        }
+        fputc('\n', output);
+    }
+    if (fclose(output) != 0) {
+        fprintf(stderr, "ssc_columns_convert: failed to write %s\n", output_path);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    ssc_columns_file file;
+    SscColumnsError result;
+    int status;
+
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <input.csv> <output.ssc> | <input.ssc> <output.csv>\n", argv[0]);
+        return 2;
+    }
+    // A columns file is converted to CSV, anything else is read as CSV
+    result = ssc_columns_map_file(&file, argv[1], false);
+    if (result == SscColumnsError_Success) {
+        status = columns_to_csv(&file, argv[2]);
+        ssc_columns_unmap_file(&file);
+        return status;
+    }
+    return csv_to_columns(argv[1], argv[2]);
+}
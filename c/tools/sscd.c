@@ -0,0 +1,556 @@
+//
+//  sscd.c
+//  Sunrise Sunset Calculator
+//  Distributed under the terms of the LGPL-3.0
+//
+//  A query daemon, listening on a Unix domain socket with the protocol in ssc_daemon.h.
+//
+//  Each connection has a thread that reads its requests and queues calculations for a pool of worker threads, so a
+//  client can pipeline requests and a slow request does not hold up the others. The workers share a SunriseSunsetCache
+//  (see ssc_cache.h) of the intervals between the events found for each location, which any query at the same location
+//  with a time inside one is answered from. Shutdown requests stop the daemon once the calculations already queued are
+//  answered.
+//
+//  Responses are queued for a writer thread of each connection, so a client that is slow to read only holds up its own
+//  responses and never a worker. Once SSC_DAEMON_MAX_IN_FLIGHT requests of a connection are waiting for their responses
+//  to be written, its reader stops reading until one is, which bounds the memory a client can make the daemon use.
+//
+#include "ssc_cache.h"
+#include "ssc_daemon.h"
+#include "ssc_parallel.h"
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+/// A response waiting to be written, the header and records follow the struct
+typedef struct Response {
+    struct Response *next;
+    size_t size;   ///< Size of the header and records [bytes]
+    bool shutdown; ///< Stop the daemon once the response is written
+} Response;
+
+/// A client connection, shared by its reader and writer threads and the calculations it has queued
+typedef struct {
+    int socket;
+    pthread_mutex_t mutex;
+    pthread_cond_t changed; ///< Signalled when a response is queued or written, or the reader stops
+    Response *head;         ///< Responses waiting for the writer
+    Response *tail;
+    size_t in_flight;  ///< Requests read and not yet answered, at most SSC_DAEMON_MAX_IN_FLIGHT
+    bool reading;      ///< If the reader thread can still read requests
+    bool failed;       ///< If a write failed, after which responses are dropped
+    size_t references; ///< Reader and writer threads and queued calculations, guarded by the server mutex
+} Connection;
+
+/// A queued calculation request
+typedef struct Job {
+    struct Job *next;
+    Connection *connection;
+    ssc_daemon_header header;
+    ssc_daemon_query *queries;
+    uint64_t received; ///< Monotonic time the request was read [microseconds]
+} Job;
+
+typedef struct {
+    int listener;
+    int wake[2]; ///< Pipe that stops the accept loop when written to
+    pthread_mutex_t mutex;
+    pthread_cond_t queued; ///< Signalled when a job is queued, or the daemon is stopping
+    pthread_cond_t sent;   ///< Signalled when every queued response has been written or dropped
+    Job *head;
+    Job *tail;
+    size_t unsent; ///< Responses queued for any writer thread
+    bool stopping;
+    ssc_daemon_stats stats; ///< Guarded by mutex
+    SunriseSunsetCache *cache;
+} Server;
+
+static Server server;
+
+static uint64_t monotonic_microseconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000u + (uint64_t) now.tv_nsec / 1000u;
+}
+
+static bool write_all(int socket, const void *data, size_t size) {
+    const char *p = (const char *) data;
+    while (size > 0) {
+        ssize_t written = send(socket, p, size, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        p += written;
+        size -= (size_t) written;
+    }
+    return true;
+}
+
+static bool read_all(int socket, void *data, size_t size) {
+    char *p = (char *) data;
+    while (size > 0) {
+        ssize_t read_size = recv(socket, p, size, 0);
+        if (read_size < 0 && errno == EINTR) {
+            continue;
+        }
+        if (read_size <= 0) {
+            return false;
+        }
+        p += read_size;
+        size -= (size_t) read_size;
+    }
+    return true;
+}
+
+/// Allocate a response to a request, with space for the records after the header
+/// @return The response, or NULL if there is not enough memory
+static Response *new_response(const ssc_daemon_header *request, size_t size) {
+    Response *response = (Response *) malloc(sizeof(Response) + sizeof(ssc_daemon_header) + size);
+    if (response != NULL) {
+        response->next = NULL;
+        response->size = sizeof(ssc_daemon_header) + size;
+        response->shutdown = false;
+        memcpy(response + 1, request, sizeof(ssc_daemon_header));
+    }
+    return response;
+}
+
+/// Records of a response
+static void *response_records(Response *response) {
+    return (char *) (response + 1) + sizeof(ssc_daemon_header);
+}
+
+/// Mark a request as answered, which lets the reader of its connection read another if it was waiting to
+static void finish_request(Connection *connection) {
+    pthread_mutex_lock(&connection->mutex);
+    connection->in_flight--;
+    pthread_cond_broadcast(&connection->changed);
+    pthread_mutex_unlock(&connection->mutex);
+}
+
+/// Queue a response for the writer thread of its connection, without waiting for it to be written
+/// @param response Response from new_response(), NULL leaves the request unanswered
+static void respond(Connection *connection, Response *response) {
+    if (response == NULL) {
+        finish_request(connection);
+        return;
+    }
+    pthread_mutex_lock(&server.mutex);
+    server.unsent++;
+    pthread_mutex_unlock(&server.mutex);
+    pthread_mutex_lock(&connection->mutex);
+    if (connection->tail != NULL) {
+        connection->tail->next = response;
+    } else {
+        connection->head = response;
+    }
+    connection->tail = response;
+    pthread_cond_broadcast(&connection->changed);
+    pthread_mutex_unlock(&connection->mutex);
+}
+
+static void release_connection(Connection *connection) {
+    bool last;
+    pthread_mutex_lock(&server.mutex);
+    last = --connection->references == 0;
+    pthread_mutex_unlock(&server.mutex);
+    if (last) {
+        close(connection->socket);
+        pthread_mutex_destroy(&connection->mutex);
+        pthread_cond_destroy(&connection->changed);
+        free(connection);
+    }
+}
+
+//-------------------------------------------------------------------------
+// Workers
+//-------------------------------------------------------------------------
+
+static void calculate_job(Job *job) {
+    Response *response = new_response(&job->header, job->header.count * sizeof(ssc_daemon_result));
+    ssc_daemon_result *results = response != NULL ? (ssc_daemon_result *) response_records(response) : NULL;
+    uint64_t hits = 0, latency;
+    int bucket = 0;
+    uint32_t i;
+
+    for (i = 0; results != NULL && i < job->header.count; i++) {
+        const ssc_daemon_query *query = &job->queries[i];
+        SunriseSunsetParameters params;
+        SunriseSunsetResult result;
+        bool hit;
+        SunriseSunsetParameters_init(&params, query->time, query->latitude, query->longitude);
+        params.search = (SunriseSunsetSearch) job->header.search;
+        params.engine = (SunriseSunsetEngine) job->header.engine;
+        results[i].status = (int32_t) sunrise_sunset_cache_calculate(server.cache, &params, &result, &hit);
+        results[i].rise = result.rise;
+        results[i].set = result.set;
+        results[i].visible = result.visible;
+        results[i].cached = hit;
+        results[i].reserved = 0;
+        hits += hit;
+    }
+    respond(job->connection, response);
+
+    for (latency = monotonic_microseconds() - job->received; latency > 0 && bucket < SSC_DAEMON_LATENCY_BUCKETS - 1;
+         latency >>= 1) {
+        bucket++;
+    }
+    pthread_mutex_lock(&server.mutex);
+    server.stats.requests++;
+    server.stats.queries += job->header.count;
+    server.stats.cache_hits += hits;
+    server.stats.cache_misses += job->header.count - hits;
+    server.stats.latency[bucket]++;
+    pthread_mutex_unlock(&server.mutex);
+}
+
+static void *worker_thread(void *argument) {
+    Job *job;
+    (void) argument;
+    for (;;) {
+        pthread_mutex_lock(&server.mutex);
+        while (server.head == NULL && !server.stopping) {
+            pthread_cond_wait(&server.queued, &server.mutex);
+        }
+        job = server.head;
+        if (job == NULL) {
+            pthread_mutex_unlock(&server.mutex);
+            break;
+        }
+        server.head = job->next;
+        server.tail = server.head == NULL ? NULL : server.tail;
+        server.stats.queue_depth--;
+        pthread_mutex_unlock(&server.mutex);
+
+        calculate_job(job);
+        release_connection(job->connection);
+        free(job->queries);
+        free(job);
+    }
+    return NULL;
+}
+
+//-------------------------------------------------------------------------
+// Connections
+//-------------------------------------------------------------------------
+
+/// Queue a calculation
+/// @return False if the daemon is stopping
+static bool queue_job(Job *job) {
+    pthread_mutex_lock(&server.mutex);
+    if (server.stopping) {
+        pthread_mutex_unlock(&server.mutex);
+        return false;
+    }
+    job->connection->references++;
+    job->next = NULL;
+    if (server.tail != NULL) {
+        server.tail->next = job;
+    } else {
+        server.head = job;
+    }
+    server.tail = job;
+    server.stats.queue_depth++;
+    if (server.stats.queue_depth > server.stats.max_queue_depth) {
+        server.stats.max_queue_depth = server.stats.queue_depth;
+    }
+    pthread_cond_signal(&server.queued);
+    pthread_mutex_unlock(&server.mutex);
+    return true;
+}
+
+/// Write the responses of a connection in the order they are queued, until its reader has stopped and every request
+/// read is answered. After a failed write the connection is shut down, which stops the reader, and the remaining
+/// responses are dropped.
+static void *writer_thread(void *argument) {
+    Connection *connection = (Connection *) argument;
+    Response *response;
+
+    for (;;) {
+        pthread_mutex_lock(&connection->mutex);
+        while (connection->head == NULL && (connection->reading || connection->in_flight > 0)) {
+            pthread_cond_wait(&connection->changed, &connection->mutex);
+        }
+        response = connection->head;
+        if (response == NULL) {
+            pthread_mutex_unlock(&connection->mutex);
+            break;
+        }
+        connection->head = response->next;
+        connection->tail = connection->head == NULL ? NULL : connection->tail;
+        pthread_mutex_unlock(&connection->mutex);
+
+        if (!connection->failed && !write_all(connection->socket, response + 1, response->size)) {
+            pthread_mutex_lock(&connection->mutex);
+            connection->failed = true;
+            pthread_mutex_unlock(&connection->mutex);
+            shutdown(connection->socket, SHUT_RDWR);
+        }
+        // Acknowledged before the accept loop wakes, as the daemon can exit as soon as it does
+        if (response->shutdown && write(server.wake[1], "", 1) < 0) {
+            perror("sscd: cannot stop");
+        }
+        free(response);
+        pthread_mutex_lock(&server.mutex);
+        if (--server.unsent == 0) {
+            pthread_cond_broadcast(&server.sent);
+        }
+        pthread_mutex_unlock(&server.mutex);
+        finish_request(connection);
+    }
+    release_connection(connection);
+    return NULL;
+}
+
+/// Wait until the connection has room for another request in flight
+/// @return False if a write to the connection has failed
+static bool start_request(Connection *connection) {
+    bool started;
+    pthread_mutex_lock(&connection->mutex);
+    while (connection->in_flight >= SSC_DAEMON_MAX_IN_FLIGHT && !connection->failed) {
+        pthread_cond_wait(&connection->changed, &connection->mutex);
+    }
+    started = !connection->failed;
+    connection->in_flight += started;
+    pthread_mutex_unlock(&connection->mutex);
+    return started;
+}
+
+/// Let the writer thread of a connection finish once the requests in flight are answered
+static void stop_reading(Connection *connection) {
+    pthread_mutex_lock(&connection->mutex);
+    connection->reading = false;
+    pthread_cond_broadcast(&connection->changed);
+    pthread_mutex_unlock(&connection->mutex);
+}
+
+/// Read the requests of a connection until it is closed or sends something that is not a valid request
+static void *connection_thread(void *argument) {
+    Connection *connection = (Connection *) argument;
+    ssc_daemon_header header;
+    Response *response;
+
+    while (start_request(connection)) {
+        if (!read_all(connection->socket, &header, sizeof(header)) || header.magic != SSC_DAEMON_MAGIC) {
+            finish_request(connection);
+            break;
+        }
+        if (header.type == SscDaemonMessage_Calculate) {
+            Job *job = (Job *) malloc(sizeof(Job));
+            if (header.count > SSC_DAEMON_MAX_QUERIES || header.search > SunriseSunsetSearch_Transit ||
+                header.engine > SunriseSunsetEngine_SpaFloat || job == NULL) {
+                free(job);
+                finish_request(connection);
+                break;
+            }
+            job->received = monotonic_microseconds();
+            job->connection = connection;
+            job->header = header;
+            job->queries = (ssc_daemon_query *) malloc((header.count + 1) * sizeof(ssc_daemon_query));
+            if (job->queries == NULL ||
+                !read_all(connection->socket, job->queries, header.count * sizeof(*job->queries)) || !queue_job(job)) {
+                free(job->queries);
+                free(job);
+                finish_request(connection);
+                break;
+            }
+        } else if (header.type == SscDaemonMessage_Stats && header.count == 0) {
+            header.count = 1;
+            response = new_response(&header, sizeof(ssc_daemon_stats));
+            pthread_mutex_lock(&server.mutex);
+            server.stats.requests++;
+            if (response != NULL) {
+                memcpy(response_records(response), &server.stats, sizeof(ssc_daemon_stats));
+            }
+            pthread_mutex_unlock(&server.mutex);
+            respond(connection, response);
+        } else if (header.type == SscDaemonMessage_Shutdown && header.count == 0) {
+            pthread_mutex_lock(&server.mutex);
+            server.stats.requests++;
+            pthread_mutex_unlock(&server.mutex);
+            response = new_response(&header, 0);
+            if (response == NULL) {
+                finish_request(connection);
+                break;
+            }
+            response->shutdown = true;
+            respond(connection, response);
+        } else {
+            finish_request(connection);
+            break;
+        }
+    }
+    stop_reading(connection);
+    release_connection(connection);
+    return NULL;
+}
+
+static void accept_connections(void) {
+    struct pollfd fds[2];
+    struct timeval timeout = {SSC_DAEMON_SEND_TIMEOUT, 0};
+    pthread_t thread;
+    Connection *connection;
+    int socket;
+
+    fds[0].fd = server.listener;
+    fds[0].events = POLLIN;
+    fds[1].fd = server.wake[0];
+    fds[1].events = POLLIN;
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (fds[1].revents != 0) {
+            break;
+        }
+        socket = accept(server.listener, NULL, NULL);
+        if (socket < 0) {
+            continue;
+        }
+        // A client that stops reading its responses is dropped, rather than keeping its writer thread forever
+        setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        connection = (Connection *) calloc(1, sizeof(Connection));
+        if (connection == NULL) {
+            close(socket);
+            continue;
+        }
+        connection->socket = socket;
+        connection->reading = true;
+        connection->references = 2;
+        pthread_mutex_init(&connection->mutex, NULL);
+        pthread_cond_init(&connection->changed, NULL);
+        if (pthread_create(&thread, NULL, writer_thread, connection) != 0) {
+            pthread_mutex_destroy(&connection->mutex);
+            pthread_cond_destroy(&connection->changed);
+            free(connection);
+            close(socket);
+            continue;
+        }
+        pthread_detach(thread);
+        if (pthread_create(&thread, NULL, connection_thread, connection) != 0) {
+            stop_reading(connection);
+            release_connection(connection);
+            continue;
+        }
+        pthread_detach(thread);
+        pthread_mutex_lock(&server.mutex);
+        server.stats.connections++;
+        pthread_mutex_unlock(&server.mutex);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    size_t threads = sunrise_sunset_parallel_processors(), started, i;
+    SunriseSunsetCacheConfig cache_config;
+    struct sockaddr_un address;
+    struct stat status;
+    pthread_t *workers;
+    const char *path = NULL;
+    int arg;
+
+    SunriseSunsetCacheConfig_init(&cache_config);
+    // Exact locations unless asked otherwise, so a query is answered with the events of its own location
+    cache_config.resolution = 0.0;
+    for (arg = 1; arg < argc; arg++) {
+        if (strcmp(argv[arg], "-t") == 0 && arg + 1 < argc && atoi(argv[arg + 1]) > 0) {
+            threads = (size_t) atoi(argv[++arg]);
+        } else if (strcmp(argv[arg], "-c") == 0 && arg + 1 < argc && atoi(argv[arg + 1]) > 0) {
+            cache_config.entries = (size_t) atoi(argv[++arg]);
+        } else if (strcmp(argv[arg], "-r") == 0 && arg + 1 < argc && atof(argv[arg + 1]) >= 0.0) {
+            cache_config.resolution = atof(argv[++arg]);
+        } else if (argv[arg][0] != '-' && path == NULL) {
+            path = argv[arg];
+        } else {
+            path = NULL;
+            break;
+        }
+    }
+    if (path == NULL || strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Usage: %s [-t threads] [-c cache entries] [-r cache resolution] <socket path>\n", argv[0]);
+        return 2;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    server.cache = sunrise_sunset_cache_create(&cache_config);
+    if (server.cache == NULL) {
+        fprintf(stderr, "sscd: cannot create a cache of %zu entries at a resolution of %g\n",
+                cache_config.entries,
+                cache_config.resolution);
+        return 1;
+    }
+    workers = (pthread_t *) malloc(threads * sizeof(pthread_t));
+    if (workers == NULL || pipe(server.wake) != 0) {
+        fprintf(stderr, "sscd: out of memory\n");
+        return 1;
+    }
+    pthread_mutex_init(&server.mutex, NULL);
+    pthread_cond_init(&server.queued, NULL);
+    pthread_cond_init(&server.sent, NULL);
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path, strlen(path) + 1);
+    // A socket left behind by a daemon that did not exit cleanly would stop the bind, anything else is left alone
+    if (lstat(path, &status) == 0) {
+        if (!S_ISSOCK(status.st_mode)) {
+            fprintf(stderr, "sscd: %s exists and is not a socket\n", path);
+            return 1;
+        }
+        unlink(path);
+    }
+    server.listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server.listener < 0 || bind(server.listener, (const struct sockaddr *) &address, sizeof(address)) != 0 ||
+        listen(server.listener, SOMAXCONN) != 0) {
+        fprintf(stderr, "sscd: cannot listen on %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    for (started = 0; started < threads && pthread_create(&workers[started], NULL, worker_thread, NULL) == 0;
+         started++) {
+    }
+    if (started == 0) {
+        fprintf(stderr, "sscd: cannot start any worker threads\n");
+        return 1;
+    }
+    server.stats.workers = started;
+    accept_connections();
+
+    close(server.listener);
+    unlink(path);
+    pthread_mutex_lock(&server.mutex);
+    server.stopping = true;
+    pthread_cond_broadcast(&server.queued);
+    pthread_mutex_unlock(&server.mutex);
+    for (i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    // Every calculation is answered, wait for the answers to be written (or dropped by the send timeout)
+    pthread_mutex_lock(&server.mutex);
+    while (server.unsent > 0) {
+        pthread_cond_wait(&server.sent, &server.mutex);
+    }
+    pthread_mutex_unlock(&server.mutex);
+    free(workers);
+    sunrise_sunset_cache_destroy(server.cache);
+    return 0;
+}
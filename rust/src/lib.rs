@@ -2,6 +2,7 @@
 //!
 //! A library to calculate times of sunrise and sunset on Earth based on latitude/longitude.
 #![deny(unsafe_code)]
+pub mod noaa;
 pub mod spa;
 
 use crate::spa::{SpaData, SpaError};
@@ -11,6 +12,16 @@ pub const SSC_DEFAULT_TEMPERATURE: f64 = 16.0;
 pub const SSC_DEFAULT_PRESSURE: f64 = 1013.25;
 pub const SSC_DEFAULT_ELEVATION: f64 = 0.0;
 
+/// Which algorithm evaluates the position of the sun
+#[derive(Debug, Copy, Clone, Default, Eq, PartialEq)]
+pub enum Engine {
+    /// NREL Solar Position Algorithm
+    #[default]
+    Spa,
+    /// Low precision NOAA algorithm, see [noaa] for its error bounds
+    Noaa,
+}
+
 /// Input parameters to the calculator
 #[derive(Debug, Copy, Clone)]
 pub struct SunriseSunsetParameters {
@@ -36,6 +47,8 @@ pub struct SunriseSunsetParameters {
     /// It should not be too small or otherwise or the search will take an unreasonable
     /// amount of time.
     pub step_size: u32,
+    /// Algorithm to evaluate the position of the sun with
+    pub engine: Engine,
 }
 
 impl SunriseSunsetParameters {
@@ -59,6 +72,7 @@ impl SunriseSunsetParameters {
             temperature: SSC_DEFAULT_TEMPERATURE,
             atmos_refract: SSC_DEFAULT_ATMOSPHERIC_REFRACTION,
             step_size: Self::default_step_size(latitude),
+            engine: Engine::default(),
         }
     }
 
@@ -87,27 +101,27 @@ impl SunriseSunsetParameters {
 
     /// Calculate sunrise and sunset times using these parameters
     pub fn calculate(self) -> Result<SunriseSunsetResult, SpaError> {
-        let mut data = SpaData {
-            jd: jd_from_unix(self.time),
-            delta_t: self.delta_t,
-            longitude: self.longitude,
-            latitude: self.latitude,
-            elevation: self.elevation,
-            pressure: self.pressure,
-            temperature: self.temperature,
-            atmos_refract: self.atmos_refract,
-            ..Default::default()
-        };
-        data.calculate()?;
+        let mut data = self.spa_data();
+        calculate_position(&mut data, self.engine)?;
 
         let visible = sun_is_up(&data);
         let step_signed = self.step_size as i64;
 
-        let backward_result =
-            search_for_change_in_visibility(&mut data, self.time, -step_signed, visible)?;
+        let backward_result = search_for_change_in_visibility(
+            &mut data,
+            self.engine,
+            self.time,
+            -step_signed,
+            visible,
+        )?;
 
-        let forward_result =
-            search_for_change_in_visibility(&mut data, self.time, step_signed, visible)?;
+        let forward_result = search_for_change_in_visibility(
+            &mut data,
+            self.engine,
+            self.time,
+            step_signed,
+            visible,
+        )?;
 
         Ok(SunriseSunsetResult {
             set: if visible {
@@ -125,6 +139,143 @@ impl SunriseSunsetParameters {
     }
 }
 
+impl SunriseSunsetParameters {
+    fn spa_data(&self) -> SpaData {
+        SpaData {
+            jd: jd_from_unix(self.time),
+            delta_t: self.delta_t,
+            longitude: self.longitude,
+            latitude: self.latitude,
+            elevation: self.elevation,
+            pressure: self.pressure,
+            temperature: self.temperature,
+            atmos_refract: self.atmos_refract,
+            ..Default::default()
+        }
+    }
+}
+
+/// Number of following intervals a calculator steps through before recalculating from scratch
+const CALCULATOR_MAX_ADVANCE: usize = 2;
+
+/// Interval between two events, during which the visibility of the sun does not change
+#[derive(Debug, Copy, Clone)]
+struct Interval {
+    /// Previous event, the first second of the interval
+    start: i64,
+    /// Next event, the first second after the interval
+    end: i64,
+    visible: bool,
+}
+
+/// A calculator for one location that caches the interval between the previous and next events,
+/// so that queries within it are answered without evaluating the SPA. Once the time moves past the
+/// next event only the event after it is searched for, other queries outside of the interval
+/// recalculate it.
+#[derive(Debug, Clone)]
+pub struct SunriseSunsetCalculator {
+    params: SunriseSunsetParameters,
+    data: SpaData,
+    interval: Interval,
+}
+
+impl SunriseSunsetCalculator {
+    /// Creates a [SunriseSunsetCalculator] for a location, calculating the interval around
+    /// `params.time`.
+    pub fn new(params: SunriseSunsetParameters) -> Result<Self, SpaError> {
+        let mut calculator = SunriseSunsetCalculator {
+            params,
+            data: params.spa_data(),
+            interval: Interval {
+                start: 0,
+                end: 0,
+                visible: false,
+            },
+        };
+        calculator.interval = calculator.refresh(params.time)?;
+        Ok(calculator)
+    }
+
+    /// Calculate sunrise and sunset times around a time.
+    ///
+    /// Gives the same result as [SunriseSunsetParameters::calculate()], except that events are
+    /// always the first second of the new visibility, where the search may be a second either side.
+    pub fn query(&mut self, time: i64) -> Result<SunriseSunsetResult, SpaError> {
+        // Step forwards an event at a time while the time has only just passed the interval
+        let mut advance = 0;
+        while time >= self.interval.end && advance < CALCULATOR_MAX_ADVANCE {
+            let visible = !self.interval.visible;
+            let end = self.next_event(self.interval.end, visible)?;
+            self.interval = Interval {
+                start: self.interval.end,
+                end,
+                visible,
+            };
+            advance += 1;
+        }
+        if time < self.interval.start || time >= self.interval.end {
+            self.interval = self.refresh(time)?;
+        }
+
+        let Interval {
+            start,
+            end,
+            visible,
+        } = self.interval;
+        Ok(SunriseSunsetResult {
+            set: if visible { end } else { start },
+            rise: if visible { start } else { end },
+            visible,
+        })
+    }
+
+    fn visible_at(&mut self, time: i64) -> Result<bool, SpaError> {
+        self.data.jd = jd_from_unix(time);
+        calculate_position(&mut self.data, self.params.engine)?;
+        Ok(sun_is_up(&self.data))
+    }
+
+    /// The search ends within a second of the change, move it to the first second of `visible`
+    fn first_second(&mut self, time: i64, visible: bool) -> Result<i64, SpaError> {
+        Ok(if self.visible_at(time)? != visible {
+            time + 1
+        } else {
+            time
+        })
+    }
+
+    /// First second after `time` at which the sun is no longer `visible`
+    fn next_event(&mut self, time: i64, visible: bool) -> Result<i64, SpaError> {
+        let step_size = self.params.step_size as i64;
+        let event = search_for_change_in_visibility(
+            &mut self.data,
+            self.params.engine,
+            time,
+            step_size,
+            visible,
+        )?;
+        self.first_second(event, !visible)
+    }
+
+    /// Calculate the interval containing a time from scratch
+    fn refresh(&mut self, time: i64) -> Result<Interval, SpaError> {
+        let visible = self.visible_at(time)?;
+        let step_size = self.params.step_size as i64;
+        let previous = search_for_change_in_visibility(
+            &mut self.data,
+            self.params.engine,
+            time,
+            -step_size,
+            visible,
+        )?;
+        Ok(Interval {
+            start: self.first_second(previous, visible)?,
+            end: self.next_event(time, visible)?,
+            visible,
+        })
+    }
+}
+
 /// Output values from the calculator
 #[derive(Debug, Copy, Clone, Eq, PartialEq)]
 pub struct SunriseSunsetResult {
@@ -146,16 +297,25 @@ fn sun_is_up(result: &SpaData) -> bool {
     result.e >= -0.8333f64
 }
 
+#[inline]
+fn calculate_position(data: &mut SpaData, engine: Engine) -> Result<(), SpaError> {
+    match engine {
+        Engine::Spa => data.calculate(),
+        Engine::Noaa => data.calculate_low_precision(),
+    }
+}
+
 #[inline]
 fn search_for_change_in_visibility(
     mut data: &mut SpaData,
+    engine: Engine,
     mut start: i64,
     mut step_size: i64,
     mut currently_visible: bool,
 ) -> Result<i64, SpaError> {
     while step_size != 0 {
         data.jd = jd_from_unix(start);
-        data.calculate()?;
+        calculate_position(data, engine)?;
         if sun_is_up(data) != currently_visible {
             step_size = -(step_size / 2i64);
             currently_visible = !currently_visible;
@@ -269,6 +429,51 @@ mod tests {
         test_outer_bounds_impl(svalbard_spring, SVALBARD_LAT, SVALBARD_LON, 10, 3600);
     }
 
+    fn test_calculator_impl(latitude: f64, longitude: f64, start: i64, end: i64, step: usize) {
+        let params = SunriseSunsetParameters::new(start, latitude, longitude);
+        let mut calculator = SunriseSunsetCalculator::new(params).unwrap();
+        for time in (start..end).step_by(step) {
+            let expected = calculate(time, latitude, longitude);
+            let actual = calculator.query(time).unwrap();
+            assert_eq!(expected.visible, actual.visible);
+            assert_abs_diff_eq!(expected.rise, actual.rise, epsilon = 2);
+            assert_abs_diff_eq!(expected.set, actual.set, epsilon = 2);
+        }
+    }
+
+    #[test]
+    fn test_calculator() {
+        let start = timestamp(2021, 7, 28, 22, 0, 0);
+        test_calculator_impl(BRISTOL_LAT, BRISTOL_LON, start, start + 5 * 86400, 1200);
+        test_calculator_impl(
+            ADELAIDE_LAT,
+            ADELAIDE_LON,
+            start,
+            start + 40 * 86400,
+            86400 + 3517,
+        );
+        let svalbard_spring = timestamp(2021, 2, 10, 0, 0, 0);
+        test_calculator_impl(
+            SVALBARD_LAT,
+            SVALBARD_LON,
+            svalbard_spring,
+            svalbard_spring + 10 * 86400,
+            3 * 3600,
+        );
+
+        // Queries back in time, and within the cached interval, give the same result
+        let params = SunriseSunsetParameters::new(start, BRISTOL_LAT, BRISTOL_LON);
+        let mut calculator = SunriseSunsetCalculator::new(params).unwrap();
+        let first = calculator.query(start).unwrap();
+        calculator.query(start + 30 * 86400).unwrap();
+        assert_eq!(calculator.query(start).unwrap(), first);
+        assert_eq!(calculator.query(first.set).unwrap(), first);
+        assert_eq!(calculator.query(first.rise - 1).unwrap(), first);
+
+        let params = SunriseSunsetParameters::new(start, 91.0, BRISTOL_LON);
+        assert!(SunriseSunsetCalculator::new(params).is_err());
+    }
+
     #[test]
     fn test_adelaide() {
         let tz = (10.5 * 60.0 * 60.0) as i32; // UTC+10:30
@@ -0,0 +1,154 @@
+//! Low precision solar position, as used by the NOAA solar calculator
+//!
+//! Based on Meeus, Astronomical Algorithms, chapter 25. The position of the sun is evaluated from a
+//! handful of polynomial and periodic terms instead of the full SPA periodic series, and nutation is
+//! reduced to its main term. The observer stage (parallax and refraction) is shared with the SPA.
+//!
+//! Against [SpaData::calculate()] the right ascension is within 0.01 degrees and the declination
+//! within 0.004 degrees between -1000 and 5000, rising to 0.025 and 0.01 degrees at the ends of the
+//! -2000 to 6000 range. Sunrise and sunset are within 10 seconds up to 60 degrees latitude and within
+//! a minute up to the polar circles.
+use crate::spa::{
+    greenwich_mean_sidereal_time, greenwich_sidereal_time, julian_century,
+    julian_ephemeris_century, julian_ephemeris_day, limit_degrees, SpaData,
+};
+
+pub(crate) fn calculate_geocentric_sun_right_ascension_and_declination(spa: &mut SpaData) {
+    spa.jc = julian_century(spa.jd);
+    spa.jde = julian_ephemeris_day(spa.jd, spa.delta_t);
+    spa.jce = julian_ephemeris_century(spa.jde);
+    let t = spa.jce;
+
+    // Geometric mean longitude and anomaly of the sun, eccentricity of earth's orbit
+    let l0 = 280.46646 + t * (36000.76983 + t * 0.0003032);
+    let m = 357.52911 + t * (35999.05029 - t * 0.0001537);
+    let e = 0.016708634 - t * (0.000042037 + t * 0.0000001267);
+
+    // Equation of the centre
+    let c = m.to_radians().sin() * (1.914602 - t * (0.004817 + t * 0.000014))
+        + (2.0 * m).to_radians().sin() * (0.019993 - t * 0.000101)
+        + (3.0 * m).to_radians().sin() * 0.000289;
+    spa.theta = l0 + c;
+    spa.beta = 0.0;
+    spa.r = 1.000001018 * (1.0 - e * e) / (1.0 + e * (m + c).to_radians().cos());
+
+    // Apparent longitude, corrected for aberration and the main nutation term
+    let omega = (125.04 - 1934.136 * t).to_radians();
+    spa.del_psi = -0.00478 * omega.sin();
+    spa.del_tau = -0.00569;
+    spa.lamda = spa.theta + spa.del_psi + spa.del_tau;
+
+    // Mean obliquity, and true obliquity with the main nutation term
+    spa.epsilon0 =
+        23.0 + (26.0 + (21.448 - t * (46.815 + t * (0.00059 - t * 0.001813))) / 60.0) / 60.0;
+    spa.epsilon = spa.epsilon0 + 0.00256 * omega.cos();
+
+    let lamda = spa.lamda.to_radians();
+    let epsilon = spa.epsilon.to_radians();
+    spa.alpha = limit_degrees(
+        (epsilon.cos() * lamda.sin())
+            .atan2(lamda.cos())
+            .to_degrees(),
+    );
+    spa.delta = (epsilon.sin() * lamda.sin()).asin().to_degrees();
+
+    spa.nu0 = greenwich_mean_sidereal_time(spa.jd, spa.jc);
+    spa.nu = greenwich_sidereal_time(spa.nu0, spa.del_psi, spa.epsilon);
+}
+
+#[cfg(test)]
+mod tests {
+    use crate::{Engine, SpaData};
+    use crate::{SunriseSunsetParameters, SunriseSunsetResult};
+    use std::time::Instant;
+
+    const UNIX_J2000: i64 = 946728000;
+    const SECONDS_PER_YEAR: i64 = 31557600;
+
+    fn data(jd: f64) -> SpaData {
+        SpaData {
+            jd,
+            pressure: 1013.25,
+            temperature: 16.0,
+            atmos_refract: 0.5667,
+            ..Default::default()
+        }
+    }
+
+    fn angle_difference(a: f64, b: f64) -> f64 {
+        let d = (a - b).rem_euclid(360.0);
+        d.min(360.0 - d)
+    }
+
+    #[test]
+    fn test_position_error() {
+        let mut max_alpha = 0f64;
+        let mut max_delta = 0f64;
+        for year in (-2000..=6000).step_by(500) {
+            for day in (0..365).step_by(3) {
+                // The range starts at the first day of -2000 and ends at the last day of 6000
+                let offset = if year == 6000 { 366.0 } else { 0.0 };
+                let jd = 990576.0 + (year + 2000) as f64 * 365.25 + day as f64 + 0.37 - offset;
+                let mut expected = data(jd);
+                expected.calculate().unwrap();
+                let mut actual = data(jd);
+                actual.calculate_low_precision().unwrap();
+                max_alpha = max_alpha.max(angle_difference(expected.alpha, actual.alpha));
+                max_delta = max_delta.max((expected.delta - actual.delta).abs());
+            }
+        }
+        println!("Max alpha error: {max_alpha:.4}, max delta error: {max_delta:.4} [degrees]");
+        assert!(max_alpha < 0.03);
+        assert!(max_delta < 0.012);
+    }
+
+    #[test]
+    fn test_sunrise_sunset_error() {
+        let years = [-1999, -1000, 0, 1000, 2000, 3000, 4000, 5000, 5999];
+        for latitude in [-60.0, -30.0, 0.0, 30.0, 60.0, 66.0] {
+            let mut max_error = 0;
+            for year in years {
+                for k in 0..6i64 {
+                    let time =
+                        UNIX_J2000 + (year - 2000) * SECONDS_PER_YEAR + k * 60 * 86400 + 3600 * k;
+                    let mut params =
+                        SunriseSunsetParameters::new(time, latitude, 60.0 * k as f64 - 165.0);
+                    let expected = params.calculate().unwrap();
+                    params.engine = Engine::Noaa;
+                    let actual: SunriseSunsetResult = params.calculate().unwrap();
+                    assert_eq!(expected.visible, actual.visible);
+                    max_error = max_error
+                        .max((expected.rise - actual.rise).abs())
+                        .max((expected.set - actual.set).abs());
+                }
+            }
+            println!("Latitude {latitude}: max sunrise/sunset error {max_error}s");
+            assert!(max_error <= 60);
+        }
+    }
+
+    // Timings are only printed, as they depend on the machine and its load
+    #[test]
+    fn test_throughput() {
+        let run = |engine: Engine| {
+            let start = Instant::now();
+            for i in 0..500i64 {
+                let mut params = SunriseSunsetParameters::new(
+                    UNIX_J2000 + i * 97 * 3600,
+                    -55.0 + (i % 110) as f64,
+                    (i % 360) as f64 - 180.0,
+                );
+                params.engine = engine;
+                params.calculate().unwrap();
+            }
+            start.elapsed().as_secs_f64() / 500.0
+        };
+        let spa = run(Engine::Spa);
+        let noaa = run(Engine::Noaa);
+        println!(
+            "SPA: {:.1} us/call, NOAA: {:.1} us/call",
+            spa * 1e6,
+            noaa * 1e6
+        );
+    }
+}
@@ -868,7 +868,7 @@ fn deg2rad(degrees: f64) -> f64 {
     PI / 180.0f64 * degrees
 }
 
-fn limit_degrees(mut degrees: f64) -> f64 {
+pub(crate) fn limit_degrees(mut degrees: f64) -> f64 {
     let mut limited: f64 = 0.;
     degrees /= 360.0f64;
     limited = 360.0f64 * (degrees - degrees.floor());
@@ -914,15 +914,15 @@ fn validate_inputs(spa: &SpaData) -> Result<(), SpaError> {
     Ok(())
 }
 
-fn julian_century(jd: f64) -> f64 {
+pub(crate) fn julian_century(jd: f64) -> f64 {
     (jd - 2451545.0f64) / 36525.0f64
 }
 
-fn julian_ephemeris_day(jd: f64, delta_t: f64) -> f64 {
+pub(crate) fn julian_ephemeris_day(jd: f64, delta_t: f64) -> f64 {
     jd + delta_t / 86400.0f64
 }
 
-fn julian_ephemeris_century(jde: f64) -> f64 {
+pub(crate) fn julian_ephemeris_century(jde: f64) -> f64 {
     (jde - 2451545.0f64) / 36525.0f64
 }
 
@@ -1108,7 +1108,7 @@ fn apparent_sun_longitude(theta: f64, delta_psi: f64, delta_tau: f64) -> f64 {
     theta + delta_psi + delta_tau
 }
 
-fn greenwich_mean_sidereal_time(jd: f64, jc: f64) -> f64 {
+pub(crate) fn greenwich_mean_sidereal_time(jd: f64, jc: f64) -> f64 {
     limit_degrees(
         280.46061837f64
             + 360.98564736629f64 * (jd - 2451545.0f64)
@@ -1116,7 +1116,7 @@ fn greenwich_mean_sidereal_time(jd: f64, jc: f64) -> f64 {
     )
 }
 
-fn greenwich_sidereal_time(nu0: f64, delta_psi: f64, epsilon: f64) -> f64 {
+pub(crate) fn greenwich_sidereal_time(nu0: f64, delta_psi: f64, epsilon: f64) -> f64 {
     let x = deg2rad(epsilon);
     nu0 + delta_psi * x.cos()
 }
@@ -1244,6 +1244,22 @@ impl SpaData {
     pub fn calculate(&mut self) -> Result<(), SpaError> {
         validate_inputs(&*self)?;
         calculate_geocentric_sun_right_ascension_and_declination(&mut *self);
+        self.calculate_topocentric();
+        Ok(())
+    }
+
+    /// Calculate the Solar Position values with the low precision NOAA algorithm
+    ///
+    /// Only the geocentric position differs from [calculate()](Self::calculate), the periodic terms
+    /// (`l`, `b`, the `x` terms and `del_epsilon`) are not evaluated. See [crate::noaa] for error bounds.
+    pub fn calculate_low_precision(&mut self) -> Result<(), SpaError> {
+        validate_inputs(&*self)?;
+        crate::noaa::calculate_geocentric_sun_right_ascension_and_declination(&mut *self);
+        self.calculate_topocentric();
+        Ok(())
+    }
+
+    fn calculate_topocentric(&mut self) {
         self.h = observer_hour_angle(self.nu, self.longitude, self.alpha);
         self.xi = sun_equatorial_horizontal_parallax(self.r);
         right_ascension_parallax_and_topocentric_dec(
@@ -1264,7 +1280,6 @@ impl SpaData {
             self.e0,
         );
         self.e = topocentric_elevation_angle_corrected(self.e0, self.del_e);
-        Ok(())
     }
 }
 